@@ -26,6 +26,13 @@ typedef struct OC_APPLE_CHUNKLIST_CONTEXT_ {
   CONST APPLE_CHUNKLIST_CHUNK *Chunks;
   APPLE_CHUNKLIST_SIG         *Signature;
   UINT8                       Hash[SHA256_DIGEST_SIZE];
+  //
+  // Streaming verification state: current chunk, amount of its data
+  // hashed so far, and its running hash.
+  //
+  UINTN                       CurrentChunk;
+  UINT32                      ChunkOffset;
+  SHA256_CONTEXT              ChunkHashContext;
 } OC_APPLE_CHUNKLIST_CONTEXT;
 
 //
@@ -60,7 +67,7 @@ OcAppleChunklistVerifySignature (
   Verifies the specified data against a chunklist context.
 
   @param[in] Context            The Context to verify against.
-  @param[in] ExtentTable        A pointer to the RAM disk extent table to be
+  @param[in] RamDisk            A pointer to the RAM disk context to be
                                 verified.
 
   @retval EFI_SUCCESS           The data was verified successfully.
@@ -70,8 +77,51 @@ OcAppleChunklistVerifySignature (
 **/
 BOOLEAN
 OcAppleChunklistVerifyData (
-  IN OUT OC_APPLE_CHUNKLIST_CONTEXT         *Context,
-  IN     CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT       *Context,
+  IN     CONST OC_APPLE_RAM_DISK_CONTEXT  *RamDisk
+  );
+
+/**
+  Starts streaming verification of data against a chunklist context.
+  The chunklist signature must have been verified before.
+
+  @param[in,out] Context  The Context to verify against.
+**/
+VOID
+OcAppleChunklistVerifyStreamStart (
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT  *Context
+  );
+
+/**
+  Verifies the next part of the data against a chunklist context.
+  Every chunk is checked as soon as its last byte is passed. Data past
+  the last chunk is not covered by the chunklist and is ignored.
+
+  @param[in,out] Context   The Context to verify against.
+  @param[in]     Data      Next part of the data.
+  @param[in]     DataSize  Size of Data in bytes.
+
+  @retval TRUE   All completed chunks were verified successfully.
+  @retval FALSE  A chunk failed verification.
+**/
+BOOLEAN
+OcAppleChunklistVerifyStreamUpdate (
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN     CONST VOID                  *Data,
+  IN     UINTN                       DataSize
+  );
+
+/**
+  Finishes streaming verification of data against a chunklist context.
+
+  @param[in] Context  The Context to verify against.
+
+  @retval TRUE   All chunks were passed and verified successfully.
+  @retval FALSE  The data was shorter than the chunklist.
+**/
+BOOLEAN
+OcAppleChunklistVerifyStreamEnd (
+  IN CONST OC_APPLE_CHUNKLIST_CONTEXT  *Context
   );
 
 #endif // APPLE_CHUNKLIST_LIB_H
@@ -20,16 +20,57 @@
 #include <Library/OcAppleChunklistLib.h>
 #include <Library/OcAppleRamDiskLib.h>
 
+//
+// Default memory budget for decompressed chunk cache.
+//
+#define OC_APPLE_DISK_IMAGE_DEFAULT_CACHE_SIZE  SIZE_8MB
+
+//
+// Maximum amount of decompressed chunks cached at a time.
+//
+#define OC_APPLE_DISK_IMAGE_MAX_CACHE_ENTRIES   16
+
+//
+// Decompressed chunk cache entry.
+//
+typedef struct {
+    CONST APPLE_DISK_IMAGE_CHUNK      *Chunk;
+    UINT8                             *Data;
+    UINTN                             Size;
+    UINT32                            LastUse;
+} OC_APPLE_DISK_IMAGE_CACHE_ENTRY;
+
+//
+// Chunk lookup entry sorted by absolute sector, limited to the block range.
+//
+typedef struct {
+    UINT64                            SectorStart;
+    UINT64                            SectorTop;
+    APPLE_DISK_IMAGE_BLOCK_DATA       *BlockData;
+    APPLE_DISK_IMAGE_CHUNK            *Chunk;
+} OC_APPLE_DISK_IMAGE_CHUNK_ENTRY;
+
 //
 // Disk image context.
 //
 typedef struct {
-    CONST APPLE_RAM_DISK_EXTENT_TABLE *ExtentTable;
+    OC_APPLE_RAM_DISK_CONTEXT         RamDisk;
 
     UINTN                             SectorCount;
 
     UINT32                            BlockCount;
     APPLE_DISK_IMAGE_BLOCK_DATA       **Blocks;
+
+    UINT32                            ChunkEntryCount;
+    UINT32                            LastChunkEntry;
+    OC_APPLE_DISK_IMAGE_CHUNK_ENTRY   *ChunkEntries;
+    BOOLEAN                           ChunkEntriesOverlap;
+
+    UINTN                             CacheBudget;
+    UINTN                             CacheUsed;
+    UINT32                            CacheTick;
+    UINT32                            CacheEntryCount;
+    OC_APPLE_DISK_IMAGE_CACHE_ENTRY   CacheEntries[OC_APPLE_DISK_IMAGE_MAX_CACHE_ENTRIES];
 } OC_APPLE_DISK_IMAGE_CONTEXT;
 
 BOOLEAN
@@ -39,16 +80,43 @@ OcAppleDiskImageInitializeContext (
   IN  UINTN                              FileSize
   );
 
+/**
+  Load disk image from file and initialise its context.
+  When LoadCallback is passed, it sees the image data while it is loaded.
+
+  @param[out] Context              Disk image context.
+  @param[in]  File                 Disk image file open for reading.
+  @param[in]  LoadCallback         File data callback, optional.
+  @param[in]  LoadCallbackContext  Callback context, optional.
+
+  @retval TRUE on success.
+**/
 BOOLEAN
 OcAppleDiskImageInitializeFromFile (
-  OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
-  IN  EFI_FILE_PROTOCOL            *File
+  OUT OC_APPLE_DISK_IMAGE_CONTEXT      *Context,
+  IN  EFI_FILE_PROTOCOL                *File,
+  IN  OC_APPLE_RAM_DISK_LOAD_CALLBACK  LoadCallback         OPTIONAL,
+  IN  VOID                             *LoadCallbackContext OPTIONAL
   );
 
 VOID
 OcAppleDiskImageFreeContext (
   IN OC_APPLE_DISK_IMAGE_CONTEXT *Context
   );
+
+/**
+  Set memory budget for decompressed chunk cache.
+  Cached chunks exceeding the new budget are released immediately.
+
+  @param[in,out] Context     Disk image context.
+  @param[in]     CacheSize   Cache size in bytes, 0 disables caching.
+**/
+VOID
+OcAppleDiskImageSetCacheSize (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        CacheSize
+  );
+
 VOID
 OcAppleDiskImageFreeFile (
   IN OC_APPLE_DISK_IMAGE_CONTEXT  *Context
@@ -62,10 +130,10 @@ OcAppleDiskImageVerifyData (
 
 BOOLEAN
 OcAppleDiskImageRead (
-  IN  OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
-  IN  UINTN                        Lba,
-  IN  UINTN                        BufferSize,
-  OUT VOID                         *Buffer
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        Lba,
+  IN     UINTN                        BufferSize,
+  OUT    VOID                         *Buffer
   );
 
 EFI_HANDLE
@@ -17,6 +17,7 @@
 
 #include <Library/OcCpuLib.h>
 #include <Library/OcMachoLib.h>
+#include <Library/OcMemoryLib.h>
 #include <Library/OcXmlLib.h>
 #include <Protocol/SimpleFileSystem.h>
 
@@ -51,6 +52,11 @@
 //
 #define PRELINK_INFO_RESERVE_SIZE (5U * 1024U * 1024U)
 
+//
+// Bundle identifier map entry, see PrelinkedInternal.h.
+//
+typedef struct PRELINKED_KEXT_MAP_ENTRY_ PRELINKED_KEXT_MAP_ENTRY;
+
 //
 // Prelinked context used for kernel modification.
 //
@@ -128,6 +134,28 @@ typedef struct {
   // Used for caching prelinked kexts.
   //
   LIST_ENTRY               PrelinkedKexts;
+  //
+  // Current dependency walk epoch of PrelinkedKexts.
+  //
+  UINT32                   KextVisitEpoch;
+  //
+  // Hashed map of bundle identifiers to KextList entries and PrelinkedKexts.
+  // Built upon context creation, NULL makes lookups scan both linearly.
+  //
+  PRELINKED_KEXT_MAP_ENTRY *KextMap;
+  //
+  // Number of KextMap slots, a power of two.
+  //
+  UINT32                   KextMapSize;
+  //
+  // Number of used KextMap slots. KextMapCount <= KextMapSize / 2.
+  //
+  UINT32                   KextMapCount;
+  //
+  // Memory for cached kexts and detached kext strings.
+  // Released as a whole upon context destruction.
+  //
+  OC_MEMORY_ARENA          Arena;
 } PRELINKED_CONTEXT;
 
 //
@@ -387,6 +415,25 @@ PatcherApplyGenericPatch (
   IN     PATCHER_GENERIC_PATCH  *Patch
   );
 
+/**
+  Apply generic patches in order with a single search pass.
+  Equivalent to calling PatcherApplyGenericPatch for every patch.
+
+  @param[in,out] Context         Patcher context.
+  @param[in]     Patches         Patch descriptions.
+  @param[in]     PatchCount      Patch description count.
+  @param[out]    Results         Per-patch results, PatchCount entries.
+
+  @return  RETURN_SUCCESS when every patch was applied.
+**/
+RETURN_STATUS
+PatcherApplyGenericPatches (
+  IN OUT PATCHER_CONTEXT        *Context,
+  IN     PATCHER_GENERIC_PATCH  *Patches,
+  IN     UINT32                 PatchCount,
+     OUT RETURN_STATUS          *Results
+  );
+
 /**
   Block kext from loading.
 
@@ -18,6 +18,48 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Protocol/AppleRamDisk.h>
 #include <Protocol/SimpleFileSystem.h>
 
+/**
+  Maximum amount of extents in extent table.
+**/
+#define OC_APPLE_RAM_DISK_MAX_EXTENTS \
+  (sizeof (((APPLE_RAM_DISK_EXTENT_TABLE *) 0)->Extents) / sizeof (APPLE_RAM_DISK_EXTENT))
+
+/**
+  RAM disk access context with extent lookup index.
+**/
+typedef struct {
+  //
+  // Extent table backing the RAM disk.
+  //
+  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable;
+  //
+  // Total size of all extents in bytes.
+  //
+  UINTN                              Size;
+  //
+  // RAM disk offset of every extent, ascending.
+  //
+  UINTN                              ExtentOffsets[OC_APPLE_RAM_DISK_MAX_EXTENTS];
+} OC_APPLE_RAM_DISK_CONTEXT;
+
+/**
+  File data callback for OcAppleRamDiskLoadFile, called for every read
+  block before it is written to the RAM disk.
+
+  @param[in]  Context   Parameterised callback data.
+  @param[in]  Data      Read file data.
+  @param[in]  DataSize  Size of Data in bytes.
+
+  @retval TRUE to continue loading.
+**/
+typedef
+BOOLEAN
+(*OC_APPLE_RAM_DISK_LOAD_CALLBACK) (
+  IN VOID        *Context  OPTIONAL,
+  IN CONST VOID  *Data,
+  IN UINTN       DataSize
+  );
+
 /**
   Request allocation of Size bytes in extents table.
 
@@ -33,9 +75,43 @@ OcAppleRamDiskAllocate (
   );
 
 /**
-  Read RAM disk data.
+  Initialize RAM disk access context for an extent table.
 
+  @param[out] Context     RAM disk context.
   @param[in]  ExtentTable Allocated extent table.
+
+  @retval TRUE on success.
+**/
+BOOLEAN
+OcAppleRamDiskInitializeContext (
+  OUT OC_APPLE_RAM_DISK_CONTEXT          *Context,
+  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable
+  );
+
+/**
+  Map RAM disk data range without copying. The returned span is contiguous
+  and may be shorter than requested when the range crosses an extent
+  boundary, in which case the caller is to map the remainder separately.
+
+  @param[in]  Context     RAM disk context.
+  @param[in]  Offset      Offset in RAM disk.
+  @param[in]  Size        Amount of data to map.
+  @param[out] MappedSize  Amount of data mapped, at most Size.
+
+  @retval Pointer to RAM disk data at Offset or NULL.
+**/
+VOID *
+OcAppleRamDiskMapRange (
+  IN  CONST OC_APPLE_RAM_DISK_CONTEXT  *Context,
+  IN  UINTN                            Offset,
+  IN  UINTN                            Size,
+  OUT UINTN                            *MappedSize
+  );
+
+/**
+  Read RAM disk data.
+
+  @param[in]  Context     RAM disk context.
   @param[in]  Offset      Offset in RAM disk.
   @param[in]  Size        Amount of data to read.
   @param[out] Buffer      Resulting data.
@@ -44,16 +120,16 @@ OcAppleRamDiskAllocate (
 **/
 BOOLEAN
 OcAppleRamDiskRead (
-  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
-  IN  UINTN                              Offset,
-  IN  UINTN                              Size,
-  OUT VOID                               *Buffer
+  IN  CONST OC_APPLE_RAM_DISK_CONTEXT  *Context,
+  IN  UINTN                            Offset,
+  IN  UINTN                            Size,
+  OUT VOID                             *Buffer
   );
 
 /**
   Write RAM disk data.
 
-  @param[in]  ExtentTable Allocated extent table.
+  @param[in]  Context     RAM disk context.
   @param[in]  Offset      Offset in RAM disk.
   @param[in]  Size        Amount of data to write.
   @param[in]  Buffer      Source data.
@@ -62,18 +138,22 @@ OcAppleRamDiskRead (
 **/
 BOOLEAN
 OcAppleRamDiskWrite (
-  IN CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
-  IN UINTN                              Offset,
-  IN UINTN                              Size,
-  IN CONST VOID                         *Buffer
+  IN CONST OC_APPLE_RAM_DISK_CONTEXT  *Context,
+  IN UINTN                            Offset,
+  IN UINTN                            Size,
+  IN CONST VOID                       *Buffer
   );
 
 /**
   Load file into RAM disk as it is.
+  When Callback is passed, it sees the data while it is read,
+  and loading is aborted when it returns FALSE.
 
-  @param[in]  ExtentTable Allocated extent table.
-  @param[in]  File        File protocol open for reading.
-  @param[in]  FileSize    Amount of data to write.
+  @param[in]  ExtentTable      Allocated extent table.
+  @param[in]  File             File protocol open for reading.
+  @param[in]  FileSize         Amount of data to write.
+  @param[in]  Callback         File data callback, optional.
+  @param[in]  CallbackContext  Callback context, optional.
 
   @retval TRUE on success.
 **/
@@ -81,7 +161,9 @@ BOOLEAN
 OcAppleRamDiskLoadFile (
   IN OUT CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
   IN     EFI_FILE_PROTOCOL                  *File,
-  IN     UINTN                              FileSize
+  IN     UINTN                              FileSize,
+  IN     OC_APPLE_RAM_DISK_LOAD_CALLBACK    Callback         OPTIONAL,
+  IN     VOID                               *CallbackContext OPTIONAL
   );
 
 /**
@@ -533,6 +533,10 @@ struct OC_PICKER_CONTEXT_ {
   //
   BOOLEAN                    PickerAudioAssist;
   //
+  // Allow the interface to store decoded images in a cache file.
+  //
+  BOOLEAN                    PickerImageCache;
+  //
   // Recommended audio protocol, optional.
   //
   OC_AUDIO_PROTOCOL          *OcAudio;
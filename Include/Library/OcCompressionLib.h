@@ -117,4 +117,77 @@ DecompressZLIB (
   IN  UINTN        SrcLen
   );
 
+/**
+  Streaming decompression algorithms.
+**/
+#define OC_DECOMPRESS_STREAM_LZSS  1U
+#define OC_DECOMPRESS_STREAM_LZVN  2U
+
+/**
+  Streaming decompression context.
+**/
+typedef struct OC_DECOMPRESS_STREAM_ OC_DECOMPRESS_STREAM;
+
+/**
+  Create streaming decompression context.
+
+  @param[in]   Algorithm   Decompression algorithm, OC_DECOMPRESS_STREAM_*.
+  @param[out]  Dst         Destination buffer.
+  @param[in]   DstLen      Destination buffer size.
+
+  @return  Allocated context or NULL.
+**/
+OC_DECOMPRESS_STREAM *
+DecompressStreamCreate (
+  IN  UINT32  Algorithm,
+  OUT UINT8   *Dst,
+  IN  UINT32  DstLen
+  );
+
+/**
+  Decompress the next part of the source into the destination buffer.
+  Incomplete trailing tokens are not consumed and must be passed again
+  followed by the rest of the source.
+
+  @param[in,out]  Stream      Streaming decompression context.
+  @param[in]      Src         Source buffer.
+  @param[in]      SrcLen      Source buffer size.
+  @param[out]     DstLen      Total number of decompressed bytes so far.
+
+  @return  Number of bytes consumed from Src.
+**/
+UINT32
+DecompressStreamUpdate (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+  IN     CONST UINT8           *Src,
+  IN     UINT32                SrcLen,
+     OUT UINT32                *DstLen
+  );
+
+/**
+  Free streaming decompression context.
+
+  @param[in]  Stream      Streaming decompression context.
+**/
+VOID
+DecompressStreamFree (
+  IN OC_DECOMPRESS_STREAM  *Stream
+  );
+
+/**
+  Calculate Adler-32 checksum.
+
+  @param[in]  Adler       Checksum of the preceding data, 1 for no data.
+  @param[in]  Buffer      Data buffer.
+  @param[in]  Length      Data buffer size.
+
+  @return  Updated checksum.
+**/
+UINT32
+Adler32 (
+  IN UINT32       Adler,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  );
+
 #endif // OC_COMPRESSION_LIB_H
@@ -107,7 +107,6 @@ typedef struct SHA1_CONTEXT_ {
   UINT32  DataLen;
   UINT64  BitLen;
   UINT32  State[5];
-  UINT32  K[4];
 } SHA1_CONTEXT;
 
 typedef struct SHA256_CONTEXT_ {
@@ -160,6 +159,41 @@ typedef PACKED struct {
 
 #pragma pack(pop)
 
+///
+/// Pre-processed RSA public key with scratch memory for verification.
+/// A context can verify any amount of signatures without allocating.
+///
+typedef struct OC_RSA_VERIFY_CONTEXT_ {
+  ///
+  /// The number of BIGNUM words of N and RSqrMod each.
+  ///
+  UINTN        NumWords;
+  ///
+  /// The Montgomery Inverse of N.
+  ///
+  UINTN        N0Inv;
+  ///
+  /// The RSA exponent.
+  ///
+  UINT32       Exponent;
+  ///
+  /// The Modulus in BIGNUM format.
+  ///
+  CONST VOID   *N;
+  ///
+  /// Montgomery's R^2 mod N in BIGNUM format.
+  ///
+  CONST VOID   *RSqrMod;
+  ///
+  /// Scratch memory for three BIGNUMs of NumWords words each.
+  ///
+  VOID         *Scratch;
+  ///
+  /// Allocated memory, containing Scratch and possibly N and RSqrMod.
+  ///
+  VOID         *Memory;
+} OC_RSA_VERIFY_CONTEXT;
+
 //
 // Functions prototypes
 //
@@ -470,6 +504,105 @@ RsaVerifySigDataFromKey (
   IN OC_SIG_HASH_TYPE         Algorithm
   );
 
+/**
+  Initialise RSA verification context from a raw modulus.
+  The modulus' size must be a multiple of the configured BIGNUM word size.
+  This will be true for any conventional RSA, which use two's potencies.
+
+  @param[out] Context      The RSA verification context to initialise.
+  @param[in]  Modulus      The RSA modulus byte array.
+  @param[in]  ModulusSize  The size, in bytes, of Modulus.
+  @param[in]  Exponent     The RSA exponent.
+
+  @returns  Whether the context has been successfully initialised.
+
+**/
+BOOLEAN
+RsaVerifyContextInitFromData (
+  OUT OC_RSA_VERIFY_CONTEXT  *Context,
+  IN  CONST UINT8            *Modulus,
+  IN  UINTN                  ModulusSize,
+  IN  UINT32                 Exponent
+  );
+
+/**
+  Initialise RSA verification context from a pre-processed public key.
+  The key is referenced and must stay valid while the context is in use.
+  The exponent is always 65537 as per the format specification.
+
+  @param[out] Context  The RSA verification context to initialise.
+  @param[in]  Key      The RSA Public Key.
+
+  @returns  Whether the context has been successfully initialised.
+
+**/
+BOOLEAN
+RsaVerifyContextInitFromKey (
+  OUT OC_RSA_VERIFY_CONTEXT    *Context,
+  IN  CONST OC_RSA_PUBLIC_KEY  *Key
+  );
+
+/**
+  Free RSA verification context resources.
+
+  @param[in,out] Context  The RSA verification context to free.
+
+**/
+VOID
+RsaVerifyContextFree (
+  IN OUT OC_RSA_VERIFY_CONTEXT  *Context
+  );
+
+/**
+  Verify a RSA PKCS1.5 signature against an expected hash.
+  The context scratch memory is used, so this function is not reentrant
+  for the same context.
+
+  @param[in,out] Context        The RSA verification context.
+  @param[in]     Signature      The RSA signature to be verified.
+  @param[in]     SignatureSize  Size, in bytes, of Signature.
+  @param[in]     Hash           The Hash digest of the signed data.
+  @param[in]     HashSize       Size, in bytes, of Hash.
+  @param[in]     Algorithm      The RSA algorithm used.
+
+  @returns  Whether the signature has been successfully verified as valid.
+
+**/
+BOOLEAN
+RsaVerifySigHashFromContext (
+  IN OUT OC_RSA_VERIFY_CONTEXT  *Context,
+  IN     CONST UINT8            *Signature,
+  IN     UINTN                  SignatureSize,
+  IN     CONST UINT8            *Hash,
+  IN     UINTN                  HashSize,
+  IN     OC_SIG_HASH_TYPE       Algorithm
+  );
+
+/**
+  Verify RSA PKCS1.5 signed data against its signature.
+  The context scratch memory is used, so this function is not reentrant
+  for the same context.
+
+  @param[in,out] Context        The RSA verification context.
+  @param[in]     Signature      The RSA signature to be verified.
+  @param[in]     SignatureSize  Size, in bytes, of Signature.
+  @param[in]     Data           The signed data to verify.
+  @param[in]     DataSize       Size, in bytes, of Data.
+  @param[in]     Algorithm      The RSA algorithm used.
+
+  @returns  Whether the signature has been successfully verified as valid.
+
+**/
+BOOLEAN
+RsaVerifySigDataFromContext (
+  IN OUT OC_RSA_VERIFY_CONTEXT  *Context,
+  IN     CONST UINT8            *Signature,
+  IN     UINTN                  SignatureSize,
+  IN     CONST UINT8            *Data,
+  IN     UINTN                  DataSize,
+  IN     OC_SIG_HASH_TYPE       Algorithm
+  );
+
 /**
   Performs a cryptographically secure comparison of the contents of two
   buffers.
@@ -67,6 +67,16 @@ OcConfigureLogProtocol (
   IN EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *LogFileSystem  OPTIONAL
   );
 
+/**
+  Write pending log file lines. Log file is not written after
+  ExitBootServices, so call this before starting an image which may
+  exit boot services.
+**/
+VOID
+OcLogFlushFile (
+  VOID
+  );
+
 /**
   Install and initialise the Apple Debug Log protocol.
 
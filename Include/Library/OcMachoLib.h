@@ -41,6 +41,13 @@ typedef struct {
   MACH_NLIST_64         *IndirectSymbolTable;
   MACH_RELOCATION_INFO  *LocalRelocations;
   MACH_RELOCATION_INFO  *ExternRelocations;
+  //
+  // Relocations sorted by address, built on the first lookup.  Extern entries
+  // are followed by local ones.
+  //
+  MACH_RELOCATION_INFO  **RelocationIndex;
+  UINT32                NumIndexedExternRelocations;
+  UINT32                NumIndexedLocalRelocations;
 } OC_MACHO_CONTEXT;
 
 /**
@@ -668,6 +675,37 @@ MachoPreserveRelocationIntel64 (
   IN UINT8  Type
   );
 
+/**
+  Retrieves a Relocation by the address it targets.  The first call builds an
+  index of the Relocations sorted by address, which must be released with
+  MachoFreeRelocationIndex before the Relocations are modified.  If the index
+  cannot be allocated, the Relocations are searched linearly.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Address  The address to search for.
+  @param[in]     Extern   Whether to search the extern or the local Relocations.
+
+  @retval NULL  NULL is returned on failure.
+
+**/
+MACH_RELOCATION_INFO *
+MachoLookupRelocation (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     UINT64            Address,
+  IN     BOOLEAN           Extern
+  );
+
+/**
+  Frees the Relocation index built by MachoLookupRelocation, if any.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+**/
+VOID
+MachoFreeRelocationIndex (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  );
+
 /**
   Obtain symbol tables.
 
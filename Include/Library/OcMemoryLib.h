@@ -379,4 +379,135 @@ UmmFree (
   IN VOID  *Ptr
   );
 
+/**
+  Memory arena block.
+**/
+typedef struct OC_MEMORY_ARENA_BLOCK_ OC_MEMORY_ARENA_BLOCK;
+
+/**
+  Scoped memory arena. Allocations are served from large pool blocks
+  and are only released all at once when the arena is freed.
+**/
+typedef struct {
+  //
+  // Arena name for statistics.
+  //
+  CONST CHAR8            *Name;
+  //
+  // Most recently allocated block.
+  //
+  OC_MEMORY_ARENA_BLOCK  *Blocks;
+  //
+  // Size of the first block, restored when the arena is freed.
+  //
+  UINT32                 InitialBlockSize;
+  //
+  // Size of the next block.
+  //
+  UINT32                 BlockSize;
+  //
+  // Amount of served allocations.
+  //
+  UINT32                 Allocations;
+  //
+  // Amount of pool allocations for blocks.
+  //
+  UINT32                 PoolAllocations;
+  //
+  // Total size of served allocations.
+  //
+  UINT32                 UsedSize;
+  //
+  // Total size of allocated blocks, which is also peak arena usage.
+  //
+  UINT32                 PeakSize;
+  //
+  // Time spent in pool services in CPU timestamp counter ticks.
+  //
+  UINT64                 PoolTicks;
+} OC_MEMORY_ARENA;
+
+/**
+  Initialize empty memory arena.
+
+  @param[out] Arena      Memory arena.
+  @param[in]  Name       Arena name for statistics.
+  @param[in]  BlockSize  Initial block size, grows for further blocks.
+**/
+VOID
+MemoryArenaInit (
+  OUT OC_MEMORY_ARENA  *Arena,
+  IN  CONST CHAR8      *Name,
+  IN  UINT32           BlockSize
+  );
+
+/**
+  Perform 8-byte aligned allocation from memory arena.
+
+  @param[in,out]  Arena  Memory arena.
+  @param[in]      Size   Allocation size.
+
+  @retval allocated memory on success.
+**/
+VOID *
+MemoryArenaAllocate (
+  IN OUT OC_MEMORY_ARENA  *Arena,
+  IN     UINT32           Size
+  );
+
+/**
+  Perform zeroed allocation from memory arena.
+
+  @param[in,out]  Arena  Memory arena.
+  @param[in]      Size   Allocation size.
+
+  @retval allocated memory on success.
+**/
+VOID *
+MemoryArenaAllocateZero (
+  IN OUT OC_MEMORY_ARENA  *Arena,
+  IN     UINT32           Size
+  );
+
+/**
+  Perform allocation from memory arena and copy buffer contents to it.
+
+  @param[in,out]  Arena   Memory arena.
+  @param[in]      Size    Allocation size.
+  @param[in]      Buffer  Buffer to copy.
+
+  @retval allocated memory on success.
+**/
+VOID *
+MemoryArenaAllocateCopy (
+  IN OUT OC_MEMORY_ARENA  *Arena,
+  IN     UINT32           Size,
+  IN     CONST VOID       *Buffer
+  );
+
+/**
+  Check whether memory was allocated from memory arena.
+
+  @param[in]  Arena   Memory arena.
+  @param[in]  Memory  Memory to check.
+
+  @retval TRUE when memory belongs to the arena.
+**/
+BOOLEAN
+MemoryArenaContains (
+  IN CONST OC_MEMORY_ARENA  *Arena,
+  IN CONST VOID             *Memory
+  );
+
+/**
+  Release all memory allocated from memory arena and report its statistics.
+  The arena stays initialized and can be used again.
+
+  @param[in,out]  Arena  Memory arena.
+**/
+VOID
+MemoryArenaFree (
+  IN OUT OC_MEMORY_ARENA  *Arena
+  );
+
 #endif // OC_MEMORY_LIB_H
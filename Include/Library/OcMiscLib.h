@@ -51,6 +51,70 @@ ApplyPatch (
   IN UINT32        Skip
   );
 
+/**
+  Data patch description for ApplyPatches.
+**/
+typedef struct {
+  //
+  // Pattern to look for, or NULL to write Replace at DataOff unconditionally.
+  //
+  CONST UINT8  *Pattern;
+  //
+  // Pattern mask, optional.
+  //
+  CONST UINT8  *PatternMask;
+  //
+  // Replacement data.
+  //
+  CONST UINT8  *Replace;
+  //
+  // Replacement mask, optional.
+  //
+  CONST UINT8  *ReplaceMask;
+  //
+  // Pattern and replacement size.
+  //
+  UINT32       Size;
+  //
+  // Data range to search in.
+  //
+  UINT32       DataOff;
+  UINT32       DataSize;
+  //
+  // Maximum amount of replacements, 0 for unlimited.
+  //
+  UINT32       Count;
+  //
+  // Amount of matches to skip before replacing.
+  //
+  UINT32       Skip;
+  //
+  // Amount of replacements performed, set by ApplyPatches.
+  //
+  UINT32       ReplaceCount;
+} OC_DATA_PATCH;
+
+/**
+  Apply multiple patches to the same data in a single search pass.
+  The result is identical to calling ApplyPatch for every patch in order,
+  including matches created or destroyed by earlier patches.
+
+  @param[in,out] Patches     Patches to apply, ReplaceCount is updated.
+  @param[in]     PatchCount  Amount of patches.
+  @param[in,out] Data        Data to patch.
+  @param[in]     DataSize    Data size.
+
+  @retval TRUE on success.
+  @retval FALSE on allocation failure, Data is left unchanged.
+**/
+BOOLEAN
+ApplyPatches (
+  IN OUT OC_DATA_PATCH  *Patches,
+  IN     UINT32         PatchCount,
+  IN OUT UINT8          *Data,
+  IN     UINT32         DataSize
+  );
+
 /**
   @param[in] Protocol    The published unique identifier of the protocol. It is the callers responsibility to pass in
                          a valid GUID.
@@ -98,4 +162,44 @@ MultThenDivU64x64x32 (
   OUT UINT32  *Remainder  OPTIONAL
   );
 
+/**
+  Calculate 32-bit FNV-1a hash of a buffer.
+
+  @param[in] Data  Data to hash.
+  @param[in] Size  Data size in bytes.
+
+  @return Data hash.
+**/
+UINT32
+OcHashFnv1a (
+  IN CONST VOID  *Data,
+  IN UINTN       Size
+  );
+
+/**
+  Calculate 32-bit FNV-1a hash of a null-terminated ASCII string.
+
+  @param[in] String  String to hash.
+
+  @return String hash.
+**/
+UINT32
+OcHashFnv1aAscii (
+  IN CONST CHAR8  *String
+  );
+
+/**
+  Calculate 32-bit FNV-1a hash of a null-terminated Unicode string.
+  Only the low byte of every character is hashed, so that ASCII strings
+  hash equally in both encodings.
+
+  @param[in] String  String to hash.
+
+  @return String hash.
+**/
+UINT32
+OcHashFnv1aUnicode (
+  IN CONST CHAR16  *String
+  );
+
 #endif // OC_MISC_LIB_H
@@ -56,6 +56,20 @@
   _(OC_STORAGE_VAULT_FILES      , Files    ,     , OC_CONSTR (OC_STORAGE_VAULT_FILES, _, __) , OC_DESTR (OC_STORAGE_VAULT_FILES))
   OC_DECLARE (OC_STORAGE_VAULT)
 
+/**
+  Storage vault file index entry.
+**/
+typedef struct {
+  ///
+  /// Vault file path hash.
+  ///
+  UINT32                           Hash;
+  ///
+  /// Vault file index plus one, 0 for free entries.
+  ///
+  UINT32                           File;
+} OC_STORAGE_VAULT_INDEX_ENTRY;
+
 /**
   Storage abstraction context
 **/
@@ -88,6 +102,14 @@ typedef struct {
   /// Vault status.
   ///
   BOOLEAN                          HasVault;
+  ///
+  /// Vault file path hash table, optional.
+  ///
+  OC_STORAGE_VAULT_INDEX_ENTRY     *VaultIndex;
+  ///
+  /// Vault file path hash table size minus one.
+  ///
+  UINT32                           VaultIndexMask;
 } OC_STORAGE_CONTEXT;
 
 /**
@@ -20,6 +20,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define OC_TEMPLATE_LIB_H
 
 #include <Library/BaseMemoryLib.h>
+#include <Library/OcMemoryLib.h>
 
 //
 // Common structor prototype.
@@ -257,6 +258,16 @@ OcListEntryAllocate (
   VOID            **Key
   );
 
+//
+// Serve allocations of blobs, maps and arrays from memory arena, or from
+// pool when Arena is NULL. Objects must be destructed with the same arena
+// set before freeing the arena. Previous arena is returned.
+//
+OC_MEMORY_ARENA *
+OcTemplateSetArena (
+  OC_MEMORY_ARENA  *Arena  OPTIONAL
+  );
+
 //
 // Some useful generic types
 // OC_STRING  - implements support for resizable ASCII strings.
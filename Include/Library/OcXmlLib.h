@@ -150,6 +150,43 @@ XmlDocumentExport (
   UINT32        Skip
   );
 
+//
+// Calculates exported document size.
+//
+// @param Document XML_DOCUMENT to export
+// @param Length   Resulting length of the export without trailing \0
+// @param Skip     N root levels before exporting, normally 0.
+//
+// @return TRUE on success, FALSE when the size does not fit UINT32.
+//
+BOOLEAN
+XmlDocumentExportSize (
+  XML_DOCUMENT  *Document,
+  UINT32        *Length,
+  UINT32        Skip
+  );
+
+//
+// Exports parsed document into a caller provided buffer.
+// Use XmlDocumentExportSize to obtain the size required.
+//
+// @param Document XML_DOCUMENT to export
+// @param Buffer   Buffer to export to
+// @param Size     Buffer size including trailing \0
+// @param Length   Resulting length of the buffer without trailing \0 (optional)
+// @param Skip     N root levels before exporting, normally 0.
+//
+// @return TRUE on success, FALSE when the buffer is too small.
+//
+BOOLEAN
+XmlDocumentExportBuffer (
+  XML_DOCUMENT  *Document,
+  CHAR8         *Buffer,
+  UINT32        Size,
+  UINT32        *Length,
+  UINT32        Skip
+  );
+
 //
 // Frees all resources associated with the document. All XML_NODE
 // references obtained through the document will be invalidated.
@@ -290,6 +327,21 @@ PlistDictChild (
   XML_NODE     **Value OPTIONAL
   );
 
+//
+// Finds dictionary value by key. Larger dictionaries get a keyed index on
+// the first lookup, which is dropped when appending or prepending nodes.
+//
+// @param Node  Dictionary node.
+// @param Key   Key to look up.
+//
+// @return The value of the first matching key or NULL.
+//
+XML_NODE *
+PlistDictLookup (
+  XML_NODE     *Node,
+  CONST CHAR8  *Key
+  );
+
 //
 // @return key value for valid type or NULL.
 //
@@ -33,6 +33,7 @@
 #define OC_LOG_VARIABLE     BIT4
 #define OC_LOG_NONVOLATILE  BIT5
 #define OC_LOG_FILE         BIT6
+#define OC_LOG_SAFE_FILE    BIT7
 
 typedef UINT32 OC_LOG_OPTIONS;
 
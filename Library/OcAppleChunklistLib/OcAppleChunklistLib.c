@@ -19,6 +19,58 @@
 #include <Library/OcAppleRamDiskLib.h>
 #include <Library/OcCryptoLib.h>
 #include <Library/OcGuardLib.h>
+#include <Library/TimerLib.h>
+
+//
+// Maximum amount of cached RSA verification contexts, one per trusted key.
+//
+#define OC_APPLE_CHUNKLIST_MAX_KEY_CONTEXTS  4
+
+//
+// RSA verification context cached by its public key.
+//
+typedef struct {
+  CONST OC_RSA_PUBLIC_KEY  *PublicKey;
+  OC_RSA_VERIFY_CONTEXT    Context;
+} OC_APPLE_CHUNKLIST_KEY_CONTEXT;
+
+STATIC OC_APPLE_CHUNKLIST_KEY_CONTEXT  mKeyContexts[OC_APPLE_CHUNKLIST_MAX_KEY_CONTEXTS];
+STATIC UINT32                          mKeyContextNext;
+
+/**
+  Get RSA verification context for a public key, initialising it on first use.
+
+  @retval RSA verification context or NULL on failure.
+**/
+STATIC
+OC_RSA_VERIFY_CONTEXT *
+InternalGetKeyContext (
+  IN CONST OC_RSA_PUBLIC_KEY  *PublicKey
+  )
+{
+  OC_APPLE_CHUNKLIST_KEY_CONTEXT  *Entry;
+  UINT32                          Index;
+
+  for (Index = 0; Index < OC_APPLE_CHUNKLIST_MAX_KEY_CONTEXTS; ++Index) {
+    if (mKeyContexts[Index].PublicKey == PublicKey) {
+      return &mKeyContexts[Index].Context;
+    }
+  }
+
+  Entry = &mKeyContexts[mKeyContextNext];
+  mKeyContextNext = (mKeyContextNext + 1) % OC_APPLE_CHUNKLIST_MAX_KEY_CONTEXTS;
+  if (Entry->PublicKey != NULL) {
+    RsaVerifyContextFree (&Entry->Context);
+    Entry->PublicKey = NULL;
+  }
+
+  if (!RsaVerifyContextInitFromKey (&Entry->Context, PublicKey)) {
+    return NULL;
+  }
+
+  Entry->PublicKey = PublicKey;
+  return &Entry->Context;
+}
 
 BOOLEAN
 OcAppleChunklistInitializeContext (
@@ -102,13 +154,20 @@ OcAppleChunklistVerifySignature (
   IN     CONST OC_RSA_PUBLIC_KEY     *PublicKey
   )
 {
-  BOOLEAN Result;
+  BOOLEAN                Result;
+  OC_RSA_VERIFY_CONTEXT  *KeyContext;
 
   ASSERT (Context != NULL);
   ASSERT (Context->Signature != NULL);
+  ASSERT (PublicKey != NULL);
+
+  KeyContext = InternalGetKeyContext (PublicKey);
+  if (KeyContext == NULL) {
+    return FALSE;
+  }
 
-  Result = RsaVerifySigHashFromKey (
-             PublicKey,
+  Result = RsaVerifySigHashFromContext (
+             KeyContext,
              Context->Signature->Signature,
              sizeof (Context->Signature->Signature),
              Context->Hash,
@@ -124,71 +183,178 @@ OcAppleChunklistVerifySignature (
   return Result;
 }
 
-BOOLEAN
-OcAppleChunklistVerifyData (
-  IN OUT OC_APPLE_CHUNKLIST_CONTEXT         *Context,
-  IN     CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable
+VOID
+OcAppleChunklistVerifyStreamStart (
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT  *Context
   )
 {
-  BOOLEAN                     Result;
-
-  UINTN                       Index;
-  UINT8                       ChunkHash[SHA256_DIGEST_SIZE];
-  CONST APPLE_CHUNKLIST_CHUNK *CurrentChunk;
-  UINTN                       CurrentOffset;
-
-  UINT32                      ChunkDataSize;
-  VOID                        *ChunkData;
-
   ASSERT (Context != NULL);
   ASSERT (Context->Chunks != NULL);
-  ASSERT (ExtentTable != NULL);
 
   DEBUG_CODE (
     ASSERT (Context->Signature == NULL);
     );
 
-  ChunkDataSize = 0;
-  for (Index = 0; Index < Context->ChunkCount; ++Index) {
-    CurrentChunk = &Context->Chunks[Index];
-    if (ChunkDataSize < CurrentChunk->Length) {
-      ChunkDataSize = CurrentChunk->Length;
+  Context->CurrentChunk = 0;
+  Context->ChunkOffset  = 0;
+  Sha256Init (&Context->ChunkHashContext);
+}
+
+BOOLEAN
+OcAppleChunklistVerifyStreamUpdate (
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN     CONST VOID                  *Data,
+  IN     UINTN                       DataSize
+  )
+{
+  CONST APPLE_CHUNKLIST_CHUNK *CurrentChunk;
+  CONST UINT8                 *DataBytes;
+  UINTN                       HashSize;
+  UINT8                       ChunkHash[SHA256_DIGEST_SIZE];
+
+  ASSERT (Context != NULL);
+  ASSERT (Data != NULL || DataSize == 0);
+
+  DataBytes = Data;
+
+  while (Context->CurrentChunk < Context->ChunkCount) {
+    CurrentChunk = &Context->Chunks[Context->CurrentChunk];
+    //
+    // Hash chunk data in place. Chunks crossing a buffer boundary are
+    // hashed in several pieces.
+    //
+    HashSize = MIN (DataSize, CurrentChunk->Length - Context->ChunkOffset);
+    Sha256Update (&Context->ChunkHashContext, DataBytes, HashSize);
+
+    DataBytes            += HashSize;
+    DataSize             -= HashSize;
+    Context->ChunkOffset += (UINT32) HashSize;
+
+    if (Context->ChunkOffset < CurrentChunk->Length) {
+      ASSERT (DataSize == 0);
+      break;
     }
-  }
 
-  ChunkData = AllocatePool (ChunkDataSize);
-  if (ChunkData == NULL) {
-    return FALSE;
+    Sha256Final (&Context->ChunkHashContext, ChunkHash);
+    //
+    // Ensure the checksums match.
+    //
+    if (CompareMem (ChunkHash, CurrentChunk->Checksum, SHA256_DIGEST_SIZE) != 0) {
+      DEBUG ((
+        DEBUG_INFO,
+        "OCCL: Chunk %Lu of %Lu is damaged\n",
+        (UINT64) Context->CurrentChunk + 1,
+        (UINT64) Context->ChunkCount
+        ));
+      return FALSE;
+    }
+
+    ++Context->CurrentChunk;
+    Context->ChunkOffset = 0;
+    Sha256Init (&Context->ChunkHashContext);
   }
 
+  return TRUE;
+}
+
+BOOLEAN
+OcAppleChunklistVerifyStreamEnd (
+  IN CONST OC_APPLE_CHUNKLIST_CONTEXT  *Context
+  )
+{
+  ASSERT (Context != NULL);
+
+  return Context->CurrentChunk == Context->ChunkCount;
+}
+
+BOOLEAN
+OcAppleChunklistVerifyData (
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT       *Context,
+  IN     CONST OC_APPLE_RAM_DISK_CONTEXT  *RamDisk
+  )
+{
+  UINTN                       CurrentOffset;
+  UINTN                       MappedSize;
+  CONST UINT8                 *Data;
+
+  UINT64                      StartTime;
+  UINT64                      ElapsedMs;
+
+  ASSERT (Context != NULL);
+  ASSERT (RamDisk != NULL);
+
+  StartTime = GetPerformanceCounter ();
+
+  OcAppleChunklistVerifyStreamStart (Context);
+
   CurrentOffset = 0;
-  for (Index = 0; Index < Context->ChunkCount; Index++) {
-    CurrentChunk = &Context->Chunks[Index];
-
-    Result = OcAppleRamDiskRead (
-               ExtentTable,
-               CurrentOffset,
-               CurrentChunk->Length,
-               ChunkData
-               );
-    if (!Result) {
-      FreePool (ChunkData);
-      return FALSE;
-    }
+  while (!OcAppleChunklistVerifyStreamEnd (Context)) {
     //
-    // Calculate checksum of data and ensure they match.
+    // Chunks must not exceed RAM disk data.
     //
-    DEBUG ((DEBUG_VERBOSE, "AppleChunklistVerifyData(): Validating chunk %lu of %lu\n",
-      (UINT64)Index + 1, (UINT64)Context->ChunkCount));
-    Sha256 (ChunkHash, ChunkData, CurrentChunk->Length);
-    if (CompareMem (ChunkHash, CurrentChunk->Checksum, SHA256_DIGEST_SIZE) != 0) {
-      FreePool (ChunkData);
+    if (CurrentOffset >= RamDisk->Size) {
+      return FALSE;
+    }
+
+    Data = OcAppleRamDiskMapRange (
+             RamDisk,
+             CurrentOffset,
+             RamDisk->Size - CurrentOffset,
+             &MappedSize
+             );
+    if (Data == NULL) {
+      return FALSE;
+    }
+
+    if (!OcAppleChunklistVerifyStreamUpdate (Context, Data, MappedSize)) {
       return FALSE;
     }
 
-    CurrentOffset += CurrentChunk->Length;
+    CurrentOffset += MappedSize;
   }
 
-  FreePool (ChunkData);
+  DEBUG_CODE_BEGIN ();
+  ElapsedMs = DivU64x32 (
+                GetTimeInNanoSecond (GetPerformanceCounter () - StartTime),
+                1000000
+                );
+  DEBUG ((
+    DEBUG_INFO,
+    "OCCL: Verified %Lu MB in %Lu ms (%Lu MB/s)\n",
+    RShiftU64 (CurrentOffset, 20),
+    ElapsedMs,
+    RShiftU64 (
+      DivU64x32 (
+        MultU64x32 (CurrentOffset, 1000),
+        (UINT32) MIN (MAX (ElapsedMs, 1), MAX_UINT32)
+        ),
+      20
+      )
+    ));
+  DEBUG_CODE_END ();
+
   return TRUE;
 }
+
+/**
+  Free the cached RSA verification contexts.
+
+  @retval RETURN_SUCCESS  The destructor always returns RETURN_SUCCESS.
+**/
+RETURN_STATUS
+EFIAPI
+OcAppleChunklistLibDestructor (
+  VOID
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < OC_APPLE_CHUNKLIST_MAX_KEY_CONTEXTS; ++Index) {
+    if (mKeyContexts[Index].PublicKey != NULL) {
+      RsaVerifyContextFree (&mKeyContexts[Index].Context);
+      mKeyContexts[Index].PublicKey = NULL;
+    }
+  }
+
+  return RETURN_SUCCESS;
+}
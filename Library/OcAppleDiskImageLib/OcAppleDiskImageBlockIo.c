@@ -170,7 +170,7 @@ InternalConstructDmgDevicePath (
   ASSERT (DiskImageData != NULL);
   ASSERT (DiskImageData->ImageContext);
 
-  RamDmgAddress = (UINTN)DiskImageData->ImageContext->ExtentTable;
+  RamDmgAddress = (UINTN)DiskImageData->ImageContext->RamDisk.ExtentTable;
 
   DevPath = &DiskImageData->DevicePath;
 
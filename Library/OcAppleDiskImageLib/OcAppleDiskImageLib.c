@@ -66,12 +66,18 @@ OcAppleDiskImageInitializeContext (
     return FALSE;
   }
 
+  Result = OcAppleRamDiskInitializeContext (&Context->RamDisk, ExtentTable);
+  if (!Result || Context->RamDisk.Size < FileSize) {
+    DEBUG ((DEBUG_INFO, "OCBD: DMG extent table error: %u\n", Result));
+    return FALSE;
+  }
+
   SwappedSig = SwapBytes32 (APPLE_DISK_IMAGE_MAGIC);
 
   TrailerOffset = (FileSize - sizeof (Trailer));
 
   Result = OcAppleRamDiskRead (
-             ExtentTable,
+             &Context->RamDisk,
              TrailerOffset,
              sizeof (Trailer),
              &Trailer
@@ -156,7 +162,7 @@ OcAppleDiskImageInitializeContext (
   }
 
   Result = OcAppleRamDiskRead (
-             ExtentTable,
+             &Context->RamDisk,
              (UINTN)XmlOffset,
              (UINTN)XmlLength,
              PlistData
@@ -184,18 +190,31 @@ OcAppleDiskImageInitializeContext (
     return FALSE;
   }
 
-  Context->ExtentTable = ExtentTable;
-  Context->BlockCount  = DmgBlockCount;
-  Context->Blocks      = DmgBlocks;
-  Context->SectorCount = (UINTN)SectorCount;
+  Context->BlockCount      = DmgBlockCount;
+  Context->Blocks          = DmgBlocks;
+  Context->SectorCount     = (UINTN)SectorCount;
+  Context->ChunkEntries    = NULL;
+  Context->CacheBudget     = OC_APPLE_DISK_IMAGE_DEFAULT_CACHE_SIZE;
+  Context->CacheUsed       = 0;
+  Context->CacheTick       = 0;
+  Context->CacheEntryCount = 0;
+
+  Result = InternalBuildChunkEntries (Context);
+  if (!Result) {
+    DEBUG ((DEBUG_INFO, "OCBD: DMG chunk table error: %u\n", DmgBlockCount));
+    OcAppleDiskImageFreeContext (Context);
+    return FALSE;
+  }
 
   return TRUE;
 }
 
 BOOLEAN
 OcAppleDiskImageInitializeFromFile (
-  OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
-  IN  EFI_FILE_PROTOCOL            *File
+  OUT OC_APPLE_DISK_IMAGE_CONTEXT      *Context,
+  IN  EFI_FILE_PROTOCOL                *File,
+  IN  OC_APPLE_RAM_DISK_LOAD_CALLBACK  LoadCallback         OPTIONAL,
+  IN  VOID                             *LoadCallbackContext OPTIONAL
   )
 {
   EFI_STATUS                        Status;
@@ -219,7 +238,13 @@ OcAppleDiskImageInitializeFromFile (
     return FALSE;
   }
 
-  Result = OcAppleRamDiskLoadFile (ExtentTable, File, FileSize);
+  Result = OcAppleRamDiskLoadFile (
+             ExtentTable,
+             File,
+             FileSize,
+             LoadCallback,
+             LoadCallbackContext
+             );
   if (!Result) {
     DEBUG ((DEBUG_INFO, "OCBD: Failed to load DMG file\n"));
 
@@ -249,7 +274,7 @@ OcAppleDiskImageVerifyData (
 
   return OcAppleChunklistVerifyData (
            ChunklistContext,
-           Context->ExtentTable
+           &Context->RamDisk
            );
 }
 
@@ -262,6 +287,12 @@ OcAppleDiskImageFreeContext (
 
   ASSERT (Context != NULL);
 
+  InternalTrimChunkCache (Context, 0);
+
+  if (Context->ChunkEntries != NULL) {
+    FreePool (Context->ChunkEntries);
+  }
+
   for (Index = 0; Index < Context->BlockCount; ++Index) {
     FreePool (Context->Blocks[Index]);
   }
@@ -269,21 +300,33 @@ OcAppleDiskImageFreeContext (
   FreePool (Context->Blocks);
 }
 
+VOID
+OcAppleDiskImageSetCacheSize (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        CacheSize
+  )
+{
+  ASSERT (Context != NULL);
+
+  InternalTrimChunkCache (Context, CacheSize);
+  Context->CacheBudget = CacheSize;
+}
+
 VOID
 OcAppleDiskImageFreeFile (
   IN OC_APPLE_DISK_IMAGE_CONTEXT  *Context
   )
 {
-  OcAppleRamDiskFree (Context->ExtentTable);
+  OcAppleRamDiskFree (Context->RamDisk.ExtentTable);
   OcAppleDiskImageFreeContext (Context);
 }
 
 BOOLEAN
 OcAppleDiskImageRead (
-  IN  OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
-  IN  UINTN                        Lba,
-  IN  UINTN                        BufferSize,
-  OUT VOID                         *Buffer
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        Lba,
+  IN     UINTN                        BufferSize,
+  OUT    VOID                         *Buffer
   )
 {
   BOOLEAN                     Result;
@@ -294,7 +337,7 @@ OcAppleDiskImageRead (
   UINT64                      ChunkLength;
   UINT64                      ChunkOffset;
   UINT8                       *ChunkData;
-  UINT8                       *ChunkDataCompressed;
+  BOOLEAN                     ChunkCached;
 
   UINTN                       LbaCurrent;
   UINTN                       LbaOffset;
@@ -303,8 +346,6 @@ OcAppleDiskImageRead (
   UINTN                       BufferChunkSize;
   UINT8                       *BufferCurrent;
 
-  UINTN                       OutSize;
-
   ASSERT (Context != NULL);
   ASSERT (Buffer != NULL);
   ASSERT (Lba < Context->SectorCount);
@@ -355,7 +396,7 @@ OcAppleDiskImageRead (
       case APPLE_DISK_IMAGE_CHUNK_TYPE_RAW:
       {
         Result = OcAppleRamDiskRead (
-                   Context->ExtentTable,
+                   &Context->RamDisk,
                    (UINTN)(Chunk->CompressedOffset + ChunkOffset),
                    BufferChunkSize,
                    BufferCurrent
@@ -369,36 +410,21 @@ OcAppleDiskImageRead (
 
       case APPLE_DISK_IMAGE_CHUNK_TYPE_ZLIB:
       {
-        ChunkData = AllocatePool ((UINTN)(ChunkTotalLength + Chunk->CompressedLength));
+        ChunkData = InternalGetDecompressedChunk (
+                      Context,
+                      Chunk,
+                      (UINTN)ChunkTotalLength,
+                      &ChunkCached
+                      );
         if (ChunkData == NULL) {
           return FALSE;
         }
 
-        ChunkDataCompressed = (ChunkData + (UINTN)ChunkTotalLength);
-        Result = OcAppleRamDiskRead (
-                   Context->ExtentTable,
-                   (UINTN)Chunk->CompressedOffset,
-                   (UINTN)Chunk->CompressedLength,
-                   ChunkDataCompressed
-                   );
-        if (!Result) {
-          FreePool (ChunkData);
-          return FALSE;
-        }
+        CopyMem (BufferCurrent, (ChunkData + ChunkOffset), BufferChunkSize);
 
-        OutSize = DecompressZLIB (
-                    ChunkData,
-                    (UINTN)ChunkTotalLength,
-                    ChunkDataCompressed,
-                    (UINTN)Chunk->CompressedLength
-                    );
-        if (OutSize != (UINTN)ChunkTotalLength) {
+        if (!ChunkCached) {
           FreePool (ChunkData);
-          return FALSE;
         }
-
-        CopyMem (BufferCurrent, (ChunkData + ChunkOffset), BufferChunkSize);
-        FreePool (ChunkData);
         break;
       }
 
@@ -13,56 +13,17 @@
 #include <Uefi.h>
 
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleDiskImageLib.h>
+#include <Library/OcAppleRamDiskLib.h>
+#include <Library/OcCompressionLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcXmlLib.h>
 
 #include "OcAppleDiskImageLibInternal.h"
 
-STATIC
-BOOLEAN
-InternalFindPlistDictChild (
-  IN  XML_NODE  *Node,
-  IN  CHAR8     *KeyName,
-  OUT XML_NODE  **Key,
-  OUT XML_NODE  **Value
-  )
-{
-  UINT32      ChildCount;
-  XML_NODE    *ChildValue;
-  XML_NODE    *ChildKey;
-  CONST CHAR8 *ChildKeyName;
-  UINT32      Index;
-
-  ASSERT (Node != NULL);
-  ASSERT (KeyName != NULL);
-  ASSERT (Key != NULL);
-  ASSERT (Value != NULL);
-
-  ChildCount = PlistDictChildren (Node);
-  for (Index = 0; Index < ChildCount; ++Index) {
-    ChildKey = PlistDictChild (Node, Index, &ChildValue);
-    if (ChildKey == NULL) {
-      break;
-    }
-
-    ChildKeyName = PlistKeyValue (ChildKey);
-    if (ChildKeyName == NULL) {
-      break;
-    }
-
-    if (AsciiStrCmp (ChildKeyName, KeyName) == 0) {
-      *Key   = ChildKey;
-      *Value = ChildValue;
-      return TRUE;
-    }
-  }
-
-  return FALSE;
-}
-
 STATIC
 BOOLEAN
 InternalSwapBlockData (
@@ -175,13 +136,10 @@ InternalParsePlist (
 
   XML_DOCUMENT                *XmlPlistDoc;
   XML_NODE                    *NodeRoot;
-  XML_NODE                    *NodeResourceForkKey;
   XML_NODE                    *NodeResourceForkValue;
-  XML_NODE                    *NodeBlockListKey;
   XML_NODE                    *NodeBlockListValue;
 
   XML_NODE                    *NodeBlockDict;
-  XML_NODE                    *BlockDictChildKey;
   XML_NODE                    *BlockDictChildValue;
   UINT32                      BlockDictChildDataSize;
 
@@ -213,23 +171,15 @@ InternalParsePlist (
     goto DONE_ERROR;
   }
 
-  Result = InternalFindPlistDictChild (
-             NodeRoot,
-             DMG_PLIST_RESOURCE_FORK_KEY,
-             &NodeResourceForkKey,
-             &NodeResourceForkValue
-             );
-  if (!Result) {
+  NodeResourceForkValue = PlistDictLookup (NodeRoot, DMG_PLIST_RESOURCE_FORK_KEY);
+  if (NodeResourceForkValue == NULL) {
+    Result = FALSE;
     goto DONE_ERROR;
   }
 
-  Result = InternalFindPlistDictChild (
-             NodeResourceForkValue,
-             DMG_PLIST_BLOCK_LIST_KEY,
-             &NodeBlockListKey,
-             &NodeBlockListValue
-             );
-  if (!Result) {
+  NodeBlockListValue = PlistDictLookup (NodeResourceForkValue, DMG_PLIST_BLOCK_LIST_KEY);
+  if (NodeBlockListValue == NULL) {
+    Result = FALSE;
     goto DONE_ERROR;
   }
 
@@ -253,13 +203,9 @@ InternalParsePlist (
   for (Index = 0; Index < NumDmgBlocks; ++Index) {
     NodeBlockDict = XmlNodeChild (NodeBlockListValue, Index);
 
-    Result = InternalFindPlistDictChild (
-               NodeBlockDict,
-               DMG_PLIST_DATA,
-               &BlockDictChildKey,
-               &BlockDictChildValue
-               );
-    if (!Result) {
+    BlockDictChildValue = PlistDictLookup (NodeBlockDict, DMG_PLIST_DATA);
+    if (BlockDictChildValue == NULL) {
+      Result = FALSE;
       goto DONE_ERROR;
     }
 
@@ -320,7 +266,121 @@ DONE_ERROR:
 }
 
 BOOLEAN
-InternalGetBlockChunk (
+InternalBuildChunkEntries (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context
+  )
+{
+  BOOLEAN                         Result;
+  UINT32                          BlockIndex;
+  UINT32                          ChunkIndex;
+  UINT32                          EntryCount;
+  UINT32                          EntriesSize;
+  UINT32                          Index;
+  UINT64                          SectorTop;
+  APPLE_DISK_IMAGE_BLOCK_DATA     *BlockData;
+  APPLE_DISK_IMAGE_CHUNK          *BlockChunk;
+  OC_APPLE_DISK_IMAGE_CHUNK_ENTRY *Entries;
+  OC_APPLE_DISK_IMAGE_CHUNK_ENTRY Entry;
+
+  ASSERT (Context != NULL);
+
+  EntryCount = 0;
+  for (BlockIndex = 0; BlockIndex < Context->BlockCount; ++BlockIndex) {
+    Result = OcOverflowAddU32 (
+               EntryCount,
+               Context->Blocks[BlockIndex]->ChunkCount,
+               &EntryCount
+               );
+    if (Result) {
+      return FALSE;
+    }
+  }
+
+  if (EntryCount == 0) {
+    Context->ChunkEntries        = NULL;
+    Context->ChunkEntryCount     = 0;
+    Context->LastChunkEntry      = 0;
+    Context->ChunkEntriesOverlap = FALSE;
+    return TRUE;
+  }
+
+  Result = OcOverflowMulU32 (EntryCount, sizeof (*Entries), &EntriesSize);
+  if (Result) {
+    return FALSE;
+  }
+
+  Entries = AllocatePool (EntriesSize);
+  if (Entries == NULL) {
+    return FALSE;
+  }
+
+  EntryCount = 0;
+  for (BlockIndex = 0; BlockIndex < Context->BlockCount; ++BlockIndex) {
+    BlockData = Context->Blocks[BlockIndex];
+
+    for (ChunkIndex = 0; ChunkIndex < BlockData->ChunkCount; ++ChunkIndex) {
+      BlockChunk = &BlockData->Chunks[ChunkIndex];
+
+      //
+      // Chunks only match within their block range. Comment and terminator
+      // chunks cover no sectors and can never match.
+      //
+      Entry.SectorStart = MAX (
+        DMG_SECTOR_START_ABS (BlockData, BlockChunk),
+        BlockData->SectorNumber
+        );
+      Entry.SectorTop = MIN (
+        DMG_SECTOR_START_ABS (BlockData, BlockChunk) + BlockChunk->SectorCount,
+        BlockData->SectorNumber + BlockData->SectorCount
+        );
+      if (Entry.SectorStart >= Entry.SectorTop) {
+        continue;
+      }
+
+      Entry.BlockData = BlockData;
+      Entry.Chunk     = BlockChunk;
+
+      //
+      // Chunks normally come in ascending order, so insertion sort is linear.
+      //
+      Index = EntryCount;
+      while (Index > 0 && Entries[Index - 1].SectorStart > Entry.SectorStart) {
+        CopyMem (&Entries[Index], &Entries[Index - 1], sizeof (*Entries));
+        --Index;
+      }
+
+      CopyMem (&Entries[Index], &Entry, sizeof (*Entries));
+      ++EntryCount;
+    }
+  }
+
+  //
+  // Valid images have disjoint chunk ranges, so the entry found by binary
+  // search is the only match. Overlapping ranges fall back to a sequential
+  // walk, which matches the first chunk in block order.
+  //
+  Context->ChunkEntriesOverlap = FALSE;
+  SectorTop                    = 0;
+  for (Index = 0; Index < EntryCount; ++Index) {
+    if (Entries[Index].SectorStart < SectorTop) {
+      DEBUG ((DEBUG_INFO, "OCDI: Overlapping chunk at sector %Lu\n", Entries[Index].SectorStart));
+      Context->ChunkEntriesOverlap = TRUE;
+      break;
+    }
+
+    SectorTop = Entries[Index].SectorTop;
+  }
+
+  Context->ChunkEntries    = Entries;
+  Context->ChunkEntryCount = EntryCount;
+  Context->LastChunkEntry  = 0;
+
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+InternalWalkBlockChunks (
   IN  OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
   IN  UINTN                        Lba,
   OUT APPLE_DISK_IMAGE_BLOCK_DATA  **Data,
@@ -352,3 +412,238 @@ InternalGetBlockChunk (
 
   return FALSE;
 }
+
+BOOLEAN
+InternalGetBlockChunk (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        Lba,
+  OUT    APPLE_DISK_IMAGE_BLOCK_DATA  **Data,
+  OUT    APPLE_DISK_IMAGE_CHUNK       **Chunk
+  )
+{
+  OC_APPLE_DISK_IMAGE_CHUNK_ENTRY *Entries;
+  UINT32                          Index;
+  UINT32                          Low;
+  UINT32                          High;
+  UINT32                          Middle;
+
+  Entries = Context->ChunkEntries;
+  Index   = Context->LastChunkEntry;
+
+  if (Context->ChunkEntriesOverlap) {
+    return InternalWalkBlockChunks (Context, Lba, Data, Chunk);
+  }
+
+  if (Context->ChunkEntryCount == 0) {
+    return FALSE;
+  }
+
+  //
+  // Sequential access hits either the last used chunk or the next one.
+  //
+  if (Lba >= Entries[Index].SectorStart) {
+    if (Lba < Entries[Index].SectorTop) {
+      *Data  = Entries[Index].BlockData;
+      *Chunk = Entries[Index].Chunk;
+      return TRUE;
+    }
+
+    ++Index;
+    if (Index < Context->ChunkEntryCount
+      && Lba >= Entries[Index].SectorStart
+      && Lba < Entries[Index].SectorTop) {
+      Context->LastChunkEntry = Index;
+      *Data  = Entries[Index].BlockData;
+      *Chunk = Entries[Index].Chunk;
+      return TRUE;
+    }
+  }
+
+  //
+  // Find the last entry starting at or before Lba.
+  //
+  Low  = 0;
+  High = Context->ChunkEntryCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Entries[Middle].SectorStart <= Lba) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if (Low == 0) {
+    return FALSE;
+  }
+
+  Index = Low - 1;
+  if (Lba >= Entries[Index].SectorTop) {
+    return FALSE;
+  }
+
+  Context->LastChunkEntry = Index;
+  *Data  = Entries[Index].BlockData;
+  *Chunk = Entries[Index].Chunk;
+  return TRUE;
+}
+
+STATIC
+VOID
+InternalEvictCachedChunk (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context
+  )
+{
+  OC_APPLE_DISK_IMAGE_CACHE_ENTRY *Entries;
+  UINT32                          Index;
+  UINT32                          Oldest;
+
+  ASSERT (Context->CacheEntryCount > 0);
+
+  Entries = Context->CacheEntries;
+
+  //
+  // Ages are computed relative to the current tick to survive wraparound.
+  //
+  Oldest = 0;
+  for (Index = 1; Index < Context->CacheEntryCount; ++Index) {
+    if ((Context->CacheTick - Entries[Index].LastUse)
+      > (Context->CacheTick - Entries[Oldest].LastUse)) {
+      Oldest = Index;
+    }
+  }
+
+  Context->CacheUsed -= Entries[Oldest].Size;
+  FreePool (Entries[Oldest].Data);
+
+  --Context->CacheEntryCount;
+  if (Oldest != Context->CacheEntryCount) {
+    CopyMem (
+      &Entries[Oldest],
+      &Entries[Context->CacheEntryCount],
+      sizeof (Entries[Oldest])
+      );
+  }
+}
+
+VOID
+InternalTrimChunkCache (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        Budget
+  )
+{
+  ASSERT (Context != NULL);
+
+  while (Context->CacheEntryCount > 0 && Context->CacheUsed > Budget) {
+    InternalEvictCachedChunk (Context);
+  }
+}
+
+UINT8 *
+InternalGetDecompressedChunk (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     CONST APPLE_DISK_IMAGE_CHUNK *Chunk,
+  IN     UINTN                        ChunkSize,
+  OUT    BOOLEAN                      *Cached
+  )
+{
+  BOOLEAN                         Result;
+  OC_APPLE_DISK_IMAGE_CACHE_ENTRY *Entry;
+  UINT32                          Index;
+  UINT8                           *ChunkData;
+  UINT8                           *ChunkDataCompressed;
+  UINTN                           OutSize;
+  UINTN                           MappedSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (Chunk != NULL);
+  ASSERT (Cached != NULL);
+
+  for (Index = 0; Index < Context->CacheEntryCount; ++Index) {
+    Entry = &Context->CacheEntries[Index];
+    if (Entry->Chunk == Chunk) {
+      Entry->LastUse = ++Context->CacheTick;
+      *Cached = TRUE;
+      return Entry->Data;
+    }
+  }
+
+  ChunkData = AllocatePool (ChunkSize);
+  if (ChunkData == NULL) {
+    return NULL;
+  }
+
+  //
+  // Decompress straight from the RAM disk when the compressed data does not
+  // cross an extent boundary, which is the common case.
+  //
+  ChunkDataCompressed = OcAppleRamDiskMapRange (
+                          &Context->RamDisk,
+                          (UINTN)Chunk->CompressedOffset,
+                          (UINTN)Chunk->CompressedLength,
+                          &MappedSize
+                          );
+  if (ChunkDataCompressed != NULL
+   && MappedSize == (UINTN)Chunk->CompressedLength) {
+    OutSize = DecompressZLIB (
+                ChunkData,
+                ChunkSize,
+                ChunkDataCompressed,
+                (UINTN)Chunk->CompressedLength
+                );
+  } else {
+    ChunkDataCompressed = AllocatePool ((UINTN)Chunk->CompressedLength);
+    if (ChunkDataCompressed == NULL) {
+      FreePool (ChunkData);
+      return NULL;
+    }
+
+    Result = OcAppleRamDiskRead (
+               &Context->RamDisk,
+               (UINTN)Chunk->CompressedOffset,
+               (UINTN)Chunk->CompressedLength,
+               ChunkDataCompressed
+               );
+    if (!Result) {
+      FreePool (ChunkDataCompressed);
+      FreePool (ChunkData);
+      return NULL;
+    }
+
+    OutSize = DecompressZLIB (
+                ChunkData,
+                ChunkSize,
+                ChunkDataCompressed,
+                (UINTN)Chunk->CompressedLength
+                );
+    FreePool (ChunkDataCompressed);
+  }
+
+  if (OutSize != ChunkSize) {
+    FreePool (ChunkData);
+    return NULL;
+  }
+
+  if (ChunkSize > Context->CacheBudget) {
+    *Cached = FALSE;
+    return ChunkData;
+  }
+
+  if (Context->CacheEntryCount == ARRAY_SIZE (Context->CacheEntries)) {
+    InternalEvictCachedChunk (Context);
+  }
+
+  InternalTrimChunkCache (Context, Context->CacheBudget - ChunkSize);
+
+  Entry = &Context->CacheEntries[Context->CacheEntryCount];
+  Entry->Chunk   = Chunk;
+  Entry->Data    = ChunkData;
+  Entry->Size    = ChunkSize;
+  Entry->LastUse = ++Context->CacheTick;
+
+  ++Context->CacheEntryCount;
+  Context->CacheUsed += ChunkSize;
+
+  *Cached = TRUE;
+  return ChunkData;
+}
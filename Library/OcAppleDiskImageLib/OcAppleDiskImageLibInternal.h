@@ -37,12 +37,55 @@ InternalParsePlist (
   OUT APPLE_DISK_IMAGE_BLOCK_DATA  ***Blocks
   );
 
+/**
+  Build sorted sector to chunk lookup table for context blocks.
+
+  @param[in,out] Context  Disk image context with parsed blocks.
+
+  @return  TRUE on success.
+**/
+BOOLEAN
+InternalBuildChunkEntries (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context
+  );
+
 BOOLEAN
 InternalGetBlockChunk (
-  IN  OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
-  IN  UINTN                        Lba,
-  OUT APPLE_DISK_IMAGE_BLOCK_DATA  **Data,
-  OUT APPLE_DISK_IMAGE_CHUNK       **Chunk
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        Lba,
+  OUT    APPLE_DISK_IMAGE_BLOCK_DATA  **Data,
+  OUT    APPLE_DISK_IMAGE_CHUNK       **Chunk
+  );
+
+/**
+  Obtain decompressed chunk data, possibly from cache.
+
+  @param[in,out] Context      Disk image context.
+  @param[in]     Chunk        Compressed chunk to decompress.
+  @param[in]     ChunkSize    Decompressed chunk size.
+  @param[out]    Cached       Set to TRUE when returned data is owned by cache.
+                              Otherwise it is to be freed by the caller.
+
+  @return  decompressed chunk data or NULL.
+**/
+UINT8 *
+InternalGetDecompressedChunk (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     CONST APPLE_DISK_IMAGE_CHUNK *Chunk,
+  IN     UINTN                        ChunkSize,
+  OUT    BOOLEAN                      *Cached
+  );
+
+/**
+  Release cached chunks until the cache fits into Budget.
+
+  @param[in,out] Context  Disk image context.
+  @param[in]     Budget   Target cache size in bytes.
+**/
+VOID
+InternalTrimChunkCache (
+  IN OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     UINTN                        Budget
   );
 
 #endif // APPLE_DISK_IMAGE_LIB_INTERNAL_H
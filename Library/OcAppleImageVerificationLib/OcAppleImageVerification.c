@@ -39,6 +39,12 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <IndustryStandard/PeImage.h>
 #include <Guid/AppleCertificate.h>
 
+//
+// RSA verification contexts of the Apple public keys, initialised on first use.
+//
+STATIC OC_RSA_VERIFY_CONTEXT mPkContexts[NUM_OF_PK];
+STATIC BOOLEAN               mPkContextsReady[NUM_OF_PK];
+
 EFI_STATUS
 BuildPeContext (
   VOID                                *Image,
@@ -586,7 +592,7 @@ VerifyApplePeImageSignature (
 {
   UINTN                              Index             = 0;
   APPLE_SIGNATURE_CONTEXT            *SignatureContext = NULL;
-  OC_RSA_PUBLIC_KEY                  *Pk               = NULL;
+  OC_RSA_VERIFY_CONTEXT              *PkContext        = NULL;
   APPLE_PE_COFF_LOADER_IMAGE_CONTEXT *Context          = NULL;
 
   Context = AllocateZeroPool (sizeof (APPLE_PE_COFF_LOADER_IMAGE_CONTEXT));
@@ -644,13 +650,22 @@ VerifyApplePeImageSignature (
   for (Index = 0; Index < NUM_OF_PK; Index++) {
     if (CompareMem (PkDataBase[Index].Hash, SignatureContext->PublicKeyHash, 32) == 0) {
       //
-      // PublicKey valid. Extract prepared publickey from database
+      // PublicKey valid. Use verification context of prepared publickey from database
       //
-      Pk = (OC_RSA_PUBLIC_KEY *) PkDataBase[Index].PublicKey;
+      if (!mPkContextsReady[Index]) {
+        mPkContextsReady[Index] = RsaVerifyContextInitFromKey (
+                                    &mPkContexts[Index],
+                                    PkDataBase[Index].PublicKey
+                                    );
+      }
+
+      if (mPkContextsReady[Index]) {
+        PkContext = &mPkContexts[Index];
+      }
     }
   }
 
-  if (Pk == NULL) {
+  if (PkContext == NULL) {
     DEBUG ((DEBUG_WARN, "Unknown publickey or malformed certificate\n"));
     FreePool (SignatureContext);
     FreePool (Context);
@@ -660,7 +675,7 @@ VerifyApplePeImageSignature (
   //
   // Verify signature
   //
-  if (RsaVerifySigHashFromKey (Pk, SignatureContext->Signature, sizeof (SignatureContext->Signature), Context->PeImageHash, sizeof (Context->PeImageHash), OcSigHashTypeSha256) == 1 ) {
+  if (RsaVerifySigHashFromContext (PkContext, SignatureContext->Signature, sizeof (SignatureContext->Signature), Context->PeImageHash, sizeof (Context->PeImageHash), OcSigHashTypeSha256) == 1 ) {
     DEBUG ((DEBUG_INFO, "Signature verified!\n"));
     FreePool (SignatureContext);
     FreePool (Context);
@@ -672,3 +687,30 @@ VerifyApplePeImageSignature (
 
   return EFI_SECURITY_VIOLATION;
 }
+
+/**
+  Free the verification contexts of the Apple public keys.
+
+  @param[in] ImageHandle  The firmware allocated handle for the EFI image.
+  @param[in] SystemTable  A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS  The destructor always returns EFI_SUCCESS.
+**/
+EFI_STATUS
+EFIAPI
+OcAppleImageVerificationLibDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < NUM_OF_PK; Index++) {
+    if (mPkContextsReady[Index]) {
+      RsaVerifyContextFree (&mPkContexts[Index]);
+      mPkContextsReady[Index] = FALSE;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
@@ -31,6 +31,87 @@
 GLOBAL_REMOVE_IF_UNREFERENCED const uint8_t *DERImg4RootCertificate     = gAppleX86SecureBootRootCaCert;
 GLOBAL_REMOVE_IF_UNREFERENCED const size_t  *DERImg4RootCertificateSize = &gAppleX86SecureBootRootCaCertSize;
 
+//
+// Maximum amount of cached RSA verification contexts. Img4 verification
+// uses the root, the intermediate and the manifest keys.
+//
+#define IMG4_MAX_RSA_CONTEXTS  4
+
+//
+// RSA verification context cached by its public key.
+//
+typedef struct {
+  UINT8                  *Modulus;
+  UINTN                  ModulusSize;
+  UINT32                 Exponent;
+  OC_RSA_VERIFY_CONTEXT  Context;
+} IMG4_RSA_CONTEXT_ENTRY;
+
+STATIC IMG4_RSA_CONTEXT_ENTRY  mImg4RsaContexts[IMG4_MAX_RSA_CONTEXTS];
+STATIC UINT32                  mImg4RsaContextNext;
+
+STATIC
+VOID
+InternalFreeRsaContext (
+  IN OUT IMG4_RSA_CONTEXT_ENTRY  *Entry
+  )
+{
+  if (Entry->Modulus != NULL) {
+    FreePool (Entry->Modulus);
+    RsaVerifyContextFree (&Entry->Context);
+    Entry->Modulus = NULL;
+  }
+}
+
+/**
+  Get RSA verification context for a public key, initialising it on first use.
+
+  @retval RSA verification context or NULL on failure.
+**/
+STATIC
+OC_RSA_VERIFY_CONTEXT *
+InternalGetRsaContext (
+  IN CONST UINT8  *Modulus,
+  IN UINTN        ModulusSize,
+  IN UINT32       Exponent
+  )
+{
+  IMG4_RSA_CONTEXT_ENTRY  *Entry;
+  UINT32                  Index;
+
+  for (Index = 0; Index < IMG4_MAX_RSA_CONTEXTS; ++Index) {
+    Entry = &mImg4RsaContexts[Index];
+    if (Entry->Modulus != NULL
+      && Entry->ModulusSize == ModulusSize
+      && Entry->Exponent == Exponent
+      && CompareMem (Entry->Modulus, Modulus, ModulusSize) == 0) {
+      return &Entry->Context;
+    }
+  }
+
+  //
+  // Replace the entries in order of insertion.
+  //
+  Entry = &mImg4RsaContexts[mImg4RsaContextNext];
+  mImg4RsaContextNext = (mImg4RsaContextNext + 1) % IMG4_MAX_RSA_CONTEXTS;
+  InternalFreeRsaContext (Entry);
+
+  Entry->Modulus = AllocateCopyPool (ModulusSize, Modulus);
+  if (Entry->Modulus == NULL) {
+    return NULL;
+  }
+
+  if (!RsaVerifyContextInitFromData (&Entry->Context, Modulus, ModulusSize, Exponent)) {
+    FreePool (Entry->Modulus);
+    Entry->Modulus = NULL;
+    return NULL;
+  }
+
+  Entry->ModulusSize = ModulusSize;
+  Entry->Exponent    = Exponent;
+  return &Entry->Context;
+}
+
 bool
 DERImg4VerifySignature (
   DERByte        *Modulus,
@@ -43,7 +124,8 @@ DERImg4VerifySignature (
   const DERItem  *AlgoOid
   )
 {
-  OC_SIG_HASH_TYPE AlgoType;
+  OC_SIG_HASH_TYPE      AlgoType;
+  OC_RSA_VERIFY_CONTEXT *Context;
 
   ASSERT (Modulus != NULL);
   ASSERT (ModulusSize > 0);
@@ -63,10 +145,13 @@ DERImg4VerifySignature (
     return false;
   }
 
-  return RsaVerifySigDataFromData (
-           Modulus,
-           ModulusSize,
-           Exponent,
+  Context = InternalGetRsaContext (Modulus, ModulusSize, Exponent);
+  if (Context == NULL) {
+    return false;
+  }
+
+  return RsaVerifySigDataFromContext (
+           Context,
            Signature,
            SignatureSize,
            Data,
@@ -320,3 +405,23 @@ AppleImg4Verify (
 
   return EFI_SUCCESS;
 }
+
+/**
+  Free the cached RSA verification contexts.
+
+  @retval RETURN_SUCCESS  The destructor always returns RETURN_SUCCESS.
+**/
+RETURN_STATUS
+EFIAPI
+OcAppleImg4LibDestructor (
+  VOID
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < IMG4_MAX_RSA_CONTEXTS; ++Index) {
+    InternalFreeRsaContext (&mImg4RsaContexts[Index]);
+  }
+
+  return RETURN_SUCCESS;
+}
@@ -18,6 +18,7 @@
 #include <IndustryStandard/AppleFatBinaryImage.h>
 
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleKernelLib.h>
@@ -30,6 +31,11 @@
 //
 #define KERNEL_HEADER_SIZE (EFI_PAGE_SIZE*2)
 
+//
+// Compressed kernel is read and decompressed in windows of this size.
+//
+#define KERNEL_COMPRESSED_WINDOW_SIZE BASE_1MB
+
 STATIC
 RETURN_STATUS
 ReplaceBuffer (
@@ -133,15 +139,23 @@ ParseCompressedHeader (
   IN     UINT32             ReservedSize
   )
 {
-  RETURN_STATUS       Status;
-
-  UINT32            KernelSize;
-  MACH_COMP_HEADER  *CompHeader;
-  UINT8             *CompressedBuffer;
-  UINT32            CompressionType;
-  UINT32            CompressedSize;
-  UINT32            DecompressedSize;
-  UINT32            DecompressedHash;
+  RETURN_STATUS         Status;
+
+  UINT32                KernelSize;
+  MACH_COMP_HEADER      *CompHeader;
+  UINT8                 *Window;
+  OC_DECOMPRESS_STREAM  *Stream;
+  UINT32                CompressionType;
+  UINT32                CompressedSize;
+  UINT32                DecompressedSize;
+  UINT32                DecompressedHash;
+  UINT32                Hash;
+  UINT32                ReadOffset;
+  UINT32                ReadSize;
+  UINT32                Remaining;
+  UINT32                Pending;
+  UINT32                Consumed;
+  UINT32                Produced;
 
   CompHeader       = (MACH_COMP_HEADER *)*Buffer;
   CompressionType  = CompHeader->Compression;
@@ -159,41 +173,84 @@ ParseCompressedHeader (
     return KernelSize;
   }
 
+  if (CompressionType == MACH_COMPRESSED_BINARY_INVERT_LZVN) {
+    CompressionType = OC_DECOMPRESS_STREAM_LZVN;
+  } else if (CompressionType == MACH_COMPRESSED_BINARY_INVERT_LZSS) {
+    CompressionType = OC_DECOMPRESS_STREAM_LZSS;
+  } else {
+    DEBUG ((DEBUG_INFO, "Comp kernel unsupported compression %08X at %08X\n", CompressionType, Offset));
+    return KernelSize;
+  }
+
   Status = ReplaceBuffer (DecompressedSize, Buffer, AllocatedSize, ReservedSize);
   if (RETURN_ERROR (Status)) {
     DEBUG ((DEBUG_INFO, "Decomp kernel (%u bytes) cannot be allocated at %08X\n", DecompressedSize, Offset));
     return KernelSize;
   }
 
-  CompressedBuffer = AllocatePool (CompressedSize);
-  if (CompressedBuffer == NULL) {
-    DEBUG ((DEBUG_INFO, "Comp kernel (%u bytes) cannot be allocated at %08X\n", CompressedSize, Offset));
+  Window = AllocatePool (MIN (CompressedSize, KERNEL_COMPRESSED_WINDOW_SIZE));
+  if (Window == NULL) {
+    DEBUG ((DEBUG_INFO, "Comp kernel window cannot be allocated at %08X\n", Offset));
     return KernelSize;
   }
 
-  Status = GetFileData (File, Offset + sizeof (MACH_COMP_HEADER), CompressedSize, CompressedBuffer);
-  if (RETURN_ERROR (Status)) {
-    DEBUG ((DEBUG_INFO, "Comp kernel (%u bytes) cannot be read at %08X\n", CompressedSize, Offset));
-    FreePool (CompressedBuffer);
+  Stream = DecompressStreamCreate (CompressionType, *Buffer, DecompressedSize);
+  if (Stream == NULL) {
+    DEBUG ((DEBUG_INFO, "Comp kernel stream cannot be allocated at %08X\n", Offset));
+    FreePool (Window);
     return KernelSize;
   }
 
-  if (CompressionType == MACH_COMPRESSED_BINARY_INVERT_LZVN) {
-    KernelSize = (UINT32)DecompressLZVN (*Buffer, DecompressedSize, CompressedBuffer, CompressedSize);
-  } else if (CompressionType == MACH_COMPRESSED_BINARY_INVERT_LZSS) {
-    KernelSize = (UINT32)DecompressLZSS (*Buffer, DecompressedSize, CompressedBuffer, CompressedSize);
-  }
+  //
+  // Read the compressed image window by window, keeping the incomplete
+  // trailing token of every window for the next one. Checksum the output
+  // while it is still in cache.
+  //
+  ReadOffset = Offset + sizeof (MACH_COMP_HEADER);
+  Remaining  = CompressedSize;
+  Pending    = 0;
+  Hash       = 1;
 
-  if (KernelSize != DecompressedSize) {
-    KernelSize = 0;
+  while (TRUE) {
+    ReadSize = MIN (Remaining, KERNEL_COMPRESSED_WINDOW_SIZE - Pending);
+    Status   = GetFileData (File, ReadOffset, ReadSize, &Window[Pending]);
+    if (RETURN_ERROR (Status)) {
+      DEBUG ((DEBUG_INFO, "Comp kernel (%u bytes) cannot be read at %08X\n", ReadSize, ReadOffset));
+      break;
+    }
+
+    ReadOffset += ReadSize;
+    Remaining  -= ReadSize;
+    Pending    += ReadSize;
+
+    Consumed   = DecompressStreamUpdate (Stream, Window, Pending, &Produced);
+    Hash       = Adler32 (Hash, *Buffer + KernelSize, Produced - KernelSize);
+    KernelSize = Produced;
+
+    Pending -= Consumed;
+    CopyMem (Window, &Window[Consumed], Pending);
+
+    if (Remaining == 0 || KernelSize == DecompressedSize) {
+      break;
+    }
+
+    if (Pending == KERNEL_COMPRESSED_WINDOW_SIZE) {
+      DEBUG ((DEBUG_INFO, "Comp kernel stalled at %08X\n", ReadOffset));
+      break;
+    }
   }
 
-  //
-  // TODO: implement adler32 hash verification.
-  //
-  (VOID) DecompressedHash;
+  DecompressStreamFree (Stream);
+  FreePool (Window);
 
-  FreePool (CompressedBuffer);
+  if (RETURN_ERROR (Status) || KernelSize != DecompressedSize) {
+    return 0;
+  }
+
+  if (Hash != DecompressedHash) {
+    DEBUG ((DEBUG_INFO, "Comp kernel adler32 %08X mismatch %08X at %08X\n", Hash, DecompressedHash, Offset));
+    return 0;
+  }
 
   return KernelSize;
 }
@@ -19,6 +19,7 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleKernelLib.h>
 #include <Library/OcMachoLib.h>
 #include <Library/OcMiscLib.h>
@@ -118,19 +119,24 @@ PatcherGetSymbolAddress (
   return RETURN_SUCCESS;
 }
 
+STATIC
 RETURN_STATUS
-PatcherApplyGenericPatch (
+InternalPrepareGenericPatch (
   IN OUT PATCHER_CONTEXT        *Context,
-  IN     PATCHER_GENERIC_PATCH  *Patch
+  IN     PATCHER_GENERIC_PATCH  *Patch,
+     OUT OC_DATA_PATCH          *DataPatch
   )
 {
   RETURN_STATUS  Status;
+  UINT8          *Header;
   UINT8          *Base;
   UINT32         Size;
-  UINT32         ReplaceCount;
 
-  Base = (UINT8 *)MachoGetMachHeader64 (&Context->MachContext);
-  Size = MachoGetFileSize (&Context->MachContext);
+  ZeroMem (DataPatch, sizeof (*DataPatch));
+
+  Header = (UINT8 *)MachoGetMachHeader64 (&Context->MachContext);
+  Base   = Header;
+  Size   = MachoGetFileSize (&Context->MachContext);
   if (Patch->Base != NULL) {
     Status = PatcherGetSymbolAddress (Context, Patch->Base, &Base);
     if (RETURN_ERROR (Status)) {
@@ -143,11 +149,38 @@ PatcherApplyGenericPatch (
       return Status;
     }
 
-    Size -= (UINT32)(Base - (UINT8 *)MachoGetMachHeader64 (&Context->MachContext));
+    Size -= (UINT32)(Base - Header);
+  }
+
+  if (Patch->Find != NULL && Patch->Limit > 0 && Patch->Limit < Size) {
+    Size = Patch->Limit;
   }
 
+  DataPatch->Pattern     = Patch->Find;
+  DataPatch->PatternMask = Patch->Mask;
+  DataPatch->Replace     = Patch->Replace;
+  //
+  // Data written to base ignores the replace mask.
+  //
+  DataPatch->ReplaceMask = Patch->Find != NULL ? Patch->ReplaceMask : NULL;
+  DataPatch->Size        = Patch->Size;
+  DataPatch->DataOff     = (UINT32)(Base - Header);
+  DataPatch->DataSize    = Size;
+  DataPatch->Count       = Patch->Count;
+  DataPatch->Skip        = Patch->Skip;
+
+  return RETURN_SUCCESS;
+}
+
+STATIC
+RETURN_STATUS
+InternalReportGenericPatch (
+  IN PATCHER_GENERIC_PATCH  *Patch,
+  IN OC_DATA_PATCH          *DataPatch
+  )
+{
   if (Patch->Find == NULL) {
-    if (Size < Patch->Size) {
+    if (DataPatch->ReplaceCount == 0) {
       DEBUG ((
         DEBUG_INFO,
         "OCAK: %a is borked, not found\n",
@@ -155,50 +188,135 @@ PatcherApplyGenericPatch (
         ));
       return RETURN_NOT_FOUND;
     }
-    CopyMem (Base, Patch->Replace, Patch->Size);
     return RETURN_SUCCESS;
   }
 
-  if (Patch->Limit > 0 && Patch->Limit < Size) {
-    Size = Patch->Limit;
-  }
-
-  ReplaceCount = ApplyPatch (
-    Patch->Find,
-    Patch->Mask,
-    Patch->Size,
-    Patch->Replace,
-    Patch->ReplaceMask,
-    Base,
-    Size,
-    Patch->Count,
-    Patch->Skip
-    );
-
   DEBUG ((
     DEBUG_INFO,
     "OCAK: %a replace count - %u\n",
     Patch->Comment != NULL ? Patch->Comment : "Patch",
-    ReplaceCount
+    DataPatch->ReplaceCount
     ));
 
-  if (ReplaceCount > 0 && Patch->Count > 0 && ReplaceCount != Patch->Count) {
+  if (DataPatch->ReplaceCount > 0 && Patch->Count > 0 && DataPatch->ReplaceCount != Patch->Count) {
     DEBUG ((
       DEBUG_INFO,
       "OCAK: %a performed only %u replacements out of %u\n",
       Patch->Comment != NULL ? Patch->Comment : "Patch",
-      ReplaceCount,
+      DataPatch->ReplaceCount,
       Patch->Count
       ));
   }
 
-  if (ReplaceCount > 0) {
+  if (DataPatch->ReplaceCount > 0) {
     return RETURN_SUCCESS;
   }
 
   return RETURN_NOT_FOUND;
 }
 
+RETURN_STATUS
+PatcherApplyGenericPatches (
+  IN OUT PATCHER_CONTEXT        *Context,
+  IN     PATCHER_GENERIC_PATCH  *Patches,
+  IN     UINT32                 PatchCount,
+     OUT RETURN_STATUS          *Results
+  )
+{
+  RETURN_STATUS  Status;
+  OC_DATA_PATCH  *DataPatches;
+  OC_DATA_PATCH  *DataPatch;
+  OC_DATA_PATCH  SingleDataPatch;
+  UINT8          *Header;
+  UINT32         Index;
+
+  ASSERT (Context != NULL);
+  ASSERT (Patches != NULL);
+  ASSERT (Results != NULL);
+
+  if (PatchCount == 0) {
+    return RETURN_SUCCESS;
+  }
+
+  if (PatchCount == 1) {
+    DataPatches = &SingleDataPatch;
+  } else {
+    DataPatches = AllocatePool (PatchCount * sizeof (*DataPatches));
+    if (DataPatches == NULL) {
+      Status = RETURN_SUCCESS;
+      for (Index = 0; Index < PatchCount; ++Index) {
+        PatcherApplyGenericPatches (Context, &Patches[Index], 1, &Results[Index]);
+        if (RETURN_ERROR (Results[Index])) {
+          Status = Results[Index];
+        }
+      }
+      return Status;
+    }
+  }
+
+  for (Index = 0; Index < PatchCount; ++Index) {
+    Results[Index] = InternalPrepareGenericPatch (Context, &Patches[Index], &DataPatches[Index]);
+  }
+
+  Header = (UINT8 *)MachoGetMachHeader64 (&Context->MachContext);
+
+  if (!ApplyPatches (DataPatches, PatchCount, Header, MachoGetFileSize (&Context->MachContext))) {
+    //
+    // Out of memory for the batch search, fall back to patching one by one.
+    //
+    for (Index = 0; Index < PatchCount; ++Index) {
+      DataPatch = &DataPatches[Index];
+      if (DataPatch->Pattern != NULL) {
+        DataPatch->ReplaceCount = ApplyPatch (
+          DataPatch->Pattern,
+          DataPatch->PatternMask,
+          DataPatch->Size,
+          DataPatch->Replace,
+          DataPatch->ReplaceMask,
+          &Header[DataPatch->DataOff],
+          DataPatch->DataSize,
+          DataPatch->Count,
+          DataPatch->Skip
+          );
+      } else if (DataPatch->Size > 0 && DataPatch->Size <= DataPatch->DataSize) {
+        CopyMem (&Header[DataPatch->DataOff], DataPatch->Replace, DataPatch->Size);
+        DataPatch->ReplaceCount = 1;
+      } else {
+        DataPatch->ReplaceCount = 0;
+      }
+    }
+  }
+
+  Status = RETURN_SUCCESS;
+  for (Index = 0; Index < PatchCount; ++Index) {
+    if (!RETURN_ERROR (Results[Index])) {
+      Results[Index] = InternalReportGenericPatch (&Patches[Index], &DataPatches[Index]);
+    }
+
+    if (RETURN_ERROR (Results[Index])) {
+      Status = Results[Index];
+    }
+  }
+
+  if (DataPatches != &SingleDataPatch) {
+    FreePool (DataPatches);
+  }
+
+  return Status;
+}
+
+RETURN_STATUS
+PatcherApplyGenericPatch (
+  IN OUT PATCHER_CONTEXT        *Context,
+  IN     PATCHER_GENERIC_PATCH  *Patch
+  )
+{
+  RETURN_STATUS  Status;
+
+  PatcherApplyGenericPatches (Context, Patch, 1, &Status);
+  return Status;
+}
+
 RETURN_STATUS
 PatcherBlockKext (
   IN OUT PATCHER_CONTEXT        *Context
@@ -24,6 +24,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/OcAppleKernelLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcMachoLib.h>
+#include <Library/OcMiscLib.h>
 
 #include "PrelinkedInternal.h"
 
@@ -34,13 +35,120 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 // Symbols
 //
 
+/**
+  Hashes a symbol name for PRELINKED_KEXT symbol lookup (FNV-1a).
+
+  @param[in] Name    Symbol name, not necessarily null-terminated.
+  @param[in] Length  Symbol name length.
+
+  @return  Name hash.
+**/
+UINT32
+InternalHashSymbolName (
+  IN CONST CHAR8  *Name,
+  IN UINT32       Length
+  )
+{
+  return OcHashFnv1a (Name, Length);
+}
+
+/**
+  Hashes a symbol value for PRELINKED_KEXT symbol lookup.
+
+  @param[in] Value  Symbol value.
+
+  @return  Value hash.
+**/
+UINT32
+InternalHashSymbolValue (
+  IN UINT64  Value
+  )
+{
+  //
+  // Symbol values are addresses with varying low bits, Fibonacci hashing
+  // spreads them well enough.
+  //
+  return (UINT32) ((Value * 0x9E3779B97F4A7C15ULL) >> 32U);
+}
+
+STATIC
+CONST PRELINKED_KEXT_SYMBOL *
+InternalOcGetSymbolIndexedName (
+  IN PRELINKED_KEXT                   *Kext,
+  IN CONST CHAR8                      *LookupValue,
+  IN UINT32                           LookupValueLength,
+  IN UINT32                           FirstIndex
+  )
+{
+  CONST PRELINKED_KEXT_SYMBOL *Symbol;
+  UINT32                      Mask;
+  UINT32                      Slot;
+  UINT32                      Entry;
+
+  Mask = Kext->SymbolIndexSize - 1;
+  Slot = InternalHashSymbolName (LookupValue, LookupValueLength) & Mask;
+
+  //
+  // Entries are inserted in LinkedSymbolTable order, hence the first match
+  // on the probe sequence is the same symbol the linear scan would find.
+  //
+  Entry = Kext->SymbolNameIndex[Slot];
+  while (Entry != 0) {
+    if (Entry > FirstIndex) {
+      Symbol = &Kext->LinkedSymbolTable[Entry - 1];
+      if (Symbol->Length == LookupValueLength
+        && CompareMem (Symbol->Name, LookupValue, LookupValueLength) == 0) {
+        return Symbol;
+      }
+    }
+
+    Slot  = (Slot + 1) & Mask;
+    Entry = Kext->SymbolNameIndex[Slot];
+  }
+
+  return NULL;
+}
+
+STATIC
+CONST PRELINKED_KEXT_SYMBOL *
+InternalOcGetSymbolIndexedValue (
+  IN PRELINKED_KEXT                   *Kext,
+  IN UINT64                           LookupValue,
+  IN UINT32                           FirstIndex
+  )
+{
+  CONST PRELINKED_KEXT_SYMBOL *Symbol;
+  UINT32                      Mask;
+  UINT32                      Slot;
+  UINT32                      Entry;
+
+  Mask = Kext->SymbolIndexSize - 1;
+  Slot = InternalHashSymbolValue (LookupValue) & Mask;
+
+  Entry = Kext->SymbolValueIndex[Slot];
+  while (Entry != 0) {
+    if (Entry > FirstIndex) {
+      Symbol = &Kext->LinkedSymbolTable[Entry - 1];
+      if (Symbol->Value == LookupValue) {
+        return Symbol;
+      }
+    }
+
+    Slot  = (Slot + 1) & Mask;
+    Entry = Kext->SymbolValueIndex[Slot];
+  }
+
+  return NULL;
+}
+
 STATIC
 CONST PRELINKED_KEXT_SYMBOL *
 InternalOcGetSymbolWorkerName (
   IN PRELINKED_KEXT                   *Kext,
   IN CONST CHAR8                      *LookupValue,
   IN UINT32                           LookupValueLength,
-  IN OC_GET_SYMBOL_LEVEL              SymbolLevel
+  IN OC_GET_SYMBOL_LEVEL              SymbolLevel,
+  IN UINT32                           Epoch
   )
 {
   PRELINKED_KEXT              *Dependency;
@@ -48,41 +156,55 @@ InternalOcGetSymbolWorkerName (
   CONST PRELINKED_KEXT_SYMBOL *SymbolsEnd;
   UINT32                      Index;
   UINT32                      NumSymbols;
+  UINT32                      FirstIndex;
 
   //
   // Block any 1+ level dependencies.
   //
-  Kext->Processed = TRUE;
+  Kext->VisitEpoch = Epoch;
 
+  FirstIndex = 0;
   NumSymbols = Kext->NumberOfSymbols;
-  Symbols    = Kext->LinkedSymbolTable;
 
   if (SymbolLevel == OcGetSymbolOnlyCxx) {
+    FirstIndex = Kext->NumberOfSymbols - Kext->NumberOfCxxSymbols;
     NumSymbols = Kext->NumberOfCxxSymbols;
-    Symbols    = &Kext->LinkedSymbolTable[Kext->NumberOfSymbols - Kext->NumberOfCxxSymbols];
   }
 
-  SymbolsEnd = &Symbols[NumSymbols];
-  while (Symbols < SymbolsEnd) {
-    //
-    // Symbol names often start and end similarly due to C++ mangling (e.g. __ZN).
-    // To optimise the lookup we compare their length check in the middle.
-    // Please do not change this without careful profiling.
-    //
-    if (Symbols->Length == LookupValueLength) {
-      if (Symbols->Name[LookupValueLength / 2] == LookupValue[LookupValueLength / 2]
-        && Symbols->Name[(LookupValueLength / 2) + 1] == LookupValue[(LookupValueLength / 2) + 1]) {
-        for (Index = 0; Index < LookupValueLength; ++Index) {
-          if (Symbols->Name[Index] != LookupValue[Index]) {
-            break;
+  if (Kext->SymbolNameIndex != NULL) {
+    Symbols = InternalOcGetSymbolIndexedName (
+                Kext,
+                LookupValue,
+                LookupValueLength,
+                FirstIndex
+                );
+    if (Symbols != NULL) {
+      return Symbols;
+    }
+  } else {
+    Symbols    = &Kext->LinkedSymbolTable[FirstIndex];
+    SymbolsEnd = &Symbols[NumSymbols];
+    while (Symbols < SymbolsEnd) {
+      //
+      // Symbol names often start and end similarly due to C++ mangling (e.g. __ZN).
+      // To optimise the lookup we compare their length check in the middle.
+      // Please do not change this without careful profiling.
+      //
+      if (Symbols->Length == LookupValueLength) {
+        if (Symbols->Name[LookupValueLength / 2] == LookupValue[LookupValueLength / 2]
+          && Symbols->Name[(LookupValueLength / 2) + 1] == LookupValue[(LookupValueLength / 2) + 1]) {
+          for (Index = 0; Index < LookupValueLength; ++Index) {
+            if (Symbols->Name[Index] != LookupValue[Index]) {
+              break;
+            }
+          }
+          if (Index == LookupValueLength) {
+            return Symbols;
           }
-        }
-        if (Index == LookupValueLength) {
-          return Symbols;
         }
       }
+      Symbols++;
     }
-    Symbols++;
   }
 
   if (SymbolLevel != OcGetSymbolFirstLevel) {
@@ -92,7 +214,7 @@ InternalOcGetSymbolWorkerName (
         return NULL;
       }
 
-      if (Dependency->Processed) {
+      if (Dependency->VisitEpoch == Epoch) {
         continue;
       }
 
@@ -100,7 +222,8 @@ InternalOcGetSymbolWorkerName (
                  Dependency,
                  LookupValue,
                  LookupValueLength,
-                 OcGetSymbolOnlyCxx
+                 OcGetSymbolOnlyCxx,
+                 Epoch
                  );
       if (Symbols != NULL) {
         return Symbols;
@@ -116,41 +239,58 @@ CONST PRELINKED_KEXT_SYMBOL *
 InternalOcGetSymbolWorkerValue (
   IN PRELINKED_KEXT                   *Kext,
   IN UINT64                           LookupValue,
-  IN OC_GET_SYMBOL_LEVEL              SymbolLevel
+  IN OC_GET_SYMBOL_LEVEL              SymbolLevel,
+  IN UINT32                           Epoch
   )
 {
   PRELINKED_KEXT              *Dependency;
   CONST PRELINKED_KEXT_SYMBOL *Symbols;
   CONST PRELINKED_KEXT_SYMBOL *SymbolsEnd;
+  CONST PRELINKED_KEXT_SYMBOL *SymbolsTail;
   UINT32                      Index;
-  UINT32                      NumSymbols;
+  UINT32                      FirstIndex;
 
   //
   // Block any 1+ level dependencies.
   //
-  Kext->Processed = TRUE;
+  Kext->VisitEpoch = Epoch;
 
-  NumSymbols = Kext->NumberOfSymbols;
-  Symbols    = Kext->LinkedSymbolTable;
+  FirstIndex = 0;
 
   if (SymbolLevel == OcGetSymbolOnlyCxx) {
-    NumSymbols = Kext->NumberOfCxxSymbols;
-    Symbols    = &Kext->LinkedSymbolTable[(Kext->NumberOfSymbols - Kext->NumberOfCxxSymbols) & ~15ULL];
+    FirstIndex = Kext->NumberOfSymbols - Kext->NumberOfCxxSymbols;
   }
-  //
-  // WARN! Hot path! Do not change this code unless you have decent profiling data.
-  // We are not allowed to use SIMD in UEFI, but we can still do better with larger iteration.
-  // Up to 15 C symbols extra may get parsed, but it is fine, as they will not match.
-  // Increasing the iteration block to more than 16 no longer pays off.
-  // Note, lower loop is not on hot path.
-  //
-  SymbolsEnd = &Symbols[NumSymbols & ~15ULL];
-  while (Symbols < SymbolsEnd) {
-    #define MATCH(X) if (Symbols[X].Value == LookupValue) { return &Symbols[X]; }
-    MATCH (0) MATCH (1) MATCH (2)  MATCH (3)  MATCH (4)  MATCH (5)  MATCH (6)  MATCH (7)
-    MATCH (8) MATCH (9) MATCH (10) MATCH (11) MATCH (12) MATCH (13) MATCH (14) MATCH (15)
-    #undef MATCH
-    Symbols += 16;
+
+  if (Kext->SymbolValueIndex != NULL) {
+    Symbols = InternalOcGetSymbolIndexedValue (Kext, LookupValue, FirstIndex);
+    if (Symbols != NULL) {
+      return Symbols;
+    }
+  } else {
+    Symbols     = &Kext->LinkedSymbolTable[FirstIndex & ~15U];
+    SymbolsTail = &Kext->LinkedSymbolTable[Kext->NumberOfSymbols];
+    //
+    // WARN! Hot path! Do not change this code unless you have decent profiling data.
+    // We are not allowed to use SIMD in UEFI, but we can still do better with larger iteration.
+    // Up to 15 C symbols extra may get parsed, but it is fine, as they will not match.
+    // Increasing the iteration block to more than 16 no longer pays off.
+    // Note, lower loop is not on hot path.
+    //
+    SymbolsEnd = &Symbols[(UINTN) (SymbolsTail - Symbols) & ~(UINTN) 15];
+    while (Symbols < SymbolsEnd) {
+      #define MATCH(X) if (Symbols[X].Value == LookupValue) { return &Symbols[X]; }
+      MATCH (0) MATCH (1) MATCH (2)  MATCH (3)  MATCH (4)  MATCH (5)  MATCH (6)  MATCH (7)
+      MATCH (8) MATCH (9) MATCH (10) MATCH (11) MATCH (12) MATCH (13) MATCH (14) MATCH (15)
+      #undef MATCH
+      Symbols += 16;
+    }
+
+    while (Symbols < SymbolsTail) {
+      if (Symbols->Value == LookupValue) {
+        return Symbols;
+      }
+      Symbols++;
+    }
   }
 
   if (SymbolLevel != OcGetSymbolFirstLevel) {
@@ -160,14 +300,15 @@ InternalOcGetSymbolWorkerValue (
         return NULL;
       }
 
-      if (Dependency->Processed) {
+      if (Dependency->VisitEpoch == Epoch) {
         continue;
       }
 
       Symbols = InternalOcGetSymbolWorkerValue (
                  Dependency,
                  LookupValue,
-                 OcGetSymbolOnlyCxx
+                 OcGetSymbolOnlyCxx,
+                 Epoch
                  );
       if (Symbols != NULL) {
         return Symbols;
@@ -191,6 +332,7 @@ InternalOcGetSymbolName (
   PRELINKED_KEXT              *Dependency;
   UINT32                      Index;
   UINT32                      LookupValueLength;
+  UINT32                      Epoch;
 
   Symbol = NULL;
   LookupValueLength = (UINT32)AsciiStrLen (LookupValue);
@@ -202,12 +344,15 @@ InternalOcGetSymbolName (
     return NULL;
   }
 
+  Epoch = InternalNewVisitEpoch (Context);
+
   if ((SymbolLevel == OcGetSymbolOnlyCxx) && (Kext->LinkedSymbolTable != NULL)) {
     Symbol = InternalOcGetSymbolWorkerName (
       Kext,
       LookupValue,
       LookupValueLength,
-      SymbolLevel
+      SymbolLevel,
+      Epoch
       );
   } else {
     for (Index = 0; Index < ARRAY_SIZE (Kext->Dependencies); ++Index) {
@@ -220,7 +365,8 @@ InternalOcGetSymbolName (
                  Dependency,
                  LookupValue,
                  LookupValueLength,
-                 SymbolLevel
+                 SymbolLevel,
+                 Epoch
                  );
       if (Symbol != NULL) {
         break;
@@ -228,8 +374,6 @@ InternalOcGetSymbolName (
     }
   }
 
-  InternalUnlockContextKexts (Context);
-
   return Symbol;
 }
 
@@ -245,11 +389,13 @@ InternalOcGetSymbolValue (
 
   PRELINKED_KEXT              *Dependency;
   UINT32                      Index;
+  UINT32                      Epoch;
 
   Symbol = NULL;
+  Epoch  = InternalNewVisitEpoch (Context);
 
   if ((SymbolLevel == OcGetSymbolOnlyCxx) && (Kext->LinkedSymbolTable != NULL)) {
-    Symbol = InternalOcGetSymbolWorkerValue (Kext, LookupValue, SymbolLevel);
+    Symbol = InternalOcGetSymbolWorkerValue (Kext, LookupValue, SymbolLevel, Epoch);
   } else {
     for (Index = 0; Index < ARRAY_SIZE (Kext->Dependencies); ++Index) {
       Dependency = Kext->Dependencies[Index];
@@ -260,7 +406,8 @@ InternalOcGetSymbolValue (
       Symbol = InternalOcGetSymbolWorkerValue (
                  Dependency,
                  LookupValue,
-                 SymbolLevel
+                 SymbolLevel,
+                 Epoch
                  );
       if (Symbol != NULL) {
         break;
@@ -268,8 +415,6 @@ InternalOcGetSymbolValue (
     }
   }
 
-  InternalUnlockContextKexts (Context);
-
   return Symbol;
 }
 
@@ -1420,6 +1565,10 @@ InternalPrelinkKext64 (
   // Create and patch the KEXT's VTables.
   //
   Result = InternalPatchByVtables64 (Context, Kext);
+  //
+  // The Relocations are rewritten below, discard their index.
+  //
+  MachoFreeRelocationIndex (MachoContext);
   if (!Result) {
     DEBUG ((DEBUG_INFO, "Vtable patching failed for kext %a\n", Kext->Identifier));
     return RETURN_LOAD_ERROR;
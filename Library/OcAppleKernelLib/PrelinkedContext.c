@@ -154,9 +154,6 @@ PrelinkedContextInit (
   )
 {
   XML_NODE     *PrelinkedInfoRoot;
-  CONST CHAR8  *PrelinkedInfoRootKey;
-  UINT32       PrelinkedInfoRootIndex;
-  UINT32       PrelinkedInfoRootCount;
 
   ASSERT (Context != NULL);
   ASSERT (Prelinked != NULL);
@@ -165,6 +162,8 @@ PrelinkedContextInit (
 
   ZeroMem (Context, sizeof (*Context));
 
+  MemoryArenaInit (&Context->Arena, "Prelinked", PRELINKED_ARENA_BLOCK_SIZE);
+
   Context->Prelinked          = Prelinked;
   Context->PrelinkedSize      = MACHO_ALIGN (PrelinkedSize);
   Context->PrelinkedAllocSize = PrelinkedAllocSize;
@@ -257,21 +256,13 @@ PrelinkedContextInit (
     return RETURN_INVALID_PARAMETER;
   }
 
-  PrelinkedInfoRootCount = PlistDictChildren (PrelinkedInfoRoot);
-  for (PrelinkedInfoRootIndex = 0; PrelinkedInfoRootIndex < PrelinkedInfoRootCount; ++PrelinkedInfoRootIndex) {
-    PrelinkedInfoRootKey = PlistKeyValue (PlistDictChild (PrelinkedInfoRoot, PrelinkedInfoRootIndex, &Context->KextList));
-    if (PrelinkedInfoRootKey == NULL) {
-      continue;
-    }
-
-    if (AsciiStrCmp (PrelinkedInfoRootKey, PRELINK_INFO_DICTIONARY_KEY) == 0) {
-      if (PlistNodeCast (Context->KextList, PLIST_NODE_TYPE_ARRAY) != NULL) {
-        Context->PrelinkedLastLoadAddress = PrelinkedFindLastLoadAddress (Context->KextList);
-        if (Context->PrelinkedLastLoadAddress != 0) {
-          return RETURN_SUCCESS;
-        }
-      }
-      break;
+  Context->KextList = PlistDictLookup (PrelinkedInfoRoot, PRELINK_INFO_DICTIONARY_KEY);
+  if (Context->KextList != NULL
+    && PlistNodeCast (Context->KextList, PLIST_NODE_TYPE_ARRAY) != NULL) {
+    Context->PrelinkedLastLoadAddress = PrelinkedFindLastLoadAddress (Context->KextList);
+    if (Context->PrelinkedLastLoadAddress != 0) {
+      InternalBuildPrelinkedKextMap (Context);
+      return RETURN_SUCCESS;
     }
   }
 
@@ -288,6 +279,8 @@ PrelinkedContextFree (
   LIST_ENTRY      *Link;
   PRELINKED_KEXT  *Kext;
 
+  InternalFreePrelinkedKextMap (Context);
+
   if (Context->PrelinkedInfoDocument != NULL) {
     XmlDocumentFree (Context->PrelinkedInfoDocument);
     Context->PrelinkedInfoDocument = NULL;
@@ -316,10 +309,12 @@ PrelinkedContextFree (
     Link = GetFirstNode (&Context->PrelinkedKexts);
     Kext = GET_PRELINKED_KEXT_FROM_LINK (Link);
     RemoveEntryList (Link);
-    InternalFreePrelinkedKext (Kext);
+    InternalFreePrelinkedKext (Context, Kext);
   }
 
   ZeroMem (&Context->PrelinkedKexts, sizeof (Context->PrelinkedKexts));
+
+  MemoryArenaFree (&Context->Arena);
 }
 
 RETURN_STATUS
@@ -408,12 +403,10 @@ PrelinkedInjectComplete (
   IN OUT PRELINKED_CONTEXT  *Context
   )
 {
-  CHAR8       *ExportedInfo;
   UINT32      ExportedInfoSize;
   UINT32      NewSize;
 
-  ExportedInfo = XmlDocumentExport (Context->PrelinkedInfoDocument, &ExportedInfoSize, 0);
-  if (ExportedInfo == NULL) {
+  if (!XmlDocumentExportSize (Context->PrelinkedInfoDocument, &ExportedInfoSize, 0)) {
     return RETURN_OUT_OF_RESOURCES;
   }
 
@@ -424,10 +417,24 @@ PrelinkedInjectComplete (
 
   if (OcOverflowAddU32 (Context->PrelinkedSize, MACHO_ALIGN (ExportedInfoSize), &NewSize)
     || NewSize > Context->PrelinkedAllocSize) {
-    FreePool (ExportedInfo);
     return RETURN_BUFFER_TOO_SMALL;
   }
 
+  //
+  // Export straight into the free space past the prelinked image.
+  // Plist contents live in pool buffers, so nothing referenced by
+  // the document is overwritten.
+  //
+  if (!XmlDocumentExportBuffer (
+    Context->PrelinkedInfoDocument,
+    (CHAR8 *) &Context->Prelinked[Context->PrelinkedSize],
+    ExportedInfoSize,
+    NULL,
+    0
+    )) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
   Context->PrelinkedInfoSegment->VirtualAddress = Context->PrelinkedLastAddress;
   Context->PrelinkedInfoSegment->Size           = ExportedInfoSize;
   Context->PrelinkedInfoSegment->FileOffset     = Context->PrelinkedSize;
@@ -436,12 +443,6 @@ PrelinkedInjectComplete (
   Context->PrelinkedInfoSection->Size           = ExportedInfoSize;
   Context->PrelinkedInfoSection->Offset         = Context->PrelinkedSize;
 
-  CopyMem (
-    &Context->Prelinked[Context->PrelinkedSize],
-    ExportedInfo,
-    ExportedInfoSize
-    );
-
   ZeroMem (
     &Context->Prelinked[Context->PrelinkedSize + ExportedInfoSize],
     MACHO_ALIGN (ExportedInfoSize) - ExportedInfoSize
@@ -450,8 +451,6 @@ PrelinkedInjectComplete (
   Context->PrelinkedLastAddress += MACHO_ALIGN (ExportedInfoSize);
   Context->PrelinkedSize        += MACHO_ALIGN (ExportedInfoSize);
 
-  FreePool (ExportedInfo);
-
   return RETURN_SUCCESS;
 }
 
@@ -513,9 +512,6 @@ PrelinkedInjectKext (
   CHAR8             *TmpInfoPlist;
   CHAR8             *NewInfoPlist;
   OC_MACHO_CONTEXT  ExecutableContext;
-  CONST CHAR8       *TmpKeyValue;
-  UINT32            FieldCount;
-  UINT32            FieldIndex;
   UINT32            NewInfoPlistSize;
   UINT32            NewPrelinkedSize;
   UINT32            AlignedExecutableSize;
@@ -598,20 +594,10 @@ PrelinkedInjectKext (
   // code in debug mode to diagnose it.
   //
   DEBUG_CODE_BEGIN ();
-  if (Executable == NULL) {
-    FieldCount = PlistDictChildren (InfoPlistRoot);
-    for (FieldIndex = 0; FieldIndex < FieldCount; ++FieldIndex) {
-      TmpKeyValue = PlistKeyValue (PlistDictChild (InfoPlistRoot, FieldIndex, NULL));
-      if (TmpKeyValue == NULL) {
-        continue;
-      }
-
-      if (AsciiStrCmp (TmpKeyValue, INFO_BUNDLE_EXECUTABLE_KEY) == 0) {
-        DEBUG ((DEBUG_ERROR, "OCK: Plist-only kext has %a key\n", INFO_BUNDLE_EXECUTABLE_KEY));
-        ASSERT (FALSE);
-        CpuDeadLoop ();
-      }
-    }
+  if (Executable == NULL && PlistDictLookup (InfoPlistRoot, INFO_BUNDLE_EXECUTABLE_KEY) != NULL) {
+    DEBUG ((DEBUG_ERROR, "OCK: Plist-only kext has %a key\n", INFO_BUNDLE_EXECUTABLE_KEY));
+    ASSERT (FALSE);
+    CpuDeadLoop ();
   }
   DEBUG_CODE_END ();
 
@@ -678,7 +664,7 @@ PrelinkedInjectKext (
 
   if (NewInfoPlist == NULL) {
     if (PrelinkedKext != NULL) {
-      InternalFreePrelinkedKext (PrelinkedKext);
+      InternalFreePrelinkedKext (Context, PrelinkedKext);
     }
     return RETURN_OUT_OF_RESOURCES;
   }
@@ -687,14 +673,14 @@ PrelinkedInjectKext (
   if (RETURN_ERROR (Status)) {
     FreePool (NewInfoPlist);
     if (PrelinkedKext != NULL) {
-      InternalFreePrelinkedKext (PrelinkedKext);
+      InternalFreePrelinkedKext (Context, PrelinkedKext);
     }
     return Status;
   }
 
   if (XmlNodeAppend (Context->KextList, "dict", NULL, NewInfoPlist) == NULL) {
     if (PrelinkedKext != NULL) {
-      InternalFreePrelinkedKext (PrelinkedKext);
+      InternalFreePrelinkedKext (Context, PrelinkedKext);
     }
     return RETURN_OUT_OF_RESOURCES;
   }
@@ -703,7 +689,7 @@ PrelinkedInjectKext (
   // Let other kexts depend on this one.
   //
   if (PrelinkedKext != NULL) {
-    InsertTailList (&Context->PrelinkedKexts, &PrelinkedKext->Link);
+    InternalInsertPrelinkedKext (Context, PrelinkedKext);
   }
 
   return RETURN_SUCCESS;
@@ -27,6 +27,20 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 #define MAX_KEXT_DEPEDENCIES 16
 
+//
+// Build hashed symbol and vtable lookup indices for dependency kexts.
+// Set to 0 to always scan LinkedSymbolTable and LinkedVtables linearly,
+// e.g. for profiling.
+//
+#ifndef OC_PRELINKED_SYMBOL_INDEX
+#define OC_PRELINKED_SYMBOL_INDEX 1
+#endif
+
+//
+// Maximum number of symbols to build the lookup indices for.
+//
+#define PRELINKED_SYMBOL_INDEX_MAX  BIT24
+
 typedef struct PRELINKED_KEXT_ PRELINKED_KEXT;
 
 typedef struct {
@@ -110,9 +124,22 @@ struct PRELINKED_KEXT_ {
   //
   PRELINKED_KEXT_SYMBOL    *LinkedSymbolTable;
   //
-  // A flag set during dependency walk BFS to avoid going through the same path.
+  // Open addressing hash tables over LinkedSymbolTable keyed by symbol name
+  // and by symbol value. Each slot holds a 1-based LinkedSymbolTable index,
+  // 0 marks a free slot. NULL when not built, LinkedSymbolTable is then
+  // scanned linearly.
+  //
+  UINT32                   *SymbolNameIndex;
+  UINT32                   *SymbolValueIndex;
   //
-  BOOLEAN                  Processed;
+  // Number of slots in each of the symbol indices, always a power of two.
+  //
+  UINT32                   SymbolIndexSize;
+  //
+  // Dependency walk epoch this kext was last visited in to avoid going
+  // through the same path. See InternalNewVisitEpoch.
+  //
+  UINT32                   VisitEpoch;
   //
   // Number of vtables in this kext.
   //
@@ -121,6 +148,15 @@ struct PRELINKED_KEXT_ {
   // Scanned vtable buffer. Iterated with GET_NEXT_PRELINKED_VTABLE.
   //
   PRELINKED_VTABLE         *LinkedVtables;
+  //
+  // Open addressing hash table over LinkedVtables keyed by vtable name.
+  // NULL when not built, LinkedVtables are then scanned linearly.
+  //
+  CONST PRELINKED_VTABLE   **VtableIndex;
+  //
+  // Number of slots in VtableIndex, always a power of two.
+  //
+  UINT32                   VtableIndexSize;
 };
 
 //
@@ -141,6 +177,35 @@ struct PRELINKED_KEXT_ {
     PRELINKED_KEXT_SIGNATURE                \
     ))
 
+//
+// Initial number of PRELINKED_CONTEXT KextMap slots.
+//
+#define PRELINKED_KEXT_MAP_MIN_SIZE  256U
+
+//
+// Initial PRELINKED_CONTEXT arena block size, fits a few dozen cached kexts.
+//
+#define PRELINKED_ARENA_BLOCK_SIZE   SIZE_16KB
+
+struct PRELINKED_KEXT_MAP_ENTRY_ {
+  //
+  // Bundle identifier, NULL for unused slots.
+  //
+  CONST CHAR8     *Identifier;
+  //
+  // Bundle identifier hash.
+  //
+  UINT32          Hash;
+  //
+  // KextList entry with this bundle identifier or NULL.
+  //
+  XML_NODE        *KextPlist;
+  //
+  // Cached PRELINKED_KEXT with this bundle identifier or NULL.
+  //
+  PRELINKED_KEXT  *Kext;
+};
+
 /**
   Creates new PRELINKED_KEXT from OC_MACHO_CONTEXT.
 **/
@@ -151,11 +216,13 @@ InternalNewPrelinkedKext (
   );
 
 /**
-  Frees PRELINKED_KEXT.
+  Frees PRELINKED_KEXT. Kexts allocated from context arena
+  only release their resources.
 **/
 VOID
 InternalFreePrelinkedKext (
-  IN PRELINKED_KEXT  *Kext
+  IN PRELINKED_CONTEXT  *Context,
+  IN PRELINKED_KEXT     *Kext
   );
 
 /**
@@ -167,6 +234,40 @@ InternalCachedPrelinkedKext (
   IN     CONST CHAR8        *Identifier
   );
 
+/**
+  Builds PRELINKED_CONTEXT KextMap from KextList and PrelinkedKexts.
+  Failure to build the map is not an error, as the lookup falls back
+  to scanning both linearly.
+
+  @param[in,out] Context  Prelinked context.
+**/
+VOID
+InternalBuildPrelinkedKextMap (
+  IN OUT PRELINKED_CONTEXT  *Context
+  );
+
+/**
+  Frees PRELINKED_CONTEXT KextMap.
+
+  @param[in,out] Context  Prelinked context.
+**/
+VOID
+InternalFreePrelinkedKextMap (
+  IN OUT PRELINKED_CONTEXT  *Context
+  );
+
+/**
+  Inserts PRELINKED_KEXT into PRELINKED_CONTEXT cache.
+
+  @param[in,out] Context  Prelinked context.
+  @param[in,out] Kext     Prelinked kext to insert.
+**/
+VOID
+InternalInsertPrelinkedKext (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN OUT PRELINKED_KEXT     *Kext
+  );
+
 /**
   Gets cached kernel PRELINKED_KEXT from PRELINKED_CONTEXT.
 **/
@@ -186,13 +287,16 @@ InternalScanPrelinkedKext (
   );
 
 /**
-  Unlock all context dependency kexts by unsetting Processed flag.
+  Start a new dependency walk. Kexts with VisitEpoch equal to the returned
+  value are considered visited during this walk.
 
-  @param[in] Context      Prelinked context.
+  @param[in,out] Context      Prelinked context.
+
+  @return  New non-zero visit epoch.
 **/
-VOID
-InternalUnlockContextKexts (
-  IN PRELINKED_CONTEXT  *Context
+UINT32
+InternalNewVisitEpoch (
+  IN OUT PRELINKED_CONTEXT  *Context
   );
 
 /**
@@ -342,6 +446,17 @@ typedef enum {
   OcGetSymbolOnlyCxx
 } OC_GET_SYMBOL_LEVEL;
 
+UINT32
+InternalHashSymbolName (
+  IN CONST CHAR8  *Name,
+  IN UINT32       Length
+  );
+
+UINT32
+InternalHashSymbolValue (
+  IN UINT64  Value
+  );
+
 CONST PRELINKED_KEXT_SYMBOL *
 InternalOcGetSymbolName (
   IN PRELINKED_CONTEXT    *Context,
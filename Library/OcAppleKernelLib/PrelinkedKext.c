@@ -20,6 +20,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleKernelLib.h>
 #include <Library/OcMachoLib.h>
+#include <Library/OcMemoryLib.h>
 #include <Library/OcXmlLib.h>
 
 #include "PrelinkedInternal.h"
@@ -144,15 +145,20 @@ InternalCreatePrelinkedKext (
 
   //
   // Important to ZeroPool for dependency cleanup.
+  // Cached kexts live as long as the context, so use its arena.
   //
-  NewKext = AllocateZeroPool (sizeof (*NewKext));
+  if (Prelinked != NULL) {
+    NewKext = MemoryArenaAllocateZero (&Prelinked->Arena, sizeof (*NewKext));
+  } else {
+    NewKext = AllocateZeroPool (sizeof (*NewKext));
+  }
+
   if (NewKext == NULL) {
     return NULL;
   }
 
   if (Prelinked != NULL
     && !MachoInitializeContext (&NewKext->Context.MachContext, &Prelinked->Prelinked[SourceBase], (UINT32)SourceSize)) {
-    FreePool (NewKext);
     return NULL;
   }
 
@@ -203,6 +209,72 @@ InternalScanCurrentPrelinkedKextLinkedEdit (
   return RETURN_SUCCESS;
 }
 
+#if OC_PRELINKED_SYMBOL_INDEX
+/**
+  Builds hashed name and value lookup indices over LinkedSymbolTable.
+  Failure to build the indices is not an error, as the lookup falls back
+  to scanning LinkedSymbolTable linearly.
+
+  @param[in,out] Kext  Prelinked kext with LinkedSymbolTable constructed.
+**/
+STATIC
+VOID
+InternalScanBuildLinkedSymbolIndex (
+  IN OUT PRELINKED_KEXT  *Kext
+  )
+{
+  CONST PRELINKED_KEXT_SYMBOL *Symbol;
+  UINT32                      *NameIndex;
+  UINT32                      *ValueIndex;
+  UINT32                      IndexSize;
+  UINT32                      Mask;
+  UINT32                      Slot;
+  UINT32                      Index;
+
+  if (Kext->NumberOfSymbols == 0
+    || Kext->NumberOfSymbols > PRELINKED_SYMBOL_INDEX_MAX) {
+    return;
+  }
+
+  //
+  // Keep the load factor at or below 1/2 for short probe sequences.
+  //
+  IndexSize = 1;
+  while (IndexSize < Kext->NumberOfSymbols * 2) {
+    IndexSize <<= 1U;
+  }
+
+  NameIndex = AllocateZeroPool (2 * IndexSize * sizeof (*NameIndex));
+  if (NameIndex == NULL) {
+    DEBUG ((DEBUG_VERBOSE, "OCAK: No symbol index for %a\n", Kext->Identifier));
+    return;
+  }
+
+  ValueIndex = &NameIndex[IndexSize];
+  Mask       = IndexSize - 1;
+
+  for (Index = 0; Index < Kext->NumberOfSymbols; ++Index) {
+    Symbol = &Kext->LinkedSymbolTable[Index];
+
+    Slot = InternalHashSymbolName (Symbol->Name, Symbol->Length) & Mask;
+    while (NameIndex[Slot] != 0) {
+      Slot = (Slot + 1) & Mask;
+    }
+    NameIndex[Slot] = Index + 1;
+
+    Slot = InternalHashSymbolValue (Symbol->Value) & Mask;
+    while (ValueIndex[Slot] != 0) {
+      Slot = (Slot + 1) & Mask;
+    }
+    ValueIndex[Slot] = Index + 1;
+  }
+
+  Kext->SymbolNameIndex  = NameIndex;
+  Kext->SymbolValueIndex = ValueIndex;
+  Kext->SymbolIndexSize  = IndexSize;
+}
+#endif
+
 STATIC
 RETURN_STATUS
 InternalScanBuildLinkedSymbolTable (
@@ -321,9 +393,69 @@ InternalScanBuildLinkedSymbolTable (
   Kext->NumberOfCxxSymbols = NumCxxSymbols;
   Kext->LinkedSymbolTable  = SymbolTable;
 
+#if OC_PRELINKED_SYMBOL_INDEX
+  InternalScanBuildLinkedSymbolIndex (Kext);
+#endif
+
   return RETURN_SUCCESS;
 }
 
+#if OC_PRELINKED_SYMBOL_INDEX
+/**
+  Builds hashed name lookup index over LinkedVtables.
+  Failure to build the index is not an error, as the lookup falls back
+  to scanning LinkedVtables linearly.
+
+  @param[in,out] Kext  Prelinked kext with LinkedVtables constructed.
+**/
+STATIC
+VOID
+InternalScanBuildLinkedVtableIndex (
+  IN OUT PRELINKED_KEXT  *Kext
+  )
+{
+  CONST PRELINKED_VTABLE  *Vtable;
+  CONST PRELINKED_VTABLE  **VtableIndex;
+  UINT32                  IndexSize;
+  UINT32                  Mask;
+  UINT32                  Slot;
+  UINT32                  Index;
+
+  if (Kext->NumberOfVtables == 0
+    || Kext->NumberOfVtables > PRELINKED_SYMBOL_INDEX_MAX) {
+    return;
+  }
+
+  IndexSize = 1;
+  while (IndexSize < Kext->NumberOfVtables * 2) {
+    IndexSize <<= 1U;
+  }
+
+  VtableIndex = AllocateZeroPool (IndexSize * sizeof (*VtableIndex));
+  if (VtableIndex == NULL) {
+    DEBUG ((DEBUG_VERBOSE, "OCAK: No vtable index for %a\n", Kext->Identifier));
+    return;
+  }
+
+  Mask = IndexSize - 1;
+
+  for (
+    Index = 0, Vtable = Kext->LinkedVtables;
+    Index < Kext->NumberOfVtables;
+    ++Index, Vtable = GET_NEXT_PRELINKED_VTABLE (Vtable)
+    ) {
+    Slot = InternalHashSymbolName (Vtable->Name, (UINT32)AsciiStrLen (Vtable->Name)) & Mask;
+    while (VtableIndex[Slot] != NULL) {
+      Slot = (Slot + 1) & Mask;
+    }
+    VtableIndex[Slot] = Vtable;
+  }
+
+  Kext->VtableIndex     = VtableIndex;
+  Kext->VtableIndexSize = IndexSize;
+}
+#endif
+
 STATIC
 RETURN_STATUS
 InternalScanBuildLinkedVtables (
@@ -412,6 +544,10 @@ InternalScanBuildLinkedVtables (
   Kext->NumberOfVtables = NumVtables;
   Kext->LinkedVtables   = LinkedVtables;
 
+#if OC_PRELINKED_SYMBOL_INDEX
+  InternalScanBuildLinkedVtableIndex (Kext);
+#endif
+
   return RETURN_SUCCESS;
 }
 
@@ -488,7 +624,8 @@ InternalNewPrelinkedKext (
 
 VOID
 InternalFreePrelinkedKext (
-  IN PRELINKED_KEXT  *Kext
+  IN PRELINKED_CONTEXT  *Context,
+  IN PRELINKED_KEXT     *Kext
   )
 {
   if (Kext->LinkedSymbolTable != NULL) {
@@ -496,12 +633,266 @@ InternalFreePrelinkedKext (
     Kext->LinkedSymbolTable = NULL;
   }
 
+  if (Kext->SymbolNameIndex != NULL) {
+    FreePool (Kext->SymbolNameIndex);
+    Kext->SymbolNameIndex  = NULL;
+    Kext->SymbolValueIndex = NULL;
+    Kext->SymbolIndexSize  = 0;
+  }
+
+  if (Kext->VtableIndex != NULL) {
+    FreePool (Kext->VtableIndex);
+    Kext->VtableIndex     = NULL;
+    Kext->VtableIndexSize = 0;
+  }
+
   if (Kext->LinkedVtables != NULL) {
     FreePool (Kext->LinkedVtables);
     Kext->LinkedVtables = NULL;
   }
 
-  FreePool (Kext);
+  MachoFreeRelocationIndex (&Kext->Context.MachContext);
+
+  if (!MemoryArenaContains (&Context->Arena, Kext)) {
+    FreePool (Kext);
+  }
+}
+
+/**
+  Inserts an entry into PRELINKED_CONTEXT KextMap, which must have room for it.
+
+  @param[in,out] Map         Map slots.
+  @param[in]     Mask        Map slot count minus one.
+  @param[in]     Entry       Entry to insert.
+**/
+STATIC
+VOID
+InternalKextMapInsertEntry (
+  IN OUT PRELINKED_KEXT_MAP_ENTRY        *Map,
+  IN     UINT32                          Mask,
+  IN     CONST PRELINKED_KEXT_MAP_ENTRY  *Entry
+  )
+{
+  UINT32  Slot;
+
+  Slot = Entry->Hash & Mask;
+  while (Map[Slot].Identifier != NULL) {
+    Slot = (Slot + 1) & Mask;
+  }
+
+  CopyMem (&Map[Slot], Entry, sizeof (*Entry));
+}
+
+/**
+  Adds an entry to PRELINKED_CONTEXT KextMap, growing it when needed.
+  The map is discarded when it cannot grow.
+
+  @param[in,out] Context     Prelinked context.
+  @param[in]     Identifier  Bundle identifier.
+  @param[in]     KextPlist   KextList entry or NULL.
+  @param[in]     Kext        Cached kext or NULL.
+**/
+STATIC
+VOID
+InternalKextMapAdd (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN     CONST CHAR8        *Identifier,
+  IN     XML_NODE           *KextPlist  OPTIONAL,
+  IN     PRELINKED_KEXT     *Kext       OPTIONAL
+  )
+{
+  PRELINKED_KEXT_MAP_ENTRY  Entry;
+  PRELINKED_KEXT_MAP_ENTRY  *NewMap;
+  UINT32                    NewSize;
+  UINT32                    Start;
+  UINT32                    Index;
+  UINT32                    Slot;
+
+  if (Context->KextMap == NULL) {
+    return;
+  }
+
+  if (Context->KextMapCount + 1 > Context->KextMapSize / 2) {
+    if (Context->KextMapSize > MAX_UINT32 / 2) {
+      InternalFreePrelinkedKextMap (Context);
+      return;
+    }
+
+    NewSize = Context->KextMapSize * 2;
+    NewMap  = AllocateZeroPool (NewSize * sizeof (*NewMap));
+    if (NewMap == NULL) {
+      InternalFreePrelinkedKextMap (Context);
+      return;
+    }
+
+    //
+    // Walk from an unused slot so that every probe sequence is visited in
+    // order, and entries with equal identifiers keep their relative order.
+    //
+    for (Start = 0; Context->KextMap[Start].Identifier != NULL; ++Start) {
+    }
+
+    for (Index = 1; Index <= Context->KextMapSize; ++Index) {
+      Slot = (Start + Index) & (Context->KextMapSize - 1);
+      if (Context->KextMap[Slot].Identifier != NULL) {
+        InternalKextMapInsertEntry (NewMap, NewSize - 1, &Context->KextMap[Slot]);
+      }
+    }
+
+    FreePool (Context->KextMap);
+    Context->KextMap     = NewMap;
+    Context->KextMapSize = NewSize;
+  }
+
+  Entry.Identifier = Identifier;
+  Entry.Hash       = InternalHashSymbolName (Identifier, (UINT32) AsciiStrLen (Identifier));
+  Entry.KextPlist  = KextPlist;
+  Entry.Kext       = Kext;
+
+  InternalKextMapInsertEntry (Context->KextMap, Context->KextMapSize - 1, &Entry);
+  ++Context->KextMapCount;
+}
+
+VOID
+InternalBuildPrelinkedKextMap (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  UINT32          Index;
+  UINT32          KextCount;
+  XML_NODE        *KextPlist;
+  XML_NODE        *KextPlistValue;
+  CONST CHAR8     *KextIdentifier;
+  LIST_ENTRY      *Link;
+  PRELINKED_KEXT  *Kext;
+
+  ASSERT (Context->KextMap == NULL);
+
+  KextCount = XmlNodeChildren (Context->KextList);
+
+  Context->KextMapSize = PRELINKED_KEXT_MAP_MIN_SIZE;
+  while (Context->KextMapSize / 2 < KextCount) {
+    if (Context->KextMapSize > MAX_UINT32 / 2) {
+      Context->KextMapSize = 0;
+      return;
+    }
+    Context->KextMapSize *= 2;
+  }
+
+  Context->KextMap = AllocateZeroPool (Context->KextMapSize * sizeof (*Context->KextMap));
+  if (Context->KextMap == NULL) {
+    DEBUG ((DEBUG_INFO, "OCAK: No kext map for %u kexts\n", KextCount));
+    Context->KextMapSize = 0;
+    return;
+  }
+
+  //
+  // Identifiers are taken the same way InternalCreatePrelinkedKext matches
+  // them, i.e. from the first CFBundleIdentifier key.
+  //
+  for (Index = 0; Index < KextCount; ++Index) {
+    KextPlist = PlistNodeCast (XmlNodeChild (Context->KextList, Index), PLIST_NODE_TYPE_DICT);
+    if (KextPlist == NULL) {
+      continue;
+    }
+
+    KextPlistValue = PlistDictLookup (KextPlist, INFO_BUNDLE_IDENTIFIER_KEY);
+    if (KextPlistValue == NULL) {
+      continue;
+    }
+
+    KextIdentifier = XmlNodeContent (KextPlistValue);
+    if (PlistNodeCast (KextPlistValue, PLIST_NODE_TYPE_STRING) != NULL && KextIdentifier != NULL) {
+      InternalKextMapAdd (Context, KextIdentifier, KextPlist, NULL);
+    }
+  }
+
+  //
+  // Kexts cached so far, i.e. the kernel, have no KextList entries.
+  //
+  Link = GetFirstNode (&Context->PrelinkedKexts);
+  while (!IsNull (&Context->PrelinkedKexts, Link)) {
+    Kext = GET_PRELINKED_KEXT_FROM_LINK (Link);
+    InternalKextMapAdd (Context, Kext->Identifier, NULL, Kext);
+    Link = GetNextNode (&Context->PrelinkedKexts, Link);
+  }
+}
+
+VOID
+InternalFreePrelinkedKextMap (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  if (Context->KextMap != NULL) {
+    FreePool (Context->KextMap);
+    Context->KextMap      = NULL;
+    Context->KextMapSize  = 0;
+    Context->KextMapCount = 0;
+  }
+}
+
+VOID
+InternalInsertPrelinkedKext (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN OUT PRELINKED_KEXT     *Kext
+  )
+{
+  InsertTailList (&Context->PrelinkedKexts, &Kext->Link);
+  InternalKextMapAdd (Context, Kext->Identifier, NULL, Kext);
+}
+
+/**
+  Gets cached PRELINKED_KEXT from PRELINKED_CONTEXT KextMap.
+
+  @param[in,out] Prelinked   Prelinked context with KextMap.
+  @param[in]     Identifier  Bundle identifier.
+
+  @return  cached PRELINKED_KEXT or NULL.
+**/
+STATIC
+PRELINKED_KEXT *
+InternalCachedPrelinkedKextMapped (
+  IN OUT PRELINKED_CONTEXT  *Prelinked,
+  IN     CONST CHAR8        *Identifier
+  )
+{
+  PRELINKED_KEXT_MAP_ENTRY  *Entry;
+  PRELINKED_KEXT            *NewKext;
+  UINT32                    Hash;
+  UINT32                    Mask;
+  UINT32                    Slot;
+
+  Hash = InternalHashSymbolName (Identifier, (UINT32) AsciiStrLen (Identifier));
+  Mask = Prelinked->KextMapSize - 1;
+
+  //
+  // Find cached entry if any.
+  //
+  for (Slot = Hash & Mask; Prelinked->KextMap[Slot].Identifier != NULL; Slot = (Slot + 1) & Mask) {
+    Entry = &Prelinked->KextMap[Slot];
+    if (Entry->Kext != NULL && Entry->Hash == Hash
+      && AsciiStrCmp (Identifier, Entry->Identifier) == 0) {
+      return Entry->Kext;
+    }
+  }
+
+  //
+  // Try with real entry.
+  //
+  for (Slot = Hash & Mask; Prelinked->KextMap[Slot].Identifier != NULL; Slot = (Slot + 1) & Mask) {
+    Entry = &Prelinked->KextMap[Slot];
+    if (Entry->KextPlist != NULL && Entry->Hash == Hash
+      && AsciiStrCmp (Identifier, Entry->Identifier) == 0) {
+      NewKext = InternalCreatePrelinkedKext (Prelinked, Entry->KextPlist, Identifier);
+      if (NewKext != NULL) {
+        InsertTailList (&Prelinked->PrelinkedKexts, &NewKext->Link);
+        Entry->Kext = NewKext;
+        return NewKext;
+      }
+    }
+  }
+
+  return NULL;
 }
 
 PRELINKED_KEXT *
@@ -516,6 +907,10 @@ InternalCachedPrelinkedKext (
   UINT32          KextCount;
   XML_NODE        *KextPlist;
 
+  if (Prelinked->KextMap != NULL) {
+    return InternalCachedPrelinkedKextMapped (Prelinked, Identifier);
+  }
+
   //
   // Find cached entry if any.
   //
@@ -572,7 +967,7 @@ InternalCachedPrelinkedKernel (
     return GET_PRELINKED_KEXT_FROM_LINK (Kext);
   }
 
-  NewKext = AllocateZeroPool (sizeof (*NewKext));
+  NewKext = MemoryArenaAllocateZero (&Prelinked->Arena, sizeof (*NewKext));
   if (NewKext == NULL) {
     return NULL;
   }
@@ -581,7 +976,6 @@ InternalCachedPrelinkedKernel (
   ASSERT (Prelinked->PrelinkedSize > 0);
 
   if (!MachoInitializeContext (&NewKext->Context.MachContext, &Prelinked->Prelinked[0], Prelinked->PrelinkedSize)) {
-    FreePool (NewKext);
     return NULL;
   }
 
@@ -590,7 +984,6 @@ InternalCachedPrelinkedKernel (
     "__TEXT"
     );
   if (Segment == NULL || Segment->VirtualAddress < Segment->FileOffset) {
-    FreePool (NewKext);
     return NULL;
   }
 
@@ -601,7 +994,7 @@ InternalCachedPrelinkedKernel (
   NewKext->Context.VirtualBase  = Segment->VirtualAddress - Segment->FileOffset;
   NewKext->Context.VirtualKmod  = 0;
 
-  InsertTailList (&Prelinked->PrelinkedKexts, &NewKext->Link);
+  InternalInsertPrelinkedKext (Prelinked, NewKext);
 
   return NewKext;
 }
@@ -755,18 +1148,28 @@ InternalScanPrelinkedKext (
   return RETURN_SUCCESS;
 }
 
-VOID
-InternalUnlockContextKexts (
-  IN PRELINKED_CONTEXT                *Context
+UINT32
+InternalNewVisitEpoch (
+  IN OUT PRELINKED_CONTEXT  *Context
   )
 {
   LIST_ENTRY  *Kext;
 
-  Kext = GetFirstNode (&Context->PrelinkedKexts);
-  while (!IsNull (&Context->PrelinkedKexts, Kext)) {
-    GET_PRELINKED_KEXT_FROM_LINK (Kext)->Processed = FALSE;
-    Kext = GetNextNode (&Context->PrelinkedKexts, Kext);
+  ++Context->KextVisitEpoch;
+  //
+  // Forget all visits on wraparound, 0 is never used as an epoch.
+  //
+  if (Context->KextVisitEpoch == 0) {
+    Kext = GetFirstNode (&Context->PrelinkedKexts);
+    while (!IsNull (&Context->PrelinkedKexts, Kext)) {
+      GET_PRELINKED_KEXT_FROM_LINK (Kext)->VisitEpoch = 0;
+      Kext = GetNextNode (&Context->PrelinkedKexts, Kext);
+    }
+
+    Context->KextVisitEpoch = 1;
   }
+
+  return Context->KextVisitEpoch;
 }
 
 PRELINKED_KEXT *
@@ -788,39 +1191,33 @@ InternalLinkPrelinkedKext (
 
   Status = InternalScanPrelinkedKext (Kext, Context, FALSE);
   if (RETURN_ERROR (Status)) {
-    InternalFreePrelinkedKext (Kext);
+    InternalFreePrelinkedKext (Context, Kext);
     return NULL;
   }
 
   //
   // Detach Identifier from temporary memory location.
   //
-  Kext->Identifier = AllocateCopyPool (AsciiStrSize (Kext->Identifier), Kext->Identifier);
+  Kext->Identifier = MemoryArenaAllocateCopy (
+    &Context->Arena,
+    (UINT32) AsciiStrSize (Kext->Identifier),
+    Kext->Identifier
+    );
   if (Kext->Identifier == NULL) {
-    InternalFreePrelinkedKext (Kext);
-    return NULL;
-  }
-
-  Status = PrelinkedDependencyInsert (Context, (VOID *)Kext->Identifier);
-  if (RETURN_ERROR (Status)) {
-    FreePool ((VOID *)Kext->Identifier);
-    InternalFreePrelinkedKext (Kext);
+    InternalFreePrelinkedKext (Context, Kext);
     return NULL;
   }
   //
   // Also detach bundle compatible version if any.
   //
   if (Kext->CompatibleVersion != NULL) {
-    Kext->CompatibleVersion = AllocateCopyPool (AsciiStrSize (Kext->CompatibleVersion), Kext->CompatibleVersion);
+    Kext->CompatibleVersion = MemoryArenaAllocateCopy (
+      &Context->Arena,
+      (UINT32) AsciiStrSize (Kext->CompatibleVersion),
+      Kext->CompatibleVersion
+      );
     if (Kext->CompatibleVersion == NULL) {
-      InternalFreePrelinkedKext (Kext);
-      return NULL;
-    }
-
-    Status = PrelinkedDependencyInsert (Context, (VOID *)Kext->CompatibleVersion);
-    if (RETURN_ERROR (Status)) {
-      FreePool ((VOID *)Kext->CompatibleVersion);
-      InternalFreePrelinkedKext (Kext);
+      InternalFreePrelinkedKext (Context, Kext);
       return NULL;
     }
   }
@@ -833,7 +1230,7 @@ InternalLinkPrelinkedKext (
   Status = InternalPrelinkKext64 (Context, Kext, LoadAddress);
 
   if (RETURN_ERROR (Status)) {
-    InternalFreePrelinkedKext (Kext);
+    InternalFreePrelinkedKext (Context, Kext);
     return NULL;
   }
 
@@ -848,6 +1245,12 @@ InternalLinkPrelinkedKext (
   // We could also store the name's offset and access via a StringTable pointer,
   // yet it was prone to errors and was already removed once.
   //
+  if (Kext->VtableIndex != NULL) {
+    FreePool (Kext->VtableIndex);
+    Kext->VtableIndex     = NULL;
+    Kext->VtableIndexSize = 0;
+  }
+
   if (Kext->LinkedVtables != NULL) {
     FreePool (Kext->LinkedVtables);
     Kext->LinkedVtables   = NULL;
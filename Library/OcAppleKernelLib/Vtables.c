@@ -26,29 +26,47 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include "PrelinkedInternal.h"
 
+STATIC
 CONST PRELINKED_VTABLE *
 InternalGetOcVtableByNameWorker (
-  IN PRELINKED_CONTEXT     *Context,
   IN PRELINKED_KEXT        *Kext,
-  IN CONST CHAR8           *Name
+  IN CONST CHAR8           *Name,
+  IN UINT32                NameHash,
+  IN UINT32                Epoch
   )
 {
   CONST PRELINKED_VTABLE *Vtable;
 
   UINTN                  Index;
+  UINT32                 Mask;
+  UINT32                 Slot;
   PRELINKED_KEXT         *Dependency;
   INTN                   Result;
 
-  Kext->Processed = TRUE;
+  Kext->VisitEpoch = Epoch;
 
-  for (
-    Index = 0, Vtable = Kext->LinkedVtables;
-    Index < Kext->NumberOfVtables;
-    ++Index, Vtable = GET_NEXT_PRELINKED_VTABLE (Vtable)
-    ) {
-    Result = AsciiStrCmp (Vtable->Name, Name);
-    if (Result == 0) {
-      return Vtable;
+  if (Kext->VtableIndex != NULL) {
+    Mask = Kext->VtableIndexSize - 1;
+    for (
+      Slot = NameHash & Mask;
+      Kext->VtableIndex[Slot] != NULL;
+      Slot = (Slot + 1) & Mask
+      ) {
+      Vtable = Kext->VtableIndex[Slot];
+      if (AsciiStrCmp (Vtable->Name, Name) == 0) {
+        return Vtable;
+      }
+    }
+  } else {
+    for (
+      Index = 0, Vtable = Kext->LinkedVtables;
+      Index < Kext->NumberOfVtables;
+      ++Index, Vtable = GET_NEXT_PRELINKED_VTABLE (Vtable)
+      ) {
+      Result = AsciiStrCmp (Vtable->Name, Name);
+      if (Result == 0) {
+        return Vtable;
+      }
     }
   }
 
@@ -58,11 +76,11 @@ InternalGetOcVtableByNameWorker (
       break;
     }
 
-    if (Dependency->Processed) {
+    if (Dependency->VisitEpoch == Epoch) {
       continue;
     }
 
-    Vtable = InternalGetOcVtableByName (Context, Dependency, Name);
+    Vtable = InternalGetOcVtableByNameWorker (Dependency, Name, NameHash, Epoch);
     if (Vtable != NULL) {
       return Vtable;
     }
@@ -78,13 +96,12 @@ InternalGetOcVtableByName (
   IN CONST CHAR8           *Name
   )
 {
-  CONST PRELINKED_VTABLE *Vtable;
-
-  Vtable = InternalGetOcVtableByNameWorker (Context, Kext, Name);
-
-  InternalUnlockContextKexts (Context);
-
-  return Vtable;
+  return InternalGetOcVtableByNameWorker (
+           Kext,
+           Name,
+           InternalHashSymbolName (Name, (UINT32)AsciiStrLen (Name)),
+           InternalNewVisitEpoch (Context)
+           );
 }
 
 STATIC
@@ -350,126 +350,165 @@ OcAppleRamDiskAllocate (
 }
 
 BOOLEAN
-OcAppleRamDiskRead (
-  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
-  IN  UINTN                              Offset,
-  IN  UINTN                              Size,
-  OUT VOID                               *Buffer
+OcAppleRamDiskInitializeContext (
+  OUT OC_APPLE_RAM_DISK_CONTEXT          *Context,
+  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable
   )
 {
-  UINT8                       *BufferBytes;
+  UINT32  Index;
+  UINTN   CurrentOffset;
 
-  UINT32                      Index;
-  CONST APPLE_RAM_DISK_EXTENT *Extent;
+  ASSERT (Context != NULL);
+  ASSERT (ExtentTable != NULL);
+  INTERNAL_ASSERT_EXTENT_TABLE_VALID (ExtentTable);
+
+  STATIC_ASSERT (
+    OC_APPLE_RAM_DISK_MAX_EXTENTS == ARRAY_SIZE (ExtentTable->Extents),
+    "Extent index must fit every extent"
+    );
+
+  CurrentOffset = 0;
+  for (Index = 0; Index < ExtentTable->ExtentCount; ++Index) {
+    if (ExtentTable->Extents[Index].Start > MAX_UINTN
+      || ExtentTable->Extents[Index].Length > MAX_UINTN) {
+      return FALSE;
+    }
+
+    Context->ExtentOffsets[Index] = CurrentOffset;
+
+    if (OcOverflowAddUN (CurrentOffset, (UINTN) ExtentTable->Extents[Index].Length, &CurrentOffset)) {
+      return FALSE;
+    }
+  }
+
+  Context->ExtentTable = ExtentTable;
+  Context->Size        = CurrentOffset;
+
+  return TRUE;
+}
 
-  UINTN                       CurrentOffset;
+VOID *
+OcAppleRamDiskMapRange (
+  IN  CONST OC_APPLE_RAM_DISK_CONTEXT  *Context,
+  IN  UINTN                            Offset,
+  IN  UINTN                            Size,
+  OUT UINTN                            *MappedSize
+  )
+{
+  CONST APPLE_RAM_DISK_EXTENT *Extent;
+  UINT32                      Low;
+  UINT32                      High;
+  UINT32                      Middle;
   UINTN                       LocalOffset;
-  UINTN                       LocalSize;
 
-  ASSERT (ExtentTable != NULL);
-  INTERNAL_ASSERT_EXTENT_TABLE_VALID (ExtentTable);
+  ASSERT (Context != NULL);
   ASSERT (Size > 0);
-  ASSERT (Buffer != NULL);
+  ASSERT (MappedSize != NULL);
+
+  if (Offset >= Context->Size) {
+    return NULL;
+  }
 
-  BufferBytes = Buffer;
   //
-  // As per the allocation algorithm, the sum over all Extent->Length must be
-  // smaller than MAX_UINTN.
+  // Find the last extent starting at or before Offset. Empty extents share
+  // their offset with the next one and are thus skipped.
   //
-  for (
-    Index = 0, CurrentOffset = 0;
-    Index < ExtentTable->ExtentCount;
-    ++Index, CurrentOffset += (UINTN)Extent->Length
-    ) {
-    Extent = &ExtentTable->Extents[Index];
-    ASSERT (Extent->Start <= MAX_UINTN);
-    ASSERT (Extent->Length <= MAX_UINTN);
-
-    if (Offset >= CurrentOffset && (Offset - CurrentOffset) < Extent->Length) {
-      LocalOffset = (Offset - CurrentOffset);
-      LocalSize   = (UINTN)MIN ((Extent->Length - LocalOffset), Size);
-      CopyMem (
-        BufferBytes,
-        (VOID *)((UINTN)Extent->Start + LocalOffset),
-        LocalSize
-        );
+  Low  = 0;
+  High = Context->ExtentTable->ExtentCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Context->ExtentOffsets[Middle] <= Offset) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
 
-      Size -= LocalSize;
-      if (Size == 0) {
-        return TRUE;
-      }
+  ASSERT (Low > 0);
+
+  Extent      = &Context->ExtentTable->Extents[Low - 1];
+  LocalOffset = Offset - Context->ExtentOffsets[Low - 1];
+  ASSERT (LocalOffset < Extent->Length);
+
+  *MappedSize = (UINTN) MIN (Extent->Length - LocalOffset, Size);
+  return (VOID *)((UINTN) Extent->Start + LocalOffset);
+}
 
-      BufferBytes += LocalSize;
-      Offset      += LocalSize;
+BOOLEAN
+OcAppleRamDiskRead (
+  IN  CONST OC_APPLE_RAM_DISK_CONTEXT  *Context,
+  IN  UINTN                            Offset,
+  IN  UINTN                            Size,
+  OUT VOID                             *Buffer
+  )
+{
+  UINT8  *BufferBytes;
+  VOID   *Data;
+  UINTN  LocalSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (Size > 0);
+  ASSERT (Buffer != NULL);
+
+  BufferBytes = Buffer;
+
+  while (Size > 0) {
+    Data = OcAppleRamDiskMapRange (Context, Offset, Size, &LocalSize);
+    if (Data == NULL) {
+      return FALSE;
     }
+
+    CopyMem (BufferBytes, Data, LocalSize);
+
+    BufferBytes += LocalSize;
+    Offset      += LocalSize;
+    Size        -= LocalSize;
   }
 
-  return FALSE;
+  return TRUE;
 }
 
 BOOLEAN
 OcAppleRamDiskWrite (
-  IN CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
-  IN UINTN                              Offset,
-  IN UINTN                              Size,
-  IN CONST VOID                         *Buffer
+  IN CONST OC_APPLE_RAM_DISK_CONTEXT  *Context,
+  IN UINTN                            Offset,
+  IN UINTN                            Size,
+  IN CONST VOID                       *Buffer
   )
 {
-  CONST UINT8                 *BufferBytes;
-
-  UINT32                      Index;
-  CONST APPLE_RAM_DISK_EXTENT *Extent;
-
-  UINTN                       CurrentOffset;
-  UINTN                       LocalOffset;
-  UINTN                       LocalSize;
+  CONST UINT8  *BufferBytes;
+  VOID         *Data;
+  UINTN        LocalSize;
 
-  ASSERT (ExtentTable != NULL);
-  INTERNAL_ASSERT_EXTENT_TABLE_VALID (ExtentTable);
+  ASSERT (Context != NULL);
   ASSERT (Size > 0);
   ASSERT (Buffer != NULL);
 
   BufferBytes = Buffer;
-  //
-  // As per the allocation algorithm, the sum over all Extent->Length must be
-  // smaller than MAX_UINTN.
-  //
-  for (
-    Index = 0, CurrentOffset = 0;
-    Index < ExtentTable->ExtentCount;
-    ++Index, CurrentOffset += (UINTN)Extent->Length
-    ) {
-    Extent = &ExtentTable->Extents[Index];
-    ASSERT (Extent->Start <= MAX_UINTN);
-    ASSERT (Extent->Length <= MAX_UINTN);
-
-    if (Offset >= CurrentOffset && (Offset - CurrentOffset) < Extent->Length) {
-      LocalOffset = (Offset - CurrentOffset);
-      LocalSize   = (UINTN)MIN ((Extent->Length - LocalOffset), Size);
-      CopyMem (
-        (VOID *)((UINTN)Extent->Start + LocalOffset),
-        BufferBytes,
-        LocalSize
-        );
-
-      Size -= LocalSize;
-      if (Size == 0) {
-        return TRUE;
-      }
 
-      BufferBytes += LocalSize;
-      Offset      += LocalSize;
+  while (Size > 0) {
+    Data = OcAppleRamDiskMapRange (Context, Offset, Size, &LocalSize);
+    if (Data == NULL) {
+      return FALSE;
     }
+
+    CopyMem (Data, BufferBytes, LocalSize);
+
+    BufferBytes += LocalSize;
+    Offset      += LocalSize;
+    Size        -= LocalSize;
   }
 
-  return FALSE;
+  return TRUE;
 }
 
 BOOLEAN
 OcAppleRamDiskLoadFile (
   IN CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
   IN EFI_FILE_PROTOCOL                  *File,
-  IN UINTN                              FileSize
+  IN UINTN                              FileSize,
+  IN OC_APPLE_RAM_DISK_LOAD_CALLBACK    Callback         OPTIONAL,
+  IN VOID                               *CallbackContext OPTIONAL
   )
 {
   EFI_STATUS      Status;
@@ -535,6 +574,15 @@ OcAppleRamDiskLoadFile (
       Sha256Update (&Ctx, TmpBuffer, ReadSize);
       DEBUG_CODE_END ();
 
+      //
+      // Pass the data while it is still in cache, e.g. for verification.
+      //
+      if (Callback != NULL && !Callback (CallbackContext, TmpBuffer, ReadSize)) {
+        DEBUG ((DEBUG_INFO, "OCRAM: Load callback aborted at %Lu\n", FilePosition));
+        FreePool (TmpBuffer);
+        return FALSE;
+      }
+
       CopyMem (ExtentBuffer, TmpBuffer, ReadSize);
 
       FilePosition += ReadSize;
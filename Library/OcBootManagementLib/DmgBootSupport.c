@@ -107,39 +107,45 @@ InternalGetFirstDeviceBootFilePath (
   return BootDevicePath;
 }
 
+/**
+  Prepare DMG chunklist context as requested by Policy.
+
+  @param[out] ChunklistContext     Chunklist context to initialise.
+  @param[out] VerifyData           Whether DMG data must be verified against
+                                   ChunklistContext.
+  @param[in]  Policy               Loading policy.
+  @param[in]  ChunklistBuffer      Chunklist data.
+  @param[in]  ChunklistBufferSize  Chunklist data size.
+
+  @retval TRUE when DMG may be loaded.
+**/
 STATIC
-EFI_DEVICE_PATH_PROTOCOL *
-InternalGetDiskImageBootFile (
-  OUT INTERNAL_DMG_LOAD_CONTEXT   *Context,
-  IN  APPLE_BOOT_POLICY_PROTOCOL  *BootPolicy,
+BOOLEAN
+InternalPrepareDmgChunklist (
+  OUT OC_APPLE_CHUNKLIST_CONTEXT  *ChunklistContext,
+  OUT BOOLEAN                     *VerifyData,
   IN  UINT32                      Policy,
-  IN  UINTN                       DmgFileSize,
   IN  VOID                        *ChunklistBuffer OPTIONAL,
   IN  UINT32                      ChunklistBufferSize OPTIONAL
   )
 {
-  EFI_DEVICE_PATH_PROTOCOL       *DevPath;
-
-  BOOLEAN                        Result;
-  OC_APPLE_CHUNKLIST_CONTEXT     ChunklistContext;
+  BOOLEAN  Result;
 
-  CONST EFI_DEVICE_PATH_PROTOCOL *DmgDevicePath;
-  UINTN                          DmgDevicePathSize;
+  ASSERT (ChunklistContext != NULL);
+  ASSERT (VerifyData != NULL);
 
-  ASSERT (Context != NULL);
-  ASSERT (BootPolicy != NULL);
-  ASSERT (DmgFileSize > 0);
+  *VerifyData = FALSE;
 
   if (ChunklistBuffer == NULL) {
     if ((Policy & OC_LOAD_REQUIRE_APPLE_SIGN) != 0) {
       DEBUG ((DEBUG_WARN, "Missing DMG signature, aborting\n"));
-      return NULL;
+      return FALSE;
     }
   } else if ((Policy & (OC_LOAD_VERIFY_APPLE_SIGN | OC_LOAD_REQUIRE_TRUSTED_KEY)) != 0) {
     ASSERT (ChunklistBufferSize > 0);
 
     Result = OcAppleChunklistInitializeContext (
-                &ChunklistContext,
+                ChunklistContext,
                 ChunklistBuffer,
                 ChunklistBufferSize
                 );
@@ -148,7 +154,7 @@ InternalGetDiskImageBootFile (
         DEBUG_INFO,
         "OCB: Failed to initialise DMG Chunklist context\n"
         ));
-      return NULL;
+      return FALSE;
     }
 
     if ((Policy & OC_LOAD_REQUIRE_TRUSTED_KEY) != 0) {
@@ -158,38 +164,61 @@ InternalGetDiskImageBootFile (
       //
       if ((Policy & OC_LOAD_TRUST_APPLE_V1_KEY) != 0) {
         Result = OcAppleChunklistVerifySignature (
-                   &ChunklistContext,
+                   ChunklistContext,
                    PkDataBase[0].PublicKey
                    );
       }
 
       if (!Result && ((Policy & OC_LOAD_TRUST_APPLE_V2_KEY) != 0)) {
         Result = OcAppleChunklistVerifySignature (
-                   &ChunklistContext,
+                   ChunklistContext,
                    PkDataBase[1].PublicKey
                    );
       }
 
       if (!Result) {
         DEBUG ((DEBUG_WARN, "DMG is not trusted, aborting\n"));
-        return NULL;
+        return FALSE;
       }
     }
 
-    Result = OcAppleDiskImageVerifyData (
-               Context->DmgContext,
-               &ChunklistContext
-               );
-    if (!Result) {
-      DEBUG ((DEBUG_WARN, "DMG has been altered\n"));
-      //
-      // FIXME: Warn user instead of aborting when OC_LOAD_REQUIRE_TRUSTED_KEY
-      //        is not set.
-      //
-      return NULL;
-    }
+    *VerifyData = TRUE;
   }
 
+  return TRUE;
+}
+
+/**
+  Verify DMG data read by OcAppleRamDiskLoadFile against the chunklist.
+**/
+STATIC
+BOOLEAN
+InternalVerifyDmgData (
+  IN VOID        *Context,
+  IN CONST VOID  *Data,
+  IN UINTN       DataSize
+  )
+{
+  return OcAppleChunklistVerifyStreamUpdate (Context, Data, DataSize);
+}
+
+STATIC
+EFI_DEVICE_PATH_PROTOCOL *
+InternalGetDiskImageBootFile (
+  OUT INTERNAL_DMG_LOAD_CONTEXT   *Context,
+  IN  APPLE_BOOT_POLICY_PROTOCOL  *BootPolicy,
+  IN  UINTN                       DmgFileSize
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL       *DevPath;
+
+  CONST EFI_DEVICE_PATH_PROTOCOL *DmgDevicePath;
+  UINTN                          DmgDevicePathSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (BootPolicy != NULL);
+  ASSERT (DmgFileSize > 0);
+
   Context->BlockIoHandle = OcAppleDiskImageInstallBlockIo (
                              Context->DmgContext,
                              DmgFileSize,
@@ -335,10 +364,12 @@ InternalLoadDmg (
   EFI_FILE_PROTOCOL        *DmgFile;
   UINT32                   DmgFileSize;
 
-  EFI_FILE_INFO            *ChunklistFileInfo;
-  EFI_FILE_PROTOCOL        *ChunklistFile;
-  UINT32                   ChunklistFileSize;
-  VOID                     *ChunklistBuffer;
+  EFI_FILE_INFO              *ChunklistFileInfo;
+  EFI_FILE_PROTOCOL          *ChunklistFile;
+  UINT32                     ChunklistFileSize;
+  VOID                       *ChunklistBuffer;
+  OC_APPLE_CHUNKLIST_CONTEXT ChunklistContext;
+  BOOLEAN                    VerifyData;
 
   CHAR16 *DevPathText;
 
@@ -408,25 +439,6 @@ InternalLoadDmg (
     return NULL;
   }
 
-  Context->DmgContext = AllocatePool (sizeof (*Context->DmgContext));
-  if (Context->DmgContext == NULL) {
-    DEBUG ((DEBUG_INFO, "OCB: Failed to allocate DMG context\n"));
-    return NULL;
-  }
-
-  Result = OcAppleDiskImageInitializeFromFile (Context->DmgContext, DmgFile);
-
-  DmgFile->Close (DmgFile);
-
-  if (!Result) {
-    DEBUG ((DEBUG_INFO, "OCB: Failed to initialise DMG from file\n"));
-
-    FreePool (DmgFileInfo);
-    FreePool (Context->DmgContext);
-    DmgDir->Close (DmgDir);
-    return NULL;
-  }
-
   ChunklistBuffer   = NULL;
   ChunklistFileSize = 0;
 
@@ -470,13 +482,76 @@ InternalLoadDmg (
 
   DmgDir->Close (DmgDir);
 
+  //
+  // Chunklist is verified before loading the DMG, so that DMG data can be
+  // verified while it is read instead of making another pass over it.
+  //
+  Result = InternalPrepareDmgChunklist (
+             &ChunklistContext,
+             &VerifyData,
+             Policy,
+             ChunklistBuffer,
+             ChunklistFileSize
+             );
+
+  Context->DmgContext = NULL;
+  if (Result) {
+    Context->DmgContext = AllocatePool (sizeof (*Context->DmgContext));
+    if (Context->DmgContext == NULL) {
+      DEBUG ((DEBUG_INFO, "OCB: Failed to allocate DMG context\n"));
+    }
+  }
+
+  if (Context->DmgContext == NULL) {
+    DmgFile->Close (DmgFile);
+    if (ChunklistBuffer != NULL) {
+      FreePool (ChunklistBuffer);
+    }
+
+    return NULL;
+  }
+
+  if (VerifyData) {
+    OcAppleChunklistVerifyStreamStart (&ChunklistContext);
+  }
+
+  Result = OcAppleDiskImageInitializeFromFile (
+             Context->DmgContext,
+             DmgFile,
+             VerifyData ? InternalVerifyDmgData : NULL,
+             VerifyData ? &ChunklistContext : NULL
+             );
+
+  DmgFile->Close (DmgFile);
+
+  if (Result && VerifyData && !OcAppleChunklistVerifyStreamEnd (&ChunklistContext)) {
+    DEBUG ((DEBUG_INFO, "OCB: DMG is shorter than its chunklist\n"));
+    OcAppleDiskImageFreeFile (Context->DmgContext);
+    Result = FALSE;
+  }
+
+  if (ChunklistBuffer != NULL) {
+    FreePool (ChunklistBuffer);
+  }
+
+  if (!Result) {
+    DEBUG ((DEBUG_INFO, "OCB: Failed to initialise DMG from file\n"));
+    if (VerifyData) {
+      DEBUG ((DEBUG_WARN, "DMG has been altered or could not be read\n"));
+      //
+      // FIXME: Warn user instead of aborting when OC_LOAD_REQUIRE_TRUSTED_KEY
+      //        is not set.
+      //
+    }
+
+    FreePool (Context->DmgContext);
+    return NULL;
+  }
+
   DevPath = InternalGetDiskImageBootFile (
               Context,
               BootPolicy,
-              Policy,
-              DmgFileSize,
-              ChunklistBuffer,
-              ChunklistFileSize
+              DmgFileSize
               );
   Context->DevicePath = DevPath;
 
@@ -487,10 +562,6 @@ InternalLoadDmg (
     FreePool (Context->DmgContext);
   }
 
-  if (ChunklistBuffer != NULL) {
-    FreePool (ChunklistBuffer);
-  }
-
   return DevPath;
 }
 
@@ -0,0 +1,105 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcCompressionLib.h>
+
+#include "lzss/lzss.h"
+#include "lzvn/lzvn.h"
+#include "zlib/zlib.h"
+
+struct OC_DECOMPRESS_STREAM_ {
+  UINT32  Algorithm;
+  VOID    *State;
+};
+
+OC_DECOMPRESS_STREAM *
+DecompressStreamCreate (
+  IN  UINT32  Algorithm,
+  OUT UINT8   *Dst,
+  IN  UINT32  DstLen
+  )
+{
+  OC_DECOMPRESS_STREAM  *Stream;
+
+  Stream = AllocatePool (sizeof (*Stream));
+  if (Stream == NULL) {
+    return NULL;
+  }
+
+  Stream->Algorithm = Algorithm;
+
+  if (Algorithm == OC_DECOMPRESS_STREAM_LZSS) {
+    Stream->State = lzss_stream_create (Dst, DstLen);
+  } else if (Algorithm == OC_DECOMPRESS_STREAM_LZVN) {
+    Stream->State = lzvn_stream_create (Dst, DstLen);
+  } else {
+    Stream->State = NULL;
+  }
+
+  if (Stream->State == NULL) {
+    FreePool (Stream);
+    return NULL;
+  }
+
+  return Stream;
+}
+
+UINT32
+DecompressStreamUpdate (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+  IN     CONST UINT8           *Src,
+  IN     UINT32                SrcLen,
+     OUT UINT32                *DstLen
+  )
+{
+  UINTN  Consumed;
+  UINTN  Produced;
+
+  ASSERT (Stream != NULL);
+  ASSERT (DstLen != NULL);
+
+  if (Stream->Algorithm == OC_DECOMPRESS_STREAM_LZSS) {
+    return lzss_stream_update (Stream->State, Src, SrcLen, DstLen);
+  }
+
+  Consumed = lzvn_stream_update (Stream->State, Src, SrcLen, &Produced);
+  *DstLen  = (UINT32) Produced;
+  return (UINT32) Consumed;
+}
+
+VOID
+DecompressStreamFree (
+  IN OC_DECOMPRESS_STREAM  *Stream
+  )
+{
+  ASSERT (Stream != NULL);
+
+  FreePool (Stream->State);
+  FreePool (Stream);
+}
+
+UINT32
+Adler32 (
+  IN UINT32       Adler,
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  )
+{
+  return (UINT32) adler32_z (Adler, Buffer, Length);
+}
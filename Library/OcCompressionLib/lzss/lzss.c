@@ -137,6 +137,95 @@ u_int32_t decompress_lzss(
     return (u_int32_t)(dst - dststart);
 }
 
+/*******************************************************************************
+ * Incremental variant of decompress_lzss, which may be fed the source in parts.
+ * Tokens are only consumed once complete, so the output is identical.
+ ******************************************************************************/
+struct lzss_decode_state {
+    /* ring buffer of size N, with extra F-1 bytes to aid string comparison */
+    u_int8_t text_buf[N + F - 1];
+    u_int8_t * dststart;
+    u_int8_t * dst;
+    u_int8_t * dstend;
+    int r;
+    unsigned int flags;
+};
+
+void * lzss_stream_create(
+    u_int8_t       * dst,
+    u_int32_t        dstlen)
+{
+    struct lzss_decode_state * sp;
+
+    if (dstlen > OC_COMPRESSION_MAX_LENGTH) {
+        return NULL;
+    }
+
+    sp = malloc(sizeof(*sp));
+    if (sp == NULL) {
+        return NULL;
+    }
+
+    memset(sp->text_buf, ' ', N - F);
+    sp->dststart = dst;
+    sp->dst = dst;
+    sp->dstend = dst + dstlen;
+    sp->r = N - F;
+    sp->flags = 0;
+
+    return sp;
+}
+
+u_int32_t lzss_stream_update(
+    void           * state,
+    const u_int8_t * src,
+    u_int32_t        srclen,
+    u_int32_t      * dstpos)
+{
+    struct lzss_decode_state * sp = state;
+    const u_int8_t * srcstart = src;
+    const u_int8_t * srcend = src + srclen;
+    const u_int8_t * pos;
+    int  i, j, k;
+    u_int8_t c;
+    unsigned int flags;
+
+    while (sp->dst < sp->dstend) {
+        /* peek the next token and stop if it is incomplete */
+        pos = src;
+        flags = sp->flags >> 1;
+        if ((flags & 0x100) == 0) {
+            if (pos < srcend) flags = *pos++ | 0xFF00; else break;
+        }
+        if (srcend - pos < ((flags & 1) ? 1 : 2)) {
+            break;
+        }
+        sp->flags = flags;
+        src = pos;
+
+        if (flags & 1) {
+            c = *src++;
+            *sp->dst++ = c;
+            sp->text_buf[sp->r++] = c;
+            sp->r &= (N - 1);
+        } else {
+            i = *src++;
+            j = *src++;
+            i |= ((j & 0xF0) << 4);
+            j  =  (j & 0x0F) + THRESHOLD;
+            for (k = 0; k <= j && sp->dst < sp->dstend; k++) {
+                c = sp->text_buf[(i + k) & (N - 1)];
+                *sp->dst++ = c;
+                sp->text_buf[sp->r++] = c;
+                sp->r &= (N - 1);
+            }
+        }
+    }
+
+    *dstpos = (u_int32_t)(sp->dst - sp->dststart);
+    return (u_int32_t)(src - srcstart);
+}
+
 /*
  * initialize state, mostly the trees
  *
@@ -148,10 +237,14 @@ u_int32_t decompress_lzss(
  * Note there are 256 trees. */
 static void init_state(struct encode_state *sp)
 {
+    int  i;
+
     bzero(sp, sizeof(*sp));
     memset(&sp->text_buf[0], ' ', N - F);
-    bzero(&sp->rchild[N + 1], 256 * sizeof(sp->rchild[0]));
-    bzero(&sp->parent[0], N * sizeof(sp->parent[0]));
+    for (i = N + 1; i <= N + 256; i++)
+        sp->rchild[i] = NIL;
+    for (i = 0; i < N; i++)
+        sp->parent[i] = NIL;
 }
 
 /*
@@ -30,6 +30,17 @@ typedef INT32 int32_t;
 #define compress_lzss CompressLZSS
 #define decompress_lzss DecompressLZSS
 
+/**
+  Create incremental LZSS decompression state, freed with FreePool.
+**/
+void * lzss_stream_create(u_int8_t * dst, u_int32_t dstlen);
+
+/**
+  Decompress complete LZSS tokens from src, returning the number of bytes
+  consumed and the number of decompressed bytes in dstpos.
+**/
+u_int32_t lzss_stream_update(void * state, const u_int8_t * src, u_int32_t srclen, u_int32_t * dstpos);
+
 #ifdef memset
 #undef memset
 #endif
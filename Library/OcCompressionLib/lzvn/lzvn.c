@@ -843,3 +843,39 @@ size_t lzvn_decode_buffer(unsigned char *dst, size_t dst_size,
   // This is how much we decompressed
   return dstate.dst - dst;
 }
+
+void *lzvn_stream_create(unsigned char *dst, size_t dst_size) {
+  lzvn_decoder_state *dstate;
+
+  if (dst_size > OC_COMPRESSION_MAX_LENGTH) {
+    return NULL;
+  }
+
+  dstate = AllocateZeroPool(sizeof(*dstate));
+  if (dstate == NULL) {
+    return NULL;
+  }
+
+  dstate->dst_begin = dst;
+  dstate->dst = dst;
+  dstate->dst_end = dst + dst_size;
+
+  return dstate;
+}
+
+size_t lzvn_stream_update(void *state, const unsigned char *src,
+                          size_t src_size, size_t *dst_pos) {
+  lzvn_decoder_state *dstate = state;
+
+  // The decoder stops at the beginning of a truncated instruction, so it can
+  // be resumed once the rest of the instruction is appended to the source.
+  dstate->src = src;
+  dstate->src_end = src + src_size;
+
+  if (!dstate->end_of_stream) {
+    lzvn_decode(dstate);
+  }
+
+  *dst_pos = dstate->dst - dstate->dst_begin;
+  return dstate->src - src;
+}
@@ -16,6 +16,7 @@
 #define LZVN_H
 
 #include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcCompressionLib.h>
 
 typedef UINT16 uint16_t;
@@ -31,6 +32,18 @@ typedef UINTN uintmax_t;
 
 #define lzvn_decode_buffer DecompressLZVN
 
+/**
+  Create incremental LZVN decompression state, freed with FreePool.
+**/
+void *lzvn_stream_create(unsigned char *dst, size_t dst_size);
+
+/**
+  Decompress complete LZVN instructions from src, returning the number of
+  bytes consumed and the number of decompressed bytes in dst_pos.
+**/
+size_t lzvn_stream_update(void *state, const unsigned char *src,
+                          size_t src_size, size_t *dst_pos);
+
 #ifdef memset
 #undef memset
 #endif
@@ -325,6 +325,7 @@ mMiscConfigurationBootSchema[] = {
   OC_SCHEMA_BOOLEAN_IN ("HideSelf",            OC_GLOBAL_CONFIG, Misc.Boot.HideSelf),
   OC_SCHEMA_INTEGER_IN ("PickerAttributes",    OC_GLOBAL_CONFIG, Misc.Boot.PickerAttributes),
   OC_SCHEMA_BOOLEAN_IN ("PickerAudioAssist",   OC_GLOBAL_CONFIG, Misc.Boot.PickerAudioAssist),
+  OC_SCHEMA_BOOLEAN_IN ("PickerImageCache",    OC_GLOBAL_CONFIG, Misc.Boot.PickerImageCache),
   OC_SCHEMA_STRING_IN  ("PickerMode",          OC_GLOBAL_CONFIG, Misc.Boot.PickerMode),
   OC_SCHEMA_BOOLEAN_IN ("PollAppleHotKeys",    OC_GLOBAL_CONFIG, Misc.Boot.PollAppleHotKeys),
   OC_SCHEMA_BOOLEAN_IN ("ShowPicker",          OC_GLOBAL_CONFIG, Misc.Boot.ShowPicker),
@@ -628,6 +629,13 @@ mRootConfigurationInfo = {
   .Dict = {mRootConfigurationNodes, ARRAY_SIZE (mRootConfigurationNodes)}
 };
 
+//
+// Configuration strings, data and entries live until the configuration is freed.
+//
+STATIC
+OC_MEMORY_ARENA
+mConfigurationArena;
+
 EFI_STATUS
 OcConfigurationInit (
   OUT OC_GLOBAL_CONFIG   *Config,
@@ -635,16 +643,28 @@ OcConfigurationInit (
   IN  UINT32             Size
   )
 {
-  BOOLEAN  Success;
+  BOOLEAN          Success;
+  OC_MEMORY_ARENA  *PreviousArena;
+
+  //
+  // Only one configuration is supported at a time.
+  //
+  ASSERT (mConfigurationArena.Blocks == NULL);
+
+  MemoryArenaInit (&mConfigurationArena, "Config", Size / 2);
+  PreviousArena = OcTemplateSetArena (&mConfigurationArena);
 
   OC_GLOBAL_CONFIG_CONSTRUCT (Config, sizeof (*Config));
   Success = ParseSerialized (Config, &mRootConfigurationInfo, Buffer, Size);
 
   if (!Success) {
     OC_GLOBAL_CONFIG_DESTRUCT (Config, sizeof (*Config));
+    OcTemplateSetArena (PreviousArena);
+    MemoryArenaFree (&mConfigurationArena);
     return EFI_UNSUPPORTED;
   }
 
+  OcTemplateSetArena (PreviousArena);
   return EFI_SUCCESS;
 }
 
@@ -658,5 +678,10 @@ OcConfigurationFree (
   IN OUT OC_GLOBAL_CONFIG   *Config
   )
 {
+  OC_MEMORY_ARENA  *PreviousArena;
+
+  PreviousArena = OcTemplateSetArena (&mConfigurationArena);
   OC_GLOBAL_CONFIG_DESTRUCT (Config, sizeof (*Config));
+  OcTemplateSetArena (PreviousArena);
+  MemoryArenaFree (&mConfigurationArena);
 }
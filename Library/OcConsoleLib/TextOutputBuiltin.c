@@ -165,7 +165,12 @@ STATIC UINT32 mConsoleGopMode;
 STATIC UINT8  mFontScale;
 STATIC EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION mBackgroundColor;
 STATIC EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION mForegroundColor;
-STATIC EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION *mCharacterBuffer;
+STATIC EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION *mShadowBuffer;
+STATIC UINTN  mShadowWidth;
+STATIC UINTN  mDirtyMinX;
+STATIC UINTN  mDirtyMinY;
+STATIC UINTN  mDirtyMaxX;
+STATIC UINTN  mDirtyMaxY;
 STATIC EFI_CONSOLE_CONTROL_SCREEN_MODE     mConsoleMode = EfiConsoleControlScreenText;
 
 #define SCR_PADD           1
@@ -180,7 +185,106 @@ STATIC EFI_CONSOLE_CONTROL_SCREEN_MODE     mConsoleMode = EfiConsoleControlScree
 #define TGT_CURSOR_HEIGHT  (mFontScale)
 
 /**
-  Render character onscreen.
+  Mark console area as changed since the last flush.
+
+  @param[in]  PosX    First character X position.
+  @param[in]  PosY    First character Y position.
+  @param[in]  Width   Area width in characters.
+  @param[in]  Height  Area height in characters.
+**/
+STATIC
+VOID
+RenderMarkDirty (
+  IN UINTN    PosX,
+  IN UINTN    PosY,
+  IN UINTN    Width,
+  IN UINTN    Height
+  )
+{
+  if (mDirtyMinX >= mDirtyMaxX) {
+    mDirtyMinX = PosX;
+    mDirtyMinY = PosY;
+    mDirtyMaxX = PosX + Width;
+    mDirtyMaxY = PosY + Height;
+    return;
+  }
+
+  mDirtyMinX = MIN (mDirtyMinX, PosX);
+  mDirtyMinY = MIN (mDirtyMinY, PosY);
+  mDirtyMaxX = MAX (mDirtyMaxX, PosX + Width);
+  mDirtyMaxY = MAX (mDirtyMaxY, PosY + Height);
+}
+
+/**
+  Transfer changed console area from the shadow buffer onscreen.
+  All changes are merged into a single rectangle, so this results
+  in at most one Blt call.
+**/
+STATIC
+VOID
+RenderFlush (
+  VOID
+  )
+{
+  if (mDirtyMinX >= mDirtyMaxX) {
+    return;
+  }
+
+  mGraphicsOutput->Blt (
+    mGraphicsOutput,
+    &mShadowBuffer[0].Pixel,
+    EfiBltBufferToVideo,
+    mDirtyMinX * TGT_CHAR_WIDTH,
+    mDirtyMinY * TGT_CHAR_HEIGHT,
+    TGT_PADD_WIDTH  + mDirtyMinX * TGT_CHAR_WIDTH,
+    TGT_PADD_HEIGHT + mDirtyMinY * TGT_CHAR_HEIGHT,
+    (mDirtyMaxX - mDirtyMinX) * TGT_CHAR_WIDTH,
+    (mDirtyMaxY - mDirtyMinY) * TGT_CHAR_HEIGHT,
+    mShadowWidth * sizeof (mShadowBuffer[0])
+    );
+
+  mDirtyMinX = 0;
+  mDirtyMaxX = 0;
+}
+
+/**
+  Fill console area in the shadow buffer with background colour.
+  The area is not marked dirty.
+
+  @param[in]  PosY    First character Y position.
+  @param[in]  Width   Area width in characters from the left.
+  @param[in]  Height  Area height in characters.
+**/
+STATIC
+VOID
+RenderClearShadow (
+  IN UINTN    PosY,
+  IN UINTN    Width,
+  IN UINTN    Height
+  )
+{
+  UINT32  *DstBuffer;
+  UINTN   Line;
+
+  DstBuffer = &mShadowBuffer[PosY * TGT_CHAR_HEIGHT * mShadowWidth].Raw;
+
+  if (Width * TGT_CHAR_WIDTH == mShadowWidth) {
+    SetMem32 (
+      DstBuffer,
+      mShadowWidth * Height * TGT_CHAR_HEIGHT * sizeof (DstBuffer[0]),
+      mBackgroundColor.Raw
+      );
+    return;
+  }
+
+  for (Line = 0; Line < Height * TGT_CHAR_HEIGHT; ++Line) {
+    SetMem32 (DstBuffer, Width * TGT_CHAR_WIDTH * sizeof (DstBuffer[0]), mBackgroundColor.Raw);
+    DstBuffer += mShadowWidth;
+  }
+}
+
+/**
+  Render character into the shadow buffer.
 
   @param[in]  Char  Character code.
   @param[in]  PosX  Character X position.
@@ -201,57 +305,55 @@ RenderChar (
   UINT32  Index2;
   UINT8   Mask;
 
-  DstBuffer = &mCharacterBuffer[0].Raw;
+  DstBuffer = &mShadowBuffer[PosY * TGT_CHAR_HEIGHT * mShadowWidth + PosX * TGT_CHAR_WIDTH].Raw;
 
-  if ((Char >= 0 && Char < ISO_CHAR_MIN) || Char == ' ' || Char == '\t' || Char == 0x7F) {
-    SetMem32 (DstBuffer, TGT_CHAR_AREA * sizeof (DstBuffer[0]), mBackgroundColor.Raw);
-  } else {
+  RenderMarkDirty (PosX, PosY, 1, 1);
 
-    if (Char < ISO_CHAR_MIN || Char > ISO_CHAR_MAX) {
-      Char = L'_';
+  if ((Char >= 0 && Char < ISO_CHAR_MIN) || Char == ' ' || Char == '\t' || Char == 0x7F) {
+    for (Line = 0; Line < TGT_CHAR_HEIGHT; ++Line) {
+      SetMem32 (DstBuffer, TGT_CHAR_WIDTH * sizeof (DstBuffer[0]), mBackgroundColor.Raw);
+      DstBuffer += mShadowWidth;
     }
+    return;
+  }
 
-    SrcBuffer = mIsoFontData + ((Char - ISO_CHAR_MIN) * (ISO_CHAR_HEIGHT - 2));
+  if (Char < ISO_CHAR_MIN || Char > ISO_CHAR_MAX) {
+    Char = L'_';
+  }
 
-    SetMem32 (DstBuffer, TGT_CHAR_WIDTH * mFontScale * sizeof (DstBuffer[0]), mBackgroundColor.Raw);
-    DstBuffer += TGT_CHAR_WIDTH * mFontScale;
+  SrcBuffer = mIsoFontData + ((Char - ISO_CHAR_MIN) * (ISO_CHAR_HEIGHT - 2));
 
-    for (Line = 0; Line < ISO_CHAR_HEIGHT - 2; ++Line) {
-      //
-      // Iterate, while the single bit drops to the right.
-      //
-      for (Index = 0; Index < mFontScale; ++Index) {
-        Mask = 1;
-        do {
-          for (Index2 = 0; Index2 < mFontScale; ++Index2) {
-            *DstBuffer = (*SrcBuffer & Mask) ? mForegroundColor.Raw : mBackgroundColor.Raw;
-            ++DstBuffer;
-          }
-          Mask <<= 1U;
-        } while (Mask != 0);
-      }
-      ++SrcBuffer;
-    }
+  for (Index = 0; Index < mFontScale; ++Index) {
+    SetMem32 (DstBuffer, TGT_CHAR_WIDTH * sizeof (DstBuffer[0]), mBackgroundColor.Raw);
+    DstBuffer += mShadowWidth;
+  }
 
-    SetMem32 (DstBuffer, TGT_CHAR_WIDTH * mFontScale * sizeof (DstBuffer[0]), mBackgroundColor.Raw);
+  for (Line = 0; Line < ISO_CHAR_HEIGHT - 2; ++Line) {
+    //
+    // Iterate, while the single bit drops to the right.
+    //
+    for (Index = 0; Index < mFontScale; ++Index) {
+      Mask = 1;
+      do {
+        for (Index2 = 0; Index2 < mFontScale; ++Index2) {
+          *DstBuffer = (*SrcBuffer & Mask) ? mForegroundColor.Raw : mBackgroundColor.Raw;
+          ++DstBuffer;
+        }
+        Mask <<= 1U;
+      } while (Mask != 0);
+      DstBuffer += mShadowWidth - TGT_CHAR_WIDTH;
+    }
+    ++SrcBuffer;
   }
 
-  mGraphicsOutput->Blt (
-    mGraphicsOutput,
-    &mCharacterBuffer[0].Pixel,
-    EfiBltBufferToVideo,
-    0,
-    0,
-    TGT_PADD_WIDTH  + PosX * TGT_CHAR_WIDTH,
-    TGT_PADD_HEIGHT + PosY * TGT_CHAR_HEIGHT,
-    TGT_CHAR_WIDTH,
-    TGT_CHAR_HEIGHT,
-    0
-    );
+  for (Index = 0; Index < mFontScale; ++Index) {
+    SetMem32 (DstBuffer, TGT_CHAR_WIDTH * sizeof (DstBuffer[0]), mBackgroundColor.Raw);
+    DstBuffer += mShadowWidth;
+  }
 }
 
 /**
-  Swap cursor visibility onscreen.
+  Swap cursor visibility in the shadow buffer.
 
   @param[in]  Enabled  Whether cursor is visible.
   @param[in]  PosX     Character X position.
@@ -265,8 +367,9 @@ FlushCursor (
   IN UINTN    PosY
   )
 {
-  EFI_STATUS                           Status;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION  Colour;
+  UINT32  *DstBuffer;
+  UINT32  Colour;
+  UINTN   Line;
 
   if (!Enabled) {
     return;
@@ -282,35 +385,18 @@ FlushCursor (
   // This is weird but EDK II implementation seems to match the logic, and as a result we
   // track cursor visibility or easily optimise this logic.
   //
-  Status = mGraphicsOutput->Blt (
-    mGraphicsOutput,
-    &Colour.Pixel,
-    EfiBltVideoToBltBuffer,
-    TGT_PADD_WIDTH  + PosX * TGT_CHAR_WIDTH  + TGT_CURSOR_X,
-    TGT_PADD_HEIGHT + PosY * TGT_CHAR_HEIGHT + TGT_CURSOR_Y,
-    0,
-    0,
-    1,
-    1,
-    0
-    );
+  DstBuffer = &mShadowBuffer[
+    (PosY * TGT_CHAR_HEIGHT + TGT_CURSOR_Y) * mShadowWidth + PosX * TGT_CHAR_WIDTH + TGT_CURSOR_X
+    ].Raw;
 
-  if (EFI_ERROR (Status)) {
-    return;
+  Colour = *DstBuffer == mForegroundColor.Raw ? mBackgroundColor.Raw : mForegroundColor.Raw;
+
+  for (Line = 0; Line < TGT_CURSOR_HEIGHT; ++Line) {
+    SetMem32 (DstBuffer, TGT_CURSOR_WIDTH * sizeof (DstBuffer[0]), Colour);
+    DstBuffer += mShadowWidth;
   }
 
-  mGraphicsOutput->Blt (
-    mGraphicsOutput,
-    Colour.Raw == mForegroundColor.Raw ? &mBackgroundColor.Pixel : &mForegroundColor.Pixel,
-    EfiBltVideoFill,
-    0,
-    0,
-    TGT_PADD_WIDTH  + PosX * TGT_CHAR_WIDTH  + TGT_CURSOR_X,
-    TGT_PADD_HEIGHT + PosY * TGT_CHAR_HEIGHT + TGT_CURSOR_Y,
-    TGT_CURSOR_WIDTH,
-    TGT_CURSOR_HEIGHT,
-    0
-    );
+  RenderMarkDirty (PosX, PosY, 1, 1);
 }
 
 STATIC
@@ -319,37 +405,25 @@ RenderScroll (
   VOID
   )
 {
+  UINTN  LineSize;
+
   //
-  // Move data.
+  // Move data. Scrolling is done in the shadow buffer, as reading
+  // back from the framebuffer with EfiBltVideoToVideo is very slow.
   //
-  mGraphicsOutput->Blt (
-    mGraphicsOutput,
-    NULL,
-    EfiBltVideoToVideo,
-    0,
-    TGT_PADD_HEIGHT + TGT_CHAR_HEIGHT,
-    0,
-    TGT_PADD_HEIGHT,
-    mGraphicsOutput->Mode->Info->HorizontalResolution,
-    TGT_CHAR_HEIGHT * (mConsoleHeight - 1),
-    0
+  LineSize = mShadowWidth * TGT_CHAR_HEIGHT;
+  CopyMem (
+    &mShadowBuffer[0],
+    &mShadowBuffer[LineSize],
+    LineSize * (mConsoleHeight - 1) * sizeof (mShadowBuffer[0])
     );
 
   //
   // Erase last line.
   //
-  mGraphicsOutput->Blt (
-    mGraphicsOutput,
-    &mBackgroundColor.Pixel,
-    EfiBltVideoFill,
-    0,
-    0,
-    0,
-    TGT_PADD_HEIGHT + TGT_CHAR_HEIGHT * (mConsoleHeight - 1),
-    mGraphicsOutput->Mode->Info->HorizontalResolution,
-    TGT_CHAR_HEIGHT,
-    0
-    );
+  RenderClearShadow (mConsoleHeight - 1, mConsoleWidth, 1);
+
+  RenderMarkDirty (0, 0, mConsoleWidth, mConsoleHeight);
 }
 
 STATIC
@@ -369,13 +443,8 @@ RenderResync (
     return EFI_DEVICE_ERROR;
   }
 
-  if (mCharacterBuffer != NULL) {
-    FreePool (mCharacterBuffer);
-  }
-
-  mCharacterBuffer = AllocatePool (TGT_CHAR_AREA * sizeof (mCharacterBuffer[0]));
-  if (mCharacterBuffer == NULL) {
-    return EFI_DEVICE_ERROR;
+  if (mShadowBuffer != NULL) {
+    FreePool (mShadowBuffer);
   }
 
   mConsoleGopMode          = mGraphicsOutput->Mode->Mode;
@@ -383,6 +452,23 @@ RenderResync (
   mConsoleHeight           = (Info->VerticalResolution   / TGT_CHAR_HEIGHT) - 2 * SCR_PADD;
   mConsoleMaxPosX          = 0;
   mConsoleMaxPosY          = 0;
+  mShadowWidth             = mConsoleWidth * TGT_CHAR_WIDTH;
+  mDirtyMinX               = 0;
+  mDirtyMaxX               = 0;
+
+  //
+  // Shadow buffer only covers the console area without padding.
+  //
+  mShadowBuffer = AllocatePool (mConsoleWidth * mConsoleHeight * TGT_CHAR_AREA * sizeof (mShadowBuffer[0]));
+  if (mShadowBuffer == NULL) {
+    //
+    // Force resync on the next call.
+    //
+    mConsoleGopMode = MAX_UINT32;
+    return EFI_DEVICE_ERROR;
+  }
+
+  RenderClearShadow (0, mConsoleWidth, mConsoleHeight);
 
   This->Mode->CursorColumn = 0;
   This->Mode->CursorRow    = 0;
@@ -537,6 +623,7 @@ AsciiTextOutputString (
   }
 
   FlushCursor (This->Mode->CursorVisible, This->Mode->CursorColumn, This->Mode->CursorRow);
+  RenderFlush ();
 
   gBS->RestoreTPL (OldTpl);
 
@@ -669,6 +756,7 @@ AsciiTextSetAttribute (
     This->Mode->Attribute = Attribute;
 
     FlushCursor (This->Mode->CursorVisible, This->Mode->CursorColumn, This->Mode->CursorRow);
+    RenderFlush ();
   }
 
   gBS->RestoreTPL (OldTpl);
@@ -718,12 +806,25 @@ AsciiTextClearScreen (
     0
     );
 
+  //
+  // Keep the shadow buffer in sync with the filled area. Pending changes
+  // are discarded, as they are all within the filled area.
+  //
+  RenderClearShadow (
+    0,
+    MIN (mConsoleMaxPosX + 1, mConsoleWidth),
+    MIN (mConsoleMaxPosY + 1, mConsoleHeight)
+    );
+  mDirtyMinX = 0;
+  mDirtyMaxX = 0;
+
   //
   // Handle cursor.
   //
   This->Mode->CursorColumn  = 0;
   This->Mode->CursorRow     = 0;
   FlushCursor (This->Mode->CursorVisible, This->Mode->CursorColumn, This->Mode->CursorRow);
+  RenderFlush ();
 
   //
   // We do not reset max here, as we may still scroll (e.g. in shell via page buttons).
@@ -760,6 +861,7 @@ AsciiTextSetCursorPosition (
     This->Mode->CursorColumn = (INT32) Column;
     This->Mode->CursorRow    = (INT32) Row;
     FlushCursor (This->Mode->CursorVisible, This->Mode->CursorColumn, This->Mode->CursorRow);
+    RenderFlush ();
     mConsoleMaxPosX = MAX (mConsoleMaxPosX, Column);
     mConsoleMaxPosY = MAX (mConsoleMaxPosY, Row);
     Status = EFI_SUCCESS;
@@ -795,6 +897,7 @@ AsciiTextEnableCursor (
   FlushCursor (This->Mode->CursorVisible, This->Mode->CursorColumn, This->Mode->CursorRow);
   This->Mode->CursorVisible = Visible;
   FlushCursor (This->Mode->CursorVisible, This->Mode->CursorColumn, This->Mode->CursorRow);
+  RenderFlush ();
   gBS->RestoreTPL (OldTpl);
   return EFI_SUCCESS;
 }
@@ -574,11 +574,10 @@ BigNumPowMod (
   IN     UINT32            B,
   IN     CONST OC_BN_WORD  *N,
   IN     OC_BN_WORD        N0Inv,
-  IN     CONST OC_BN_WORD  *RSqrMod
+  IN     CONST OC_BN_WORD  *RSqrMod,
+  IN OUT OC_BN_WORD        *ATmp
   )
 {
-  OC_BN_WORD *ATmp;
-
   UINTN      Index;
 
   ASSERT (Result != NULL);
@@ -587,6 +586,7 @@ BigNumPowMod (
   ASSERT (N != NULL);
   ASSERT (N0Inv != 0);
   ASSERT (RSqrMod != NULL);
+  ASSERT (ATmp != NULL);
   //
   // Currently, only the most frequent exponents are supported.
   //
@@ -595,11 +595,6 @@ BigNumPowMod (
     return FALSE;
   }
 
-  ATmp = AllocatePool ((UINTN)NumWords * OC_BN_WORD_SIZE);
-  if (ATmp == NULL) {
-    DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure in ModPow\n"));
-    return FALSE;
-  }
   //
   // Convert A into the Montgomery Domain.
   // ATmp = MM (A, R^2 mod N)
@@ -654,6 +649,5 @@ BigNumPowMod (
     BigNumSub (Result, NumWords, Result, N);
   }
 
-  FreePool (ATmp);
   return TRUE;
 }
@@ -151,6 +151,7 @@ SigVerifyShaHashBySize (
   @param[in] Hash           The Hash digest of the signed data.
   @param[in] HashSize       Size, in bytes, of Hash.
   @param[in] Algorithm      The RSA algorithm used.
+  @param[in] Scratch        Scratch buffer of 3 * NumWords Words.
 
   @returns  Whether the signature has been successfully verified as valid.
 
@@ -167,7 +168,8 @@ RsaVerifySigHashFromProcessed (
   IN UINTN             SignatureSize,
   IN CONST UINT8       *Hash,
   IN UINTN             HashSize,
-  IN OC_SIG_HASH_TYPE  Algorithm
+  IN OC_SIG_HASH_TYPE  Algorithm,
+  IN OC_BN_WORD        *Scratch
   )
 {
   BOOLEAN     Result;
@@ -175,7 +177,6 @@ RsaVerifySigHashFromProcessed (
 
   UINTN       ModulusSize;
 
-  VOID        *Memory;
   OC_BN_WORD  *EncryptedSigNum;
   OC_BN_WORD  *DecryptedSigNum;
 
@@ -193,6 +194,7 @@ RsaVerifySigHashFromProcessed (
   ASSERT (SignatureSize > 0);
   ASSERT (Hash != NULL);
   ASSERT (HashSize > 0);
+  ASSERT (Scratch != NULL);
 
   STATIC_ASSERT (
     OcSigHashTypeSha512 == OcSigHashTypeMax - 1,
@@ -243,25 +245,16 @@ RsaVerifySigHashFromProcessed (
   //
   // Verify the Signature size matches the Modulus size.
   // This implicitly verifies it's a multiple of the Word size.
+  // The Modulus size itself is verified on context initialisation.
   //
   ModulusSize = NumWords * OC_BN_WORD_SIZE;
-  if (!InternalRsaModulusSizeIsAllowed (ModulusSize)) {
-    return FALSE;
-  }
-
   if (SignatureSize != ModulusSize) {
-    DEBUG ((DEBUG_INFO, "OCCR: Signature length does not match key length"));
-    return FALSE;
-  }
-
-  Memory = AllocatePool (2 * ModulusSize);
-  if (Memory == NULL) {
-    DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure\n"));
+    DEBUG ((DEBUG_INFO, "OCCR: Signature length does not match key length\n"));
     return FALSE;
   }
 
-  EncryptedSigNum = Memory;
-  DecryptedSigNum = (OC_BN_WORD *)((UINTN)EncryptedSigNum + ModulusSize);
+  EncryptedSigNum = Scratch;
+  DecryptedSigNum = &Scratch[NumWords];
 
   BigNumParseBuffer (
     EncryptedSigNum,
@@ -277,10 +270,10 @@ RsaVerifySigHashFromProcessed (
              Exponent,
              N,
              N0Inv,
-             RSqrMod
+             RSqrMod,
+             &Scratch[2 * NumWords]
              );
   if (!Result) {
-    FreePool (Memory);
     return FALSE;
   }
   //
@@ -317,12 +310,10 @@ RsaVerifySigHashFromProcessed (
   //
   DigestSize = PaddingSize + HashSize;
   if (SignatureSize < DigestSize + 11) {
-    FreePool (Memory);
     return FALSE;
   }
 
   if (Signature[0] != 0x00 || Signature[1] != 0x01) {
-    FreePool (Memory);
     return FALSE;
   }
   //
@@ -333,13 +324,11 @@ RsaVerifySigHashFromProcessed (
   //
   for (Index = 2; Index < SignatureSize - DigestSize - 3 + 2; ++Index) {
     if (Signature[Index] != 0xFF) {
-      FreePool (Memory);
       return FALSE;
     }
   }
 
   if (Signature[Index] != 0x00) {
-    FreePool (Memory);
     return FALSE;
   }
 
@@ -347,7 +336,6 @@ RsaVerifySigHashFromProcessed (
 
   CmpResult = CompareMem (&Signature[Index], Padding, PaddingSize);
   if (CmpResult != 0) {
-    FreePool (Memory);
     return FALSE;
   }
 
@@ -355,7 +343,6 @@ RsaVerifySigHashFromProcessed (
 
   CmpResult = CompareMem (&Signature[Index], Hash, HashSize);
   if (CmpResult != 0) {
-    FreePool (Memory);
     return FALSE;
   }
   //
@@ -363,51 +350,176 @@ RsaVerifySigHashFromProcessed (
   //
   ASSERT (Index + HashSize == SignatureSize);
 
-  FreePool (Memory);
   return TRUE;
 }
 
-/**
-  Verify RSA PKCS1.5 signed data against its signature.
-  The modulus' size must be a multiple of the configured BIGNUM word size.
-  This will be true for any conventional RSA, which use two's potencies.
+BOOLEAN
+RsaVerifyContextInitFromData (
+  OUT OC_RSA_VERIFY_CONTEXT  *Context,
+  IN  CONST UINT8            *Modulus,
+  IN  UINTN                  ModulusSize,
+  IN  UINT32                 Exponent
+  )
+{
+  UINTN           ModulusNumWordsTmp;
+  OC_BN_NUM_WORDS ModulusNumWords;
 
-  @param[in] N              The RSA modulus.
-  @param[in] NumWords       The number of Words of N and RSqrMod.
-  @param[in] N0Inv          The Montgomery Inverse of N.
-  @param[in] RSqrMod        Montgomery's R^2 mod N.
-  @param[in] Exponent       The RSA exponent.
-  @param[in] Signature      The RSA signature to be verified.
-  @param[in] SignatureSize  Size, in bytes, of Signature.
-  @param[in] Data           The signed data to verify.
-  @param[in] DataSize       Size, in bytes, of Data.
-  @param[in] Algorithm      The RSA algorithm used.
+  OC_BN_WORD      *N;
+  OC_BN_WORD      *RSqrMod;
 
-  @returns  Whether the signature has been successfully verified as valid.
+  ASSERT (Context != NULL);
+  ASSERT (Modulus != NULL);
+  ASSERT (ModulusSize > 0);
+  ASSERT (Exponent > 0);
+
+  ZeroMem (Context, sizeof (*Context));
+
+  ModulusNumWordsTmp = ModulusSize / OC_BN_WORD_SIZE;
+  if (ModulusNumWordsTmp > OC_BN_MAX_LEN
+   || (ModulusSize % OC_BN_WORD_SIZE) != 0
+   || !InternalRsaModulusSizeIsAllowed (ModulusSize)) {
+    return FALSE;
+  }
+
+  ModulusNumWords = (OC_BN_NUM_WORDS)ModulusNumWordsTmp;
+
+  STATIC_ASSERT (
+    OC_BN_MAX_SIZE <= MAX_UINTN / 5,
+    "An overflow verification must be added"
+    );
+  //
+  // N and RSqrMod are followed by the scratch memory for verification.
+  //
+  Context->Memory = AllocatePool (5 * ModulusSize);
+  if (Context->Memory == NULL) {
+    DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure\n"));
+    return FALSE;
+  }
+
+  N       = (OC_BN_WORD *)Context->Memory;
+  RSqrMod = &N[ModulusNumWords];
+
+  BigNumParseBuffer (N, ModulusNumWords, Modulus, ModulusSize);
+
+  Context->N0Inv = BigNumCalculateMontParams (RSqrMod, ModulusNumWords, N);
+  if (Context->N0Inv == 0) {
+    RsaVerifyContextFree (Context);
+    return FALSE;
+  }
+
+  Context->NumWords = ModulusNumWords;
+  Context->Exponent = Exponent;
+  Context->N        = N;
+  Context->RSqrMod  = RSqrMod;
+  Context->Scratch  = &RSqrMod[ModulusNumWords];
+  return TRUE;
+}
 
-**/
-STATIC
 BOOLEAN
-RsaVerifySigDataFromProcessed (
-  IN CONST OC_BN_WORD  *N,
-  IN OC_BN_NUM_WORDS   NumWords,
-  IN OC_BN_WORD        N0Inv,
-  IN CONST OC_BN_WORD  *RSqrMod,
-  IN UINT32            Exponent,
-  IN CONST UINT8       *Signature,
-  IN UINTN             SignatureSize,
-  IN CONST UINT8       *Data,
-  IN UINTN             DataSize,
-  IN OC_SIG_HASH_TYPE  Algorithm
+RsaVerifyContextInitFromKey (
+  OUT OC_RSA_VERIFY_CONTEXT    *Context,
+  IN  CONST OC_RSA_PUBLIC_KEY  *Key
+  )
+{
+  UINTN  NumWords;
+  UINTN  ModulusSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (Key != NULL);
+
+  STATIC_ASSERT (
+    OC_BN_WORD_SIZE <= 8,
+    "The parentheses need to be changed to avoid truncation."
+    );
+
+  ZeroMem (Context, sizeof (*Context));
+
+  NumWords    = Key->Hdr.NumQwords * (8 / OC_BN_WORD_SIZE);
+  ModulusSize = NumWords * OC_BN_WORD_SIZE;
+  if (NumWords > OC_BN_MAX_LEN
+   || !InternalRsaModulusSizeIsAllowed (ModulusSize)) {
+    return FALSE;
+  }
+
+  STATIC_ASSERT (
+    OC_BN_MAX_SIZE <= MAX_UINTN / 3,
+    "An overflow verification must be added"
+    );
+
+  Context->Memory = AllocatePool (3 * ModulusSize);
+  if (Context->Memory == NULL) {
+    DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure\n"));
+    return FALSE;
+  }
+  //
+  // When OC_BN_WORD is not UINT64, this violates the strict aliasing rule.
+  // However, due to packed-ness and byte order, this is perfectly safe.
+  //
+  Context->NumWords = NumWords;
+  Context->N0Inv    = (OC_BN_WORD)Key->Hdr.N0Inv;
+  Context->Exponent = 0x10001;
+  Context->N        = Key->Data;
+  Context->RSqrMod  = &Key->Data[Key->Hdr.NumQwords];
+  Context->Scratch  = Context->Memory;
+  return TRUE;
+}
+
+VOID
+RsaVerifyContextFree (
+  IN OUT OC_RSA_VERIFY_CONTEXT  *Context
+  )
+{
+  ASSERT (Context != NULL);
+
+  if (Context->Memory != NULL) {
+    FreePool (Context->Memory);
+  }
+
+  ZeroMem (Context, sizeof (*Context));
+}
+
+BOOLEAN
+RsaVerifySigHashFromContext (
+  IN OUT OC_RSA_VERIFY_CONTEXT  *Context,
+  IN     CONST UINT8            *Signature,
+  IN     UINTN                  SignatureSize,
+  IN     CONST UINT8            *Hash,
+  IN     UINTN                  HashSize,
+  IN     OC_SIG_HASH_TYPE       Algorithm
+  )
+{
+  ASSERT (Context != NULL);
+  ASSERT (Context->Scratch != NULL);
+
+  return RsaVerifySigHashFromProcessed (
+           Context->N,
+           Context->NumWords,
+           (OC_BN_WORD)Context->N0Inv,
+           Context->RSqrMod,
+           Context->Exponent,
+           Signature,
+           SignatureSize,
+           Hash,
+           HashSize,
+           Algorithm,
+           Context->Scratch
+           );
+}
+
+BOOLEAN
+RsaVerifySigDataFromContext (
+  IN OUT OC_RSA_VERIFY_CONTEXT  *Context,
+  IN     CONST UINT8            *Signature,
+  IN     UINTN                  SignatureSize,
+  IN     CONST UINT8            *Data,
+  IN     UINTN                  DataSize,
+  IN     OC_SIG_HASH_TYPE       Algorithm
   )
 {
   UINT8 Hash[OC_MAX_SHA_DIGEST_SIZE];
   UINTN HashSize;
 
-  ASSERT (N != NULL);
-  ASSERT (NumWords > 0);
-  ASSERT (RSqrMod != NULL);
-  ASSERT (Exponent > 0);
+  ASSERT (Context != NULL);
   ASSERT (Signature != NULL);
   ASSERT (SignatureSize > 0);
   ASSERT (Data != NULL);
@@ -450,12 +562,8 @@ RsaVerifySigDataFromProcessed (
     }
   }
 
-  return RsaVerifySigHashFromProcessed (
-           N,
-           NumWords,
-           N0Inv,
-           RSqrMod,
-           Exponent,
+  return RsaVerifySigHashFromContext (
+           Context,
            Signature,
            SignatureSize,
            Hash,
@@ -476,59 +584,15 @@ RsaVerifySigDataFromData (
   IN OC_SIG_HASH_TYPE  Algorithm
   )
 {
-  UINTN           ModulusNumWordsTmp;
-  OC_BN_NUM_WORDS ModulusNumWords;
+  OC_RSA_VERIFY_CONTEXT Context;
+  BOOLEAN               Result;
 
-  VOID            *Memory;
-  OC_BN_WORD      *N;
-  OC_BN_WORD      *RSqrMod;
-
-  OC_BN_WORD      N0Inv;
-  BOOLEAN         Result;
-
-  ASSERT (Modulus != NULL);
-  ASSERT (ModulusSize > 0);
-  ASSERT (Exponent > 0);
-  ASSERT (Signature != NULL);
-  ASSERT (SignatureSize > 0);
-  ASSERT (Data != NULL);
-  ASSERT (DataSize > 0);
-
-  ModulusNumWordsTmp = ModulusSize / OC_BN_WORD_SIZE;
-  if (ModulusNumWordsTmp > OC_BN_MAX_LEN
-   || (ModulusSize % OC_BN_WORD_SIZE) != 0) {
-    return FALSE;
-  }
-
-  ModulusNumWords = (OC_BN_NUM_WORDS)ModulusNumWordsTmp;
-
-  STATIC_ASSERT (
-    OC_BN_MAX_SIZE <= MAX_UINTN / 2,
-    "An overflow verification must be added"
-    );
-
-  Memory = AllocatePool (2 * ModulusSize);
-  if (Memory == NULL) {
-    return FALSE;
-  }
-
-  N       = (OC_BN_WORD *)Memory;
-  RSqrMod = (OC_BN_WORD *)((UINTN)N + ModulusSize);
-
-  BigNumParseBuffer (N, ModulusNumWords, Modulus, ModulusSize);
-
-  N0Inv = BigNumCalculateMontParams (RSqrMod, ModulusNumWords, N);
-  if (N0Inv == 0) {
-    FreePool (Memory);
+  if (!RsaVerifyContextInitFromData (&Context, Modulus, ModulusSize, Exponent)) {
     return FALSE;
   }
 
-  Result = RsaVerifySigDataFromProcessed (
-             N,
-             ModulusNumWords,
-             N0Inv,
-             RSqrMod,
-             Exponent,
+  Result = RsaVerifySigDataFromContext (
+             &Context,
              Signature,
              SignatureSize,
              Data,
@@ -536,7 +600,7 @@ RsaVerifySigDataFromData (
              Algorithm
              );
 
-  FreePool (Memory);
+  RsaVerifyContextFree (&Context);
   return Result;
 }
 
@@ -550,32 +614,24 @@ RsaVerifySigHashFromKey (
   IN OC_SIG_HASH_TYPE         Algorithm
   )
 {
-  ASSERT (Key != NULL);
-  ASSERT (Signature != NULL);
-  ASSERT (SignatureSize > 0);
-  ASSERT (Hash != NULL);
-  ASSERT (HashSize > 0);
+  OC_RSA_VERIFY_CONTEXT Context;
+  BOOLEAN               Result;
 
-  STATIC_ASSERT (
-    OC_BN_WORD_SIZE <= 8,
-    "The parentheses need to be changed to avoid truncation."
-    );
-  //
-  // When OC_BN_WORD is not UINT64, this violates the strict aliasing rule.
-  // However, due to packed-ness and byte order, this is perfectly safe.
-  //
-  return RsaVerifySigHashFromProcessed (
-           (OC_BN_WORD *)Key->Data,
-           Key->Hdr.NumQwords * (8 / OC_BN_WORD_SIZE),
-           (OC_BN_WORD)Key->Hdr.N0Inv,
-           (OC_BN_WORD *)&Key->Data[Key->Hdr.NumQwords],
-           0x10001,
-           Signature,
-           SignatureSize,
-           Hash,
-           HashSize,
-           Algorithm
-           );
+  if (!RsaVerifyContextInitFromKey (&Context, Key)) {
+    return FALSE;
+  }
+
+  Result = RsaVerifySigHashFromContext (
+             &Context,
+             Signature,
+             SignatureSize,
+             Hash,
+             HashSize,
+             Algorithm
+             );
+
+  RsaVerifyContextFree (&Context);
+  return Result;
 }
 
 BOOLEAN
@@ -588,30 +644,22 @@ RsaVerifySigDataFromKey (
   IN OC_SIG_HASH_TYPE         Algorithm
   )
 {
-  ASSERT (Key != NULL);
-  ASSERT (Signature != NULL);
-  ASSERT (SignatureSize > 0);
-  ASSERT (Data != NULL);
-  ASSERT (DataSize > 0);
+  OC_RSA_VERIFY_CONTEXT Context;
+  BOOLEAN               Result;
 
-  STATIC_ASSERT (
-    OC_BN_WORD_SIZE <= 8,
-    "The parentheses need to be changed to avoid truncation."
-    );
-  //
-  // When OC_BN_WORD is not UINT64, this violates the strict aliasing rule.
-  // However, due to packed-ness and byte order, this is perfectly safe.
-  //
-  return RsaVerifySigDataFromProcessed (
-           (OC_BN_WORD *)Key->Data,
-           Key->Hdr.NumQwords * (8 / OC_BN_WORD_SIZE),
-           (OC_BN_WORD)Key->Hdr.N0Inv,
-           (OC_BN_WORD *)&Key->Data[Key->Hdr.NumQwords],
-           0x10001,
-           Signature,
-           SignatureSize,
-           Data,
-           DataSize,
-           Algorithm
-           );
+  if (!RsaVerifyContextInitFromKey (&Context, Key)) {
+    return FALSE;
+  }
+
+  Result = RsaVerifySigDataFromContext (
+             &Context,
+             Signature,
+             SignatureSize,
+             Data,
+             DataSize,
+             Algorithm
+             );
+
+  RsaVerifyContextFree (&Context);
+  return Result;
 }
@@ -27,28 +27,76 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
               This implementation uses little endian byte order.
 *********************************************************************/
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/OcCryptoLib.h>
 
 #define ROTLEFT(a, b) ((a << b) | (a >> (32 - b)))
 
+#define SHA1_F0(B, C, D)  ((D) ^ ((B) & ((C) ^ (D))))
+#define SHA1_F1(B, C, D)  ((B) ^ (C) ^ (D))
+#define SHA1_F2(B, C, D)  (((B) & (C)) | ((D) & ((B) | (C))))
+#define SHA1_F3(B, C, D)  ((B) ^ (C) ^ (D))
+
+#define SHA1_K0  0x5A827999U
+#define SHA1_K1  0x6ED9EBA1U
+#define SHA1_K2  0x8F1BBCDCU
+#define SHA1_K3  0xCA62C1D6U
+
+#define SHA1_LOAD32(Str)               \
+  (  ((UINT32) (Str)[0] << 24)         \
+   | ((UINT32) (Str)[1] << 16)         \
+   | ((UINT32) (Str)[2] <<  8)         \
+   | ((UINT32) (Str)[3]))
+
+//
+// Message schedule is computed in place in a 16 word circular buffer.
+//
+#define SHA1_SCHEDULE(W, Index)                                       \
+  (T = W[((Index) - 3) & 15] ^ W[((Index) - 8) & 15]                  \
+    ^ W[((Index) - 14) & 15] ^ W[(Index) & 15],                        \
+   W[(Index) & 15] = ROTLEFT (T, 1))
+
+#define SHA1_ROUND(A, B, C, D, E, Func, K, Wi)                      \
+  do {                                                              \
+    (E) += ROTLEFT (A, 5) + Func (B, C, D) + (K) + (Wi);            \
+    (B)  = ROTLEFT (B, 30);                                         \
+  } while (0)
+
+//
+// Five rounds with working registers rotated by renaming.
+//
+#define SHA1_ROUNDS(Func, K, W0, W1, W2, W3, W4)      \
+  do {                                                \
+    SHA1_ROUND (A, B, C, D, E, Func, K, W0);          \
+    SHA1_ROUND (E, A, B, C, D, Func, K, W1);          \
+    SHA1_ROUND (D, E, A, B, C, Func, K, W2);          \
+    SHA1_ROUND (C, D, E, A, B, Func, K, W3);          \
+    SHA1_ROUND (B, C, D, E, A, Func, K, W4);          \
+  } while (0)
+
+#define SHA1_SCHEDULED_ROUNDS(Func, K, Index)         \
+  SHA1_ROUNDS (                                       \
+    Func,                                             \
+    K,                                                \
+    SHA1_SCHEDULE (W, (Index) + 0),                   \
+    SHA1_SCHEDULE (W, (Index) + 1),                   \
+    SHA1_SCHEDULE (W, (Index) + 2),                   \
+    SHA1_SCHEDULE (W, (Index) + 3),                   \
+    SHA1_SCHEDULE (W, (Index) + 4)                    \
+    )
+
+STATIC
 VOID
 Sha1Transform (
   SHA1_CONTEXT *Ctx,
-  CONST UINT8  *Data
+  CONST UINT8  *Data,
+  UINTN        BlockNb
   )
 {
-  UINT32 A, B, C, D, E, Index1, Index2, T, M[80];
-
-  for (Index1 = 0, Index2 = 0; Index1 < 16; ++Index1, Index2 += 4) {
-    M[Index1] = (Data[Index2] << 24) + (Data[Index2 + 1] << 16)
-                + (Data[Index2 + 2] << 8) + (Data[Index2 + 3]);
-  }
-
-  for ( ; Index1 < 80; ++Index1) {
-    M[Index1] = (M[Index1 - 3] ^ M[Index1 - 8] ^ M[Index1 - 14] ^ M[Index1 - 16]);
-    M[Index1] = (M[Index1] << 1) | (M[Index1] >> 31);
-  }
+  UINT32  A, B, C, D, E, T;
+  UINT32  W[16];
+  UINTN   Index;
 
   A = Ctx->State[0];
   B = Ctx->State[1];
@@ -56,44 +104,43 @@ Sha1Transform (
   D = Ctx->State[3];
   E = Ctx->State[4];
 
-  for (Index1 = 0; Index1 < 20; ++Index1) {
-    T = ROTLEFT (A, 5) + ((B & C) ^ (~B & D)) + E + Ctx->K[0] + M[Index1];
-    E = D;
-    D = C;
-    C = ROTLEFT (B, 30);
-    B = A;
-    A = T;
-  }
-  for ( ; Index1 < 40; ++Index1) {
-    T = ROTLEFT (A, 5) + (B ^ C ^ D) + E + Ctx->K[1] + M[Index1];
-    E = D;
-    D = C;
-    C = ROTLEFT (B, 30);
-    B = A;
-    A = T;
-  }
-  for ( ; Index1 < 60; ++Index1) {
-    T = ROTLEFT (A, 5) + ((B & C) ^ (B & D) ^ (C & D))  + E + Ctx->K[2] + M[Index1];
-    E = D;
-    D = C;
-    C = ROTLEFT (B, 30);
-    B = A;
-    A = T;
-  }
-  for ( ; Index1 < 80; ++Index1) {
-    T = ROTLEFT (A, 5) + (B ^ C ^ D) + E + Ctx->K[3] + M[Index1];
-    E = D;
-    D = C;
-    C = ROTLEFT (B, 30);
-    B = A;
-    A = T;
-  }
+  for (; BlockNb > 0; --BlockNb, Data += 64) {
+    for (Index = 0; Index < 16; ++Index) {
+      W[Index] = SHA1_LOAD32 (&Data[Index << 2]);
+    }
+
+    for (Index = 0; Index < 15; Index += 5) {
+      SHA1_ROUNDS (SHA1_F0, SHA1_K0, W[Index], W[Index + 1], W[Index + 2], W[Index + 3], W[Index + 4]);
+    }
 
-  Ctx->State[0] += A;
-  Ctx->State[1] += B;
-  Ctx->State[2] += C;
-  Ctx->State[3] += D;
-  Ctx->State[4] += E;
+    SHA1_ROUNDS (
+      SHA1_F0,
+      SHA1_K0,
+      W[15],
+      SHA1_SCHEDULE (W, 16),
+      SHA1_SCHEDULE (W, 17),
+      SHA1_SCHEDULE (W, 18),
+      SHA1_SCHEDULE (W, 19)
+      );
+
+    for (Index = 20; Index < 40; Index += 5) {
+      SHA1_SCHEDULED_ROUNDS (SHA1_F1, SHA1_K1, Index);
+    }
+
+    for (; Index < 60; Index += 5) {
+      SHA1_SCHEDULED_ROUNDS (SHA1_F2, SHA1_K2, Index);
+    }
+
+    for (; Index < 80; Index += 5) {
+      SHA1_SCHEDULED_ROUNDS (SHA1_F3, SHA1_K3, Index);
+    }
+
+    A = Ctx->State[0] += A;
+    B = Ctx->State[1] += B;
+    C = Ctx->State[2] += C;
+    D = Ctx->State[3] += D;
+    E = Ctx->State[4] += E;
+  }
 }
 
 VOID
@@ -108,10 +155,6 @@ Sha1Init (
   Ctx->State[2] = 0x98BADCFE;
   Ctx->State[3] = 0x10325476;
   Ctx->State[4] = 0xC3D2E1F0;
-  Ctx->K[0] = 0x5A827999;
-  Ctx->K[1] = 0x6ED9EBA1;
-  Ctx->K[2] = 0x8F1BBCDC;
-  Ctx->K[3] = 0xCA62C1D6;
 }
 
 VOID
@@ -121,17 +164,41 @@ Sha1Update (
   UINTN        Len
   )
 {
-  UINTN Index = 0;
-
-  for (Index = 0; Index < Len; ++Index) {
-    Ctx->Data[Ctx->DataLen] = Data[Index];
-    Ctx->DataLen++;
-    if (Ctx->DataLen == 64) {
-      Sha1Transform (Ctx, Ctx->Data);
-      Ctx->BitLen += 512;
-      Ctx->DataLen = 0;
+  UINTN  CopyLen;
+  UINTN  BlockNb;
+
+  //
+  // Complete the buffered block first.
+  //
+  if (Ctx->DataLen > 0) {
+    CopyLen = MIN (Len, sizeof (Ctx->Data) - Ctx->DataLen);
+    CopyMem (&Ctx->Data[Ctx->DataLen], Data, CopyLen);
+    Ctx->DataLen += (UINT32) CopyLen;
+    Data         += CopyLen;
+    Len          -= CopyLen;
+
+    if (Ctx->DataLen < sizeof (Ctx->Data)) {
+      return;
     }
+
+    Sha1Transform (Ctx, Ctx->Data, 1);
+    Ctx->BitLen += 512;
+    Ctx->DataLen = 0;
   }
+
+  //
+  // Hash full blocks directly from the caller buffer.
+  //
+  BlockNb = Len / sizeof (Ctx->Data);
+  if (BlockNb > 0) {
+    Sha1Transform (Ctx, Data, BlockNb);
+    Ctx->BitLen += LShiftU64 (BlockNb, 9);
+    Data        += BlockNb * sizeof (Ctx->Data);
+    Len         -= BlockNb * sizeof (Ctx->Data);
+  }
+
+  CopyMem (Ctx->Data, Data, Len);
+  Ctx->DataLen = (UINT32) Len;
 }
 
 VOID
@@ -151,7 +218,7 @@ Sha1Final (
   } else {
     Ctx->Data[Index++] = 0x80;
     ZeroMem (Ctx->Data + Index, 64-Index);
-    Sha1Transform (Ctx, Ctx->Data);
+    Sha1Transform (Ctx, Ctx->Data, 1);
     ZeroMem (Ctx->Data, 56);
   }
 
@@ -167,7 +234,7 @@ Sha1Final (
   Ctx->Data[58] = (UINT8) (Ctx->BitLen >> 40);
   Ctx->Data[57] = (UINT8) (Ctx->BitLen >> 48);
   Ctx->Data[56] = (UINT8) (Ctx->BitLen >> 56);
-  Sha1Transform (Ctx, Ctx->Data);
+  Sha1Transform (Ctx, Ctx->Data, 1);
 
   //
   // Since this implementation uses little endian byte ordering and MD uses big endian,
@@ -37,6 +37,34 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include <Library/OcCryptoLib.h>
 
+//
+// Use Intel SHA extensions for SHA-256 when the CPU supports them.
+// Set to 0 to only build the portable implementation.
+//
+#ifndef OC_CRYPTO_SHA_NI
+  #if defined (MDE_CPU_X64)
+    #define OC_CRYPTO_SHA_NI 1
+  #else
+    #define OC_CRYPTO_SHA_NI 0
+  #endif
+#endif
+
+#if OC_CRYPTO_SHA_NI
+#include <Register/Intel/Cpuid.h>
+#include <immintrin.h>
+
+#if defined (__GNUC__) || defined (__clang__)
+#define SHA256_NI_TARGET __attribute__ ((target ("sha,ssse3,sse4.1")))
+#else
+#define SHA256_NI_TARGET
+#endif
+
+//
+// CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS EBX bit for SHA extensions.
+//
+#define SHA256_NI_CPUID_SHA  BIT29
+#endif
+
 
 #define UNPACK64(x, str)                         \
   do {                                           \
@@ -77,6 +105,26 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define SHA256_SIG0(x) (ROTRIGHT(x, 7)  ^ ROTRIGHT(x, 18) ^ SHFR(x, 3))
 #define SHA256_SIG1(x) (ROTRIGHT(x, 17) ^ ROTRIGHT(x, 19) ^ SHFR(x, 10))
 
+#define SHA256_LOAD32(Str)             \
+  (  ((UINT32) (Str)[0] << 24)         \
+   | ((UINT32) (Str)[1] << 16)         \
+   | ((UINT32) (Str)[2] <<  8)         \
+   | ((UINT32) (Str)[3]))
+
+//
+// Message schedule is computed in place in a 16 word circular buffer.
+//
+#define SHA256_SCHEDULE(W, Index)                              \
+  (W[(Index) & 15] += SHA256_SIG1 (W[((Index) - 2) & 15])      \
+    + W[((Index) - 7) & 15] + SHA256_SIG0 (W[((Index) - 15) & 15]))
+
+#define SHA256_ROUND(A, B, C, D, E, F, G, H, Index, Wi)                     \
+  do {                                                                      \
+    T1   = (H) + SHA256_EP1 (E) + CH (E, F, G) + SHA256_K[Index] + (Wi);    \
+    (D) += T1;                                                              \
+    (H)  = T1 + SHA256_EP0 (A) + MAJ (A, B, C);                             \
+  } while (0)
+
 //
 // Sha 512
 //
@@ -85,11 +133,16 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define SHA512_SIG0(x) (ROTRIGHT(x,  1) ^ ROTRIGHT(x,  8) ^ SHFR(x,  7))
 #define SHA512_SIG1(x) (ROTRIGHT(x, 19) ^ ROTRIGHT(x, 61) ^ SHFR(x,  6))
 
-#define SHA512_SCR(Index)                                   \
-  do {                                                      \
-    W[Index] =  SHA512_SIG1(W[Index -  2]) + W[Index -  7]  \
-          + SHA512_SIG0(W[Index - 15]) + W[Index - 16];     \
-  } while(0)
+#define SHA512_SCHEDULE(W, Index)                              \
+  (W[(Index) & 15] += SHA512_SIG1 (W[((Index) - 2) & 15])      \
+    + W[((Index) - 7) & 15] + SHA512_SIG0 (W[((Index) - 15) & 15]))
+
+#define SHA512_ROUND(A, B, C, D, E, F, G, H, Index, Wi)                     \
+  do {                                                                      \
+    T1   = (H) + SHA512_EP1 (E) + CH (E, F, G) + SHA512_K[Index] + (Wi);    \
+    (D) += T1;                                                              \
+    (H)  = T1 + SHA512_EP0 (A) + MAJ (A, B, C);                             \
+  } while (0)
 
 
 
@@ -105,7 +158,7 @@ STATIC CONST UINT32 SHA256_K[64] = {
 };
 
 
-STATIC UINT64 SHA512_K[80] = {
+STATIC CONST UINT64 SHA512_K[80] = {
   0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
   0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
   0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
@@ -166,26 +219,17 @@ STATIC CONST UINT64 SHA512_H0[8] = {
 //
 // Sha 256 functions
 //
+STATIC
 VOID
-Sha256Transform (
+Sha256TransformPortable (
   SHA256_CONTEXT  *Context,
-  CONST UINT8     *Data
+  CONST UINT8     *Data,
+  UINTN           BlockNb
   )
 {
-  UINT32 A, B, C, D, E, F, G, H, Index1, Index2, T1, T2;
-  UINT32 M[64];
-
-  for (Index1 = 0, Index2 = 0; Index1 < 16; Index1++, Index2 += 4) {
-    M[Index1] = ((UINT32)Data[Index2] << 24)
-                | ((UINT32)Data[Index2 + 1] << 16)
-                | ((UINT32)Data[Index2 + 2] << 8)
-                | ((UINT32)Data[Index2 + 3]);
-  }
-
-  for ( ; Index1 < 64; ++Index1) {
-    M[Index1] = SHA256_SIG1 (M[Index1 - 2]) + M[Index1 - 7]
-      + SHA256_SIG0 (M[Index1 - 15]) + M[Index1 - 16];
-  }
+  UINT32  A, B, C, D, E, F, G, H, T1;
+  UINT32  W[16];
+  UINTN   Index;
 
   A = Context->State[0];
   B = Context->State[1];
@@ -196,27 +240,220 @@ Sha256Transform (
   G = Context->State[6];
   H = Context->State[7];
 
-  for (Index1 = 0; Index1 < 64; ++Index1) {
-    T1 = H + SHA256_EP1 (E) + CH (E, F, G) + SHA256_K[Index1] + M[Index1];
-    T2 = SHA256_EP0 (A) + MAJ (A, B, C);
-    H = G;
-    G = F;
-    F = E;
-    E = D + T1;
-    D = C;
-    C = B;
-    B = A;
-    A = T1 + T2;
+  for (; BlockNb > 0; --BlockNb, Data += SHA256_BLOCK_SIZE) {
+    for (Index = 0; Index < 16; ++Index) {
+      W[Index] = SHA256_LOAD32 (&Data[Index << 2]);
+    }
+
+    //
+    // Working registers are rotated by renaming, eight rounds at a time.
+    //
+    for (Index = 0; Index < 16; Index += 8) {
+      SHA256_ROUND (A, B, C, D, E, F, G, H, Index + 0, W[Index + 0]);
+      SHA256_ROUND (H, A, B, C, D, E, F, G, Index + 1, W[Index + 1]);
+      SHA256_ROUND (G, H, A, B, C, D, E, F, Index + 2, W[Index + 2]);
+      SHA256_ROUND (F, G, H, A, B, C, D, E, Index + 3, W[Index + 3]);
+      SHA256_ROUND (E, F, G, H, A, B, C, D, Index + 4, W[Index + 4]);
+      SHA256_ROUND (D, E, F, G, H, A, B, C, Index + 5, W[Index + 5]);
+      SHA256_ROUND (C, D, E, F, G, H, A, B, Index + 6, W[Index + 6]);
+      SHA256_ROUND (B, C, D, E, F, G, H, A, Index + 7, W[Index + 7]);
+    }
+
+    for (; Index < 64; Index += 8) {
+      SHA256_ROUND (A, B, C, D, E, F, G, H, Index + 0, SHA256_SCHEDULE (W, Index + 0));
+      SHA256_ROUND (H, A, B, C, D, E, F, G, Index + 1, SHA256_SCHEDULE (W, Index + 1));
+      SHA256_ROUND (G, H, A, B, C, D, E, F, Index + 2, SHA256_SCHEDULE (W, Index + 2));
+      SHA256_ROUND (F, G, H, A, B, C, D, E, Index + 3, SHA256_SCHEDULE (W, Index + 3));
+      SHA256_ROUND (E, F, G, H, A, B, C, D, Index + 4, SHA256_SCHEDULE (W, Index + 4));
+      SHA256_ROUND (D, E, F, G, H, A, B, C, Index + 5, SHA256_SCHEDULE (W, Index + 5));
+      SHA256_ROUND (C, D, E, F, G, H, A, B, Index + 6, SHA256_SCHEDULE (W, Index + 6));
+      SHA256_ROUND (B, C, D, E, F, G, H, A, Index + 7, SHA256_SCHEDULE (W, Index + 7));
+    }
+
+    A = Context->State[0] += A;
+    B = Context->State[1] += B;
+    C = Context->State[2] += C;
+    D = Context->State[3] += D;
+    E = Context->State[4] += E;
+    F = Context->State[5] += F;
+    G = Context->State[6] += G;
+    H = Context->State[7] += H;
+  }
+}
+
+#if OC_CRYPTO_SHA_NI
+
+STATIC BOOLEAN  mSha256NiChecked;
+STATIC BOOLEAN  mSha256NiSupported;
+
+//
+// Four rounds with Wi + Ki, two rounds per SHA256RNDS2.
+//
+#define SHA256_NI_ROUNDS(Msg0, Index)                                                   \
+  do {                                                                                  \
+    Msg    = _mm_add_epi32 (Msg0, _mm_loadu_si128 ((CONST __m128i *) &SHA256_K[(Index) * 4])); \
+    State1 = _mm_sha256rnds2_epu32 (State1, State0, Msg);                              \
+    Msg    = _mm_shuffle_epi32 (Msg, 0x0E);                                             \
+    State0 = _mm_sha256rnds2_epu32 (State0, State1, Msg);                              \
+  } while (0)
+
+//
+// Finish the next four message words in MsgNext, which already holds
+// the earlier words passed through SHA256MSG1.
+//
+#define SHA256_NI_SCHEDULE(MsgNext, MsgPrev, MsgCur)                                   \
+  do {                                                                                  \
+    MsgNext = _mm_add_epi32 (MsgNext, _mm_alignr_epi8 (MsgCur, MsgPrev, 4));            \
+    MsgNext = _mm_sha256msg2_epu32 (MsgNext, MsgCur);                                   \
+  } while (0)
+
+/**
+  Check for SHA extensions and SSE4.1 used to shuffle the state.
+**/
+STATIC
+BOOLEAN
+Sha256NiDetect (
+  VOID
+  )
+{
+  UINT32                  MaxLeaf;
+  CPUID_VERSION_INFO_ECX  VersionEcx;
+  UINT32                  FeatureEbx;
+
+  AsmCpuid (CPUID_SIGNATURE, &MaxLeaf, NULL, NULL, NULL);
+  if (MaxLeaf < CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS) {
+    return FALSE;
+  }
+
+  AsmCpuid (CPUID_VERSION_INFO, NULL, NULL, &VersionEcx.Uint32, NULL);
+  if (VersionEcx.Bits.SSSE3 == 0 || VersionEcx.Bits.SSE4_1 == 0) {
+    return FALSE;
   }
 
-  Context->State[0] += A;
-  Context->State[1] += B;
-  Context->State[2] += C;
-  Context->State[3] += D;
-  Context->State[4] += E;
-  Context->State[5] += F;
-  Context->State[6] += G;
-  Context->State[7] += H;
+  AsmCpuidEx (
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS,
+    CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_SUB_LEAF_INFO,
+    NULL,
+    &FeatureEbx,
+    NULL,
+    NULL
+    );
+  return (FeatureEbx & SHA256_NI_CPUID_SHA) != 0;
+}
+
+/**
+  SHA-256 transform using SHA extensions.
+  XMM registers are only used in this function, so the compiler preserves
+  the nonvolatile ones per X64 calling convention, and UEFI guarantees SSE
+  availability on X64 during boot services.
+**/
+STATIC
+SHA256_NI_TARGET
+VOID
+Sha256TransformNi (
+  SHA256_CONTEXT  *Context,
+  CONST UINT8     *Data,
+  UINTN           BlockNb
+  )
+{
+  __m128i  State0;
+  __m128i  State1;
+  __m128i  Abef;
+  __m128i  Cdgh;
+  __m128i  Msg;
+  __m128i  Msg0;
+  __m128i  Msg1;
+  __m128i  Msg2;
+  __m128i  Msg3;
+  __m128i  Tmp;
+  __m128i  Mask;
+  UINTN    Index;
+
+  Mask = _mm_set_epi64x (0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+
+  //
+  // SHA256RNDS2 works on ABEF and CDGH state halves.
+  //
+  Tmp    = _mm_loadu_si128 ((CONST __m128i *) &Context->State[0]);
+  State1 = _mm_loadu_si128 ((CONST __m128i *) &Context->State[4]);
+  Tmp    = _mm_shuffle_epi32 (Tmp, 0xB1);
+  State1 = _mm_shuffle_epi32 (State1, 0x1B);
+  State0 = _mm_alignr_epi8 (Tmp, State1, 8);
+  State1 = _mm_blend_epi16 (State1, Tmp, 0xF0);
+
+  for (; BlockNb > 0; --BlockNb, Data += SHA256_BLOCK_SIZE) {
+    Abef = State0;
+    Cdgh = State1;
+
+    Msg0 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[0]), Mask);
+    SHA256_NI_ROUNDS (Msg0, 0);
+
+    Msg1 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[16]), Mask);
+    SHA256_NI_ROUNDS (Msg1, 1);
+    Msg0 = _mm_sha256msg1_epu32 (Msg0, Msg1);
+
+    Msg2 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[32]), Mask);
+    SHA256_NI_ROUNDS (Msg2, 2);
+    Msg1 = _mm_sha256msg1_epu32 (Msg1, Msg2);
+
+    Msg3 = _mm_shuffle_epi8 (_mm_loadu_si128 ((CONST __m128i *) &Data[48]), Mask);
+    SHA256_NI_ROUNDS (Msg3, 3);
+    SHA256_NI_SCHEDULE (Msg0, Msg2, Msg3);
+    Msg2 = _mm_sha256msg1_epu32 (Msg2, Msg3);
+
+    //
+    // Message words for the next four rounds are prepared one step ahead,
+    // the last iteration prepares a few unused words.
+    //
+    for (Index = 4; Index < 16; Index += 4) {
+      SHA256_NI_ROUNDS (Msg0, Index + 0);
+      SHA256_NI_SCHEDULE (Msg1, Msg3, Msg0);
+      Msg3 = _mm_sha256msg1_epu32 (Msg3, Msg0);
+
+      SHA256_NI_ROUNDS (Msg1, Index + 1);
+      SHA256_NI_SCHEDULE (Msg2, Msg0, Msg1);
+      Msg0 = _mm_sha256msg1_epu32 (Msg0, Msg1);
+
+      SHA256_NI_ROUNDS (Msg2, Index + 2);
+      SHA256_NI_SCHEDULE (Msg3, Msg1, Msg2);
+      Msg1 = _mm_sha256msg1_epu32 (Msg1, Msg2);
+
+      SHA256_NI_ROUNDS (Msg3, Index + 3);
+      SHA256_NI_SCHEDULE (Msg0, Msg2, Msg3);
+      Msg2 = _mm_sha256msg1_epu32 (Msg2, Msg3);
+    }
+
+    State0 = _mm_add_epi32 (State0, Abef);
+    State1 = _mm_add_epi32 (State1, Cdgh);
+  }
+
+  Tmp    = _mm_shuffle_epi32 (State0, 0x1B);
+  State1 = _mm_shuffle_epi32 (State1, 0xB1);
+  State0 = _mm_blend_epi16 (Tmp, State1, 0xF0);
+  State1 = _mm_alignr_epi8 (State1, Tmp, 8);
+
+  _mm_storeu_si128 ((__m128i *) &Context->State[0], State0);
+  _mm_storeu_si128 ((__m128i *) &Context->State[4], State1);
+}
+
+#endif
+
+STATIC
+VOID
+Sha256Transform (
+  SHA256_CONTEXT  *Context,
+  CONST UINT8     *Data,
+  UINTN           BlockNb
+  )
+{
+#if OC_CRYPTO_SHA_NI
+  if (mSha256NiSupported) {
+    Sha256TransformNi (Context, Data, BlockNb);
+    return;
+  }
+#endif
+
+  Sha256TransformPortable (Context, Data, BlockNb);
 }
 
 VOID
@@ -230,6 +467,13 @@ Sha256Init (
   }
   Context->DataLen = 0;
   Context->BitLen = 0;
+
+#if OC_CRYPTO_SHA_NI
+  if (!mSha256NiChecked) {
+    mSha256NiSupported = Sha256NiDetect ();
+    mSha256NiChecked   = TRUE;
+  }
+#endif
 }
 
 VOID
@@ -239,17 +483,42 @@ Sha256Update (
   UINTN          Len
   )
 {
-  UINT32 Index;
-
-  for (Index = 0; Index < Len; ++Index) {
-    Context->Data[Context->DataLen] = Data[Index];
-    Context->DataLen++;
-    if (Context->DataLen == 64) {
-      Sha256Transform (Context, Context->Data);
-      Context->BitLen += 512;
-      Context->DataLen = 0;
+  UINTN  CopyLen;
+  UINTN  BlockNb;
+
+  //
+  // Complete the buffered block first.
+  //
+  if (Context->DataLen > 0) {
+    CopyLen = SHA256_BLOCK_SIZE - Context->DataLen;
+    CopyLen = Len < CopyLen ? Len : CopyLen;
+    CopyMem (&Context->Data[Context->DataLen], Data, CopyLen);
+    Context->DataLen += (UINT32) CopyLen;
+    Data             += CopyLen;
+    Len              -= CopyLen;
+
+    if (Context->DataLen < SHA256_BLOCK_SIZE) {
+      return;
     }
+
+    Sha256Transform (Context, Context->Data, 1);
+    Context->BitLen += 512;
+    Context->DataLen = 0;
+  }
+
+  //
+  // Hash full blocks directly from the caller buffer.
+  //
+  BlockNb = Len / SHA256_BLOCK_SIZE;
+  if (BlockNb > 0) {
+    Sha256Transform (Context, Data, BlockNb);
+    Context->BitLen += LShiftU64 (BlockNb, 9);
+    Data            += BlockNb * SHA256_BLOCK_SIZE;
+    Len             -= BlockNb * SHA256_BLOCK_SIZE;
   }
+
+  CopyMem (Context->Data, Data, Len);
+  Context->DataLen = (UINT32) Len;
 }
 
 VOID
@@ -271,7 +540,7 @@ Sha256Final (
   } else {
     Context->Data[Index++] = 0x80;
     ZeroMem (Context->Data + Index, 64-Index);
-    Sha256Transform (Context, Context->Data);
+    Sha256Transform (Context, Context->Data, 1);
     ZeroMem (Context->Data, 56);
   }
 
@@ -287,7 +556,7 @@ Sha256Final (
   Context->Data[58] = (UINT8) (Context->BitLen >> 40);
   Context->Data[57] = (UINT8) (Context->BitLen >> 48);
   Context->Data[56] = (UINT8) (Context->BitLen >> 56);
-  Sha256Transform (Context, Context->Data);
+  Sha256Transform (Context, Context->Data, 1);
 
   //
   // Since this implementation uses little endian byte ordering and SHA uses big endian,
@@ -324,6 +593,7 @@ Sha256 (
 //
 // Sha 512 functions
 //
+STATIC
 VOID
 Sha512Transform (
   SHA512_CONTEXT  *Context,
@@ -331,66 +601,63 @@ Sha512Transform (
   UINTN           BlockNb
   )
 {
-  UINT64       W[80];
-  UINT64       Wv[8];
-  UINT64       T1;
-  UINT64       T2;
-  CONST UINT8  *SubBlock;
-  UINTN        Index1;
-  UINTN        Index2;
+  UINT64  A, B, C, D, E, F, G, H, T1;
+  UINT64  W[16];
+  UINTN   Index;
 
-  for (Index1 = 0; Index1 < BlockNb; ++Index1) {
-    SubBlock = Data + (Index1 << 7);
+  A = Context->State[0];
+  B = Context->State[1];
+  C = Context->State[2];
+  D = Context->State[3];
+  E = Context->State[4];
+  F = Context->State[5];
+  G = Context->State[6];
+  H = Context->State[7];
 
+  for (; BlockNb > 0; --BlockNb, Data += SHA512_BLOCK_SIZE) {
     //
     // Convert from big-endian byte order to host byte order
     //
-    for (Index2 = 0; Index2 < 16; ++Index2) {
-      PACK64 (&SubBlock[Index2 << 3], &W[Index2]);
+    for (Index = 0; Index < 16; ++Index) {
+      PACK64 (&Data[Index << 3], &W[Index]);
     }
 
     //
-    // Initialize the 8 working registers
+    // Working registers are rotated by renaming, eight rounds at a time.
     //
-    for (Index2 = 0; Index2 < 8; ++Index2) {
-      Wv[Index2] = Context->State[Index2];
+    for (Index = 0; Index < 16; Index += 8) {
+      SHA512_ROUND (A, B, C, D, E, F, G, H, Index + 0, W[Index + 0]);
+      SHA512_ROUND (H, A, B, C, D, E, F, G, Index + 1, W[Index + 1]);
+      SHA512_ROUND (G, H, A, B, C, D, E, F, Index + 2, W[Index + 2]);
+      SHA512_ROUND (F, G, H, A, B, C, D, E, Index + 3, W[Index + 3]);
+      SHA512_ROUND (E, F, G, H, A, B, C, D, Index + 4, W[Index + 4]);
+      SHA512_ROUND (D, E, F, G, H, A, B, C, Index + 5, W[Index + 5]);
+      SHA512_ROUND (C, D, E, F, G, H, A, B, Index + 6, W[Index + 6]);
+      SHA512_ROUND (B, C, D, E, F, G, H, A, Index + 7, W[Index + 7]);
     }
 
-    for (Index2 = 0; Index2 < 80; ++Index2) {
-      //
-      // Prepare the message schedule
-      //
-      if (Index2 >= 16) {
-        SHA512_SCR (Index2);
-      }
-
-      //
-      // Calculate T1 and T2
-      //
-      T1 = Wv[7] + SHA512_EP1 (Wv[4])
-        + CH (Wv[4], Wv[5], Wv[6]) + SHA512_K[Index2]
-        + W[Index2];
-
-      T2 = SHA512_EP0 (Wv[0]) + MAJ (Wv[0], Wv[1], Wv[2]);
-
-      //
-      // Update the working registers
-      //
-      Wv[7] = Wv[6];
-      Wv[6] = Wv[5];
-      Wv[5] = Wv[4];
-      Wv[4] = Wv[3] + T1;
-      Wv[3] = Wv[2];
-      Wv[2] = Wv[1];
-      Wv[1] = Wv[0];
-      Wv[0] = T1 + T2;
+    for (; Index < 80; Index += 8) {
+      SHA512_ROUND (A, B, C, D, E, F, G, H, Index + 0, SHA512_SCHEDULE (W, Index + 0));
+      SHA512_ROUND (H, A, B, C, D, E, F, G, Index + 1, SHA512_SCHEDULE (W, Index + 1));
+      SHA512_ROUND (G, H, A, B, C, D, E, F, Index + 2, SHA512_SCHEDULE (W, Index + 2));
+      SHA512_ROUND (F, G, H, A, B, C, D, E, Index + 3, SHA512_SCHEDULE (W, Index + 3));
+      SHA512_ROUND (E, F, G, H, A, B, C, D, Index + 4, SHA512_SCHEDULE (W, Index + 4));
+      SHA512_ROUND (D, E, F, G, H, A, B, C, Index + 5, SHA512_SCHEDULE (W, Index + 5));
+      SHA512_ROUND (C, D, E, F, G, H, A, B, Index + 6, SHA512_SCHEDULE (W, Index + 6));
+      SHA512_ROUND (B, C, D, E, F, G, H, A, Index + 7, SHA512_SCHEDULE (W, Index + 7));
     }
+
     //
     // Update the hash value
     //
-    for (Index2 = 0; Index2 < 8; ++Index2) {
-      Context->State[Index2] += Wv[Index2];
-    }
+    A = Context->State[0] += A;
+    B = Context->State[1] += B;
+    C = Context->State[2] += C;
+    D = Context->State[3] += D;
+    E = Context->State[4] += E;
+    F = Context->State[5] += F;
+    G = Context->State[6] += G;
+    H = Context->State[7] += H;
   }
 }
 
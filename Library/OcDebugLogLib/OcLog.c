@@ -139,6 +139,175 @@ GetLogPath (
   return LogPath;
 }
 
+STATIC
+EFI_STATUS
+AppendLogBuffer (
+  IN OUT CHAR8        *Buffer,
+  IN     UINTN        BufferSize,
+  IN OUT UINTN        *BufferLength,
+  IN     CONST CHAR8  *Timing  OPTIONAL,
+  IN     UINTN        TimingLength,
+  IN     CONST CHAR8  *Line,
+  IN     UINTN        LineLength
+  )
+{
+  //
+  // Keep room for the null terminator, the buffer must stay a valid string.
+  //
+  if (BufferSize - *BufferLength <= TimingLength + LineLength) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  if (Timing != NULL) {
+    CopyMem (&Buffer[*BufferLength], Timing, TimingLength);
+    *BufferLength += TimingLength;
+  }
+
+  CopyMem (&Buffer[*BufferLength], Line, LineLength);
+  *BufferLength += LineLength;
+  Buffer[*BufferLength] = '\0';
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FlushLogFile (
+  IN OC_LOG_PROTOCOL      *OcLog,
+  IN OC_LOG_PRIVATE_DATA  *Private,
+  IN BOOLEAN              Force
+  )
+{
+  UINTN  Size;
+
+  if ((OcLog->Options & OC_LOG_FILE) == 0 || OcLog->FileSystem == NULL) {
+    return;
+  }
+
+  if ((OcLog->Options & OC_LOG_SAFE_FILE) != 0) {
+    //
+    // Always overwriting file completely is most reliable.
+    // I know it is slow, but fixed size write is more reliable with broken FAT32 driver.
+    //
+    Size = Private->AsciiBufferSize;
+  } else {
+    //
+    // Otherwise write in batches to avoid rewriting the file on every line.
+    //
+    if (Private->AsciiBufferFlushed == Private->AsciiBufferLength
+      || (!Force && Private->AsciiBufferLength - Private->AsciiBufferFlushed < OC_LOG_FILE_FLUSH_SIZE)) {
+      return;
+    }
+
+    Size = Private->AsciiBufferLength;
+  }
+
+  SetFileData (
+    OcLog->FileSystem,
+    OcLog->FilePath,
+    Private->AsciiBuffer,
+    (UINT32) Size
+    );
+
+  Private->AsciiBufferFlushed = Private->AsciiBufferLength;
+}
+
+STATIC
+VOID
+GetNvramChunkName (
+  OUT CHAR16  *Name,
+  IN  UINTN   NameSize,
+  IN  UINTN   Chunk
+  )
+{
+  if (Chunk == 0) {
+    UnicodeSPrint (Name, NameSize, L"%s", OC_LOG_VARIABLE_NAME);
+  } else {
+    UnicodeSPrint (Name, NameSize, L"%s-%u", OC_LOG_VARIABLE_NAME, (UINT32) Chunk);
+  }
+}
+
+STATIC
+EFI_STATUS
+WriteNvramChunks (
+  IN OC_LOG_PRIVATE_DATA  *Private,
+  IN UINT32               Attributes,
+  IN UINTN                Start
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      Name[OC_LOG_NVRAM_CHUNK_NAME_SIZE];
+  UINTN       Chunk;
+  UINTN       ChunkStart;
+  UINTN       ChunkLength;
+
+  //
+  // Log is split into fixed size variables, so that only the chunks
+  // touched by the new line are rewritten.
+  //
+  Status = EFI_SUCCESS;
+
+  for (Chunk = Start / OC_LOG_NVRAM_CHUNK_SIZE; Chunk < OC_LOG_NVRAM_CHUNK_COUNT; ++Chunk) {
+    ChunkStart = Chunk * OC_LOG_NVRAM_CHUNK_SIZE;
+    if (ChunkStart >= Private->NvramBufferLength) {
+      break;
+    }
+
+    ChunkLength = MIN (Private->NvramBufferLength - ChunkStart, OC_LOG_NVRAM_CHUNK_SIZE);
+
+    GetNvramChunkName (Name, sizeof (Name), Chunk);
+    Status = gRT->SetVariable (
+      Name,
+      &gOcVendorVariableGuid,
+      Attributes,
+      ChunkLength,
+      &Private->NvramBuffer[ChunkStart]
+      );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  return Status;
+}
+
+STATIC
+VOID
+DeleteNvramChunks (
+  VOID
+  )
+{
+  CHAR16  Name[OC_LOG_NVRAM_CHUNK_NAME_SIZE];
+  UINTN   Chunk;
+
+  //
+  // Drop chunks left by a longer log from a previous boot.
+  //
+  for (Chunk = 1; Chunk < OC_LOG_NVRAM_CHUNK_COUNT; ++Chunk) {
+    GetNvramChunkName (Name, sizeof (Name), Chunk);
+    gRT->SetVariable (Name, &gOcVendorVariableGuid, 0, 0, NULL);
+  }
+}
+
+STATIC
+VOID
+EFIAPI
+OcLogExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  OC_LOG_PRIVATE_DATA  *Private;
+
+  Private = Context;
+
+  //
+  // File system access and pool allocation are not allowed here, any batch
+  // not flushed by OcLogFlushFile before starting the image is lost.
+  //
+  Private->OcLog.Options &= ~OC_LOG_FILE;
+}
+
 EFI_STATUS
 EFIAPI
 OcLogAddEntry  (
@@ -158,6 +327,7 @@ OcLogAddEntry  (
   UINT32                      KeySize;
   UINT32                      DataSize;
   UINT32                      TotalSize;
+  UINTN                       NvramStart;
 
   Private = OC_LOG_PRIVATE_DATA_FROM_OC_LOG_THIS (OcLog);
 
@@ -279,25 +449,20 @@ OcLogAddEntry  (
     //
     // Write to internal buffer.
     //
-
-    Status = AsciiStrCatS (Private->AsciiBuffer, Private->AsciiBufferSize, Private->TimingTxt);
-    if (!EFI_ERROR (Status)) {
-      Status = AsciiStrCatS (Private->AsciiBuffer, Private->AsciiBufferSize, Private->LineBuffer);
-    }
+    Status = AppendLogBuffer (
+      Private->AsciiBuffer,
+      Private->AsciiBufferSize,
+      &Private->AsciiBufferLength,
+      Private->TimingTxt,
+      TimingLength,
+      Private->LineBuffer,
+      LineLength
+      );
 
     //
-    // Write to a file.
-    // Always overwriting file completely is most reliable.
-    // I know it is slow, but fixed size write is more reliable with broken FAT32 driver.
+    // Write to a file, errors are written immediately.
     //
-    if ((OcLog->Options & OC_LOG_FILE) != 0 && OcLog->FileSystem != NULL) {
-      SetFileData (
-        OcLog->FileSystem,
-        OcLog->FilePath,
-        Private->AsciiBuffer,
-        (UINT32) Private->AsciiBufferSize
-        );
-    }
+    FlushLogFile (OcLog, Private, (ErrorLevel & DEBUG_ERROR) != 0);
 
     //
     // Write to a variable.
@@ -307,24 +472,27 @@ OcLogAddEntry  (
       // Do not log timing information to NVRAM, it is already large.
       // This check is here, because Microsoft is retarded and asserts.
       //
-      if (Private->NvramBufferSize - AsciiStrSize (Private->NvramBuffer) >= AsciiStrLen (Private->LineBuffer)) {
-        Status = AsciiStrCatS (Private->NvramBuffer, Private->NvramBufferSize, Private->LineBuffer);
-      } else {
-        Status = EFI_BUFFER_TOO_SMALL;
+      NvramStart = Private->NvramBufferLength;
+      if (NvramStart == 0) {
+        DeleteNvramChunks ();
       }
+
+      Status = AppendLogBuffer (
+        Private->NvramBuffer,
+        Private->NvramBufferSize,
+        &Private->NvramBufferLength,
+        NULL,
+        0,
+        Private->LineBuffer,
+        LineLength
+        );
       if (!EFI_ERROR (Status)) {
         Attributes = EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
         if ((OcLog->Options & OC_LOG_NONVOLATILE) != 0) {
           Attributes |= EFI_VARIABLE_NON_VOLATILE;
         }
 
-        Status = gRT->SetVariable (
-          OC_LOG_VARIABLE_NAME,
-          &gOcVendorVariableGuid,
-          Attributes,
-          AsciiStrLen (Private->NvramBuffer),
-          Private->NvramBuffer
-          );
+        Status = WriteNvramChunks (Private, Attributes, NvramStart);
 
         if (EFI_ERROR (Status)) {
           //
@@ -347,6 +515,7 @@ OcLogAddEntry  (
   if ((ErrorLevel & OcLog->HaltLevel) != 0
     && AsciiStrnCmp (FormatString, "\nASSERT_RETURN_ERROR", L_STR_LEN ("\nASSERT_RETURN_ERROR")) != 0
     && AsciiStrnCmp (FormatString, "\nASSERT_EFI_ERROR", L_STR_LEN ("\nASSERT_EFI_ERROR")) != 0) {
+    FlushLogFile (OcLog, Private, TRUE);
     gST->ConOut->OutputString (gST->ConOut, L"Halting on critical error\r\n");
     gBS->Stall (SECONDS_TO_MICROSECONDS (1));
     CpuDeadLoop ();
@@ -386,7 +555,20 @@ OcLogSaveLog (
   IN EFI_DEVICE_PATH_PROTOCOL  *FilePath OPTIONAL
   )
 {
-  return EFI_NOT_FOUND;
+  OC_LOG_PRIVATE_DATA  *Private;
+
+  //
+  // Only writing pending lines to the configured log file is supported.
+  //
+  if (NonVolatile != 0 || FilePath != NULL
+    || (This->Options & OC_LOG_FILE) == 0 || This->FileSystem == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Private = OC_LOG_PRIVATE_DATA_FROM_OC_LOG_THIS (This);
+  FlushLogFile (This, Private, TRUE);
+
+  return EFI_SUCCESS;
 }
 
 EFI_STATUS
@@ -422,6 +604,19 @@ InternalGetOcLog (
   return mInternalOcLog;
 }
 
+VOID
+OcLogFlushFile (
+  VOID
+  )
+{
+  OC_LOG_PROTOCOL  *OcLog;
+
+  OcLog = InternalGetOcLog ();
+  if (OcLog != NULL) {
+    OcLog->SaveLog (OcLog, 0, NULL);
+  }
+}
+
 EFI_STATUS
 OcConfigureLogProtocol (
   IN OC_LOG_OPTIONS                   Options,
@@ -526,6 +721,14 @@ OcConfigureLogProtocol (
 
       if (!EFI_ERROR (Status)) {
         OcLog = &Private->OcLog;
+
+        gBS->CreateEvent (
+          EVT_SIGNAL_EXIT_BOOT_SERVICES,
+          TPL_NOTIFY,
+          OcLogExitBootServices,
+          Private,
+          &Private->ExitBootServicesEvent
+          );
       } else {
         FreePool (Private);
       }
@@ -534,12 +737,12 @@ OcConfigureLogProtocol (
 
   if (LogRoot != NULL) {
     if (!EFI_ERROR (Status)) {
-      SetFileData (
-        LogRoot,
-        LogPath,
-        OC_LOG_PRIVATE_DATA_FROM_OC_LOG_THIS (OcLog)->AsciiBuffer,
-        (UINT32) OC_LOG_PRIVATE_DATA_FROM_OC_LOG_THIS (OcLog)->AsciiBufferSize
-        );
+      //
+      // Write everything logged so far to the new file.
+      //
+      Private = OC_LOG_PRIVATE_DATA_FROM_OC_LOG_THIS (OcLog);
+      Private->AsciiBufferFlushed = 0;
+      FlushLogFile (OcLog, Private, TRUE);
     } else {
       LogRoot->Close (LogRoot);
       FreePool (LogPath);
@@ -23,6 +23,10 @@
 #define OC_LOG_NVRAM_BUFFER_SIZE      BASE_32KB
 #define OC_LOG_FILE_PATH_BUFFER_SIZE  256
 #define OC_LOG_TIMING_BUFFER_SIZE     64
+#define OC_LOG_NVRAM_CHUNK_SIZE       BASE_4KB
+#define OC_LOG_NVRAM_CHUNK_COUNT      (OC_LOG_NVRAM_BUFFER_SIZE / OC_LOG_NVRAM_CHUNK_SIZE)
+#define OC_LOG_NVRAM_CHUNK_NAME_SIZE  32
+#define OC_LOG_FILE_FLUSH_SIZE        BASE_16KB
 
 #define OC_LOG_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('O', 'C', 'L', 'G')
 
@@ -39,11 +43,15 @@ typedef struct {
   CHAR16                 UnicodeLineBuffer[OC_LOG_LINE_BUFFER_SIZE];
   CHAR8                  AsciiBuffer[OC_LOG_BUFFER_SIZE];
   UINTN                  AsciiBufferSize;
+  UINTN                  AsciiBufferLength;
+  UINTN                  AsciiBufferFlushed;
   CHAR8                  NvramBuffer[OC_LOG_NVRAM_BUFFER_SIZE];
   UINTN                  NvramBufferSize;
+  UINTN                  NvramBufferLength;
   UINT32                 LogCounter;
   CHAR16                 *LogFilePathName;
   EFI_DATA_HUB_PROTOCOL  *DataHub;
+  EFI_EVENT              ExitBootServicesEvent;
   OC_LOG_PROTOCOL        OcLog;
 } OC_LOG_PRIVATE_DATA;
 
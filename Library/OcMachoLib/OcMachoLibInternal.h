@@ -31,6 +31,24 @@ InternalRetrieveSymtabs64 (
   IN OUT OC_MACHO_CONTEXT  *Context
   );
 
+/**
+  Retrieves a Relocation by the address it targets by a linear search.  This
+  is the reference for MachoLookupRelocation.
+
+  @param[in] Address    The address to search for.
+  @param[in] NumRelocs  The number of Relocations in Relocs.
+  @param[in] Relocs     The Relocations to search.
+
+  @retval NULL  NULL is returned on failure.
+
+**/
+MACH_RELOCATION_INFO *
+InternalLookupRelocationByOffset (
+  IN UINT64                Address,
+  IN UINT32                NumRelocs,
+  IN MACH_RELOCATION_INFO  *Relocs
+  );
+
 /**
   Retrieves an extern Relocation by the address it targets.
 
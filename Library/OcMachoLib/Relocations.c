@@ -16,7 +16,9 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #include <IndustryStandard/AppleMachoImage.h>
 
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcMachoLib.h>
 
 #include "OcMachoLibInternal.h"
@@ -66,19 +68,21 @@ MachoPreserveRelocationIntel64 (
 }
 
 /**
-  Retrieves an extern Relocation by the address it targets.
+  Retrieves a Relocation by the address it targets by a linear search.  This
+  is the reference for MachoLookupRelocation.
 
-  @param[in]     Address  The address to search for.
+  @param[in] Address    The address to search for.
+  @param[in] NumRelocs  The number of Relocations in Relocs.
+  @param[in] Relocs     The Relocations to search.
 
   @retval NULL  NULL is returned on failure.
 
 **/
-STATIC
 MACH_RELOCATION_INFO *
 InternalLookupRelocationByOffset (
-  IN     UINT64                Address,
-  IN     UINT32                NumRelocs,
-  IN     MACH_RELOCATION_INFO  *Relocs
+  IN UINT64                Address,
+  IN UINT32                NumRelocs,
+  IN MACH_RELOCATION_INFO  *Relocs
   )
 {
   UINT32               Index;
@@ -113,6 +117,279 @@ InternalLookupRelocationByOffset (
   return NULL;
 }
 
+/**
+  Collects the Relocations InternalLookupRelocationByOffset may return.
+
+  @param[in]  NumRelocs  The number of Relocations in Relocs.
+  @param[in]  Relocs     The Relocations to collect.
+  @param[out] Index      Buffer of at least NumRelocs entries to collect into.
+
+  @returns  The number of Relocations collected.
+
+**/
+STATIC
+UINT32
+InternalCollectRelocations (
+  IN  UINT32                NumRelocs,
+  IN  MACH_RELOCATION_INFO  *Relocs,
+  OUT MACH_RELOCATION_INFO  **Index
+  )
+{
+  UINT32               RelocIndex;
+  UINT32               NumCollected;
+  MACH_RELOCATION_INFO *Relocation;
+
+  NumCollected = 0;
+
+  //
+  // Mirror the skipping logic of InternalLookupRelocationByOffset exactly.
+  //
+  for (RelocIndex = 0; RelocIndex < NumRelocs; ++RelocIndex) {
+    Relocation = &Relocs[RelocIndex];
+    if ((Relocation->Extern == 0)
+     && (Relocation->SymbolNumber == MACH_RELOC_ABSOLUTE)) {
+      continue;
+    }
+
+    Index[NumCollected] = Relocation;
+    ++NumCollected;
+
+    if (MachoRelocationIsPairIntel64 ((UINT8)Relocation->Type)) {
+      ++RelocIndex;
+    }
+  }
+
+  return NumCollected;
+}
+
+/**
+  Sorts Relocations by address.  The sort is stable, so that the first of
+  several Relocations targeting the same address is found, as with a linear
+  search.
+
+  @param[in,out] Index       The Relocations to sort.
+  @param[in]     NumEntries  The number of entries in Index.
+  @param[in]     Scratch     Buffer of at least NumEntries entries.
+
+**/
+STATIC
+VOID
+InternalSortRelocations (
+  IN OUT MACH_RELOCATION_INFO  **Index,
+  IN     UINT32                NumEntries,
+  IN     MACH_RELOCATION_INFO  **Scratch
+  )
+{
+  MACH_RELOCATION_INFO **Source;
+  MACH_RELOCATION_INFO **Target;
+  MACH_RELOCATION_INFO **Swap;
+  UINT32               Width;
+  UINT32               Start;
+  UINT32               Middle;
+  UINT32               End;
+  UINT32               Left;
+  UINT32               Right;
+  UINT32               Out;
+
+  //
+  // Bottom-up merge sort.  Relocations are mostly emitted in descending
+  // address order, which is the worst case for insertion sort.
+  //
+  Source = Index;
+  Target = Scratch;
+
+  for (Width = 1; Width < NumEntries; Width *= 2) {
+    for (Start = 0; Start < NumEntries; Start += 2 * Width) {
+      Middle = MIN (Start + Width, NumEntries);
+      End    = MIN (Middle + Width, NumEntries);
+      Left   = Start;
+      Right  = Middle;
+
+      for (Out = Start; Out < End; ++Out) {
+        if (Left < Middle
+          && (Right >= End
+            || (UINT64)Source[Left]->Address <= (UINT64)Source[Right]->Address)) {
+          Target[Out] = Source[Left];
+          ++Left;
+        } else {
+          Target[Out] = Source[Right];
+          ++Right;
+        }
+      }
+    }
+
+    Swap   = Source;
+    Source = Target;
+    Target = Swap;
+  }
+
+  if (Source != Index) {
+    CopyMem (Index, Source, NumEntries * sizeof (*Index));
+  }
+}
+
+/**
+  Builds the Relocation index of Context.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+  @returns  Whether the index has been built successfully.
+
+**/
+STATIC
+BOOLEAN
+InternalBuildRelocationIndex (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  MACH_RELOCATION_INFO **Index;
+  MACH_RELOCATION_INFO **Scratch;
+  UINTN                NumRelocs;
+  UINT32               NumExtern;
+  UINT32               NumLocal;
+
+  //
+  // The Relocations have been verified to lie within the file, so the total
+  // cannot overflow.
+  //
+  NumRelocs = (UINTN)Context->DySymtab->NumExternalRelocations
+            + Context->DySymtab->NumOfLocalRelocations;
+  if (NumRelocs == 0) {
+    return FALSE;
+  }
+
+  Index = AllocatePool (NumRelocs * sizeof (*Index));
+  if (Index == NULL) {
+    return FALSE;
+  }
+
+  Scratch = AllocatePool (NumRelocs * sizeof (*Scratch));
+  if (Scratch == NULL) {
+    FreePool (Index);
+    return FALSE;
+  }
+
+  NumExtern = InternalCollectRelocations (
+                Context->DySymtab->NumExternalRelocations,
+                Context->ExternRelocations,
+                Index
+                );
+  NumLocal  = InternalCollectRelocations (
+                Context->DySymtab->NumOfLocalRelocations,
+                Context->LocalRelocations,
+                &Index[NumExtern]
+                );
+
+  InternalSortRelocations (Index, NumExtern, Scratch);
+  InternalSortRelocations (&Index[NumExtern], NumLocal, Scratch);
+
+  FreePool (Scratch);
+
+  Context->RelocationIndex             = Index;
+  Context->NumIndexedExternRelocations = NumExtern;
+  Context->NumIndexedLocalRelocations  = NumLocal;
+
+  return TRUE;
+}
+
+/**
+  Retrieves a Relocation by the address it targets.  The first call builds an
+  index of the Relocations sorted by address, which must be released with
+  MachoFreeRelocationIndex before the Relocations are modified.  If the index
+  cannot be allocated, the Relocations are searched linearly.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Address  The address to search for.
+  @param[in]     Extern   Whether to search the extern or the local Relocations.
+
+  @retval NULL  NULL is returned on failure.
+
+**/
+MACH_RELOCATION_INFO *
+MachoLookupRelocation (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     UINT64            Address,
+  IN     BOOLEAN           Extern
+  )
+{
+  MACH_RELOCATION_INFO **Index;
+  UINT32               NumEntries;
+  UINT32               Low;
+  UINT32               High;
+  UINT32               Middle;
+
+  ASSERT (Context != NULL);
+
+  if (!InternalRetrieveSymtabs64 (Context) || Context->DySymtab == NULL) {
+    return NULL;
+  }
+
+  if (Context->RelocationIndex == NULL
+   && !InternalBuildRelocationIndex (Context)) {
+    if (Extern) {
+      return InternalLookupRelocationByOffset (
+               Address,
+               Context->DySymtab->NumExternalRelocations,
+               Context->ExternRelocations
+               );
+    }
+
+    return InternalLookupRelocationByOffset (
+             Address,
+             Context->DySymtab->NumOfLocalRelocations,
+             Context->LocalRelocations
+             );
+  }
+
+  if (Extern) {
+    Index      = Context->RelocationIndex;
+    NumEntries = Context->NumIndexedExternRelocations;
+  } else {
+    Index      = &Context->RelocationIndex[Context->NumIndexedExternRelocations];
+    NumEntries = Context->NumIndexedLocalRelocations;
+  }
+  //
+  // Find the first entry not below Address.
+  //
+  Low  = 0;
+  High = NumEntries;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if ((UINT64)Index[Middle]->Address < Address) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if (Low < NumEntries && (UINT64)Index[Low]->Address == Address) {
+    return Index[Low];
+  }
+
+  return NULL;
+}
+
+/**
+  Frees the Relocation index built by MachoLookupRelocation, if any.
+
+  @param[in,out] Context  Context of the Mach-O.
+
+**/
+VOID
+MachoFreeRelocationIndex (
+  IN OUT OC_MACHO_CONTEXT  *Context
+  )
+{
+  ASSERT (Context != NULL);
+
+  if (Context->RelocationIndex != NULL) {
+    FreePool (Context->RelocationIndex);
+    Context->RelocationIndex             = NULL;
+    Context->NumIndexedExternRelocations = 0;
+    Context->NumIndexedLocalRelocations  = 0;
+  }
+}
+
 /**
   Retrieves an extern Relocation by the address it targets.
 
@@ -128,11 +405,7 @@ InternalGetExternRelocationByOffset (
   IN     UINT64            Address
   )
 {
-  return InternalLookupRelocationByOffset (
-           Address,
-           Context->DySymtab->NumExternalRelocations,
-           Context->ExternRelocations
-           );
+  return MachoLookupRelocation (Context, Address, TRUE);
 }
 
 /**
@@ -150,9 +423,5 @@ InternalGetLocalRelocationByOffset (
   IN     UINT64            Address
   )
 {
-  return InternalLookupRelocationByOffset (
-           Address,
-           Context->DySymtab->NumOfLocalRelocations,
-           Context->LocalRelocations
-           );
+  return MachoLookupRelocation (Context, Address, FALSE);
 }
@@ -0,0 +1,206 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcGuardLib.h>
+#include <Library/OcMemoryLib.h>
+
+//
+// Allocations are bump allocated from a chain of blocks, newest first.
+//
+struct OC_MEMORY_ARENA_BLOCK_ {
+  OC_MEMORY_ARENA_BLOCK  *Next;
+  UINT32                 Size;
+  UINT32                 Used;
+  UINT64                 Data[];
+};
+
+//
+// Block sizes are doubled up to this size to keep the amount of blocks small.
+//
+#define MEMORY_ARENA_MAX_GROWTH_SIZE  SIZE_32MB
+
+//
+// Smallest block size to request from pool.
+//
+#define MEMORY_ARENA_MIN_BLOCK_SIZE   SIZE_4KB
+
+VOID
+MemoryArenaInit (
+  OUT OC_MEMORY_ARENA  *Arena,
+  IN  CONST CHAR8      *Name,
+  IN  UINT32           BlockSize
+  )
+{
+  ASSERT (Arena != NULL);
+  ASSERT (Name != NULL);
+
+  ZeroMem (Arena, sizeof (*Arena));
+  Arena->Name             = Name;
+  Arena->InitialBlockSize = MAX (BlockSize, MEMORY_ARENA_MIN_BLOCK_SIZE);
+  Arena->BlockSize        = Arena->InitialBlockSize;
+}
+
+VOID *
+MemoryArenaAllocate (
+  IN OUT OC_MEMORY_ARENA  *Arena,
+  IN     UINT32           Size
+  )
+{
+  OC_MEMORY_ARENA_BLOCK  *Block;
+  UINT32                 BlockSize;
+  UINT32                 PoolSize;
+  UINT64                 StartTsc;
+  VOID                   *Memory;
+
+  ASSERT (Arena != NULL);
+
+  if (OcOverflowAddU32 (Size, sizeof (UINT64) - 1, &Size)) {
+    return NULL;
+  }
+
+  Size  = Size & ~(UINT32) (sizeof (UINT64) - 1);
+  Block = Arena->Blocks;
+
+  if (Block == NULL || Block->Size - Block->Used < Size) {
+    BlockSize = MAX (Arena->BlockSize, Size);
+    if (OcOverflowAddU32 (BlockSize, sizeof (OC_MEMORY_ARENA_BLOCK), &PoolSize)) {
+      return NULL;
+    }
+
+    StartTsc = AsmReadTsc ();
+    Block    = AllocatePool (PoolSize);
+    Arena->PoolTicks += AsmReadTsc () - StartTsc;
+    if (Block == NULL) {
+      return NULL;
+    }
+
+    Block->Next   = Arena->Blocks;
+    Block->Size   = BlockSize;
+    Block->Used   = 0;
+    Arena->Blocks = Block;
+
+    ++Arena->PoolAllocations;
+    Arena->PeakSize += PoolSize;
+
+    //
+    // Grow further blocks when the initial estimate was off.
+    //
+    if (Arena->BlockSize < MEMORY_ARENA_MAX_GROWTH_SIZE) {
+      Arena->BlockSize *= 2;
+    }
+  }
+
+  Memory       = (UINT8 *) Block->Data + Block->Used;
+  Block->Used += Size;
+
+  ++Arena->Allocations;
+  Arena->UsedSize += Size;
+
+  return Memory;
+}
+
+VOID *
+MemoryArenaAllocateZero (
+  IN OUT OC_MEMORY_ARENA  *Arena,
+  IN     UINT32           Size
+  )
+{
+  VOID  *Memory;
+
+  Memory = MemoryArenaAllocate (Arena, Size);
+  if (Memory != NULL) {
+    ZeroMem (Memory, Size);
+  }
+
+  return Memory;
+}
+
+VOID *
+MemoryArenaAllocateCopy (
+  IN OUT OC_MEMORY_ARENA  *Arena,
+  IN     UINT32           Size,
+  IN     CONST VOID       *Buffer
+  )
+{
+  VOID  *Memory;
+
+  ASSERT (Buffer != NULL);
+
+  Memory = MemoryArenaAllocate (Arena, Size);
+  if (Memory != NULL) {
+    CopyMem (Memory, Buffer, Size);
+  }
+
+  return Memory;
+}
+
+BOOLEAN
+MemoryArenaContains (
+  IN CONST OC_MEMORY_ARENA  *Arena,
+  IN CONST VOID             *Memory
+  )
+{
+  OC_MEMORY_ARENA_BLOCK  *Block;
+
+  ASSERT (Arena != NULL);
+
+  for (Block = Arena->Blocks; Block != NULL; Block = Block->Next) {
+    if ((UINTN) Memory >= (UINTN) Block->Data
+      && (UINTN) Memory < (UINTN) Block->Data + Block->Used) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+VOID
+MemoryArenaFree (
+  IN OUT OC_MEMORY_ARENA  *Arena
+  )
+{
+  OC_MEMORY_ARENA_BLOCK  *Block;
+  OC_MEMORY_ARENA_BLOCK  *Next;
+  UINT64                 StartTsc;
+
+  ASSERT (Arena != NULL);
+
+  StartTsc = AsmReadTsc ();
+  for (Block = Arena->Blocks; Block != NULL; Block = Next) {
+    Next = Block->Next;
+    FreePool (Block);
+  }
+  Arena->PoolTicks += AsmReadTsc () - StartTsc;
+
+  if (Arena->Allocations > 0) {
+    DEBUG ((
+      DEBUG_VERBOSE,
+      "OCMM: Arena %a served %u allocations of %u bytes from %u blocks of %u bytes in %Lu TSC ticks\n",
+      Arena->Name,
+      Arena->Allocations,
+      Arena->UsedSize,
+      Arena->PoolAllocations,
+      Arena->PeakSize,
+      Arena->PoolTicks
+      ));
+  }
+
+  MemoryArenaInit (Arena, Arena->Name, Arena->InitialBlockSize);
+}
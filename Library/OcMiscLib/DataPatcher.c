@@ -15,6 +15,8 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcGuardLib.h>
 #include <Library/OcMiscLib.h>
 
 INT32
@@ -115,3 +117,501 @@ ApplyPatch (
 
   return ReplaceCount;
 }
+
+//
+// Pattern match found during the search pass.
+//
+typedef struct {
+  UINT32  Patch;
+  UINT32  Offset;
+} PATCH_MATCH;
+
+//
+// Data range modified by an applied patch.
+//
+typedef struct {
+  UINT32  Start;
+  UINT32  End;
+} PATCH_RANGE;
+
+//
+// Modified data ranges, tracking is disabled on allocation failure.
+//
+typedef struct {
+  PATCH_RANGE  *Ranges;
+  UINT32       Count;
+  UINT32       Capacity;
+  BOOLEAN      Enabled;
+} PATCH_TRACKER;
+
+STATIC
+BOOLEAN
+InternalAppendItem (
+  IN OUT VOID        **Items,
+  IN OUT UINT32      *Count,
+  IN OUT UINT32      *Capacity,
+  IN     CONST VOID  *Item,
+  IN     UINT32      ItemSize
+  )
+{
+  VOID    *NewItems;
+  UINT32  NewCapacity;
+
+  if (*Count == *Capacity) {
+    NewCapacity = *Capacity > 0 ? *Capacity * 2 : 64;
+    if (NewCapacity <= *Capacity || NewCapacity > MAX_UINT32 / ItemSize) {
+      return FALSE;
+    }
+
+    NewItems = ReallocatePool (
+      *Capacity * ItemSize,
+      NewCapacity * ItemSize,
+      *Items
+      );
+    if (NewItems == NULL) {
+      return FALSE;
+    }
+
+    *Items    = NewItems;
+    *Capacity = NewCapacity;
+  }
+
+  CopyMem ((UINT8 *) *Items + *Count * ItemSize, Item, ItemSize);
+  ++*Count;
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+InternalPatchMatches (
+  IN CONST OC_DATA_PATCH  *Patch,
+  IN CONST UINT8          *Data
+  )
+{
+  UINT32  Index;
+
+  if (Patch->PatternMask == NULL) {
+    return CompareMem (Data, Patch->Pattern, Patch->Size) == 0;
+  }
+
+  for (Index = 0; Index < Patch->Size; ++Index) {
+    if ((Data[Index] & Patch->PatternMask[Index]) != Patch->Pattern[Index]) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+VOID
+InternalPatchReplace (
+  IN     CONST OC_DATA_PATCH  *Patch,
+  IN OUT UINT8                *Data
+  )
+{
+  UINT32  Index;
+
+  if (Patch->ReplaceMask == NULL) {
+    CopyMem (Data, Patch->Replace, Patch->Size);
+    return;
+  }
+
+  for (Index = 0; Index < Patch->Size; ++Index) {
+    Data[Index] = (Data[Index] & ~Patch->ReplaceMask[Index]) | (Patch->Replace[Index] & Patch->ReplaceMask[Index]);
+  }
+}
+
+/**
+  Obtain the range of pattern offsets to try, matching FindPattern bounds.
+
+  @retval FALSE when the pattern cannot match anywhere.
+**/
+STATIC
+BOOLEAN
+InternalPatchRegion (
+  IN  CONST OC_DATA_PATCH  *Patch,
+  IN  UINT32               DataSize,
+  OUT UINT32               *First,
+  OUT UINT32               *Last
+  )
+{
+  if (Patch->Size == 0
+    || Patch->DataOff >= DataSize
+    || Patch->DataSize > DataSize - Patch->DataOff
+    || Patch->DataSize <= Patch->Size) {
+    return FALSE;
+  }
+
+  *First = Patch->DataOff;
+  *Last  = Patch->DataOff + (Patch->DataSize - Patch->Size - 1);
+  return TRUE;
+}
+
+/**
+  Perform replacement at a verified match unless it is to be skipped.
+
+  @retval TRUE when the patch reached its replacement count.
+**/
+STATIC
+BOOLEAN
+InternalPatchTakeMatch (
+  IN OUT OC_DATA_PATCH  *Patch,
+  IN OUT UINT8          *Data,
+  IN     UINT32         Offset,
+  IN OUT UINT32         *Skip,
+  IN OUT PATCH_TRACKER  *Tracker
+  )
+{
+  PATCH_RANGE  Range;
+
+  if (*Skip > 0) {
+    --*Skip;
+    return FALSE;
+  }
+
+  InternalPatchReplace (Patch, &Data[Offset]);
+  ++Patch->ReplaceCount;
+
+  if (Tracker->Enabled) {
+    Range.Start = Offset;
+    Range.End   = Offset + Patch->Size;
+    if (!InternalAppendItem (
+      (VOID **) &Tracker->Ranges,
+      &Tracker->Count,
+      &Tracker->Capacity,
+      &Range,
+      sizeof (Range)
+      )) {
+      Tracker->Enabled = FALSE;
+    }
+  }
+
+  return Patch->Count > 0 && Patch->ReplaceCount == Patch->Count;
+}
+
+/**
+  Apply patch by trying every offset, like ApplyPatch does.
+**/
+STATIC
+VOID
+InternalApplyPatchLinear (
+  IN OUT OC_DATA_PATCH  *Patch,
+  IN OUT UINT8          *Data,
+  IN     UINT32         First,
+  IN     UINT32         Last,
+  IN OUT PATCH_TRACKER  *Tracker
+  )
+{
+  UINT32  Offset;
+  UINT32  Skip;
+
+  Skip   = Patch->Skip;
+  Offset = First;
+
+  while (Offset <= Last) {
+    if (!InternalPatchMatches (Patch, &Data[Offset])) {
+      ++Offset;
+      continue;
+    }
+
+    if (InternalPatchTakeMatch (Patch, Data, Offset, &Skip, Tracker)) {
+      break;
+    }
+
+    Offset += Patch->Size;
+  }
+}
+
+/**
+  Apply patch using matches from the search pass. Data modified by earlier
+  patches is searched again, as it may have created or destroyed matches.
+
+  @retval FALSE on allocation failure, Data is left unchanged.
+**/
+STATIC
+BOOLEAN
+InternalApplyPatchMatches (
+  IN OUT OC_DATA_PATCH  *Patch,
+  IN OUT UINT8          *Data,
+  IN     UINT32         First,
+  IN     UINT32         Last,
+  IN     CONST UINT32   *Matches,
+  IN     UINT32         MatchCount,
+  IN OUT PATCH_TRACKER  *Tracker
+  )
+{
+  UINT32  *Extra;
+  UINT32  ExtraCount;
+  UINT32  ExtraCapacity;
+  UINT32  RangeCount;
+  UINT32  Index;
+  UINT32  Index2;
+  UINT32  Offset;
+  UINT32  NextOffset;
+  UINT32  End;
+  UINT32  Skip;
+
+  Extra         = NULL;
+  ExtraCount    = 0;
+  ExtraCapacity = 0;
+  RangeCount    = Tracker->Count;
+
+  for (Index = 0; Index < RangeCount; ++Index) {
+    Offset = Tracker->Ranges[Index].Start;
+    Offset = Offset >= Patch->Size ? Offset - Patch->Size + 1 : 0;
+    Offset = MAX (Offset, First);
+    End    = MIN (Tracker->Ranges[Index].End - 1, Last);
+
+    for (; Offset <= End; ++Offset) {
+      if (InternalPatchMatches (Patch, &Data[Offset])
+        && !InternalAppendItem ((VOID **) &Extra, &ExtraCount, &ExtraCapacity, &Offset, sizeof (Offset))) {
+        if (Extra != NULL) {
+          FreePool (Extra);
+        }
+        return FALSE;
+      }
+    }
+  }
+
+  //
+  // Matches in modified ranges are rare, so insertion sort will do.
+  //
+  for (Index = 1; Index < ExtraCount; ++Index) {
+    Offset = Extra[Index];
+    for (Index2 = Index; Index2 > 0 && Extra[Index2 - 1] > Offset; --Index2) {
+      Extra[Index2] = Extra[Index2 - 1];
+    }
+    Extra[Index2] = Offset;
+  }
+
+  Skip       = Patch->Skip;
+  NextOffset = First;
+  Index      = 0;
+  Index2     = 0;
+
+  while (Index < MatchCount || Index2 < ExtraCount) {
+    if (Index2 == ExtraCount || (Index < MatchCount && Matches[Index] < Extra[Index2])) {
+      Offset = Matches[Index++];
+    } else {
+      Offset = Extra[Index2++];
+    }
+
+    //
+    // Overlapping or duplicate match, or one destroyed by an earlier patch.
+    //
+    if (Offset < NextOffset || !InternalPatchMatches (Patch, &Data[Offset])) {
+      continue;
+    }
+
+    if (InternalPatchTakeMatch (Patch, Data, Offset, &Skip, Tracker)) {
+      break;
+    }
+
+    NextOffset = Offset + Patch->Size;
+  }
+
+  if (Extra != NULL) {
+    FreePool (Extra);
+  }
+
+  return TRUE;
+}
+
+BOOLEAN
+ApplyPatches (
+  IN OUT OC_DATA_PATCH  *Patches,
+  IN     UINT32         PatchCount,
+  IN OUT UINT8          *Data,
+  IN     UINT32         DataSize
+  )
+{
+  OC_DATA_PATCH  *Patch;
+  UINT32         Histogram[256];
+  UINT32         Buckets[256];
+  UINT32         *Anchors;
+  UINT32         *Chains;
+  UINT32         *Firsts;
+  UINT32         *Lasts;
+  UINT32         *Groups;
+  UINT32         AllocSize;
+  PATCH_MATCH    *Matches;
+  PATCH_MATCH    Match;
+  UINT32         MatchCount;
+  UINT32         MatchCapacity;
+  UINT32         *Offsets;
+  PATCH_TRACKER  Tracker;
+  UINT32         Index;
+  UINT32         Index2;
+  UINT32         Offset;
+
+  ASSERT (Patches != NULL || PatchCount == 0);
+  ASSERT (Data != NULL);
+
+  if (OcOverflowMulU32 (PatchCount, 5 * sizeof (UINT32), &AllocSize)
+    || OcOverflowAddU32 (AllocSize, sizeof (UINT32), &AllocSize)) {
+    return FALSE;
+  }
+
+  Anchors = AllocatePool (AllocSize);
+  if (Anchors == NULL) {
+    return FALSE;
+  }
+
+  Chains  = &Anchors[PatchCount];
+  Firsts  = &Chains[PatchCount];
+  Lasts   = &Firsts[PatchCount];
+  Groups  = &Lasts[PatchCount];
+
+  //
+  // Anchor every pattern at its rarest unmasked byte, so that the search pass
+  // only has to verify few candidates. Frequencies do not matter for one patch.
+  //
+  ZeroMem (Histogram, sizeof (Histogram));
+  if (PatchCount > 1) {
+    for (Offset = 0; Offset < DataSize; ++Offset) {
+      ++Histogram[Data[Offset]];
+    }
+  }
+
+  ZeroMem (Buckets, sizeof (Buckets));
+  for (Index = 0; Index < PatchCount; ++Index) {
+    Patch = &Patches[Index];
+    Patch->ReplaceCount = 0;
+    Anchors[Index]      = MAX_UINT32;
+
+    if (Patch->Pattern == NULL
+      || !InternalPatchRegion (Patch, DataSize, &Firsts[Index], &Lasts[Index])) {
+      continue;
+    }
+
+    for (Index2 = 0; Index2 < Patch->Size; ++Index2) {
+      if ((Patch->PatternMask == NULL || Patch->PatternMask[Index2] == 0xFFU)
+        && (Anchors[Index] == MAX_UINT32
+          || Histogram[Patch->Pattern[Index2]] < Histogram[Patch->Pattern[Anchors[Index]]])) {
+        Anchors[Index] = Index2;
+      }
+    }
+
+    if (Anchors[Index] != MAX_UINT32) {
+      Chains[Index] = Buckets[Patch->Pattern[Anchors[Index]]];
+      Buckets[Patch->Pattern[Anchors[Index]]] = Index + 1;
+    }
+  }
+
+  //
+  // Search pass over the original data.
+  //
+  Matches       = NULL;
+  MatchCount    = 0;
+  MatchCapacity = 0;
+
+  for (Offset = 0; Offset < DataSize; ++Offset) {
+    for (Index = Buckets[Data[Offset]]; Index != 0; Index = Chains[Index - 1]) {
+      Match.Patch  = Index - 1;
+      if (Offset < Anchors[Match.Patch]) {
+        continue;
+      }
+
+      Match.Offset = Offset - Anchors[Match.Patch];
+      if (Match.Offset < Firsts[Match.Patch] || Match.Offset > Lasts[Match.Patch]
+        || !InternalPatchMatches (&Patches[Match.Patch], &Data[Match.Offset])) {
+        continue;
+      }
+
+      if (!InternalAppendItem ((VOID **) &Matches, &MatchCount, &MatchCapacity, &Match, sizeof (Match))) {
+        if (Matches != NULL) {
+          FreePool (Matches);
+        }
+        FreePool (Anchors);
+        return FALSE;
+      }
+    }
+  }
+
+  //
+  // Group match offsets by patch preserving their order.
+  //
+  Offsets = NULL;
+  if (MatchCount > 0) {
+    Offsets = AllocatePool (MatchCount * sizeof (UINT32));
+    if (Offsets == NULL) {
+      FreePool (Matches);
+      FreePool (Anchors);
+      return FALSE;
+    }
+  }
+
+  ZeroMem (Groups, (PatchCount + 1) * sizeof (UINT32));
+  for (Index = 0; Index < MatchCount; ++Index) {
+    ++Groups[Matches[Index].Patch + 1];
+  }
+
+  for (Index = 0; Index < PatchCount; ++Index) {
+    Groups[Index + 1] += Groups[Index];
+  }
+
+  //
+  // Chains are no longer needed and serve as group fill positions.
+  //
+  CopyMem (Chains, Groups, PatchCount * sizeof (UINT32));
+  for (Index = 0; Index < MatchCount; ++Index) {
+    Offsets[Chains[Matches[Index].Patch]++] = Matches[Index].Offset;
+  }
+
+  if (Matches != NULL) {
+    FreePool (Matches);
+  }
+
+  //
+  // Apply patches in order, tracking modified data for the later ones.
+  //
+  Tracker.Ranges   = NULL;
+  Tracker.Count    = 0;
+  Tracker.Capacity = 0;
+  Tracker.Enabled  = TRUE;
+
+  for (Index = 0; Index < PatchCount; ++Index) {
+    Patch = &Patches[Index];
+
+    if (Patch->Pattern == NULL) {
+      if (Patch->Size > 0
+        && Patch->DataOff <= DataSize
+        && Patch->DataSize <= DataSize - Patch->DataOff
+        && Patch->Size <= Patch->DataSize) {
+        Offset = 0;
+        InternalPatchTakeMatch (Patch, Data, Patch->DataOff, &Offset, &Tracker);
+      }
+      continue;
+    }
+
+    if (!InternalPatchRegion (Patch, DataSize, &Firsts[Index], &Lasts[Index])) {
+      continue;
+    }
+
+    if (!Tracker.Enabled
+      || Anchors[Index] == MAX_UINT32
+      || !InternalApplyPatchMatches (
+        Patch,
+        Data,
+        Firsts[Index],
+        Lasts[Index],
+        Offsets != NULL ? &Offsets[Groups[Index]] : NULL,
+        Groups[Index + 1] - Groups[Index],
+        &Tracker
+        )) {
+      InternalApplyPatchLinear (Patch, Data, Firsts[Index], Lasts[Index], &Tracker);
+    }
+  }
+
+  if (Tracker.Ranges != NULL) {
+    FreePool (Tracker.Ranges);
+  }
+
+  if (Offsets != NULL) {
+    FreePool (Offsets);
+  }
+
+  FreePool (Anchors);
+  return TRUE;
+}
@@ -0,0 +1,82 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/DebugLib.h>
+#include <Library/OcMiscLib.h>
+
+//
+// 32-bit FNV-1a parameters.
+//
+#define OC_FNV1A_OFFSET_BASIS  0x811C9DC5U
+#define OC_FNV1A_PRIME         0x01000193U
+
+UINT32
+OcHashFnv1a (
+  IN CONST VOID  *Data,
+  IN UINTN       Size
+  )
+{
+  CONST UINT8  *Bytes;
+  UINT32       Hash;
+  UINTN        Index;
+
+  ASSERT (Data != NULL || Size == 0);
+
+  Bytes = Data;
+  Hash  = OC_FNV1A_OFFSET_BASIS;
+  for (Index = 0; Index < Size; ++Index) {
+    Hash ^= Bytes[Index];
+    Hash *= OC_FNV1A_PRIME;
+  }
+
+  return Hash;
+}
+
+UINT32
+OcHashFnv1aAscii (
+  IN CONST CHAR8  *String
+  )
+{
+  UINT32  Hash;
+
+  ASSERT (String != NULL);
+
+  Hash = OC_FNV1A_OFFSET_BASIS;
+  while (*String != '\0') {
+    Hash ^= (UINT8) *String;
+    Hash *= OC_FNV1A_PRIME;
+    ++String;
+  }
+
+  return Hash;
+}
+
+UINT32
+OcHashFnv1aUnicode (
+  IN CONST CHAR16  *String
+  )
+{
+  UINT32  Hash;
+
+  ASSERT (String != NULL);
+
+  Hash = OC_FNV1A_OFFSET_BASIS;
+  while (*String != L'\0') {
+    Hash ^= (UINT8) *String;
+    Hash *= OC_FNV1A_PRIME;
+    ++String;
+  }
+
+  return Hash;
+}
@@ -21,6 +21,7 @@
 #include <Library/DebugLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/OcMiscLib.h>
 #include <Library/OcStringLib.h>
 #include <Library/OcStorageLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -118,6 +119,59 @@ mVaultSchema = {
   .Dict = {mVaultNodesSchema, ARRAY_SIZE (mVaultNodesSchema)}
 };
 
+//
+// Size of file data hashed at once while still in cache.
+//
+#define OC_STORAGE_READ_CHUNK_SIZE  BASE_256KB
+
+//
+// Builds vault file path hash table, vault files are looked up by path
+// for every file access.
+//
+STATIC
+VOID
+OcStorageBuildVaultIndex (
+  IN OUT OC_STORAGE_CONTEXT  *Context
+  )
+{
+  UINT32  Size;
+  UINT32  Index;
+  UINT32  Hash;
+  UINT32  Slot;
+
+  //
+  // Keep load factor at or below 1/2.
+  //
+  Size = 16;
+  while (Size < Context->Vault.Files.Count * 2) {
+    Size *= 2;
+  }
+
+  Context->VaultIndex = AllocateZeroPool (Size * sizeof (Context->VaultIndex[0]));
+  if (Context->VaultIndex == NULL) {
+    //
+    // Lookups fall back to scanning the vault.
+    //
+    return;
+  }
+
+  Context->VaultIndexMask = Size - 1;
+
+  //
+  // Entries are inserted in order, so the first of duplicate paths is found first.
+  //
+  for (Index = 0; Index < Context->Vault.Files.Count; ++Index) {
+    Hash = OcHashFnv1aAscii (OC_BLOB_GET (Context->Vault.Files.Keys[Index]));
+    Slot = Hash;
+    while (Context->VaultIndex[Slot & Context->VaultIndexMask].File != 0) {
+      ++Slot;
+    }
+
+    Context->VaultIndex[Slot & Context->VaultIndexMask].Hash = Hash;
+    Context->VaultIndex[Slot & Context->VaultIndexMask].File = Index + 1;
+  }
+}
+
 
 STATIC
 EFI_STATUS
@@ -169,9 +223,41 @@ OcStorageInitializeVault (
 
   Context->HasVault = TRUE;
 
+  OcStorageBuildVaultIndex (Context);
+
   return EFI_SUCCESS;
 }
 
+//
+// Compares vault file path with the requested one.
+//
+STATIC
+BOOLEAN
+OcStorageMatchPath (
+  IN OC_STORAGE_CONTEXT  *Context,
+  IN UINT32              Index,
+  IN CONST CHAR16        *Filename,
+  IN UINTN               FilenameSize
+  )
+{
+  UINTN              StrIndex;
+  CHAR8              *VaultFilePath;
+
+  if (Context->Vault.Files.Keys[Index]->Size != (UINT32) FilenameSize) {
+    return FALSE;
+  }
+
+  VaultFilePath = OC_BLOB_GET (Context->Vault.Files.Keys[Index]);
+
+  for (StrIndex = 0; StrIndex < FilenameSize; ++StrIndex) {
+    if (Filename[StrIndex] != VaultFilePath[StrIndex]) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 STATIC
 UINT8 *
 OcStorageGetDigest (
@@ -179,10 +265,11 @@ OcStorageGetDigest (
   IN     CONST CHAR16        *Filename
   )
 {
-  UINT32             Index;
-  UINTN              StrIndex;
-  CHAR8              *VaultFilePath;
-  UINTN              FilenameSize;
+  UINT32                        Index;
+  UINTN                         FilenameSize;
+  UINT32                        Hash;
+  UINT32                        Slot;
+  OC_STORAGE_VAULT_INDEX_ENTRY  *Entry;
 
   if (!Context->HasVault) {
     return NULL;
@@ -190,20 +277,23 @@ OcStorageGetDigest (
 
   FilenameSize = StrLen (Filename) + 1;
 
-  for (Index = 0; Index < Context->Vault.Files.Count; ++Index) {
-    if (Context->Vault.Files.Keys[Index]->Size != (UINT32) FilenameSize) {
-      continue;
-    }
-
-    VaultFilePath = OC_BLOB_GET (Context->Vault.Files.Keys[Index]);
+  if (Context->VaultIndex != NULL) {
+    Hash = OcHashFnv1aUnicode (Filename);
+    for (Slot = Hash; ; ++Slot) {
+      Entry = &Context->VaultIndex[Slot & Context->VaultIndexMask];
+      if (Entry->File == 0) {
+        return NULL;
+      }
 
-    for (StrIndex = 0; StrIndex < FilenameSize; ++StrIndex) {
-      if (Filename[StrIndex] != VaultFilePath[StrIndex]) {
-        break;
+      if (Entry->Hash == Hash
+        && OcStorageMatchPath (Context, Entry->File - 1, Filename, FilenameSize)) {
+        return &Context->Vault.Files.Values[Entry->File - 1]->Hash[0];
       }
     }
+  }
 
-    if (StrIndex == FilenameSize) {
+  for (Index = 0; Index < Context->Vault.Files.Count; ++Index) {
+    if (OcStorageMatchPath (Context, Index, Filename, FilenameSize)) {
       return &Context->Vault.Files.Values[Index]->Hash[0];
     }
   }
@@ -316,6 +406,11 @@ OcStorageFree (
     OC_STORAGE_VAULT_DESTRUCT (&Context->Vault, sizeof (Context->Vault));
     Context->HasVault = FALSE;
   }
+
+  if (Context->VaultIndex != NULL) {
+    FreePool (Context->VaultIndex);
+    Context->VaultIndex = NULL;
+  }
 }
 
 BOOLEAN
@@ -374,6 +469,10 @@ OcStorageReadFileUnicode (
   UINT8              *FileBuffer;
   UINT8              *VaultDigest;
   UINT8              FileDigest[SHA256_DIGEST_SIZE];
+  SHA256_CONTEXT     HashContext;
+  UINT32             Offset;
+  UINT32             ChunkSize;
+  UINTN              ReadSize;
 
   //
   // Using this API with empty filename is also not allowed.
@@ -420,15 +519,34 @@ OcStorageReadFileUnicode (
     return NULL;
   }
 
-  Status = GetFileData (File, 0, Size, FileBuffer);
+  //
+  // Hash file data right after reading every chunk to avoid another pass
+  // over the whole file.
+  //
+  Sha256Init (&HashContext);
+
+  Status = File->SetPosition (File, 0);
+  for (Offset = 0; !EFI_ERROR (Status) && Offset < Size; Offset += ChunkSize) {
+    ChunkSize = MIN (Size - Offset, OC_STORAGE_READ_CHUNK_SIZE);
+    ReadSize  = ChunkSize;
+    Status    = File->Read (File, &ReadSize, &FileBuffer[Offset]);
+    if (!EFI_ERROR (Status) && ReadSize != ChunkSize) {
+      Status = EFI_BAD_BUFFER_SIZE;
+    }
+
+    if (!EFI_ERROR (Status) && VaultDigest != NULL) {
+      Sha256Update (&HashContext, &FileBuffer[Offset], ChunkSize);
+    }
+  }
+
   File->Close (File);
   if (EFI_ERROR (Status)) {
     FreePool (FileBuffer);
     return NULL;
   }
 
-  if (VaultDigest != 0) {
-    Sha256 (FileDigest, FileBuffer, Size);
+  if (VaultDigest != NULL) {
+    Sha256Final (&HashContext, FileDigest);
     if (CompareMem (FileDigest, VaultDigest, SHA256_DIGEST_SIZE) != 0) {
       DEBUG ((DEBUG_ERROR, "OCS: Aborting corrupted %s file access\n", FilePath));
       FreePool (FileBuffer);
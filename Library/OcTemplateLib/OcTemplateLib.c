@@ -22,6 +22,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcGuardLib.h>
+#include <Library/OcMemoryLib.h>
 
 #define PRIV_OC_BLOB_FIELDS(_, __) \
   OC_BLOB (CHAR8, [], {0}, _, __)
@@ -52,6 +53,52 @@ STATIC_ASSERT(OFFSET_OF (PRIV_OC_ARRAY, Values)     == OFFSET_OF (PRIV_OC_MAP, V
 STATIC_ASSERT(OFFSET_OF (PRIV_OC_ARRAY, ValueSize)  == OFFSET_OF (PRIV_OC_MAP, ValueSize), "PRIV_OC_ARRAY vs PRIV_OC_MAP");
 #endif
 
+//
+// Arena serving template allocations, pool is used when NULL.
+//
+STATIC OC_MEMORY_ARENA  *mTemplateArena;
+
+OC_MEMORY_ARENA *
+OcTemplateSetArena (
+  OC_MEMORY_ARENA  *Arena  OPTIONAL
+  )
+{
+  OC_MEMORY_ARENA  *PreviousArena;
+
+  PreviousArena  = mTemplateArena;
+  mTemplateArena = Arena;
+  return PreviousArena;
+}
+
+STATIC
+VOID *
+OcTemplateAllocate (
+  UINT32  Size
+  )
+{
+  if (mTemplateArena != NULL) {
+    return MemoryArenaAllocate (mTemplateArena, Size);
+  }
+
+  return AllocatePool (Size);
+}
+
+STATIC
+VOID
+OcTemplateFree (
+  VOID  *Memory
+  )
+{
+  //
+  // Arena memory is released together with the arena.
+  //
+  if (mTemplateArena != NULL && MemoryArenaContains (mTemplateArena, Memory)) {
+    return;
+  }
+
+  FreePool (Memory);
+}
+
 VOID
 OcFreePointer (
   VOID    *Pointer,
@@ -60,7 +107,7 @@ OcFreePointer (
 {
   VOID **Field = (VOID **) Pointer;
   if (*Field) {
-    FreePool (*Field);
+    OcTemplateFree (*Field);
     *Field = NULL;
   }
 }
@@ -98,11 +145,11 @@ OcFreeList (
 
   for (Index = 0; Index < List->Array.Count; Index++) {
     List->Array.Destruct (List->Array.Values[Index], List->Array.ValueSize);
-    FreePool (List->Array.Values[Index]);
+    OcTemplateFree (List->Array.Values[Index]);
 
     if (HasKeys) {
       List->Map.KeyDestruct (List->Map.Keys[Index], List->Map.KeySize);
-      FreePool (List->Map.Keys[Index]);
+      OcTemplateFree (List->Map.Keys[Index]);
     }
   }
 
@@ -166,7 +213,7 @@ OcBlobAllocate (
   //
   if (Size > Blob->Size) {
     OcFreePointer (&Blob->DynValue, Blob->Size);
-    DynValue = AllocatePool (Size);
+    DynValue = OcTemplateAllocate (Size);
     if (DynValue == NULL) {
       DEBUG ((DEBUG_VERBOSE, "Failed to fit %u bytes in OC_BLOB\n", Size));
       return NULL;
@@ -204,15 +251,15 @@ OcListEntryAllocate (
   //
   // Prepare new pair.
   //
-  *Value = AllocatePool (List->Array.ValueSize);
+  *Value = OcTemplateAllocate (List->Array.ValueSize);
   if (*Value == NULL) {
     return FALSE;
   }
 
   if (Key != NULL) {
-    *Key = AllocatePool (List->Map.KeySize);
+    *Key = OcTemplateAllocate (List->Map.KeySize);
     if (*Key == NULL) {
-      FreePool (*Value);
+      OcTemplateFree (*Value);
       return FALSE;
     }
   }
@@ -250,31 +297,31 @@ OcListEntryAllocate (
   //
   AllocCount *= 2;
 
-  NewValues = (VOID **) AllocatePool (
+  NewValues = (VOID **) OcTemplateAllocate (
     sizeof (VOID *) * AllocCount
     );
 
   if (NewValues == NULL) {
     List->Array.Destruct (*Value, List->Array.ValueSize);
-    FreePool (*Value);
+    OcTemplateFree (*Value);
     if (Key != NULL) {
       List->Map.KeyDestruct (*Key, List->Map.KeySize);
-      FreePool (*Key);
+      OcTemplateFree (*Key);
     }
     return FALSE;
   }
 
   if (Key != NULL) {
-    NewKeys = (VOID **) AllocatePool (
+    NewKeys = (VOID **) OcTemplateAllocate (
       sizeof (VOID *) * AllocCount
       );
 
     if (NewKeys == NULL) {
       List->Array.Destruct (*Value, List->Array.ValueSize);
       List->Map.KeyDestruct (*Key, List->Map.KeySize);
-      FreePool (NewValues);
-      FreePool (*Value);
-      FreePool (*Key);
+      OcTemplateFree (NewValues);
+      OcTemplateFree (*Value);
+      OcTemplateFree (*Key);
       return FALSE;
     }
   } else {
@@ -291,7 +338,7 @@ OcListEntryAllocate (
       sizeof (VOID *) * Count
       );
 
-    FreePool (List->Array.Values);
+    OcTemplateFree (List->Array.Values);
   }
 
   if (Key != NULL && List->Map.Keys != NULL) {
@@ -301,7 +348,7 @@ OcListEntryAllocate (
       sizeof (VOID *) * Count
       );
 
-    FreePool (List->Map.Keys);
+    OcTemplateFree (List->Map.Keys);
   }
 
   List->Array.Count++;
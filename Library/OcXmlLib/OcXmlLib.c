@@ -44,19 +44,47 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/OcMemoryLib.h>
 #include <Library/OcMiscLib.h>
 #include <Library/OcStringLib.h>
 
 //
-// Minimal extra allocation size during export.
+// Estimated amount of input bytes per node used to size the parser arena.
+// Prelinked plists average around 30 bytes per node, so the first block
+// usually holds the whole document.
 //
-#define XML_EXPORT_MIN_ALLOCATION_SIZE 4096
+#define XML_ARENA_BYTES_PER_NODE 24
+
+//
+// Minimal parser arena block size.
+//
+#define XML_ARENA_MIN_BLOCK_SIZE 4096
+
+//
+// Initial capacity of the parser child stack.
+//
+#define XML_PARSER_MIN_STACK_SIZE 64
+
+//
+// Set in XML_NODE_LIST AllocCount when the list lives in the document arena.
+//
+#define XML_NODE_LIST_ARENA BIT31
+
+#define XML_NODE_LIST_FLAGS XML_NODE_LIST_ARENA
+
+//
+// Minimal plist dictionary key count to build a keyed index for.
+// Smaller dictionaries are faster to scan.
+//
+#define XML_DICT_INDEX_MIN_KEYS 16
 
 struct XML_NODE_LIST_;
 struct XML_PARSER_;
+struct XML_DICT_INDEX_;
 
 typedef struct XML_NODE_LIST_ XML_NODE_LIST;
 typedef struct XML_PARSER_ XML_PARSER;
+typedef struct XML_DICT_INDEX_ XML_DICT_INDEX;
 
 //
 // An XML_NODE will always contain a tag name and possibly a list of
@@ -71,9 +99,24 @@ struct XML_NODE_ {
 };
 
 struct XML_NODE_LIST_ {
-  UINT32    NodeCount;
-  UINT32    AllocCount;
-  XML_NODE  *NodeList[];
+  UINT32          NodeCount;
+  UINT32          AllocCount;
+  XML_DICT_INDEX  *Index;
+  XML_NODE        *NodeList[];
+};
+
+//
+// Open addressing hash index of plist dictionary keys. It is built on
+// the first keyed lookup and dropped whenever the children change.
+//
+typedef struct {
+  UINT32  Hash;
+  UINT32  Key;
+} XML_DICT_INDEX_ENTRY;
+
+struct XML_DICT_INDEX_ {
+  UINT32                Mask;
+  XML_DICT_INDEX_ENTRY  Entries[];
 };
 
 typedef struct {
@@ -91,18 +134,29 @@ struct XML_DOCUMENT_ {
     UINT32      Length;
   } Buffer;
 
-  XML_NODE      *Root;
-  XML_REFLIST   References;
+  XML_NODE         *Root;
+  XML_REFLIST      References;
+  //
+  // Parsed nodes and their child lists are allocated from the arena,
+  // which avoids one pool allocation per node on large plists.
+  //
+  OC_MEMORY_ARENA  Arena;
 };
 
 //
 // Parser context.
 //
 struct XML_PARSER_ {
-  CHAR8  *Buffer;
-  UINT32 Position;
-  UINT32 Length;
-  UINT32 Level;
+  CHAR8            *Buffer;
+  UINT32           Position;
+  UINT32           Length;
+  UINT32           Level;
+  OC_MEMORY_ARENA  Arena;
+  UINT32           Allocations;
+  UINT32           NodeCount;
+  XML_NODE         **Stack;
+  UINT32           StackCount;
+  UINT32           StackAllocCount;
 };
 
 //
@@ -173,10 +227,12 @@ XmlParseAttributeNumber (
 
 //
 // Allocates the node with contents.
+// Nodes are allocated from the arena when parsing and from pool otherwise.
 //
 STATIC
 XML_NODE *
 XmlNodeCreate (
+  XML_PARSER     *Parser,
   CONST CHAR8    *Name,
   CONST CHAR8    *Attributes,
   CONST CHAR8    *Content,
@@ -186,7 +242,11 @@ XmlNodeCreate (
 {
   XML_NODE  *Node;
 
-  Node = AllocatePool (sizeof (XML_NODE));
+  if (Parser != NULL) {
+    Node = MemoryArenaAllocate (&Parser->Arena, sizeof (XML_NODE));
+  } else {
+    Node = AllocatePool (sizeof (XML_NODE));
+  }
 
   if (Node != NULL) {
     Node->Name       = Name;
@@ -200,7 +260,7 @@ XmlNodeCreate (
 }
 
 //
-// Adds child nodes to node.
+// Adds child nodes to node after parsing.
 //
 STATIC
 BOOLEAN
@@ -220,8 +280,13 @@ XmlNodeChildPush (
   // Push new node if there is enough room.
   //
   if (Node->Children != NULL) {
+    if (Node->Children->Index != NULL) {
+      FreePool (Node->Children->Index);
+      Node->Children->Index = NULL;
+    }
+
     NodeCount = Node->Children->NodeCount;
-    AllocCount = Node->Children->AllocCount;
+    AllocCount = Node->Children->AllocCount & ~XML_NODE_LIST_FLAGS;
 
     if (NodeCount < XML_PARSER_NODE_COUNT && AllocCount > NodeCount) {
       Node->Children->NodeList[NodeCount] = Child;
@@ -253,6 +318,7 @@ XmlNodeChildPush (
 
   NewList->NodeCount  = NodeCount + 1;
   NewList->AllocCount = AllocCount;
+  NewList->Index      = NULL;
 
   if (Node->Children != NULL) {
     CopyMem (
@@ -261,7 +327,9 @@ XmlNodeChildPush (
       sizeof (NewList->NodeList[0]) * NodeCount
       );
 
-    FreePool (Node->Children);
+    if ((Node->Children->AllocCount & XML_NODE_LIST_ARENA) == 0) {
+      FreePool (Node->Children);
+    }
   }
 
   NewList->NodeList[NodeCount] = Child;
@@ -270,6 +338,93 @@ XmlNodeChildPush (
   return TRUE;
 }
 
+//
+// Pushes parsed child node to the parser stack.
+//
+STATIC
+BOOLEAN
+XmlParserPushChild (
+  XML_PARSER  *Parser,
+  XML_NODE    *Child
+  )
+{
+  XML_NODE  **NewStack;
+  UINT32    NewAllocCount;
+
+  if (Parser->StackCount == Parser->StackAllocCount) {
+    if (Parser->StackAllocCount == 0) {
+      NewAllocCount = XML_PARSER_MIN_STACK_SIZE;
+    } else if (OcOverflowMulU32 (Parser->StackAllocCount, 2, &NewAllocCount)) {
+      return FALSE;
+    }
+
+    NewStack = AllocatePool (NewAllocCount * sizeof (Parser->Stack[0]));
+    if (NewStack == NULL) {
+      return FALSE;
+    }
+
+    if (Parser->Stack != NULL) {
+      CopyMem (
+        &NewStack[0],
+        &Parser->Stack[0],
+        Parser->StackCount * sizeof (Parser->Stack[0])
+        );
+      FreePool (Parser->Stack);
+    }
+
+    Parser->Stack           = NewStack;
+    Parser->StackAllocCount = NewAllocCount;
+    ++Parser->Allocations;
+  }
+
+  Parser->Stack[Parser->StackCount] = Child;
+  ++Parser->StackCount;
+
+  return TRUE;
+}
+
+//
+// Moves child nodes pushed since First to an exactly sized arena list.
+//
+STATIC
+BOOLEAN
+XmlParserPopChildren (
+  XML_PARSER  *Parser,
+  XML_NODE    *Node,
+  UINT32      First
+  )
+{
+  XML_NODE_LIST  *List;
+  UINT32         NodeCount;
+
+  NodeCount = Parser->StackCount - First;
+  if (NodeCount == 0) {
+    return TRUE;
+  }
+
+  List = MemoryArenaAllocate (
+    &Parser->Arena,
+    sizeof (XML_NODE_LIST) + sizeof (List->NodeList[0]) * NodeCount
+    );
+  if (List == NULL) {
+    return FALSE;
+  }
+
+  List->NodeCount  = NodeCount;
+  List->AllocCount = NodeCount | XML_NODE_LIST_ARENA;
+  List->Index      = NULL;
+  CopyMem (
+    &List->NodeList[0],
+    &Parser->Stack[First],
+    sizeof (List->NodeList[0]) * NodeCount
+    );
+
+  Node->Children     = List;
+  Parser->StackCount = First;
+
+  return TRUE;
+}
+
 STATIC
 BOOLEAN
 XmlPushReference (
@@ -345,24 +500,34 @@ XmlNodeReal (
 }
 
 //
-// Frees the resources allocated by the node.
+// Frees the resources allocated by the node outside of the arena.
 //
 STATIC
 VOID
 XmlNodeFree (
-  XML_NODE  *Node
+  CONST OC_MEMORY_ARENA  *Arena,
+  XML_NODE               *Node
   )
 {
   UINT32  Index;
 
   if (Node->Children != NULL) {
     for (Index = 0; Index < Node->Children->NodeCount; ++Index) {
-      XmlNodeFree (Node->Children->NodeList[Index]);
+      XmlNodeFree (Arena, Node->Children->NodeList[Index]);
+    }
+
+    if (Node->Children->Index != NULL) {
+      FreePool (Node->Children->Index);
+    }
+
+    if ((Node->Children->AllocCount & XML_NODE_LIST_ARENA) == 0) {
+      FreePool (Node->Children);
     }
-    FreePool (Node->Children);
   }
 
-  FreePool (Node);
+  if (!MemoryArenaContains (Arena, Node)) {
+    FreePool (Node);
+  }
 }
 
 STATIC
@@ -816,57 +981,52 @@ XmlParseContent (
 }
 
 //
-// Prints to growing buffer always preserving one byte extra.
+// Export context. Export is done in two passes, the first one with NULL
+// Buffer only calculates the resulting size.
+//
+typedef struct {
+  CHAR8    *Buffer;
+  UINT32   Size;
+  UINT32   CurrentSize;
+  BOOLEAN  Overflow;
+} XML_EXPORT_CONTEXT;
+
+//
+// Prints to export buffer or accounts the size when calculating it.
 //
 STATIC
 VOID
 XmlBufferAppend (
-  CHAR8        **Buffer,
-  UINT32       *AllocSize,
-  UINT32       *CurrentSize,
-  CONST CHAR8  *Data,
-  UINT32       DataLength
+  XML_EXPORT_CONTEXT  *Context,
+  CONST CHAR8         *Data,
+  UINT32              DataLength
   )
 {
-  CHAR8   *NewBuffer;
   UINT32  NewSize;
 
-  NewSize = *AllocSize;
-
-  if (NewSize - *CurrentSize <= DataLength) {
-    if (DataLength + 1 <= XML_EXPORT_MIN_ALLOCATION_SIZE) {
-      NewSize += XML_EXPORT_MIN_ALLOCATION_SIZE;
-    } else {
-      NewSize += DataLength + 1;
-    }
-
-    NewBuffer = AllocatePool (NewSize);
-    if (NewBuffer == NULL) {
-      XML_USAGE_ERROR("XmlBufferAppend::failed to allocate");
-      return;
-    }
+  if (OcOverflowAddU32 (Context->CurrentSize, DataLength, &NewSize)
+    || NewSize > Context->Size) {
+    XML_USAGE_ERROR ("XmlBufferAppend::overflow");
+    Context->Overflow = TRUE;
+    return;
+  }
 
-    CopyMem (NewBuffer, *Buffer, *CurrentSize);
-    FreePool (*Buffer);
-    *Buffer    = NewBuffer;
-    *AllocSize = NewSize;
+  if (Context->Buffer != NULL) {
+    CopyMem (&Context->Buffer[Context->CurrentSize], Data, DataLength);
   }
 
-  CopyMem (&(*Buffer)[*CurrentSize], Data, DataLength);
-  *CurrentSize += DataLength;
+  Context->CurrentSize = NewSize;
 }
 
 //
-// Prints node to growing buffer always preserving one byte extra.
+// Prints node to export buffer.
 //
 STATIC
 VOID
 XmlNodeExportRecursive (
-  XML_NODE  *Node,
-  CHAR8     **Buffer,
-  UINT32    *AllocSize,
-  UINT32    *CurrentSize,
-  UINT32    Skip
+  XML_NODE            *Node,
+  XML_EXPORT_CONTEXT  *Context,
+  UINT32              Skip
   )
 {
   UINT32  Index;
@@ -875,7 +1035,7 @@ XmlNodeExportRecursive (
   if (Skip != 0) {
     if (Node->Children != NULL) {
       for (Index = 0; Index < Node->Children->NodeCount; ++Index) {
-        XmlNodeExportRecursive (Node->Children->NodeList[Index], Buffer, AllocSize, CurrentSize, Skip - 1);
+        XmlNodeExportRecursive (Node->Children->NodeList[Index], Context, Skip - 1);
       }
     }
 
@@ -884,30 +1044,30 @@ XmlNodeExportRecursive (
 
   NameLength = (UINT32)AsciiStrLen (Node->Name);
 
-  XmlBufferAppend (Buffer, AllocSize, CurrentSize, "<", L_STR_LEN ("<"));
-  XmlBufferAppend (Buffer, AllocSize, CurrentSize, Node->Name, NameLength);
+  XmlBufferAppend (Context, "<", L_STR_LEN ("<"));
+  XmlBufferAppend (Context, Node->Name, NameLength);
 
   if (Node->Attributes != NULL) {
-    XmlBufferAppend (Buffer, AllocSize, CurrentSize, " ", L_STR_LEN (" "));
-    XmlBufferAppend (Buffer, AllocSize, CurrentSize, Node->Attributes, (UINT32)AsciiStrLen (Node->Attributes));
+    XmlBufferAppend (Context, " ", L_STR_LEN (" "));
+    XmlBufferAppend (Context, Node->Attributes, (UINT32)AsciiStrLen (Node->Attributes));
   }
 
   if (Node->Children != NULL || Node->Content != NULL) {
-    XmlBufferAppend (Buffer, AllocSize, CurrentSize, ">", L_STR_LEN (">"));
+    XmlBufferAppend (Context, ">", L_STR_LEN (">"));
 
     if (Node->Children != NULL) {
       for (Index = 0; Index < Node->Children->NodeCount; ++Index) {
-        XmlNodeExportRecursive (Node->Children->NodeList[Index], Buffer, AllocSize, CurrentSize, 0);
+        XmlNodeExportRecursive (Node->Children->NodeList[Index], Context, 0);
       }
     } else {
-      XmlBufferAppend (Buffer, AllocSize, CurrentSize, Node->Content, (UINT32)AsciiStrLen (Node->Content));
+      XmlBufferAppend (Context, Node->Content, (UINT32)AsciiStrLen (Node->Content));
     }
 
-    XmlBufferAppend (Buffer, AllocSize, CurrentSize, "</", L_STR_LEN ("</"));
-    XmlBufferAppend (Buffer, AllocSize, CurrentSize, Node->Name, NameLength);
-    XmlBufferAppend (Buffer, AllocSize, CurrentSize, ">", L_STR_LEN (">"));
+    XmlBufferAppend (Context, "</", L_STR_LEN ("</"));
+    XmlBufferAppend (Context, Node->Name, NameLength);
+    XmlBufferAppend (Context, ">", L_STR_LEN (">"));
   } else {
-    XmlBufferAppend (Buffer, AllocSize, CurrentSize, "/>", L_STR_LEN ("/>"));
+    XmlBufferAppend (Context, "/>", L_STR_LEN ("/>"));
   }
 }
 
@@ -926,6 +1086,9 @@ XmlNodeExportRecursive (
 // </Parent>
 // ---
 //
+// Nodes are allocated from the parser arena, which is released by
+// XmlDocumentParse on failure.
+//
 STATIC
 XML_NODE *
 XmlParseNode (
@@ -939,6 +1102,7 @@ XmlParseNode (
   XML_NODE     *Node;
   XML_NODE     *Child;
   UINT32       ReferenceNumber;
+  UINT32       FirstChild;
   BOOLEAN      IsReference;
   BOOLEAN      SelfClosing;
   BOOLEAN      Unprefixed;
@@ -964,12 +1128,14 @@ XmlParseNode (
 
   XmlSkipWhitespace (Parser);
 
-  Node = XmlNodeCreate (TagOpen, Attributes, NULL, XmlNodeReal (References, Attributes), NULL);
+  Node = XmlNodeCreate (Parser, TagOpen, Attributes, NULL, XmlNodeReal (References, Attributes), NULL);
   if (Node == NULL) {
     XML_PARSER_ERROR (Parser, NO_CHARACTER, "XmlParseNode::node alloc fail");
     return NULL;
   }
 
+  ++Parser->NodeCount;
+
   //
   // If tag ends with `/' it's self closing, skip content lookup.
   //
@@ -985,7 +1151,6 @@ XmlParseNode (
 
     if (Node->Content == NULL) {
       XML_PARSER_ERROR (Parser, 0, "XmlParseNode::content");
-      XmlNodeFree (Node);
       return NULL;
     }
 
@@ -1011,11 +1176,11 @@ XmlParseNode (
 
     if (Parser->Level > XML_PARSER_NEST_LEVEL) {
       XML_PARSER_ERROR (Parser, NO_CHARACTER, "XmlParseNode::level overflow");
-      XmlNodeFree (Node);
       return NULL;
     }
 
     HasChildren = FALSE;
+    FirstChild  = Parser->StackCount;
 
     while ('/' != XmlParserPeek (Parser, NEXT_CHARACTER)) {
 
@@ -1031,20 +1196,23 @@ XmlParseNode (
         }
 
         XML_PARSER_ERROR (Parser, NEXT_CHARACTER, "XmlParseNode::child");
-        XmlNodeFree (Node);
         return NULL;
       }
 
-      if (!XmlNodeChildPush (Node, Child)) {
+      if (Parser->StackCount - FirstChild >= XML_PARSER_NODE_COUNT - 1
+        || !XmlParserPushChild (Parser, Child)) {
         XML_PARSER_ERROR (Parser, NO_CHARACTER, "XmlParseNode::node push fail");
-        XmlNodeFree (Node);
-        XmlNodeFree (Child);
         return NULL;
       }
 
       HasChildren = TRUE;
     }
 
+    if (!XmlParserPopChildren (Parser, Node, FirstChild)) {
+      XML_PARSER_ERROR (Parser, NO_CHARACTER, "XmlParseNode::child list alloc fail");
+      return NULL;
+    }
+
     Parser->Level--;
 
     if (!HasChildren && References != NULL && Attributes != NULL) {
@@ -1063,7 +1231,6 @@ XmlParseNode (
   TagClose = XmlParseTagClose (Parser, Unprefixed);
   if (TagClose == NULL) {
     XML_PARSER_ERROR (Parser, NO_CHARACTER, "XmlParseNode::tag close");
-    XmlNodeFree (Node);
     return NULL;
   }
 
@@ -1072,13 +1239,11 @@ XmlParseNode (
   //
   if (AsciiStrCmp (TagOpen, TagClose) != 0) {
     XML_PARSER_ERROR (Parser, NO_CHARACTER, "XmlParseNode::tag missmatch");
-    XmlNodeFree (Node);
     return NULL;
   }
 
   if (IsReference && !XmlPushReference (References, Node, ReferenceNumber)) {
     XML_PARSER_ERROR (Parser, 0, "XmlParseNode::reference");
-    XmlNodeFree (Node);
     return NULL;
   }
 
@@ -1105,6 +1270,18 @@ XmlDocumentParse (
   Parser.Length = Length;
   ZeroMem (&References, sizeof (References));
 
+  //
+  // Size the arena to hold the whole document in one block in most cases.
+  //
+  MemoryArenaInit (
+    &Parser.Arena,
+    "XML",
+    MAX (
+      Length / XML_ARENA_BYTES_PER_NODE * (sizeof (XML_NODE) + sizeof (XML_NODE *)),
+      XML_ARENA_MIN_BLOCK_SIZE
+      )
+    );
+
   //
   // An empty buffer can never contain a valid document.
   //
@@ -1117,19 +1294,26 @@ XmlDocumentParse (
   // Parse the root node.
   //
   Root = XmlParseNode (&Parser, WithRefs ? &References : NULL);
+
+  if (Parser.Stack != NULL) {
+    FreePool (Parser.Stack);
+  }
+
   if (Root == NULL) {
     XML_PARSER_ERROR (&Parser, NO_CHARACTER, "XmlDocumentParse::parsing document failed");
+    MemoryArenaFree (&Parser.Arena);
+    XmlFreeRefs (&References);
     return NULL;
   }
 
   //
   // Return parsed document.
   //
-  Document = AllocatePool (sizeof(XML_DOCUMENT));
+  Document = MemoryArenaAllocate (&Parser.Arena, sizeof (XML_DOCUMENT));
 
   if (Document == NULL) {
     XML_PARSER_ERROR (&Parser, NO_CHARACTER, "XmlDocumentParse::document allocation failed");
-    XmlNodeFree (Root);
+    MemoryArenaFree (&Parser.Arena);
     XmlFreeRefs (&References);
     return NULL;
   }
@@ -1138,10 +1322,81 @@ XmlDocumentParse (
   Document->Buffer.Length = Length;
   Document->Root = Root;
   CopyMem (&Document->References, &References, sizeof (References));
+  CopyMem (&Document->Arena, &Parser.Arena, sizeof (Parser.Arena));
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "OCXML: Parsed %u bytes into %u nodes with %u pool allocations\n",
+    Length,
+    Parser.NodeCount,
+    Parser.Allocations + Parser.Arena.PoolAllocations
+    ));
 
   return Document;
 }
 
+BOOLEAN
+XmlDocumentExportSize (
+  XML_DOCUMENT  *Document,
+  UINT32        *Length,
+  UINT32        Skip
+  )
+{
+  XML_EXPORT_CONTEXT  Context;
+
+  Context.Buffer      = NULL;
+  Context.Size        = MAX_UINT32 - 1;
+  Context.CurrentSize = 0;
+  Context.Overflow    = FALSE;
+
+  XmlNodeExportRecursive (Document->Root, &Context, Skip);
+
+  if (Context.Overflow) {
+    return FALSE;
+  }
+
+  *Length = Context.CurrentSize;
+  return TRUE;
+}
+
+BOOLEAN
+XmlDocumentExportBuffer (
+  XML_DOCUMENT  *Document,
+  CHAR8         *Buffer,
+  UINT32        Size,
+  UINT32        *Length,
+  UINT32        Skip
+  )
+{
+  XML_EXPORT_CONTEXT  Context;
+
+  if (Size == 0) {
+    return FALSE;
+  }
+
+  //
+  // Reserve one byte for trailing \0.
+  //
+  Context.Buffer      = Buffer;
+  Context.Size        = Size - 1;
+  Context.CurrentSize = 0;
+  Context.Overflow    = FALSE;
+
+  XmlNodeExportRecursive (Document->Root, &Context, Skip);
+
+  if (Context.Overflow) {
+    return FALSE;
+  }
+
+  Buffer[Context.CurrentSize] = '\0';
+
+  if (Length != NULL) {
+    *Length = Context.CurrentSize;
+  }
+
+  return TRUE;
+}
+
 CHAR8 *
 XmlDocumentExport (
   XML_DOCUMENT  *Document,
@@ -1150,27 +1405,28 @@ XmlDocumentExport (
   )
 {
   CHAR8   *Buffer;
-  UINT32  AllocSize;
-  UINT32  CurrentSize;
+  UINT32  Size;
 
-  AllocSize = Document->Buffer.Length + 1;
-  Buffer    = AllocatePool (AllocSize);
-  if (Buffer == NULL) {
-    XML_USAGE_ERROR ("XmlDocumentExport::failed to allocate");
+  //
+  // Calculate the exact size first to export into a single allocation.
+  //
+  if (!XmlDocumentExportSize (Document, &Size, Skip)) {
+    XML_USAGE_ERROR ("XmlDocumentExport::size overflow");
     return NULL;
   }
 
-  CurrentSize = 0;
-  XmlNodeExportRecursive (Document->Root, &Buffer, &AllocSize, &CurrentSize, Skip);
+  ++Size;
 
-  if (Length != NULL) {
-    *Length = CurrentSize;
+  Buffer = AllocatePool (Size);
+  if (Buffer == NULL) {
+    XML_USAGE_ERROR ("XmlDocumentExport::failed to allocate");
+    return NULL;
   }
 
-  //
-  // XmlBufferAppend guarantees one more byte.
-  //
-  Buffer[CurrentSize] = '\0';
+  if (!XmlDocumentExportBuffer (Document, Buffer, Size, Length, Skip)) {
+    FreePool (Buffer);
+    return NULL;
+  }
 
   return Buffer;
 }
@@ -1180,9 +1436,15 @@ XmlDocumentFree (
   XML_DOCUMENT  *Document
   )
 {
-  XmlNodeFree (Document->Root);
+  OC_MEMORY_ARENA  Arena;
+
+  //
+  // The document itself lives in the arena, so the arena goes last.
+  //
+  CopyMem (&Arena, &Document->Arena, sizeof (Arena));
+  XmlNodeFree (&Arena, Document->Root);
   XmlFreeRefs (&Document->References);
-  FreePool (Document);
+  MemoryArenaFree (&Arena);
 }
 
 XML_NODE *
@@ -1298,13 +1560,13 @@ XmlNodeAppend (
 {
   XML_NODE  *NewNode;
 
-  NewNode = XmlNodeCreate (Name, Attributes, Content, NULL, NULL);
+  NewNode = XmlNodeCreate (NULL, Name, Attributes, Content, NULL, NULL);
   if (NewNode == NULL) {
     return NULL;
   }
 
   if (!XmlNodeChildPush (Node, NewNode)) {
-    XmlNodeFree (NewNode);
+    XmlNodeFree (NULL, NewNode);
     return NULL;
   }
 
@@ -1428,6 +1690,117 @@ PlistDictChild (
   return XmlNodeChild (Node, Child);
 }
 
+//
+// Builds keyed index for plist dictionary children.
+//
+STATIC
+XML_DICT_INDEX *
+PlistDictBuildIndex (
+  XML_NODE  *Node,
+  UINT32    KeyCount
+  )
+{
+  XML_DICT_INDEX  *Index;
+  CONST CHAR8     *KeyValue;
+  UINT32          Size;
+  UINT32          Key;
+  UINT32          Hash;
+  UINT32          Slot;
+
+  //
+  // Keep load factor at or below 1/2.
+  //
+  Size = XML_DICT_INDEX_MIN_KEYS;
+  while (Size < KeyCount * 2) {
+    Size *= 2;
+  }
+
+  Index = AllocateZeroPool (sizeof (XML_DICT_INDEX) + Size * sizeof (Index->Entries[0]));
+  if (Index == NULL) {
+    return NULL;
+  }
+
+  Index->Mask = Size - 1;
+
+  //
+  // Entries are inserted in order, so the first of duplicate keys is found first.
+  //
+  for (Key = 0; Key < KeyCount; ++Key) {
+    KeyValue = PlistKeyValue (PlistDictChild (Node, Key, NULL));
+    if (KeyValue == NULL) {
+      continue;
+    }
+
+    Hash = OcHashFnv1aAscii (KeyValue);
+    Slot = Hash;
+    while (Index->Entries[Slot & Index->Mask].Key != 0) {
+      ++Slot;
+    }
+
+    Index->Entries[Slot & Index->Mask].Hash = Hash;
+    Index->Entries[Slot & Index->Mask].Key  = Key + 1;
+  }
+
+  return Index;
+}
+
+XML_NODE *
+PlistDictLookup (
+  XML_NODE     *Node,
+  CONST CHAR8  *Key
+  )
+{
+  XML_NODE_LIST         *Children;
+  XML_DICT_INDEX_ENTRY  *Entry;
+  XML_NODE              *Value;
+  CONST CHAR8           *KeyValue;
+  UINT32                KeyCount;
+  UINT32                Hash;
+  UINT32                Slot;
+  UINT32                Index;
+
+  Children = Node->Children;
+  KeyCount = PlistDictChildren (Node);
+
+  if (KeyCount >= XML_DICT_INDEX_MIN_KEYS && Children->Index == NULL) {
+    //
+    // Index is built on the first lookup, lookups scan the dictionary
+    // when it cannot be allocated.
+    //
+    Children->Index = PlistDictBuildIndex (Node, KeyCount);
+  }
+
+  if (KeyCount >= XML_DICT_INDEX_MIN_KEYS && Children->Index != NULL) {
+    Hash = OcHashFnv1aAscii (Key);
+    Slot = Hash;
+
+    while (TRUE) {
+      Entry = &Children->Index->Entries[Slot & Children->Index->Mask];
+      if (Entry->Key == 0) {
+        return NULL;
+      }
+
+      if (Entry->Hash == Hash) {
+        KeyValue = PlistKeyValue (PlistDictChild (Node, Entry->Key - 1, &Value));
+        if (AsciiStrCmp (KeyValue, Key) == 0) {
+          return Value;
+        }
+      }
+
+      ++Slot;
+    }
+  }
+
+  for (Index = 0; Index < KeyCount; ++Index) {
+    KeyValue = PlistKeyValue (PlistDictChild (Node, Index, &Value));
+    if (KeyValue != NULL && AsciiStrCmp (KeyValue, Key) == 0) {
+      return Value;
+    }
+  }
+
+  return NULL;
+}
+
 CONST CHAR8 *
 PlistKeyValue (
   XML_NODE  *Node
@@ -0,0 +1,284 @@
+/** @file
+  This file is part of OpenCanopy, OpenCore GUI.
+
+  Copyright (c) 2018-2020, Download-Fritz, vit9696. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-3-Clause
+**/
+
+#include <Base.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "OpenCanopy.h"
+
+#define RGB_APPLY_OPACITY(Rgba, Opacity)  \
+  (((Rgba) * (Opacity)) / 0xFF)
+
+#define RGB_ALPHA_BLEND(Back, Front, InvFrontOpacity)  \
+  ((Front) + RGB_APPLY_OPACITY (InvFrontOpacity, Back))
+
+//
+// Exact X / 0xFF for 0 <= X <= 0xFF * 0xFF without a division.
+//
+#define RGB_DIV_255(X)  \
+  (((X) + 1U + ((X) >> 8U)) >> 8U)
+
+//
+// RGB_DIV_255 for two values in 16-bit halves of a 32-bit value.
+//
+#define RGB_DIV_255_X2(X)  \
+  ((((X) + 0x00010001U + (((X) >> 8U) & 0x00FF00FFU)) >> 8U) & 0x00FF00FFU)
+
+VOID
+GuiBlendPixel (
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *BackPixel,
+  IN     CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *FrontPixel,
+  IN     UINT8                                Opacity
+  )
+{
+  UINT8                               CombOpacity;
+  UINT8                               InvFrontOpacity;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL       OpacFrontPixel;
+  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *FinalFrontPixel;
+  //
+  // qt_blend_argb32_on_argb32 in QT.
+  // Use GuiBlendRow for blending more than one pixel.
+  //
+  ASSERT (BackPixel != NULL);
+  ASSERT (FrontPixel != NULL);
+
+  if (FrontPixel->Reserved == 0) {
+    return;
+  }
+
+  if (FrontPixel->Reserved == 0xFF) {
+    if (Opacity == 0xFF) {
+      BackPixel->Blue     = FrontPixel->Blue;
+      BackPixel->Green    = FrontPixel->Green;
+      BackPixel->Red      = FrontPixel->Red;
+      BackPixel->Reserved = FrontPixel->Reserved;
+      return;
+    }
+
+    CombOpacity = Opacity;
+  } else {
+    CombOpacity = RGB_APPLY_OPACITY (FrontPixel->Reserved, Opacity);
+  }
+
+  if (CombOpacity == 0) {
+    return;
+  } else if (CombOpacity == FrontPixel->Reserved) {
+    FinalFrontPixel = FrontPixel;
+  } else {
+    OpacFrontPixel.Reserved = CombOpacity;
+    OpacFrontPixel.Blue     = RGB_APPLY_OPACITY (FrontPixel->Blue,  Opacity);
+    OpacFrontPixel.Green    = RGB_APPLY_OPACITY (FrontPixel->Green, Opacity);
+    OpacFrontPixel.Red      = RGB_APPLY_OPACITY (FrontPixel->Red,   Opacity);
+
+    FinalFrontPixel = &OpacFrontPixel;
+  }
+
+  InvFrontOpacity = (0xFF - CombOpacity);
+
+  BackPixel->Blue = RGB_ALPHA_BLEND (
+                      BackPixel->Blue,
+                      FinalFrontPixel->Blue,
+                      InvFrontOpacity
+                      );
+  BackPixel->Green = RGB_ALPHA_BLEND (
+                       BackPixel->Green,
+                       FinalFrontPixel->Green,
+                       InvFrontOpacity
+                       );
+  BackPixel->Red = RGB_ALPHA_BLEND (
+                     BackPixel->Red,
+                     FinalFrontPixel->Red,
+                     InvFrontOpacity
+                     );
+
+  if (BackPixel->Reserved != 0xFF) {
+    BackPixel->Reserved = RGB_ALPHA_BLEND (
+                            BackPixel->Reserved,
+                            CombOpacity,
+                            InvFrontOpacity
+                            );
+  }
+}
+
+/**
+  Blend a run of pixels, none of which needs special handling.
+  This matches GuiBlendPixel bit by bit, as:
+  - opacity is applied to all four channels, giving CombOpacity in alpha,
+  - an opaque back pixel stays opaque, as CombOpacity + InvFrontOpacity is 0xFF,
+  - pixels with zero CombOpacity are left untouched.
+
+  @param[in,out]  BackRow   Back pixel row.
+  @param[in]      FrontRow  Front pixel row.
+  @param[in]      Width     Number of pixels to blend.
+  @param[in]      Opacity   Front row opacity.
+**/
+STATIC
+VOID
+InternalBlendPixels (
+  IN OUT UINT32        *BackRow,
+  IN     CONST UINT32  *FrontRow,
+  IN     UINT32        Width,
+  IN     UINT8         Opacity
+  )
+{
+  UINT32   Index;
+  UINT32   Front;
+  UINT32   Back;
+  UINT32   CombOpacity;
+  UINT32   InvFrontOpacity;
+  UINT32   FrontRb;
+  UINT32   FrontAg;
+  UINT32   BackRb;
+  UINT32   BackAg;
+  UINT32   Result;
+
+#if defined (__SSE2__)
+  __m128i  Zero;
+  __m128i  ChannelMax;
+  __m128i  OpacityVec;
+  __m128i  FrontVec;
+  __m128i  BackVec;
+  __m128i  FrontLo;
+  __m128i  FrontHi;
+  __m128i  BackLo;
+  __m128i  BackHi;
+  __m128i  InvLo;
+  __m128i  InvHi;
+  __m128i  Keep;
+  __m128i  BlendVec;
+
+  Zero       = _mm_setzero_si128 ();
+  ChannelMax = _mm_set1_epi16 (0xFF);
+  OpacityVec = _mm_set1_epi16 (Opacity);
+
+  //
+  // Process four pixels at a time, two per 16-bit lane register.
+  //
+  for (; Width >= 4; Width -= 4, BackRow += 4, FrontRow += 4) {
+    FrontVec = _mm_loadu_si128 ((CONST __m128i *) FrontRow);
+    BackVec  = _mm_loadu_si128 ((CONST __m128i *) BackRow);
+
+    FrontLo  = _mm_mullo_epi16 (_mm_unpacklo_epi8 (FrontVec, Zero), OpacityVec);
+    FrontHi  = _mm_mullo_epi16 (_mm_unpackhi_epi8 (FrontVec, Zero), OpacityVec);
+    FrontLo  = _mm_srli_epi16 (_mm_add_epi16 (_mm_add_epi16 (FrontLo, _mm_set1_epi16 (1)), _mm_srli_epi16 (FrontLo, 8)), 8);
+    FrontHi  = _mm_srli_epi16 (_mm_add_epi16 (_mm_add_epi16 (FrontHi, _mm_set1_epi16 (1)), _mm_srli_epi16 (FrontHi, 8)), 8);
+
+    //
+    // Broadcast CombOpacity to all channels of each pixel.
+    //
+    InvLo    = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (FrontLo, 0xFF), 0xFF);
+    InvHi    = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (FrontHi, 0xFF), 0xFF);
+    Keep     = _mm_cmpeq_epi8 (_mm_packus_epi16 (InvLo, InvHi), Zero);
+    InvLo    = _mm_sub_epi16 (ChannelMax, InvLo);
+    InvHi    = _mm_sub_epi16 (ChannelMax, InvHi);
+
+    BackLo   = _mm_mullo_epi16 (_mm_unpacklo_epi8 (BackVec, Zero), InvLo);
+    BackHi   = _mm_mullo_epi16 (_mm_unpackhi_epi8 (BackVec, Zero), InvHi);
+    BackLo   = _mm_srli_epi16 (_mm_add_epi16 (_mm_add_epi16 (BackLo, _mm_set1_epi16 (1)), _mm_srli_epi16 (BackLo, 8)), 8);
+    BackHi   = _mm_srli_epi16 (_mm_add_epi16 (_mm_add_epi16 (BackHi, _mm_set1_epi16 (1)), _mm_srli_epi16 (BackHi, 8)), 8);
+
+    //
+    // Channels are truncated like the UINT8 stores in GuiBlendPixel.
+    //
+    BackLo   = _mm_and_si128 (_mm_add_epi16 (BackLo, FrontLo), ChannelMax);
+    BackHi   = _mm_and_si128 (_mm_add_epi16 (BackHi, FrontHi), ChannelMax);
+
+    BlendVec = _mm_packus_epi16 (BackLo, BackHi);
+    BlendVec = _mm_or_si128 (_mm_and_si128 (Keep, BackVec), _mm_andnot_si128 (Keep, BlendVec));
+    _mm_storeu_si128 ((__m128i *) BackRow, BlendVec);
+  }
+#endif
+
+  //
+  // Written without data-dependent branches to let the compiler vectorise it.
+  // Two channels are processed at a time in 16-bit halves of a 32-bit value.
+  //
+  for (Index = 0; Index < Width; ++Index) {
+    Front           = FrontRow[Index];
+    Back            = BackRow[Index];
+    CombOpacity     = RGB_DIV_255 ((Front >> 24U) * Opacity);
+    InvFrontOpacity = 0xFF - CombOpacity;
+
+    FrontRb  = RGB_DIV_255_X2 ((Front & 0x00FF00FFU) * Opacity);
+    FrontAg  = RGB_DIV_255_X2 (((Front >> 8U) & 0x00FF00FFU) * Opacity);
+    BackRb   = RGB_DIV_255_X2 ((Back & 0x00FF00FFU) * InvFrontOpacity);
+    BackAg   = RGB_DIV_255_X2 (((Back >> 8U) & 0x00FF00FFU) * InvFrontOpacity);
+    Result   = ((FrontRb + BackRb) & 0x00FF00FFU) | (((FrontAg + BackAg) & 0x00FF00FFU) << 8U);
+
+    BackRow[Index] = CombOpacity != 0 ? Result : Back;
+  }
+}
+
+VOID
+GuiBlendRow (
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *BackRow,
+  IN     CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *FrontRow,
+  IN     UINT32                               Width,
+  IN     UINT8                                Opacity
+  )
+{
+  UINT32  Index;
+  UINT32  Start;
+  UINT8   Alpha;
+  UINT32  OpaqueAlpha;
+
+  ASSERT (BackRow != NULL);
+  ASSERT (FrontRow != NULL);
+
+  if (Opacity == 0) {
+    return;
+  }
+
+  //
+  // Opaque pixels are only copied when no extra opacity is applied.
+  // 0x100 never matches any alpha value.
+  //
+  OpaqueAlpha = Opacity == 0xFF ? 0xFF : 0x100;
+
+  Index = 0;
+  while (Index < Width) {
+    Start = Index;
+    Alpha = FrontRow[Index].Reserved;
+
+    if (Alpha == 0) {
+      //
+      // Fully transparent pixels are skipped.
+      //
+      do {
+        ++Index;
+      } while (Index < Width && FrontRow[Index].Reserved == 0);
+    } else if (Alpha == OpaqueAlpha) {
+      //
+      // Fully opaque pixels replace the back pixels.
+      //
+      do {
+        ++Index;
+      } while (Index < Width && FrontRow[Index].Reserved == OpaqueAlpha);
+
+      CopyMem (&BackRow[Start], &FrontRow[Start], (Index - Start) * sizeof (*BackRow));
+    } else {
+      do {
+        ++Index;
+      } while (Index < Width
+        && FrontRow[Index].Reserved != 0
+        && FrontRow[Index].Reserved != OpaqueAlpha);
+
+      InternalBlendPixels (
+        (UINT32 *) &BackRow[Start],
+        (CONST UINT32 *) &FrontRow[Start],
+        Index - Start,
+        Opacity
+        );
+    }
+  }
+}
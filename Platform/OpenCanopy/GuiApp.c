@@ -9,9 +9,11 @@
 
 #include <Protocol/OcInterface.h>
 
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcBootManagementLib.h>
+#include <Library/OcCryptoLib.h>
 #include <Library/OcStorageLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
@@ -55,18 +57,39 @@ LoadImageFromStorage (
   IN  OC_STORAGE_CONTEXT                   *Storage,
   IN  CONST CHAR16                         *ImageFilePath,
   OUT VOID                                 *Image,
-  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *HighlightPixel  OPTIONAL
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *HighlightPixel  OPTIONAL,
+  IN  GUI_IMAGE_CACHE                      *Cache
   )
 {
   VOID          *ImageData;
   UINT32        ImageSize;
   RETURN_STATUS Status;
+  UINT8         Digest[SHA256_DIGEST_SIZE];
+  UINT32        Highlight;
+  UINT32        NumImages;
 
   ImageData = OcStorageReadFileUnicode (Storage, ImageFilePath, &ImageSize);
   if (ImageData == NULL) {
     return EFI_NOT_FOUND;
   }
 
+  //
+  // GUI_CLICK_IMAGE is laid out as two GUI_IMAGE structures.
+  //
+  if (HighlightPixel != NULL) {
+    CopyMem (&Highlight, HighlightPixel, sizeof (Highlight));
+    NumImages = sizeof (GUI_CLICK_IMAGE) / sizeof (GUI_IMAGE);
+  } else {
+    Highlight = 0;
+    NumImages = 1;
+  }
+
+  Sha256 (Digest, ImageData, ImageSize);
+  if (GuiImageCacheLookup (Cache, Digest, Highlight, Image, NumImages)) {
+    FreePool (ImageData);
+    return RETURN_SUCCESS;
+  }
+
   if (HighlightPixel != NULL) {
     Status  = GuiPngToClickImage (Image, ImageData, ImageSize, HighlightPixel);
   } else {
@@ -75,35 +98,45 @@ LoadImageFromStorage (
 
   FreePool (ImageData);
 
+  if (!RETURN_ERROR (Status)) {
+    GuiImageCacheInsert (Cache, Digest, Highlight, Image, NumImages);
+  }
+
   return Status;
 }
 
 RETURN_STATUS
 InternalContextConstruct (
   OUT BOOT_PICKER_GUI_CONTEXT  *Context,
-  IN  OC_STORAGE_CONTEXT       *Storage
+  IN  OC_STORAGE_CONTEXT       *Storage,
+  IN  BOOLEAN                  UseImageCache
   )
 {
   STATIC CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL HighlightPixel = {
     0xAF, 0xAF, 0xAF, 0x32
   };
 
-  RETURN_STATUS Status;
-  BOOLEAN       Result;
-  VOID          *FontImage;
-  VOID          *FontData;
-  UINT32        FontImageSize;
-  UINT32        FontDataSize;
+  RETURN_STATUS   Status;
+  BOOLEAN         Result;
+  VOID            *FontImage;
+  VOID            *FontData;
+  UINT32          FontImageSize;
+  UINT32          FontDataSize;
+  GUI_IMAGE_CACHE Cache;
 
   ASSERT (Context != NULL);
 
   Context->BootEntry = NULL;
 
-  Status  = LoadImageFromStorage (Storage, L"Resources\\Image\\Cursor.png", &Context->Cursor, NULL);
-  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\Selected.png", &Context->EntryBackSelected, NULL);
-  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\Selector.png", &Context->EntrySelector, &HighlightPixel);
-  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\InternalHardDrive.png", &Context->EntryIconInternal, NULL);
-  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\ExternalHardDrive.png", &Context->EntryIconExternal, NULL);
+  GuiImageCacheInit (&Cache, Storage, UseImageCache);
+
+  Status  = LoadImageFromStorage (Storage, L"Resources\\Image\\Cursor.png", &Context->Cursor, NULL, &Cache);
+  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\Selected.png", &Context->EntryBackSelected, NULL, &Cache);
+  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\Selector.png", &Context->EntrySelector, &HighlightPixel, &Cache);
+  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\InternalHardDrive.png", &Context->EntryIconInternal, NULL, &Cache);
+  Status |= LoadImageFromStorage (Storage, L"Resources\\Image\\ExternalHardDrive.png", &Context->EntryIconExternal, NULL, &Cache);
+
+  GuiImageCacheFlush (&Cache);
 
   if (RETURN_ERROR (Status)) {
     InternalContextDestruct (Context);
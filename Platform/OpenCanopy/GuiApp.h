@@ -8,6 +8,8 @@
 #ifndef GUI_APP_H
 #define GUI_APP_H
 
+#include <Library/OcStorageLib.h>
+
 #include "OpenCanopy.h"
 #include "BmfLib.h"
 
@@ -23,6 +25,16 @@ typedef struct {
   BOOLEAN          Refresh;
 } BOOT_PICKER_GUI_CONTEXT;
 
+typedef struct {
+  OC_STORAGE_CONTEXT  *Storage;
+  UINT8               *Data;
+  UINT32              DataSize;
+  UINT8               *NewData;
+  UINT32              NewDataSize;
+  UINT32              NewNumEntries;
+  BOOLEAN             *Used;
+} GUI_IMAGE_CACHE;
+
 RETURN_STATUS
 BootPickerViewInitialize (
   OUT GUI_DRAWING_CONTEXT      *DrawContext,
@@ -50,4 +62,67 @@ InternalGetCursorImage (
   IN     VOID               *Context
   );
 
+/**
+  Load decoded image cache from storage. The cache is disabled with vault.
+
+  @param[out]  Cache    Image cache.
+  @param[in]   Storage  OpenCore storage.
+  @param[in]   Enabled  Whether the cache file may be used and written.
+**/
+VOID
+GuiImageCacheInit (
+  OUT GUI_IMAGE_CACHE     *Cache,
+  IN  OC_STORAGE_CONTEXT  *Storage,
+  IN  BOOLEAN             Enabled
+  );
+
+/**
+  Find decoded images in the cache.
+
+  @param[in,out]  Cache         Image cache.
+  @param[in]      SourceDigest  SHA-256 digest of the source image file.
+  @param[in]      Highlight     Highlight pixel of the derived images or 0.
+  @param[out]     Images        Images allocated from pool on success.
+  @param[in]      NumImages     Number of images, base and derived.
+
+  @retval TRUE on cache hit.
+**/
+BOOLEAN
+GuiImageCacheLookup (
+  IN OUT GUI_IMAGE_CACHE  *Cache,
+  IN     CONST UINT8      *SourceDigest,
+  IN     UINT32           Highlight,
+  OUT    GUI_IMAGE        *Images,
+  IN     UINT32           NumImages
+  );
+
+/**
+  Add decoded images to the cache written by GuiImageCacheFlush.
+
+  @param[in,out]  Cache         Image cache.
+  @param[in]      SourceDigest  SHA-256 digest of the source image file.
+  @param[in]      Highlight     Highlight pixel of the derived images or 0.
+  @param[in]      Images        Images of the same dimensions.
+  @param[in]      NumImages     Number of images, base and derived.
+**/
+VOID
+GuiImageCacheInsert (
+  IN OUT GUI_IMAGE_CACHE  *Cache,
+  IN     CONST UINT8      *SourceDigest,
+  IN     UINT32           Highlight,
+  IN     CONST GUI_IMAGE  *Images,
+  IN     UINT32           NumImages
+  );
+
+/**
+  Write the cache back to storage when an image was inserted or a cached one
+  was not looked up, and free it.
+
+  @param[in,out]  Cache    Image cache.
+**/
+VOID
+GuiImageCacheFlush (
+  IN OUT GUI_IMAGE_CACHE  *Cache
+  );
+
 #endif // GUI_APP_H
@@ -0,0 +1,426 @@
+/** @file
+  This file is part of OpenCanopy, OpenCore GUI.
+
+  Copyright (c) 2020, vit9696. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-3-Clause
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcCryptoLib.h>
+#include <Library/OcFileLib.h>
+#include <Library/OcGuardLib.h>
+#include <Library/OcStorageLib.h>
+
+#include "OpenCanopy.h"
+#include "BmfLib.h"
+#include "GuiApp.h"
+
+#define GUI_IMAGE_CACHE_SIGNATURE  SIGNATURE_32 ('O', 'C', 'I', 'C')
+
+//
+// Bump whenever the cache layout or the image decoding results change.
+//
+#define GUI_IMAGE_CACHE_VERSION    1
+
+#define GUI_IMAGE_CACHE_PATH       L"Resources\\Image\\ImageCache.bin"
+
+//
+// Image cache file header, followed by the entries.
+//
+typedef struct {
+  UINT32  Signature;
+  UINT32  Version;
+  UINT32  NumEntries;
+  UINT32  DataSize;
+  UINT8   Digest[SHA256_DIGEST_SIZE];
+} GUI_IMAGE_CACHE_HEADER;
+
+//
+// Image cache entry, followed by NumImages images of Width x Height pixels.
+//
+typedef struct {
+  UINT8   SourceDigest[SHA256_DIGEST_SIZE];
+  UINT32  Highlight;
+  UINT32  NumImages;
+  UINT32  Width;
+  UINT32  Height;
+} GUI_IMAGE_CACHE_ENTRY;
+
+/**
+  Get entry size or 0 if the entry is malformed.
+**/
+STATIC
+UINT32
+InternalGetEntrySize (
+  IN CONST GUI_IMAGE_CACHE_ENTRY  *Entry
+  )
+{
+  UINT32  Size;
+
+  if (Entry->NumImages == 0 || Entry->NumImages > 2
+    || Entry->Width == 0 || Entry->Height == 0) {
+    return 0;
+  }
+
+  if (OcOverflowTriMulU32 (Entry->Width, Entry->Height, Entry->NumImages, &Size)
+    || OcOverflowMulAddU32 (Size, sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL), sizeof (*Entry), &Size)) {
+    return 0;
+  }
+
+  return Size;
+}
+
+
+/**
+  Get the loaded cache entry at Offset or NULL if there is no valid entry.
+**/
+STATIC
+GUI_IMAGE_CACHE_ENTRY *
+InternalGetEntry (
+  IN  CONST GUI_IMAGE_CACHE  *Cache,
+  IN  UINT32                 Offset,
+  OUT UINT32                 *EntrySize
+  )
+{
+  GUI_IMAGE_CACHE_ENTRY  *Entry;
+
+  if (Cache->DataSize - Offset < sizeof (*Entry)) {
+    return NULL;
+  }
+
+  Entry      = (GUI_IMAGE_CACHE_ENTRY *) &Cache->Data[Offset];
+  *EntrySize = InternalGetEntrySize (Entry);
+  if (*EntrySize == 0 || Cache->DataSize - Offset < *EntrySize) {
+    return NULL;
+  }
+
+  return Entry;
+}
+
+/**
+  Reserve space for a new entry at the end of the cache to be written.
+
+  @retval Entry space or NULL on failure.
+**/
+STATIC
+UINT8 *
+InternalReserveNewEntry (
+  IN OUT GUI_IMAGE_CACHE  *Cache,
+  IN     UINT32           EntrySize
+  )
+{
+  UINT32  OldSize;
+  UINT32  NewSize;
+  UINT8   *NewData;
+
+  if (Cache->NewData != NULL) {
+    OldSize = Cache->NewDataSize;
+  } else {
+    OldSize = sizeof (GUI_IMAGE_CACHE_HEADER);
+  }
+
+  if (OcOverflowAddU32 (OldSize, EntrySize, &NewSize)) {
+    return NULL;
+  }
+
+  NewData = ReallocatePool (
+    Cache->NewData != NULL ? Cache->NewDataSize : 0,
+    NewSize,
+    Cache->NewData
+    );
+  if (NewData == NULL) {
+    return NULL;
+  }
+
+  Cache->NewData     = NewData;
+  Cache->NewDataSize = NewSize;
+  ++Cache->NewNumEntries;
+  return &NewData[OldSize];
+}
+
+/**
+  Delete the cache file, as file writes do not truncate it.
+
+  @retval EFI_SUCCESS when the file was deleted or did not exist.
+**/
+STATIC
+EFI_STATUS
+InternalDeleteCacheFile (
+  IN OC_STORAGE_CONTEXT  *Storage
+  )
+{
+  EFI_STATUS         Status;
+  EFI_FILE_PROTOCOL  *File;
+
+  Status = SafeFileOpen (
+    Storage->StorageRoot,
+    &File,
+    GUI_IMAGE_CACHE_PATH,
+    EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE,
+    0
+    );
+  if (Status == EFI_NOT_FOUND) {
+    return EFI_SUCCESS;
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Delete closes the file and returns a warning when it was not deleted.
+  //
+  return File->Delete (File);
+}
+
+VOID
+GuiImageCacheInit (
+  OUT GUI_IMAGE_CACHE     *Cache,
+  IN  OC_STORAGE_CONTEXT  *Storage,
+  IN  BOOLEAN             Enabled
+  )
+{
+  GUI_IMAGE_CACHE_HEADER  *Header;
+  UINT8                   Digest[SHA256_DIGEST_SIZE];
+  UINT32                  Size;
+
+  ZeroMem (Cache, sizeof (*Cache));
+
+  //
+  // Cache file cannot be covered by the vault and would be rejected.
+  //
+  if (!Enabled || Storage->HasVault) {
+    return;
+  }
+
+  Cache->Storage = Storage;
+
+  Header = OcStorageReadFileUnicode (Storage, GUI_IMAGE_CACHE_PATH, &Size);
+  if (Header == NULL) {
+    DEBUG ((DEBUG_INFO, "OCUI: No image cache\n"));
+    return;
+  }
+
+  if (Size >= sizeof (*Header)
+    && Header->Signature == GUI_IMAGE_CACHE_SIGNATURE
+    && Header->Version == GUI_IMAGE_CACHE_VERSION
+    && Header->DataSize == Size - sizeof (*Header)
+    && Header->NumEntries > 0
+    && Header->NumEntries <= Header->DataSize / sizeof (GUI_IMAGE_CACHE_ENTRY)) {
+    Sha256 (Digest, (UINT8 *) (Header + 1), Header->DataSize);
+    if (CompareMem (Digest, Header->Digest, sizeof (Digest)) == 0) {
+      Cache->Used = AllocateZeroPool (Header->NumEntries * sizeof (*Cache->Used));
+      if (Cache->Used != NULL) {
+        Cache->Data     = (UINT8 *) Header;
+        Cache->DataSize = Size;
+        return;
+      }
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "OCUI: Ignoring invalid image cache\n"));
+  FreePool (Header);
+}
+
+BOOLEAN
+GuiImageCacheLookup (
+  IN OUT GUI_IMAGE_CACHE  *Cache,
+  IN     CONST UINT8      *SourceDigest,
+  IN     UINT32           Highlight,
+  OUT    GUI_IMAGE        *Images,
+  IN     UINT32           NumImages
+  )
+{
+  GUI_IMAGE_CACHE_HEADER  *Header;
+  GUI_IMAGE_CACHE_ENTRY   *Entry;
+  UINT32                  Offset;
+  UINT32                  EntrySize;
+  UINT32                  ImageSize;
+  UINT32                  Index;
+  UINT32                  Index2;
+
+  if (Cache->Data == NULL) {
+    return FALSE;
+  }
+
+  Header = (GUI_IMAGE_CACHE_HEADER *) Cache->Data;
+  Offset = sizeof (*Header);
+
+  for (Index = 0; Index < Header->NumEntries; ++Index) {
+    Entry = InternalGetEntry (Cache, Offset, &EntrySize);
+    if (Entry == NULL) {
+      break;
+    }
+
+    if (Entry->NumImages == NumImages
+      && Entry->Highlight == Highlight
+      && CompareMem (Entry->SourceDigest, SourceDigest, sizeof (Entry->SourceDigest)) == 0) {
+      ImageSize = (EntrySize - sizeof (*Entry)) / NumImages;
+
+      for (Index2 = 0; Index2 < NumImages; ++Index2) {
+        Images[Index2].Width  = Entry->Width;
+        Images[Index2].Height = Entry->Height;
+        Images[Index2].Buffer = AllocateCopyPool (
+          ImageSize,
+          &Cache->Data[Offset + sizeof (*Entry) + Index2 * ImageSize]
+          );
+        if (Images[Index2].Buffer == NULL) {
+          while (Index2 > 0) {
+            --Index2;
+            FreePool (Images[Index2].Buffer);
+            Images[Index2].Buffer = NULL;
+          }
+          return FALSE;
+        }
+      }
+
+      Cache->Used[Index] = TRUE;
+      return TRUE;
+    }
+
+    Offset += EntrySize;
+  }
+
+  return FALSE;
+}
+
+VOID
+GuiImageCacheInsert (
+  IN OUT GUI_IMAGE_CACHE  *Cache,
+  IN     CONST UINT8      *SourceDigest,
+  IN     UINT32           Highlight,
+  IN     CONST GUI_IMAGE  *Images,
+  IN     UINT32           NumImages
+  )
+{
+  GUI_IMAGE_CACHE_ENTRY   Entry;
+  UINT32                  EntrySize;
+  UINT32                  ImageSize;
+  UINT8                   *NewEntry;
+  UINT32                  Index;
+
+  if (Cache->Storage == NULL) {
+    return;
+  }
+
+  CopyMem (Entry.SourceDigest, SourceDigest, sizeof (Entry.SourceDigest));
+  Entry.Highlight = Highlight;
+  Entry.NumImages = NumImages;
+  Entry.Width     = Images[0].Width;
+  Entry.Height    = Images[0].Height;
+
+  for (Index = 1; Index < NumImages; ++Index) {
+    if (Images[Index].Width != Entry.Width || Images[Index].Height != Entry.Height) {
+      return;
+    }
+  }
+
+  EntrySize = InternalGetEntrySize (&Entry);
+  if (EntrySize == 0) {
+    return;
+  }
+
+  NewEntry = InternalReserveNewEntry (Cache, EntrySize);
+  if (NewEntry == NULL) {
+    return;
+  }
+
+  CopyMem (NewEntry, &Entry, sizeof (Entry));
+  ImageSize = (EntrySize - sizeof (Entry)) / NumImages;
+  for (Index = 0; Index < NumImages; ++Index) {
+    CopyMem (
+      &NewEntry[sizeof (Entry) + Index * ImageSize],
+      Images[Index].Buffer,
+      ImageSize
+      );
+  }
+}
+
+VOID
+GuiImageCacheFlush (
+  IN OUT GUI_IMAGE_CACHE  *Cache
+  )
+{
+  GUI_IMAGE_CACHE_HEADER  *Header;
+  GUI_IMAGE_CACHE_ENTRY   *Entry;
+  EFI_STATUS              Status;
+  UINT8                   *NewEntry;
+  UINT32                  Offset;
+  UINT32                  EntrySize;
+  UINT32                  Index;
+  BOOLEAN                 Rewrite;
+
+  //
+  // Rewrite the cache when an image was missing or an old one went unused.
+  //
+  Rewrite = Cache->NewData != NULL;
+  if (Cache->Data != NULL) {
+    Header = (GUI_IMAGE_CACHE_HEADER *) Cache->Data;
+    for (Index = 0; Index < Header->NumEntries && !Rewrite; ++Index) {
+      Rewrite = !Cache->Used[Index];
+    }
+
+    //
+    // Keep the old entries that were used.
+    //
+    Offset = sizeof (*Header);
+    for (Index = 0; Index < Header->NumEntries && Rewrite; ++Index) {
+      Entry = InternalGetEntry (Cache, Offset, &EntrySize);
+      if (Entry == NULL) {
+        break;
+      }
+
+      if (Cache->Used[Index]) {
+        NewEntry = InternalReserveNewEntry (Cache, EntrySize);
+        if (NewEntry != NULL) {
+          CopyMem (NewEntry, Entry, EntrySize);
+        }
+      }
+
+      Offset += EntrySize;
+    }
+  }
+
+  if (Rewrite) {
+    Status = InternalDeleteCacheFile (Cache->Storage);
+
+    if (Status == EFI_SUCCESS && Cache->NewData != NULL) {
+      Header             = (GUI_IMAGE_CACHE_HEADER *) Cache->NewData;
+      Header->Signature  = GUI_IMAGE_CACHE_SIGNATURE;
+      Header->Version    = GUI_IMAGE_CACHE_VERSION;
+      Header->NumEntries = Cache->NewNumEntries;
+      Header->DataSize   = Cache->NewDataSize - sizeof (*Header);
+      Sha256 (Header->Digest, (UINT8 *) (Header + 1), Header->DataSize);
+
+      Status = SetFileData (
+        Cache->Storage->StorageRoot,
+        GUI_IMAGE_CACHE_PATH,
+        Cache->NewData,
+        Cache->NewDataSize
+        );
+    }
+
+    DEBUG ((
+      DEBUG_INFO,
+      "OCUI: Wrote image cache with %u entries of %u bytes - %r\n",
+      Cache->NewNumEntries,
+      Cache->NewData != NULL ? Cache->NewDataSize : 0,
+      Status
+      ));
+  }
+
+  if (Cache->Data != NULL) {
+    FreePool (Cache->Data);
+    FreePool (Cache->Used);
+  }
+
+  if (Cache->NewData != NULL) {
+    FreePool (Cache->NewData);
+  }
+
+  ZeroMem (Cache, sizeof (*Cache));
+}
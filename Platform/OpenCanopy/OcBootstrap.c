@@ -80,7 +80,8 @@ OcShowMenuByOc (
 RETURN_STATUS
 InternalContextConstruct (
   OUT BOOT_PICKER_GUI_CONTEXT  *Context,
-  IN  OC_STORAGE_CONTEXT       *Storage
+  IN  OC_STORAGE_CONTEXT       *Storage,
+  IN  BOOLEAN                  UseImageCache
   );
 
 /**
@@ -107,7 +108,7 @@ GuiOcInterfaceRun (
     return Status;
   }
 
-  Status = InternalContextConstruct (&mGuiContext, Storage);
+  Status = InternalContextConstruct (&mGuiContext, Storage, Context->PickerImageCache);
   if (RETURN_ERROR (Status)) {
     return Status;
   }
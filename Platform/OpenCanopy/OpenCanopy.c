@@ -28,6 +28,16 @@ typedef struct {
   UINT32 MaxY;
 } GUI_DRAW_REQUEST;
 
+//
+// Damage tracking tile size in pixels.
+//
+#define GUI_DAMAGE_TILE_SHIFT  6U
+#define GUI_DAMAGE_TILE_SIZE   (1U << GUI_DAMAGE_TILE_SHIFT)
+//
+// Maximum amount of rectangles flushed per frame, extra ones are merged.
+//
+#define GUI_MAX_DRAW_REQUESTS  32U
+
 //
 // I/O contexts
 //
@@ -46,10 +56,24 @@ STATIC GUI_SCREEN_CURSOR             mScreenViewCursor  = { 0, 0 };
 STATIC UINT64                        mDeltaTscTarget    = 0;
 STATIC UINT64                        mStartTsc          = 0;
 //
+// Damage tracking information, one byte per dirty screen tile
+//
+STATIC UINT8                         *mDamageTiles      = NULL;
+STATIC UINT32                        mDamageTilesX      = 0;
+STATIC UINT32                        mDamageTilesY      = 0;
+STATIC UINT32                        mDamageMinTileY    = MAX_UINT32;
+STATIC UINT32                        mDamageMaxTileY    = 0;
+//
 // Drawing rectangles information
 //
-STATIC UINT8                         mNumValidDrawReqs  = 0;
-STATIC GUI_DRAW_REQUEST              mDrawRequests[4]   = { { 0 } };
+STATIC UINT32                        mNumValidDrawReqs  = 0;
+STATIC GUI_DRAW_REQUEST              mDrawRequests[GUI_MAX_DRAW_REQUESTS] = { { 0 } };
+//
+// Flushing statistics, reported once the drawing loop exits
+//
+STATIC UINT64                        mFrameCount        = 0;
+STATIC UINT64                        mFlushedBlits      = 0;
+STATIC UINT64                        mFlushedPixels     = 0;
 
 BOOLEAN
 GuiClipChildBounds (
@@ -257,85 +281,157 @@ GuiObjDelegatePtrEvent (
   return NULL;
 }
 
-#define RGB_APPLY_OPACITY(Rgba, Opacity)  \
-  (((Rgba) * (Opacity)) / 0xFF)
-
-#define RGB_ALPHA_BLEND(Back, Front, InvFrontOpacity)  \
-  ((Front) + RGB_APPLY_OPACITY (InvFrontOpacity, Back))
+/**
+  Mark screen area as requiring flushing.
 
+  @param[in]  PosX    Area X position.
+  @param[in]  PosY    Area Y position.
+  @param[in]  Width   Area width, must not be 0.
+  @param[in]  Height  Area height, must not be 0.
+**/
+STATIC
 VOID
-GuiBlendPixel (
-  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *BackPixel,
-  IN     CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *FrontPixel,
-  IN     UINT8                                Opacity
+GuiDamageArea (
+  IN UINT32  PosX,
+  IN UINT32  PosY,
+  IN UINT32  Width,
+  IN UINT32  Height
   )
 {
-  UINT8                               CombOpacity;
-  UINT8                               InvFrontOpacity;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL       OpacFrontPixel;
-  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *FinalFrontPixel;
-  //
-  // FIXME: Optimise with SIMD or such.
-  // qt_blend_argb32_on_argb32 in QT
-  //
-  ASSERT (BackPixel != NULL);
-  ASSERT (FrontPixel != NULL);
-
-  if (FrontPixel->Reserved == 0) {
-    return;
+  UINT32  MinTileX;
+  UINT32  MaxTileX;
+  UINT32  MinTileY;
+  UINT32  MaxTileY;
+  UINT32  TileY;
+
+  ASSERT (Width > 0);
+  ASSERT (Height > 0);
+
+  MinTileX = PosX >> GUI_DAMAGE_TILE_SHIFT;
+  MaxTileX = (PosX + Width - 1) >> GUI_DAMAGE_TILE_SHIFT;
+  MinTileY = PosY >> GUI_DAMAGE_TILE_SHIFT;
+  MaxTileY = (PosY + Height - 1) >> GUI_DAMAGE_TILE_SHIFT;
+
+  ASSERT (MaxTileX < mDamageTilesX);
+  ASSERT (MaxTileY < mDamageTilesY);
+
+  for (TileY = MinTileY; TileY <= MaxTileY; ++TileY) {
+    SetMem (
+      &mDamageTiles[TileY * mDamageTilesX + MinTileX],
+      MaxTileX - MinTileX + 1,
+      1
+      );
   }
 
-  if (FrontPixel->Reserved == 0xFF) {
-    if (Opacity == 0xFF) {
-      BackPixel->Blue     = FrontPixel->Blue;
-      BackPixel->Green    = FrontPixel->Green;
-      BackPixel->Red      = FrontPixel->Red;
-      BackPixel->Reserved = FrontPixel->Reserved;
-      return;
-    }
+  mDamageMinTileY = MIN (mDamageMinTileY, MinTileY);
+  mDamageMaxTileY = MAX (mDamageMaxTileY, MaxTileY);
+}
 
-    CombOpacity = Opacity;
-  } else {
-    CombOpacity = RGB_APPLY_OPACITY (FrontPixel->Reserved, Opacity);
+/**
+  Discard all pending damage.
+**/
+STATIC
+VOID
+GuiDamageReset (
+  VOID
+  )
+{
+  if (mDamageMinTileY <= mDamageMaxTileY) {
+    ZeroMem (
+      &mDamageTiles[mDamageMinTileY * mDamageTilesX],
+      (mDamageMaxTileY - mDamageMinTileY + 1) * mDamageTilesX
+      );
   }
 
-  if (CombOpacity == 0) {
-    return;
-  } else if (CombOpacity == FrontPixel->Reserved) {
-    FinalFrontPixel = FrontPixel;
-  } else {
-    OpacFrontPixel.Reserved = CombOpacity;
-    OpacFrontPixel.Blue     = RGB_APPLY_OPACITY (FrontPixel->Blue,  Opacity);
-    OpacFrontPixel.Green    = RGB_APPLY_OPACITY (FrontPixel->Green, Opacity);
-    OpacFrontPixel.Red      = RGB_APPLY_OPACITY (FrontPixel->Red,   Opacity);
+  mDamageMinTileY = MAX_UINT32;
+  mDamageMaxTileY = 0;
+}
+
+/**
+  Convert pending damage to draw requests and discard it.
+  Horizontal runs of dirty tiles are merged with the runs of the same span
+  in the tile row above, so that each request covers a rectangle of tiles.
 
-    FinalFrontPixel = &OpacFrontPixel;
+  @param[in]  ScreenWidth   Screen width in pixels.
+  @param[in]  ScreenHeight  Screen height in pixels.
+**/
+STATIC
+VOID
+GuiDamageToDrawRequests (
+  IN UINT32  ScreenWidth,
+  IN UINT32  ScreenHeight
+  )
+{
+  UINT8             *Row;
+  UINT32            TileX;
+  UINT32            TileY;
+  UINT32            RunStart;
+  UINT32            Index;
+  GUI_DRAW_REQUEST  *Request;
+
+  mNumValidDrawReqs = 0;
+
+  for (TileY = mDamageMinTileY; TileY <= mDamageMaxTileY; ++TileY) {
+    Row   = &mDamageTiles[TileY * mDamageTilesX];
+    TileX = 0;
+
+    while (TileX < mDamageTilesX) {
+      if (Row[TileX] == 0) {
+        ++TileX;
+        continue;
+      }
+
+      RunStart = TileX;
+      do {
+        Row[TileX] = 0;
+        ++TileX;
+      } while (TileX < mDamageTilesX && Row[TileX] != 0);
+
+      for (Index = 0; Index < mNumValidDrawReqs; ++Index) {
+        Request = &mDrawRequests[Index];
+        if (Request->MaxY + 1 == TileY
+         && Request->MinX == RunStart
+         && Request->MaxX == TileX - 1) {
+          Request->MaxY = TileY;
+          break;
+        }
+      }
+
+      if (Index < mNumValidDrawReqs) {
+        continue;
+      }
+
+      if (mNumValidDrawReqs < GUI_MAX_DRAW_REQUESTS) {
+        Request = &mDrawRequests[mNumValidDrawReqs];
+        Request->MinX = RunStart;
+        Request->MaxX = TileX - 1;
+        Request->MinY = TileY;
+        Request->MaxY = TileY;
+        ++mNumValidDrawReqs;
+      } else {
+        //
+        // Out of requests, grow the last one to cover this run.
+        //
+        Request = &mDrawRequests[mNumValidDrawReqs - 1];
+        Request->MinX = MIN (Request->MinX, RunStart);
+        Request->MaxX = MAX (Request->MaxX, TileX - 1);
+        Request->MaxY = TileY;
+      }
+    }
   }
 
-  InvFrontOpacity = (0xFF - CombOpacity);
+  mDamageMinTileY = MAX_UINT32;
+  mDamageMaxTileY = 0;
 
-  BackPixel->Blue = RGB_ALPHA_BLEND (
-                      BackPixel->Blue,
-                      FinalFrontPixel->Blue,
-                      InvFrontOpacity
-                      );
-  BackPixel->Green = RGB_ALPHA_BLEND (
-                       BackPixel->Green,
-                       FinalFrontPixel->Green,
-                       InvFrontOpacity
-                       );
-  BackPixel->Red = RGB_ALPHA_BLEND (
-                     BackPixel->Red,
-                     FinalFrontPixel->Red,
-                     InvFrontOpacity
-                     );
-
-  if (BackPixel->Reserved != 0xFF) {
-    BackPixel->Reserved = RGB_ALPHA_BLEND (
-                            BackPixel->Reserved,
-                            CombOpacity,
-                            InvFrontOpacity
-                            );
+  //
+  // Convert tiles to pixels, the last tiles may be cut by the screen edges.
+  //
+  for (Index = 0; Index < mNumValidDrawReqs; ++Index) {
+    Request = &mDrawRequests[Index];
+    Request->MinX <<= GUI_DAMAGE_TILE_SHIFT;
+    Request->MinY <<= GUI_DAMAGE_TILE_SHIFT;
+    Request->MaxX   = MIN (((Request->MaxX + 1) << GUI_DAMAGE_TILE_SHIFT) - 1, ScreenWidth - 1);
+    Request->MaxY   = MIN (((Request->MaxY + 1) << GUI_DAMAGE_TILE_SHIFT) - 1, ScreenHeight - 1);
   }
 }
 
@@ -362,36 +458,8 @@ GuiDrawToBuffer (
   UINT32                              RowIndex;
   UINT32                              SourceRowOffset;
   UINT32                              TargetRowOffset;
-  UINT32                              SourceColumnOffset;
   UINT32                              TargetColumnOffset;
-  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL *SourcePixel;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL       *TargetPixel;
-  GUI_DRAW_REQUEST                    ThisReq;
-  UINTN                               Index;
-
-  UINT32                              ThisArea;
-
-  UINT32                              ReqWidth;
-  UINT32                              ReqHeight;
-  UINT32                              ReqArea;
-
-  UINT32                              CombMinX;
-  UINT32                              CombMaxX;
-  UINT32                              CombMinY;
-  UINT32                              CombMaxY;
-  UINT32                              CombWidth;
-  UINT32                              CombHeight;
-  UINT32                              CombArea;
-
-  UINT32                              OverMinX;
-  UINT32                              OverMaxX;
-  UINT32                              OverMinY;
-  UINT32                              OverMaxY;
-  UINT32                              OverArea;
-  UINT32                              OverWidth;
-  UINT32                              OverHeight;
-
-  UINT32                              ActualArea;
 
   ASSERT (Image != NULL);
   ASSERT (DrawContext != NULL);
@@ -469,18 +537,12 @@ GuiDrawToBuffer (
         SourceRowOffset += Image->Width,
         TargetRowOffset += DrawContext->Screen->Width
       ) {
-      //
-      // Blend the row pixel-by-pixel.
-      //
-      for (
-        TargetColumnOffset = PosOffsetX, SourceColumnOffset = OffsetX;
-        TargetColumnOffset < PosOffsetX + Width;
-        ++TargetColumnOffset, ++SourceColumnOffset
-        ) {
-        TargetPixel = &mScreenBuffer[TargetRowOffset + PosBaseX + TargetColumnOffset];
-        SourcePixel = &Image->Buffer[SourceRowOffset + SourceColumnOffset];
-        GuiBlendPixel (TargetPixel, SourcePixel, Opacity);
-      }
+      GuiBlendRow (
+        &mScreenBuffer[TargetRowOffset + PosBaseX + PosOffsetX],
+        &Image->Buffer[SourceRowOffset + OffsetX],
+        Width,
+        Opacity
+        );
     }
   } else {
     //
@@ -508,89 +570,12 @@ GuiDrawToBuffer (
   }
 
   if (RequestDraw) {
-    //
-    // Update the coordinates of the smallest rectangle covering all changes.
-    //
-    ThisReq.MinX = PosBaseX + PosOffsetX;
-    ThisReq.MinY = PosBaseY + PosOffsetY;
-    ThisReq.MaxX = PosBaseX + PosOffsetX + Width  - 1;
-    ThisReq.MaxY = PosBaseY + PosOffsetY + Height - 1;
-
-    ThisArea = Width * Height;
-
-    for (Index = 0; Index < mNumValidDrawReqs; ++Index) {
-      //
-      // Calculate several dimensions to determine whether to merge the two
-      // draw requests for improved flushing performance.
-      //
-      ReqWidth  = mDrawRequests[Index].MaxX - mDrawRequests[Index].MinX + 1;
-      ReqHeight = mDrawRequests[Index].MaxY - mDrawRequests[Index].MinY + 1;
-      ReqArea   = ReqWidth * ReqHeight;
-
-      if (mDrawRequests[Index].MinX < ThisReq.MinX) {
-        CombMinX = mDrawRequests[Index].MinX;
-        OverMinX = ThisReq.MinX;
-      } else {
-        CombMinX = ThisReq.MinX;
-        OverMinX = mDrawRequests[Index].MinX;
-      }
-
-      if (mDrawRequests[Index].MaxX > ThisReq.MaxX) {
-        CombMaxX = mDrawRequests[Index].MaxX;
-        OverMaxX = ThisReq.MaxX;
-      } else {
-        CombMaxX = ThisReq.MaxX;
-        OverMaxX = mDrawRequests[Index].MaxX;
-      }
-
-      if (mDrawRequests[Index].MinY < ThisReq.MinY) {
-        CombMinY = mDrawRequests[Index].MinY;
-        OverMinY = ThisReq.MinY;
-      } else {
-        CombMinY = ThisReq.MinY;
-        OverMinY = mDrawRequests[Index].MinY;
-      }
-
-      if (mDrawRequests[Index].MaxY > ThisReq.MaxY) {
-        CombMaxY = mDrawRequests[Index].MaxY;
-        OverMaxY = ThisReq.MaxY;
-      } else {
-        CombMaxY = ThisReq.MaxY;
-        OverMaxY = mDrawRequests[Index].MaxY;
-      }
-
-      CombWidth  = CombMaxX - CombMinX + 1;
-      CombHeight = CombMaxY - CombMinY + 1;
-      CombArea   = CombWidth * CombHeight;
-
-      OverArea = 0;
-      if (OverMinX <= OverMaxX && OverMinY <= OverMaxY) {
-        OverWidth  = OverMaxX - OverMinX + 1;
-        OverHeight = OverMaxY - OverMinY + 1;
-        OverArea   = OverWidth * OverHeight;
-      }
-
-      ActualArea = ThisArea + ReqArea - OverArea;
-      //
-      // Two requests are merged when their combined actual draw area is at
-      // least 3/4 of the area needed to draw both at once.
-      //
-      if (4 * ActualArea >= 3 * CombArea) {
-        mDrawRequests[Index].MinX = CombMinX;
-        mDrawRequests[Index].MaxX = CombMaxX;
-        mDrawRequests[Index].MinY = CombMinY;
-        mDrawRequests[Index].MaxY = CombMaxY;
-        return;
-      }
-    }
-
-    if (mNumValidDrawReqs >= ARRAY_SIZE (mDrawRequests)) {
-      ASSERT (FALSE);
-      return;
-    }
-
-    CopyMem (&mDrawRequests[mNumValidDrawReqs], &ThisReq, sizeof (ThisReq));
-    ++mNumValidDrawReqs;
+    GuiDamageArea (
+      PosBaseX + PosOffsetX,
+      PosBaseY + PosOffsetY,
+      Width,
+      Height
+      );
   }
 }
 
@@ -724,7 +709,7 @@ GuiRedrawPointer (
     // Redraw the cursor if its image has changed.
     //
     RequestDraw = TRUE;
-  } else if (mNumValidDrawReqs == 0) {
+  } else if (mDamageMinTileY > mDamageMaxTileY) {
     //
     // Redraw the cursor if nothing else is drawn to always invoke GOP for a
     // more consistent framerate.
@@ -835,8 +820,8 @@ GuiFlushScreen (
 {
   EFI_TPL OldTpl;
 
-  UINTN   NumValidDrawReqs;
-  UINTN   Index;
+  UINT32  Index;
+  UINT32  NumPixels;
 
   UINT64  EndTsc;
   UINT64  DeltaTsc;
@@ -848,12 +833,10 @@ GuiFlushScreen (
 
   GuiRedrawPointer (DrawContext);
 
-  NumValidDrawReqs = mNumValidDrawReqs;
-  ASSERT (NumValidDrawReqs <= ARRAY_SIZE (mDrawRequests));
+  GuiDamageToDrawRequests (DrawContext->Screen->Width, DrawContext->Screen->Height);
 
-  mNumValidDrawReqs = 0;
-
-  for (Index = 0; Index < NumValidDrawReqs; ++Index) {
+  NumPixels = 0;
+  for (Index = 0; Index < mNumValidDrawReqs; ++Index) {
     ASSERT (mDrawRequests[Index].MaxX >= mDrawRequests[Index].MinX);
     ASSERT (mDrawRequests[Index].MaxY >= mDrawRequests[Index].MinY);
     //
@@ -861,7 +844,13 @@ GuiFlushScreen (
     //
     mDrawRequests[Index].MaxX -= mDrawRequests[Index].MinX - 1;
     mDrawRequests[Index].MaxY -= mDrawRequests[Index].MinY - 1;
+    NumPixels += mDrawRequests[Index].MaxX * mDrawRequests[Index].MaxY;
   }
+
+  ++mFrameCount;
+  mFlushedBlits  += mNumValidDrawReqs;
+  mFlushedPixels += NumPixels;
+
   //
   // Raise the TPL to not interrupt timing or flushing.
   //
@@ -874,7 +863,7 @@ GuiFlushScreen (
     EndTsc = InternalCpuDelayTsc (mDeltaTscTarget - DeltaTsc);
   }
 
-  for (Index = 0; Index < NumValidDrawReqs; ++Index) {
+  for (Index = 0; Index < mNumValidDrawReqs; ++Index) {
     //
     // Due to above's loop, MaxX/Y correspond to Width and Height here.
     //
@@ -971,6 +960,18 @@ GuiLibConstruct (
     CacheWriteBack
     );
 
+  mDamageTilesX = (OutputInfo->HorizontalResolution + GUI_DAMAGE_TILE_SIZE - 1) >> GUI_DAMAGE_TILE_SHIFT;
+  mDamageTilesY = (OutputInfo->VerticalResolution + GUI_DAMAGE_TILE_SIZE - 1) >> GUI_DAMAGE_TILE_SHIFT;
+  mDamageTiles  = AllocateZeroPool (mDamageTilesX * mDamageTilesY);
+  if (mDamageTiles == NULL) {
+    DEBUG ((DEBUG_ERROR, "GUI alloc failure\n"));
+    GuiLibDestruct ();
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mDamageMinTileY = MAX_UINT32;
+  mDamageMaxTileY = 0;
+
   mDeltaTscTarget =  DivU64x32 (OcGetTSCFrequency (), 60);
 
   mScreenViewCursor.X = CursorDefaultX;
@@ -998,6 +999,11 @@ GuiLibDestruct (
     GuiKeyDestruct (mKeyContext);
     mKeyContext = NULL;
   }
+
+  if (mDamageTiles != NULL) {
+    FreePool (mDamageTiles);
+    mDamageTiles = NULL;
+  }
 }
 
 VOID
@@ -1085,8 +1091,8 @@ GuiDrawLoop (
 
   ASSERT (DrawContext != NULL);
 
-  mNumValidDrawReqs = 0;
-  HoldObject        = NULL;
+  GuiDamageReset ();
+  HoldObject = NULL;
 
   GuiRedrawAndFlushScreen (DrawContext);
   //
@@ -1194,6 +1200,17 @@ GuiDrawLoop (
     //UINT64 EndTsc = AsmReadTsc ();
     //DEBUG ((DEBUG_ERROR, "Loop delta TSC: %lld, target: %lld\n", EndTsc - StartTsc, mDeltaTscTarget));
   } while (!DrawContext->ExitLoop (DrawContext->GuiContext));
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "OCUI: %Lu frames flushed %Lu blits with %Lu pixels\n",
+    mFrameCount,
+    mFlushedBlits,
+    mFlushedPixels
+    ));
+  mFrameCount    = 0;
+  mFlushedBlits  = 0;
+  mFlushedPixels = 0;
 }
 
 RETURN_STATUS
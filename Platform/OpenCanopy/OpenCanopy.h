@@ -241,6 +241,22 @@ GuiBlendPixel (
   IN     UINT8                                Opacity
   );
 
+/**
+  Blend a row of pixels, equivalent to calling GuiBlendPixel for each of them.
+
+  @param[in,out]  BackRow   Back pixel row.
+  @param[in]      FrontRow  Front pixel row.
+  @param[in]      Width     Number of pixels in the row.
+  @param[in]      Opacity   Front row opacity.
+**/
+VOID
+GuiBlendRow (
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *BackRow,
+  IN     CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *FrontRow,
+  IN     UINT32                               Width,
+  IN     UINT8                                Opacity
+  );
+
 RETURN_STATUS
 GuiCreateHighlightedImage (
   OUT GUI_IMAGE                            *SelectedImage,
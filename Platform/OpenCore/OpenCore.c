@@ -74,6 +74,8 @@ OcStartImage (
 
   OldMode = OcConsoleControlSetMode (EfiConsoleControlScreenGraphics);
 
+  OcLogFlushFile ();
+
   Status = gBS->StartImage (
     ImageHandle,
     ExitDataSize,
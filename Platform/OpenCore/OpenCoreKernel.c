@@ -322,9 +322,18 @@ OcKernelApplyPatches (
   UINT32                 MaxKernel;
   UINT32                 MinKernel;
   BOOLEAN                IsKernelPatch;
+  PATCHER_GENERIC_PATCH  *KernelPatches;
+  UINT32                 *KernelPatchIndices;
+  RETURN_STATUS          *KernelPatchResults;
+  UINT32                 KernelPatchCount;
 
   IsKernelPatch = Context == NULL;
 
+  KernelPatches      = NULL;
+  KernelPatchIndices = NULL;
+  KernelPatchResults = NULL;
+  KernelPatchCount   = 0;
+
   if (IsKernelPatch) {
     ASSERT (Kernel != NULL);
 
@@ -338,6 +347,20 @@ OcKernelApplyPatches (
       DEBUG ((DEBUG_ERROR, "OC: Kernel patcher kernel init failure - %r\n", Status));
       return;
     }
+
+    //
+    // Kernel patches share the image, so they are applied in one pass.
+    // Patches are applied one by one should the allocation fail.
+    //
+    if (Config->Kernel.Patch.Count > 0) {
+      KernelPatches = AllocatePool (
+        Config->Kernel.Patch.Count * (sizeof (*KernelPatches) + sizeof (*KernelPatchIndices) + sizeof (*KernelPatchResults))
+        );
+      if (KernelPatches != NULL) {
+        KernelPatchResults = (RETURN_STATUS *) &KernelPatches[Config->Kernel.Patch.Count];
+        KernelPatchIndices = (UINT32 *) &KernelPatchResults[Config->Kernel.Patch.Count];
+      }
+    }
   }
 
   for (Index = 0; Index < Config->Kernel.Patch.Count; ++Index) {
@@ -425,6 +448,13 @@ OcKernelApplyPatches (
     Patch.Skip    = UserPatch->Skip;
     Patch.Limit   = UserPatch->Limit;
 
+    if (KernelPatches != NULL) {
+      CopyMem (&KernelPatches[KernelPatchCount], &Patch, sizeof (Patch));
+      KernelPatchIndices[KernelPatchCount] = Index;
+      ++KernelPatchCount;
+      continue;
+    }
+
     Status = PatcherApplyGenericPatch (&Patcher, &Patch);
     DEBUG ((
       EFI_ERROR (Status) ? DEBUG_WARN : DEBUG_INFO,
@@ -436,6 +466,24 @@ OcKernelApplyPatches (
       ));
   }
 
+  if (KernelPatches != NULL) {
+    PatcherApplyGenericPatches (&Patcher, KernelPatches, KernelPatchCount, KernelPatchResults);
+
+    for (Index = 0; Index < KernelPatchCount; ++Index) {
+      UserPatch = Config->Kernel.Patch.Values[KernelPatchIndices[Index]];
+      DEBUG ((
+        EFI_ERROR (KernelPatchResults[Index]) ? DEBUG_WARN : DEBUG_INFO,
+        "OC: Kernel patcher result %u for %a (%a) - %r\n",
+        KernelPatchIndices[Index],
+        OC_BLOB_GET (&UserPatch->Identifier),
+        OC_BLOB_GET (&UserPatch->Comment),
+        KernelPatchResults[Index]
+        ));
+    }
+
+    FreePool (KernelPatches);
+  }
+
   if (!IsKernelPatch) {
     if (Config->Kernel.Quirks.AppleCpuPmCfgLock) {
       PatchAppleCpuPmCfgLock (Context);
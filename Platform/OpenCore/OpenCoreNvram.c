@@ -22,6 +22,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/PrintLib.h>
 #include <Library/OcCpuLib.h>
 #include <Library/OcFileLib.h>
+#include <Library/OcMemoryLib.h>
 #include <Library/OcSerializeLib.h>
 #include <Library/OcStringLib.h>
 #include <Library/UefiLib.h>
@@ -288,6 +289,8 @@ OcLoadLegacyNvram (
   OC_ASSOC              *VariableMap;
   OC_NVRAM_LEGACY_ENTRY *SchemaEntry;
   OC_NVRAM_LEGACY_MAP   *Schema;
+  OC_MEMORY_ARENA       Arena;
+  OC_MEMORY_ARENA       *PreviousArena;
 
   Schema = &Config->Nvram.Legacy;
 
@@ -297,8 +300,15 @@ OcLoadLegacyNvram (
     return;
   }
 
+  //
+  // Parsed storage is only needed while setting variables, so all of it is
+  // allocated from an arena and released at once instead of destructing it.
+  //
+  MemoryArenaInit (&Arena, "Nvram", FileSize / 2);
+  PreviousArena = OcTemplateSetArena (&Arena);
   OC_NVRAM_STORAGE_CONSTRUCT (&Nvram, sizeof (Nvram));
   IsValid = ParseSerialized (&Nvram, &mNvramStorageRootSchema, FileBuffer, FileSize);
+  OcTemplateSetArena (PreviousArena);
   FreePool (FileBuffer);
 
   if (!IsValid || Nvram.Version != OC_NVRAM_STORAGE_VERSION) {
@@ -308,7 +318,7 @@ OcLoadLegacyNvram (
       Nvram.Version,
       OC_NVRAM_STORAGE_VERSION
       ));
-    OC_NVRAM_STORAGE_DESTRUCT (&Nvram, sizeof (Nvram));
+    MemoryArenaFree (&Arena);
     return;
   }
 
@@ -339,7 +349,7 @@ OcLoadLegacyNvram (
     }
   }
 
-  OC_NVRAM_STORAGE_DESTRUCT (&Nvram, sizeof (Nvram));
+  MemoryArenaFree (&Arena);
 }
 
 STATIC
@@ -47,5 +47,61 @@ FwOnGetVariable (
   OUT EFI_GET_VARIABLE  *OrgGetVariable  OPTIONAL
   );
 
+/**
+  Check whether variable snapshot matches current variable list.
+
+  @retval TRUE when the snapshot can be used.
+**/
+BOOLEAN
+VariableSnapshotIsValid (
+  VOID
+  );
+
+/**
+  Invalidate variable snapshot after a variable update.
+**/
+VOID
+VariableSnapshotInvalidate (
+  VOID
+  );
+
+/**
+  Forget variable snapshot without freeing it, e.g. at ExitBootServices.
+**/
+VOID
+VariableSnapshotDiscard (
+  VOID
+  );
+
+/**
+  Take variable snapshot by enumerating all variables.
+  Must be called during boot services.
+
+  @param[in]  GetNextVariableName  Firmware variable enumeration function.
+
+  @retval TRUE on success.
+**/
+BOOLEAN
+VariableSnapshotBuild (
+  IN EFI_GET_NEXT_VARIABLE_NAME  GetNextVariableName
+  );
+
+/**
+  GetNextVariableName implementation on top of variable snapshot.
+
+  @param[in,out]  VariableNameSize  Variable name buffer size.
+  @param[in,out]  VariableName      Variable name.
+  @param[in,out]  VendorGuid        Variable vendor GUID.
+
+  @retval EFI_NOT_READY when the snapshot is not valid or has no such variable.
+  @retval other as per GetNextVariableName specification.
+**/
+EFI_STATUS
+VariableSnapshotGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  );
+
 
 #endif // FIRMWARE_RUNTIME_SERVICES_PRIVATE_H
@@ -54,8 +54,10 @@ OC_FWRT_CONFIG  *gCurrentConfig;
   Boot phase accessible variables.
 **/
 STATIC EFI_EVENT                     mTranslateEvent;
+STATIC EFI_EVENT                     mExitBootServicesEvent;
 STATIC EFI_GET_VARIABLE              mCustomGetVariable;
 STATIC BOOLEAN                       mKernelStarted;
+STATIC BOOLEAN                       mBootServicesExited;
 
 /**
   Current boot order before updating.
@@ -343,6 +345,48 @@ WrapGetVariable (
   return Status;
 }
 
+STATIC
+EFI_STATUS
+EFIAPI
+UnprotectedGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  )
+{
+  EFI_STATUS  Status;
+  BOOLEAN     Ints;
+  BOOLEAN     Wp;
+
+  WriteUnprotectorPrologue (&Ints, &Wp);
+
+  Status = mStoredGetNextVariableName (VariableNameSize, VariableName, VendorGuid);
+
+  WriteUnprotectorEpilogue (Ints, Wp);
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+CachedGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  )
+{
+  EFI_STATUS  Status;
+
+  if (!mBootServicesExited) {
+    Status = VariableSnapshotGetNextVariableName (VariableNameSize, VariableName, VendorGuid);
+    if (Status != EFI_NOT_READY) {
+      return Status;
+    }
+  }
+
+  return mStoredGetNextVariableName (VariableNameSize, VariableName, VendorGuid);
+}
+
 STATIC
 EFI_STATUS
 EFIAPI
@@ -388,6 +432,18 @@ WrapGetNextVariableName (
     return EFI_INVALID_PARAMETER;
   }
 
+  //
+  // Every EfiBoot variable lookup walks the whole variable list, which is
+  // very slow on real firmwares. Walk it once and keep a snapshot for
+  // the rest of the iteration while we can still allocate memory.
+  //
+  if (gCurrentConfig->BootVariableRedirect
+    && !mBootServicesExited
+    && !VariableSnapshotIsValid ()
+    && IsEfiBootVar (VariableName, VendorGuid, NULL, NULL)) {
+    VariableSnapshotBuild (UnprotectedGetNextVariableName);
+  }
+
   WriteUnprotectorPrologue (&Ints, &Wp);
 
   //
@@ -418,7 +474,7 @@ WrapGetNextVariableName (
       // Request for variables.
       //
       Size   = sizeof (TempName);
-      Status = mStoredGetNextVariableName (&Size, TempName, &TempGuid);
+      Status = CachedGetNextVariableName (&Size, TempName, &TempGuid);
 
       if (!EFI_ERROR (Status)) {
         if (!IsEfiBootVar (TempName, &TempGuid, NULL, NULL)) {
@@ -503,7 +559,7 @@ WrapGetNextVariableName (
   //
   while (TRUE) {
     Size   = sizeof (TempName);
-    Status = mStoredGetNextVariableName (&Size, TempName, &TempGuid);
+    Status = CachedGetNextVariableName (&Size, TempName, &TempGuid);
 
     if (!EFI_ERROR (Status)) {
       if (IsOcBootVar (TempName, &TempGuid)) {
@@ -1016,6 +1072,11 @@ WrapSetVariable (
     }
   }
 
+  //
+  // Variable list may have changed, drop the enumeration snapshot.
+  //
+  VariableSnapshotInvalidate ();
+
   WriteUnprotectorEpilogue (Ints, Wp);
 
   return Status;
@@ -1088,6 +1149,21 @@ FwOnGetVariable (
   return EFI_SUCCESS;
 }
 
+STATIC
+VOID
+EFIAPI
+ExitBootServicesHandler (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  //
+  // Snapshot lives in boot services memory, which is no longer ours.
+  //
+  VariableSnapshotDiscard ();
+  mBootServicesExited = TRUE;
+}
+
 STATIC
 VOID
 EFIAPI
@@ -1159,4 +1235,14 @@ RedirectRuntimeServices (
     );
 
   ASSERT_EFI_ERROR (Status);
+
+  Status = gBS->CreateEvent (
+    EVT_SIGNAL_EXIT_BOOT_SERVICES,
+    TPL_CALLBACK,
+    ExitBootServicesHandler,
+    NULL,
+    &mExitBootServicesEvent
+    );
+
+  ASSERT_EFI_ERROR (Status);
 }
@@ -0,0 +1,250 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "OpenRuntimePrivate.h"
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+//
+// Variable snapshot entry, followed by a null-terminated variable name.
+//
+typedef struct {
+  EFI_GUID  VendorGuid;
+  UINT32    NameSize;
+} VARIABLE_SNAPSHOT_ENTRY;
+
+//
+// Largest variable name we can work with, matches WrapGetNextVariableName.
+//
+#define VARIABLE_SNAPSHOT_MAX_NAME_SIZE  512
+
+//
+// Sanity limit for the snapshot size to survive firmwares looping in
+// GetNextVariableName.
+//
+#define VARIABLE_SNAPSHOT_MAX_SIZE       SIZE_1MB
+
+/**
+  Variable list snapshot taken during boot services.
+**/
+STATIC UINT8   *mSnapshot;
+STATIC UINT32  mSnapshotSize;
+STATIC UINT32  mSnapshotCapacity;
+STATIC UINT32  mSnapshotCursor;
+STATIC UINT32  mSnapshotGeneration;
+
+/**
+  Current variable list generation, incremented on every update.
+**/
+STATIC UINT32  mVariableGeneration = 1;
+
+STATIC
+UINT32
+GetEntrySize (
+  IN UINT32  NameSize
+  )
+{
+  return ALIGN_VALUE (sizeof (VARIABLE_SNAPSHOT_ENTRY) + NameSize, sizeof (UINT32));
+}
+
+/**
+  Find the entry following the variable, or end of the snapshot if the
+  variable is the last one.
+
+  @param[in]  VariableName  Variable name, empty to start from the beginning.
+  @param[in]  VendorGuid    Variable vendor GUID.
+  @param[out] Offset        Next entry offset.
+
+  @retval TRUE when the variable was found.
+**/
+STATIC
+BOOLEAN
+FindNextEntry (
+  IN  CONST CHAR16    *VariableName,
+  IN  CONST EFI_GUID  *VendorGuid,
+  OUT UINT32          *Offset
+  )
+{
+  VARIABLE_SNAPSHOT_ENTRY  *Entry;
+  UINT32                   Current;
+
+  if (VariableName[0] == L'\0') {
+    *Offset = 0;
+    return TRUE;
+  }
+
+  //
+  // Enumeration normally continues from the last returned variable.
+  //
+  if (mSnapshotCursor < mSnapshotSize) {
+    Entry = (VARIABLE_SNAPSHOT_ENTRY *) &mSnapshot[mSnapshotCursor];
+    if (CompareGuid (&Entry->VendorGuid, VendorGuid)
+      && StrCmp ((CHAR16 *) (Entry + 1), VariableName) == 0) {
+      *Offset = mSnapshotCursor + GetEntrySize (Entry->NameSize);
+      return TRUE;
+    }
+  }
+
+  Current = 0;
+  while (Current < mSnapshotSize) {
+    Entry   = (VARIABLE_SNAPSHOT_ENTRY *) &mSnapshot[Current];
+    Current += GetEntrySize (Entry->NameSize);
+    if (CompareGuid (&Entry->VendorGuid, VendorGuid)
+      && StrCmp ((CHAR16 *) (Entry + 1), VariableName) == 0) {
+      *Offset = Current;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+BOOLEAN
+VariableSnapshotIsValid (
+  VOID
+  )
+{
+  return mSnapshot != NULL && mSnapshotGeneration == mVariableGeneration;
+}
+
+VOID
+VariableSnapshotInvalidate (
+  VOID
+  )
+{
+  ++mVariableGeneration;
+}
+
+VOID
+VariableSnapshotDiscard (
+  VOID
+  )
+{
+  mSnapshot         = NULL;
+  mSnapshotSize     = 0;
+  mSnapshotCapacity = 0;
+  mSnapshotCursor   = 0;
+}
+
+BOOLEAN
+VariableSnapshotBuild (
+  IN EFI_GET_NEXT_VARIABLE_NAME  GetNextVariableName
+  )
+{
+  EFI_STATUS               Status;
+  CHAR16                   Name[VARIABLE_SNAPSHOT_MAX_NAME_SIZE / sizeof (CHAR16)];
+  EFI_GUID                 Guid;
+  UINTN                    Size;
+  UINT32                   NameSize;
+  UINT32                   EntrySize;
+  UINT32                   Offset;
+  UINT32                   NewCapacity;
+  UINT8                    *NewSnapshot;
+  VARIABLE_SNAPSHOT_ENTRY  *Entry;
+
+  //
+  // Reuse the previous buffer when rebuilding.
+  //
+  if (mSnapshot == NULL) {
+    mSnapshot = AllocatePool (EFI_PAGE_SIZE);
+    if (mSnapshot == NULL) {
+      return FALSE;
+    }
+
+    mSnapshotCapacity = EFI_PAGE_SIZE;
+  }
+
+  Name[0] = L'\0';
+  ZeroMem (&Guid, sizeof (Guid));
+  Offset = 0;
+
+  while (TRUE) {
+    Size   = sizeof (Name);
+    Status = GetNextVariableName (&Size, Name, &Guid);
+    if (Status == EFI_NOT_FOUND) {
+      break;
+    }
+
+    NameSize  = (UINT32) StrSize (Name); ///< Not guaranteed to be updated with EFI_SUCCESS.
+    EntrySize = GetEntrySize (NameSize);
+
+    //
+    // Leave any errors and too long variable names to the firmware.
+    // Also give up on lists growing indefinitely due to firmware bugs.
+    //
+    if (EFI_ERROR (Status) || Offset + EntrySize > VARIABLE_SNAPSHOT_MAX_SIZE) {
+      FreePool (mSnapshot);
+      VariableSnapshotDiscard ();
+      return FALSE;
+    }
+
+    if (Offset + EntrySize > mSnapshotCapacity) {
+      NewCapacity = mSnapshotCapacity * 2;
+      NewSnapshot = ReallocatePool (mSnapshotCapacity, NewCapacity, mSnapshot);
+      if (NewSnapshot == NULL) {
+        FreePool (mSnapshot);
+        VariableSnapshotDiscard ();
+        return FALSE;
+      }
+
+      mSnapshot         = NewSnapshot;
+      mSnapshotCapacity = NewCapacity;
+    }
+
+    Entry           = (VARIABLE_SNAPSHOT_ENTRY *) &mSnapshot[Offset];
+    Entry->NameSize = NameSize;
+    CopyGuid (&Entry->VendorGuid, &Guid);
+    CopyMem (Entry + 1, Name, NameSize);
+    Offset += EntrySize;
+  }
+
+  mSnapshotSize       = Offset;
+  mSnapshotCursor     = Offset;
+  mSnapshotGeneration = mVariableGeneration;
+  return TRUE;
+}
+
+EFI_STATUS
+VariableSnapshotGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  )
+{
+  VARIABLE_SNAPSHOT_ENTRY  *Entry;
+  UINT32                   Offset;
+
+  if (!VariableSnapshotIsValid ()
+    || !FindNextEntry (VariableName, VendorGuid, &Offset)) {
+    return EFI_NOT_READY;
+  }
+
+  if (Offset == mSnapshotSize) {
+    return EFI_NOT_FOUND;
+  }
+
+  Entry = (VARIABLE_SNAPSHOT_ENTRY *) &mSnapshot[Offset];
+  if (*VariableNameSize < Entry->NameSize) {
+    *VariableNameSize = Entry->NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  CopyGuid (VendorGuid, &Entry->VendorGuid);
+  CopyMem (VariableName, Entry + 1, Entry->NameSize);
+  *VariableNameSize = Entry->NameSize;
+  mSnapshotCursor   = Offset;
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,219 @@
+/** @file
+  This file is part of OpenCanopy, OpenCore GUI.
+
+  Copyright (c) 2020, vit9696. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-3-Clause
+**/
+
+/*
+clang -g -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -I../../Platform/OpenCanopy -include ../Include/Base.h Blending.c ../../Platform/OpenCanopy/Blending.c -o Blending
+
+./Blending [iterations]
+
+Blends full HD frames with GuiBlendPixel and GuiBlendRow, checks that the
+results are bit-exact and prints the timings of both.
+
+Use -O2 without sanitizers for meaningful timings, and -mno-sse2 to test
+the portable path.
+*/
+
+#include <Base.h>
+#include <Library/DebugLib.h>
+
+#include "OpenCanopy.h"
+
+#define FRAME_WIDTH    1920
+#define FRAME_HEIGHT   1080
+#define FRAME_PIXELS   (FRAME_WIDTH * FRAME_HEIGHT)
+
+STATIC UINT32 mSeed = 0x12345678;
+
+STATIC
+UINT32
+Random (
+  VOID
+  )
+{
+  mSeed = mSeed * 1103515245U + 12345U;
+  return mSeed >> 8U;
+}
+
+/**
+  Generate an image with runs of transparent, opaque and translucent pixels
+  like an icon with antialiased edges.
+**/
+STATIC
+VOID
+FillFront (
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Buffer
+  )
+{
+  UINT32  Index;
+  UINT32  RunLength;
+  UINT32  RunType;
+
+  Index = 0;
+  while (Index < FRAME_PIXELS) {
+    RunLength = 1 + Random () % 64;
+    RunType   = Random () % 4;
+
+    while (RunLength > 0 && Index < FRAME_PIXELS) {
+      Buffer[Index].Blue     = (UINT8) Random ();
+      Buffer[Index].Green    = (UINT8) Random ();
+      Buffer[Index].Red      = (UINT8) Random ();
+      if (RunType == 0) {
+        Buffer[Index].Reserved = 0;
+      } else if (RunType == 1) {
+        Buffer[Index].Reserved = 0xFF;
+      } else {
+        Buffer[Index].Reserved = (UINT8) Random ();
+      }
+
+      ++Index;
+      --RunLength;
+    }
+  }
+}
+
+STATIC
+VOID
+FillBack (
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Buffer
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < FRAME_PIXELS; ++Index) {
+    Buffer[Index].Blue     = (UINT8) Random ();
+    Buffer[Index].Green    = (UINT8) Random ();
+    Buffer[Index].Red      = (UINT8) Random ();
+    Buffer[Index].Reserved = (Random () % 4) == 0 ? (UINT8) Random () : 0xFF;
+  }
+}
+
+STATIC
+BOOLEAN
+CheckAllPixels (
+  VOID
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Front;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Back;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Expected;
+  UINT32                         Alpha;
+  UINT32                         Opacity;
+  UINT32                         Value;
+
+  //
+  // Every alpha and opacity pair with all channel values, including
+  // non-premultiplied colours.
+  //
+  for (Alpha = 0; Alpha <= 0xFF; ++Alpha) {
+    for (Opacity = 0; Opacity <= 0xFF; ++Opacity) {
+      for (Value = 0; Value <= 0xFF; ++Value) {
+        Front.Blue      = (UINT8) Value;
+        Front.Green     = (UINT8) (0xFF - Value);
+        Front.Red       = (UINT8) Random ();
+        Front.Reserved  = (UINT8) Alpha;
+        Back.Blue       = (UINT8) Random ();
+        Back.Green      = (UINT8) Value;
+        Back.Red        = (UINT8) (0xFF - Value);
+        Back.Reserved   = (UINT8) (Value & 1 ? 0xFF : Value);
+        Expected        = Back;
+
+        GuiBlendPixel (&Expected, &Front, (UINT8) Opacity);
+        GuiBlendRow (&Back, &Front, 1, (UINT8) Opacity);
+
+        if (memcmp (&Expected, &Back, sizeof (Back)) != 0) {
+          printf ("Mismatch for alpha %u opacity %u value %u\n", Alpha, Opacity, Value);
+          return FALSE;
+        }
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Front;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Back;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Expected;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Result;
+  UINT32                         Iterations;
+  UINT32                         Iteration;
+  UINT32                         Index;
+  UINT32                         Row;
+  UINT8                          Opacity;
+  clock_t                        Start;
+  clock_t                        PixelTime;
+  clock_t                        RowTime;
+
+  Iterations = 16;
+  if (argc > 1) {
+    Iterations = (UINT32) strtoul (argv[1], NULL, 0);
+  }
+
+  if (!CheckAllPixels ()) {
+    return -1;
+  }
+
+  Front    = malloc (FRAME_PIXELS * sizeof (*Front));
+  Back     = malloc (FRAME_PIXELS * sizeof (*Back));
+  Expected = malloc (FRAME_PIXELS * sizeof (*Expected));
+  Result   = malloc (FRAME_PIXELS * sizeof (*Result));
+  if (Front == NULL || Back == NULL || Expected == NULL || Result == NULL) {
+    return -1;
+  }
+
+  PixelTime = 0;
+  RowTime   = 0;
+
+  for (Iteration = 0; Iteration < Iterations; ++Iteration) {
+    FillFront (Front);
+    FillBack (Back);
+    memcpy (Expected, Back, FRAME_PIXELS * sizeof (*Back));
+    memcpy (Result, Back, FRAME_PIXELS * sizeof (*Back));
+
+    //
+    // Alternate full opacity used for static images and fading animation.
+    //
+    Opacity = (Iteration % 2) == 0 ? 0xFF : (UINT8) Random ();
+
+    Start = clock ();
+    for (Index = 0; Index < FRAME_PIXELS; ++Index) {
+      GuiBlendPixel (&Expected[Index], &Front[Index], Opacity);
+    }
+    PixelTime += clock () - Start;
+
+    Start = clock ();
+    for (Row = 0; Row < FRAME_HEIGHT; ++Row) {
+      GuiBlendRow (&Result[Row * FRAME_WIDTH], &Front[Row * FRAME_WIDTH], FRAME_WIDTH, Opacity);
+    }
+    RowTime += clock () - Start;
+
+    if (memcmp (Expected, Result, FRAME_PIXELS * sizeof (*Result)) != 0) {
+      printf ("Frame %u with opacity %u mismatches\n", Iteration, Opacity);
+      return -1;
+    }
+  }
+
+  printf (
+    "Blended %u frames, per pixel %lu ms, per row %lu ms\n",
+    Iterations,
+    (unsigned long) (PixelTime * 1000 / CLOCKS_PER_SEC),
+    (unsigned long) (RowTime * 1000 / CLOCKS_PER_SEC)
+    );
+
+  free (Front);
+  free (Back);
+  free (Expected);
+  free (Result);
+
+  return 0;
+}
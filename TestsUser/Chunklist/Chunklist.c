@@ -0,0 +1,334 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include "../Include/Uefi.h"
+
+#include <Library/OcAppleChunklistLib.h>
+#include <Library/OcAppleRamDiskLib.h>
+#include <Library/OcAppleKeysLib.h>
+#include <Library/OcCryptoLib.h>
+
+/**
+
+clang -g -fsanitize=undefined,address -Wno-incompatible-pointer-types-discards-qualifiers -fshort-wchar -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h Chunklist.c ../../Library/OcCryptoLib/Sha2.c ../../Library/OcCryptoLib/RsaDigitalSign.c ../../Library/OcCryptoLib/BigNumPrimitives.c ../../Library/OcCryptoLib/BigNumMontgomery.c ../../Library/OcCryptoLib/IA32/BigNumWordMul64.c ../../Library/OcCryptoLib/SecureMem.c ../../Library/OcAppleKeysLib/OcAppleKeysLib.c ../../Library/OcAppleChunklistLib/OcAppleChunklistLib.c ../../Library/OcAppleRamDiskLib/OcAppleRamDiskLib.c ../../Library/OcFileLib/OpenFile.c ../../Library/OcFileLib/FileProtocol.c -o Chunklist
+
+./Chunklist BaseSystem.dmg BaseSystem.chunklist
+
+Use -O2 without sanitizers for meaningful throughput numbers.
+Both in place and fused (verifying while loading) paths are measured.
+
+**/
+
+#define NUM_EXTENTS 20
+
+#define LOAD_BUFFER_SIZE  BASE_4MB
+
+EFI_GUID gOcVendorVariableGuid;
+
+uint8_t *readFile(const char *str, long *size) {
+  FILE *f = fopen(str, "rb");
+
+  if (!f) return NULL;
+
+  fseek(f, 0, SEEK_END);
+  long fsize = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  uint8_t *string = malloc(fsize + 1);
+  fread(string, fsize, 1, f);
+  fclose(f);
+
+  string[fsize] = 0;
+  *size = fsize;
+
+  return string;
+}
+
+STATIC
+BOOLEAN
+VerifyCopied (
+  IN OC_APPLE_CHUNKLIST_CONTEXT  *Context,
+  IN CONST UINT8                 *Data,
+  IN UINTN                       DataSize
+  )
+{
+  UINTN  Index;
+  UINTN  Offset;
+  UINT8  *ChunkData;
+  UINT8  ChunkHash[SHA256_DIGEST_SIZE];
+
+  //
+  // Reference implementation copying every chunk before hashing it.
+  //
+  Offset = 0;
+  for (Index = 0; Index < Context->ChunkCount; ++Index) {
+    if (DataSize - Offset < Context->Chunks[Index].Length) {
+      return FALSE;
+    }
+
+    ChunkData = malloc (Context->Chunks[Index].Length);
+    if (ChunkData == NULL) {
+      return FALSE;
+    }
+
+    memcpy (ChunkData, Data + Offset, Context->Chunks[Index].Length);
+    Sha256 (ChunkHash, ChunkData, Context->Chunks[Index].Length);
+    free (ChunkData);
+
+    if (memcmp (ChunkHash, Context->Chunks[Index].Checksum, SHA256_DIGEST_SIZE) != 0) {
+      return FALSE;
+    }
+
+    Offset += Context->Chunks[Index].Length;
+  }
+
+  return TRUE;
+}
+
+/**
+  Load data like OcAppleRamDiskLoadFile does, optionally verifying it
+  on the fly.
+
+  @retval Amount of data loaded, less than DataSize on verification failure.
+**/
+STATIC
+UINTN
+LoadData (
+  IN OC_APPLE_CHUNKLIST_CONTEXT  *Context  OPTIONAL,
+  IN CONST UINT8                 *Data,
+  IN UINTN                       DataSize,
+  IN UINTN                       StepSize,
+  IN UINT8                       *Buffer,
+  IN UINT8                       *Target
+  )
+{
+  UINTN  Offset;
+  UINTN  Size;
+
+  if (Context != NULL) {
+    OcAppleChunklistVerifyStreamStart (Context);
+  }
+
+  for (Offset = 0; Offset < DataSize; Offset += Size) {
+    Size = MIN (StepSize, DataSize - Offset);
+    memcpy (Buffer, Data + Offset, Size);
+
+    if (Context != NULL && !OcAppleChunklistVerifyStreamUpdate (Context, Buffer, Size)) {
+      return Offset;
+    }
+
+    memcpy (Target + Offset, Buffer, Size);
+  }
+
+  return DataSize;
+}
+
+STATIC
+UINT64
+ElapsedMs (
+  IN UINT64  StartTime
+  )
+{
+  return (GetPerformanceCounter () - StartTime) / 1000000ULL;
+}
+
+int main (int argc, char *argv[]) {
+  if (argc != 3) {
+    printf ("Usage: %s <dmg> <chunklist>\n", argv[0]);
+    return -1;
+  }
+
+  int     Status = -1;
+  uint8_t *Dmg;
+  long    DmgSize;
+
+  uint8_t *Chunklist = NULL;
+  long    ChunklistSize;
+
+  UINT8   *LoadBuffer = NULL;
+  UINT8   *Target     = NULL;
+
+  if ((Dmg = readFile (argv[1], &DmgSize)) == NULL
+    || (Chunklist = readFile (argv[2], &ChunklistSize)) == NULL) {
+    printf ("Read fail\n");
+    goto Done;
+  }
+
+  BOOLEAN                    Result;
+  OC_APPLE_CHUNKLIST_CONTEXT ChunklistContext;
+  APPLE_RAM_DISK_EXTENT_TABLE ExtentTable;
+  OC_APPLE_RAM_DISK_CONTEXT  RamDisk;
+  UINT32                     Index;
+  UINTN                      Step;
+  UINT64                     StartTime;
+  UINT64                     CopyMs;
+  UINT64                     InPlaceMs;
+  UINT64                     TwoPassMs;
+  UINT64                     FusedMs;
+  UINTN                      Loaded;
+
+  Result = OcAppleChunklistInitializeContext (&ChunklistContext, Chunklist, ChunklistSize);
+  if (!Result) {
+    printf ("Chunklist Context initialization error\n");
+    goto Done;
+  }
+
+  Result = OcAppleChunklistVerifySignature (&ChunklistContext, PkDataBase[0].PublicKey);
+  if (!Result) {
+    printf ("Chunklist signature verification error\n");
+    goto Done;
+  }
+
+  //
+  // Split the image at odd offsets so that chunks cross extent boundaries.
+  //
+  ExtentTable.Signature   = APPLE_RAM_DISK_EXTENT_SIGNATURE;
+  ExtentTable.Version     = APPLE_RAM_DISK_EXTENT_VERSION;
+  ExtentTable.Reserved    = 0;
+  ExtentTable.Signature2  = APPLE_RAM_DISK_EXTENT_SIGNATURE;
+  ExtentTable.ExtentCount = MIN (NUM_EXTENTS, ARRAY_SIZE (ExtentTable.Extents));
+
+  if ((UINTN) DmgSize <= (UINTN) ExtentTable.ExtentCount * ExtentTable.ExtentCount) {
+    ExtentTable.ExtentCount = 1;
+  }
+
+  Step = (DmgSize / ExtentTable.ExtentCount) | 1U;
+  for (Index = 0; Index < ExtentTable.ExtentCount; ++Index) {
+    ExtentTable.Extents[Index].Start  = (uintptr_t) Dmg + Index * Step;
+    ExtentTable.Extents[Index].Length = Step;
+  }
+  ExtentTable.Extents[Index - 1].Length = DmgSize - (Index - 1) * Step;
+
+  Result = OcAppleRamDiskInitializeContext (&RamDisk, &ExtentTable);
+  if (!Result) {
+    printf ("RAM disk context initialization error\n");
+    goto Done;
+  }
+
+  StartTime = GetPerformanceCounter ();
+  Result    = VerifyCopied (&ChunklistContext, Dmg, DmgSize);
+  CopyMs    = ElapsedMs (StartTime);
+  if (!Result) {
+    printf ("Reference chunk verification error\n");
+    goto Done;
+  }
+
+  StartTime = GetPerformanceCounter ();
+  Result    = OcAppleChunklistVerifyData (&ChunklistContext, &RamDisk);
+  InPlaceMs = ElapsedMs (StartTime);
+  if (!Result) {
+    printf ("Chunk verification error\n");
+    goto Done;
+  }
+
+  printf (
+    "Verified %ld bytes in %u extents: copy %llu ms, in place %llu ms\n",
+    DmgSize,
+    ExtentTable.ExtentCount,
+    (unsigned long long) CopyMs,
+    (unsigned long long) InPlaceMs
+    );
+
+  //
+  // Damage the byte at the first extent boundary and ensure it is caught.
+  //
+  Dmg[Step % DmgSize] ^= 0xFFU;
+  Result = OcAppleChunklistVerifyData (&ChunklistContext, &RamDisk);
+  Dmg[Step % DmgSize] ^= 0xFFU;
+  if (Result) {
+    printf ("Corrupted data passed verification\n");
+    goto Done;
+  }
+
+  //
+  // Compare loading followed by verification with verifying during loading.
+  //
+  LoadBuffer = malloc (LOAD_BUFFER_SIZE);
+  Target     = malloc (DmgSize);
+  if (LoadBuffer == NULL || Target == NULL) {
+    printf ("Load buffer allocation error\n");
+    goto Done;
+  }
+
+  ExtentTable.ExtentCount       = 1;
+  ExtentTable.Extents[0].Start  = (uintptr_t) Target;
+  ExtentTable.Extents[0].Length = DmgSize;
+  Result = OcAppleRamDiskInitializeContext (&RamDisk, &ExtentTable);
+  if (!Result) {
+    printf ("Target RAM disk context initialization error\n");
+    goto Done;
+  }
+
+  StartTime = GetPerformanceCounter ();
+  Loaded    = LoadData (NULL, Dmg, DmgSize, LOAD_BUFFER_SIZE, LoadBuffer, Target);
+  Result    = Loaded == (UINTN) DmgSize && OcAppleChunklistVerifyData (&ChunklistContext, &RamDisk);
+  TwoPassMs = ElapsedMs (StartTime);
+  if (!Result) {
+    printf ("Two pass verification error\n");
+    goto Done;
+  }
+
+  StartTime = GetPerformanceCounter ();
+  Loaded    = LoadData (&ChunklistContext, Dmg, DmgSize, LOAD_BUFFER_SIZE, LoadBuffer, Target);
+  Result    = Loaded == (UINTN) DmgSize && OcAppleChunklistVerifyStreamEnd (&ChunklistContext);
+  FusedMs   = ElapsedMs (StartTime);
+  if (!Result) {
+    printf ("Fused verification error\n");
+    goto Done;
+  }
+
+  printf (
+    "Loaded and verified %ld bytes: two pass %llu ms, fused %llu ms\n",
+    DmgSize,
+    (unsigned long long) TwoPassMs,
+    (unsigned long long) FusedMs
+    );
+
+  //
+  // Odd step sizes make chunks cross buffer boundaries.
+  //
+  Loaded = LoadData (&ChunklistContext, Dmg, DmgSize, 4093, LoadBuffer, Target);
+  if (Loaded != (UINTN) DmgSize || !OcAppleChunklistVerifyStreamEnd (&ChunklistContext)) {
+    printf ("Odd step verification error\n");
+    goto Done;
+  }
+
+  //
+  // Truncated data must not pass, damaged data must fail in its chunk.
+  //
+  Loaded = LoadData (&ChunklistContext, Dmg, DmgSize - 1, 4093, LoadBuffer, Target);
+  if (Loaded != (UINTN) DmgSize - 1 || OcAppleChunklistVerifyStreamEnd (&ChunklistContext)) {
+    printf ("Truncated data passed verification\n");
+    goto Done;
+  }
+
+  Dmg[0] ^= 0xFFU;
+  Loaded = LoadData (&ChunklistContext, Dmg, DmgSize, 4093, LoadBuffer, Target);
+  Dmg[0] ^= 0xFFU;
+  if (Loaded > ChunklistContext.Chunks[0].Length || Loaded + 4093 < ChunklistContext.Chunks[0].Length) {
+    printf ("Corrupted data was not caught in its chunk - %lu\n", (unsigned long) Loaded);
+    goto Done;
+  }
+
+  printf ("Success...\n");
+  Status = 0;
+
+Done:
+  free (Dmg);
+  free (Chunklist);
+  free (LoadBuffer);
+  free (Target);
+
+  return Status;
+}
@@ -0,0 +1,310 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+/*
+clang -g -O2 -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h DataPatcher.c ../../Library/OcMiscLib/DataPatcher.c -o DataPatcher
+
+./DataPatcher [rounds]
+
+Applies random patch sets to random data with ApplyPatches and with
+sequential ApplyPatch calls, and checks that both produce identical data
+and replacement counts. Patch sets include overlapping and identical
+patterns, pattern and replacement masks, replacement limits, skipped
+matches, search ranges and patterns at data boundaries.
+*/
+
+#include <Base.h>
+
+#include <Library/OcMiscLib.h>
+
+#define MAX_DATA_SIZE    4096
+#define MAX_PATCHES      16
+#define MAX_PATTERN_SIZE 12
+
+STATIC UINT8  mPatterns[MAX_PATCHES][MAX_PATTERN_SIZE];
+STATIC UINT8  mPatternMasks[MAX_PATCHES][MAX_PATTERN_SIZE];
+STATIC UINT8  mReplaces[MAX_PATCHES][MAX_PATTERN_SIZE];
+STATIC UINT8  mReplaceMasks[MAX_PATCHES][MAX_PATTERN_SIZE];
+
+STATIC
+UINT32
+Random (
+  IN UINT32  Limit
+  )
+{
+  return (UINT32) rand () % Limit;
+}
+
+/**
+  Pick a random pattern source offset, preferring data boundaries.
+**/
+STATIC
+UINT32
+RandomPatternOffset (
+  IN UINT32  DataSize,
+  IN UINT32  Size
+  )
+{
+  switch (Random (4)) {
+    case 0:
+      return 0;
+    case 1:
+      return DataSize - Size;
+    case 2:
+      return DataSize - Size - MIN (DataSize - Size, 1);
+    default:
+      return Random (DataSize - Size + 1);
+  }
+}
+
+STATIC
+VOID
+RandomPatch (
+  OUT OC_DATA_PATCH  *Patches,
+  IN  UINT32         Index,
+  IN  CONST UINT8    *Data,
+  IN  UINT32         DataSize,
+  IN  UINT8          Alphabet
+  )
+{
+  OC_DATA_PATCH  *Patch;
+  UINT32         Offset;
+  UINT32         Index2;
+
+  Patch = &Patches[Index];
+  ZeroMem (Patch, sizeof (*Patch));
+
+  //
+  // Repeat or shift an earlier pattern to get identical and overlapping ones.
+  //
+  if (Index > 0 && Random (4) == 0) {
+    CopyMem (Patch, &Patches[Random (Index)], sizeof (*Patch));
+    CopyMem (mPatterns[Index], Patch->Pattern, Patch->Size);
+    if (Random (2) == 0 && Patch->Size > 1) {
+      CopyMem (mPatterns[Index], Patch->Pattern + 1, Patch->Size - 1);
+      mPatterns[Index][Patch->Size - 1] = (UINT8) Random (Alphabet);
+    }
+    if (Patch->PatternMask != NULL) {
+      CopyMem (mPatternMasks[Index], Patch->PatternMask, Patch->Size);
+      Patch->PatternMask = mPatternMasks[Index];
+    }
+    Patch->Pattern = mPatterns[Index];
+  } else {
+    Patch->Size = 1 + Random (MAX_PATTERN_SIZE);
+    Patch->Size = MIN (Patch->Size, DataSize);
+    if (Random (8) == 0) {
+      for (Index2 = 0; Index2 < Patch->Size; ++Index2) {
+        mPatterns[Index][Index2] = (UINT8) Random (Alphabet);
+      }
+    } else {
+      Offset = RandomPatternOffset (DataSize, Patch->Size);
+      CopyMem (mPatterns[Index], &Data[Offset], Patch->Size);
+    }
+
+    Patch->Pattern = mPatterns[Index];
+
+    if (Random (3) == 0) {
+      for (Index2 = 0; Index2 < Patch->Size; ++Index2) {
+        mPatternMasks[Index][Index2] = Random (3) == 0 ? (UINT8) Random (256) : 0xFFU;
+        mPatterns[Index][Index2] &= mPatternMasks[Index][Index2];
+      }
+      Patch->PatternMask = mPatternMasks[Index];
+    }
+  }
+
+  //
+  // Replacements use the same alphabet, so that they create new matches.
+  //
+  for (Index2 = 0; Index2 < Patch->Size; ++Index2) {
+    mReplaces[Index][Index2]     = (UINT8) Random (Alphabet);
+    mReplaceMasks[Index][Index2] = (UINT8) Random (256);
+  }
+
+  Patch->Replace     = mReplaces[Index];
+  Patch->ReplaceMask = Random (3) == 0 ? mReplaceMasks[Index] : NULL;
+  Patch->Count       = Random (2) == 0 ? 0 : 1 + Random (4);
+  Patch->Skip        = Random (2) == 0 ? 0 : Random (4);
+
+  switch (Random (6)) {
+    case 0:
+      Patch->DataOff  = Random (DataSize + 1);
+      Patch->DataSize = Random (DataSize - Patch->DataOff + 1);
+      break;
+    case 1:
+      Patch->DataOff  = 0;
+      Patch->DataSize = Random (DataSize + 1);
+      break;
+    case 2:
+      Patch->DataOff  = Random (DataSize + 1);
+      Patch->DataSize = DataSize - Patch->DataOff;
+      break;
+    case 3:
+      //
+      // Invalid range, must be ignored.
+      //
+      Patch->DataOff  = Random (DataSize + 1);
+      Patch->DataSize = DataSize - Patch->DataOff + 1 + Random (4);
+      break;
+    default:
+      Patch->DataOff  = 0;
+      Patch->DataSize = DataSize;
+      break;
+  }
+}
+
+/**
+  Apply patches one by one like ApplyPatches is specified to do.
+**/
+STATIC
+VOID
+ApplyPatchesSequential (
+  IN  CONST OC_DATA_PATCH  *Patches,
+  IN  UINT32               PatchCount,
+  OUT UINT32               *ReplaceCounts,
+  IN  UINT8                *Data,
+  IN  UINT32               DataSize
+  )
+{
+  CONST OC_DATA_PATCH  *Patch;
+  UINT32               Index;
+
+  for (Index = 0; Index < PatchCount; ++Index) {
+    Patch = &Patches[Index];
+    ReplaceCounts[Index] = 0;
+
+    if (Patch->DataOff > DataSize || Patch->DataSize > DataSize - Patch->DataOff) {
+      continue;
+    }
+
+    ReplaceCounts[Index] = ApplyPatch (
+      Patch->Pattern,
+      Patch->PatternMask,
+      Patch->Size,
+      Patch->Replace,
+      Patch->ReplaceMask,
+      &Data[Patch->DataOff],
+      Patch->DataSize,
+      Patch->Count,
+      Patch->Skip
+      );
+  }
+}
+
+STATIC
+VOID
+PrintPatches (
+  IN CONST OC_DATA_PATCH  *Patches,
+  IN UINT32               PatchCount,
+  IN CONST UINT32         *ReplaceCounts
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < PatchCount; ++Index) {
+    printf (
+      "  Patch %u: size %u mask %d/%d range %u+%u count %u skip %u replaced %u vs %u\n",
+      Index,
+      Patches[Index].Size,
+      Patches[Index].PatternMask != NULL,
+      Patches[Index].ReplaceMask != NULL,
+      Patches[Index].DataOff,
+      Patches[Index].DataSize,
+      Patches[Index].Count,
+      Patches[Index].Skip,
+      Patches[Index].ReplaceCount,
+      ReplaceCounts[Index]
+      );
+  }
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  OC_DATA_PATCH  Patches[MAX_PATCHES];
+  UINT32         ReplaceCounts[MAX_PATCHES];
+  UINT8          *Original;
+  UINT8          *Data;
+  UINT8          *Expected;
+  UINT32         DataSize;
+  UINT32         PatchCount;
+  UINT32         Rounds;
+  UINT32         Round;
+  UINT32         Index;
+  UINT32         Replaced;
+  UINT8          Alphabet;
+
+  Rounds = argc > 1 ? (UINT32) atoi (argv[1]) : 100000;
+  srand (0);
+
+  Original = AllocatePool (MAX_DATA_SIZE);
+  Data     = AllocatePool (MAX_DATA_SIZE);
+  Expected = AllocatePool (MAX_DATA_SIZE);
+  if (Original == NULL || Data == NULL || Expected == NULL) {
+    printf ("Allocation failure\n");
+    return -1;
+  }
+
+  Replaced = 0;
+
+  for (Round = 0; Round < Rounds; ++Round) {
+    //
+    // Small alphabets produce many overlapping matches.
+    //
+    DataSize   = 1 + Random (Random (8) == 0 ? MAX_DATA_SIZE : 64);
+    Alphabet   = (UINT8) (Random (4) == 0 ? 255 : 2 + Random (3));
+    PatchCount = 1 + Random (MAX_PATCHES);
+
+    for (Index = 0; Index < DataSize; ++Index) {
+      Original[Index] = (UINT8) Random (Alphabet);
+    }
+
+    for (Index = 0; Index < PatchCount; ++Index) {
+      RandomPatch (Patches, Index, Original, DataSize, Alphabet);
+    }
+
+    CopyMem (Expected, Original, DataSize);
+    ApplyPatchesSequential (Patches, PatchCount, ReplaceCounts, Expected, DataSize);
+
+    CopyMem (Data, Original, DataSize);
+    if (!ApplyPatches (Patches, PatchCount, Data, DataSize)) {
+      printf ("Round %u: ApplyPatches failure\n", Round);
+      return -1;
+    }
+
+    for (Index = 0; Index < PatchCount; ++Index) {
+      if (Patches[Index].ReplaceCount != ReplaceCounts[Index]) {
+        break;
+      }
+      Replaced += ReplaceCounts[Index];
+    }
+
+    if (Index < PatchCount || CompareMem (Data, Expected, DataSize) != 0) {
+      printf ("Round %u: %u patches on %u bytes mismatch\n", Round, PatchCount, DataSize);
+      PrintPatches (Patches, PatchCount, ReplaceCounts);
+      return -1;
+    }
+  }
+
+  printf ("%u rounds with %u replacements matched\n", Rounds, Replaced);
+
+  FreePool (Original);
+  FreePool (Data);
+  FreePool (Expected);
+
+  printf ("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,309 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+/*
+clang -g -O2 -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h Hash.c ../../Library/OcCryptoLib/Md5.c ../../Library/OcCryptoLib/Sha1.c ../../Library/OcCryptoLib/Sha2.c ../../Library/OcCryptoLib/SecureMem.c -o Hash
+
+./Hash [megabytes]
+
+Checks MD5, SHA-1 and SHA-2 against known answers, compares digests of random
+length messages fed in random chunks and byte by byte with one-shot digests,
+and reports hashing throughput for bulk and byte by byte updates.
+
+SHA-256 uses SHA extensions when the host supports them. To check the portable
+implementation on such hosts add -DOC_CRYPTO_SHA_NI=0 to the build command.
+*/
+
+#include <Base.h>
+
+#include <Library/OcCryptoLib.h>
+
+typedef union {
+  MD5_CONTEXT     Md5;
+  SHA1_CONTEXT    Sha1;
+  SHA256_CONTEXT  Sha256;
+  SHA384_CONTEXT  Sha384;
+  SHA512_CONTEXT  Sha512;
+} HASH_CONTEXT;
+
+typedef VOID (*HASH_INIT) (VOID *Context);
+typedef VOID (*HASH_UPDATE) (VOID *Context, CONST UINT8 *Data, UINTN Len);
+typedef VOID (*HASH_FINAL) (VOID *Context, UINT8 *HashDigest);
+
+typedef struct {
+  CONST CHAR8  *Name;
+  UINT32       DigestSize;
+  HASH_INIT    Init;
+  HASH_UPDATE  Update;
+  HASH_FINAL   Final;
+  CONST CHAR8  *Abc;
+  CONST CHAR8  *TwoBlock;
+  CONST CHAR8  *Million;
+} HASH_ALGORITHM;
+
+STATIC CONST CHAR8  mTwoBlockMessage[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+STATIC HASH_ALGORITHM  mAlgorithms[] = {
+  {
+    "MD5",
+    MD5_DIGEST_SIZE,
+    (HASH_INIT) Md5Init,
+    (HASH_UPDATE) Md5Update,
+    (HASH_FINAL) Md5Final,
+    "900150983cd24fb0d6963f7d28e17f72",
+    "8215ef0796a20bcaaae116d3876c664a",
+    "7707d6ae4e027c70eea2a935c2296f21"
+  },
+  {
+    "SHA-1",
+    SHA1_DIGEST_SIZE,
+    (HASH_INIT) Sha1Init,
+    (HASH_UPDATE) Sha1Update,
+    (HASH_FINAL) Sha1Final,
+    "a9993e364706816aba3e25717850c26c9cd0d89d",
+    "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+    "34aa973cd4c4daa4f61eeb2bdbad27316534016f"
+  },
+  {
+    "SHA-256",
+    SHA256_DIGEST_SIZE,
+    (HASH_INIT) Sha256Init,
+    (HASH_UPDATE) Sha256Update,
+    (HASH_FINAL) Sha256Final,
+    "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+    "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+    "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+  },
+  {
+    "SHA-384",
+    SHA384_DIGEST_SIZE,
+    (HASH_INIT) Sha384Init,
+    (HASH_UPDATE) Sha384Update,
+    (HASH_FINAL) Sha384Final,
+    "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+    "3391fdddfc8dc7393707a65b1b4709397cf8b1d162af05abfe8f450de5f36bc6b0455a8520bc4e6f5fe95b1fe3c8452b",
+    "9d0e1809716474cb086e834e310a4a1ced149e9c00f248527972cec5704c2a5b07b8b3dc38ecc4ebae97ddd87f3d8985"
+  },
+  {
+    "SHA-512",
+    SHA512_DIGEST_SIZE,
+    (HASH_INIT) Sha512Init,
+    (HASH_UPDATE) Sha512Update,
+    (HASH_FINAL) Sha512Final,
+    "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+    "204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c33596fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445",
+    "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b"
+  }
+};
+
+STATIC
+VOID
+HashData (
+  IN  CONST HASH_ALGORITHM  *Algorithm,
+  IN  CONST UINT8           *Data,
+  IN  UINTN                 Len,
+  IN  UINTN                 ChunkLen,
+  OUT UINT8                 *Digest
+  )
+{
+  HASH_CONTEXT  Context;
+  UINTN         Offset;
+  UINTN         Size;
+
+  Algorithm->Init (&Context);
+
+  //
+  // Zero chunk length means random chunks.
+  //
+  for (Offset = 0; Offset < Len; Offset += Size) {
+    Size = ChunkLen != 0 ? ChunkLen : (UINTN) (rand () % 300);
+    Size = MIN (Size, Len - Offset);
+    Algorithm->Update (&Context, &Data[Offset], Size);
+  }
+
+  Algorithm->Final (&Context, Digest);
+}
+
+STATIC
+BOOLEAN
+CheckDigest (
+  IN CONST HASH_ALGORITHM  *Algorithm,
+  IN CONST UINT8           *Digest,
+  IN CONST CHAR8           *Expected
+  )
+{
+  CHAR8   String[OC_MAX_SHA_DIGEST_SIZE * 2 + 1];
+  UINT32  Index;
+
+  for (Index = 0; Index < Algorithm->DigestSize; ++Index) {
+    snprintf (&String[Index * 2], 3, "%02x", Digest[Index]);
+  }
+
+  return strcmp (String, Expected) == 0;
+}
+
+STATIC
+BOOLEAN
+CheckKnownAnswers (
+  IN CONST HASH_ALGORITHM  *Algorithm,
+  IN CONST UINT8           *Million
+  )
+{
+  UINT8  Digest[OC_MAX_SHA_DIGEST_SIZE];
+
+  HashData (Algorithm, (CONST UINT8 *) "abc", 3, 3, Digest);
+  if (!CheckDigest (Algorithm, Digest, Algorithm->Abc)) {
+    return FALSE;
+  }
+
+  HashData (Algorithm, (CONST UINT8 *) mTwoBlockMessage, sizeof (mTwoBlockMessage) - 1, 1, Digest);
+  if (!CheckDigest (Algorithm, Digest, Algorithm->TwoBlock)) {
+    return FALSE;
+  }
+
+  HashData (Algorithm, Million, 1000000, 1000000, Digest);
+  if (!CheckDigest (Algorithm, Digest, Algorithm->Million)) {
+    return FALSE;
+  }
+
+  HashData (Algorithm, Million, 1000000, 0, Digest);
+  return CheckDigest (Algorithm, Digest, Algorithm->Million);
+}
+
+STATIC
+BOOLEAN
+CheckRandomLengths (
+  IN CONST HASH_ALGORITHM  *Algorithm,
+  IN CONST UINT8           *Data,
+  IN UINTN                 DataLen
+  )
+{
+  UINT8   Digest[OC_MAX_SHA_DIGEST_SIZE];
+  UINT8   ChunkDigest[OC_MAX_SHA_DIGEST_SIZE];
+  UINT8   ByteDigest[OC_MAX_SHA_DIGEST_SIZE];
+  UINTN   Offset;
+  UINTN   Len;
+  UINT32  Index;
+
+  for (Index = 0; Index < 2000; ++Index) {
+    Len    = (UINTN) rand () % (Index < 1000 ? 300 : 5000);
+    Offset = (UINTN) rand () % (DataLen - Len);
+
+    //
+    // Byte by byte updates only ever go through the buffered path, while
+    // one-shot updates mostly take the full block path.
+    //
+    HashData (Algorithm, &Data[Offset], Len, Len, Digest);
+    HashData (Algorithm, &Data[Offset], Len, 0, ChunkDigest);
+    HashData (Algorithm, &Data[Offset], Len, 1, ByteDigest);
+
+    if (CompareMem (Digest, ChunkDigest, Algorithm->DigestSize) != 0
+      || CompareMem (Digest, ByteDigest, Algorithm->DigestSize) != 0) {
+      printf ("%s mismatch at offset %u length %u\n", Algorithm->Name, (UINT32) Offset, (UINT32) Len);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+UINT64
+MeasureThroughput (
+  IN CONST HASH_ALGORITHM  *Algorithm,
+  IN CONST UINT8           *Data,
+  IN UINTN                 DataLen,
+  IN UINTN                 ChunkLen
+  )
+{
+  UINT8   Digest[OC_MAX_SHA_DIGEST_SIZE];
+  UINT64  StartTime;
+  UINT64  Time;
+
+  StartTime = GetPerformanceCounter ();
+  HashData (Algorithm, Data, DataLen, ChunkLen, Digest);
+  Time = GetTimeInNanoSecond (GetPerformanceCounter () - StartTime);
+
+  //
+  // Megabytes per second.
+  //
+  return Time != 0 ? ((UINT64) DataLen * 1000000000ULL) / (Time * 1024 * 1024) : 0;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  UINT8   *Data;
+  UINTN   DataLen;
+  UINTN   Index;
+  UINT32  Failures;
+  UINT32  FeatureEbx;
+
+  DataLen = (argc > 1 ? (UINTN) atoi (argv[1]) : 64) * 1024 * 1024;
+  if (DataLen < 1000000) {
+    DataLen = 1000000;
+  }
+
+  Data = AllocatePool (DataLen);
+  if (Data == NULL) {
+    return -1;
+  }
+
+  srand (0);
+  Failures = 0;
+
+  AsmCpuidEx (7, 0, NULL, &FeatureEbx, NULL, NULL);
+  printf ("Host SHA extensions are %s\n", (FeatureEbx & BIT29) != 0 ? "supported" : "unsupported");
+
+  for (Index = 0; Index < ARRAY_SIZE (mAlgorithms); ++Index) {
+    SetMem (Data, 1000000, 'a');
+    if (!CheckKnownAnswers (&mAlgorithms[Index], Data)) {
+      printf ("%s known answer mismatch\n", mAlgorithms[Index].Name);
+      ++Failures;
+    }
+  }
+
+  for (Index = 0; Index < DataLen; ++Index) {
+    Data[Index] = (UINT8) rand ();
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mAlgorithms); ++Index) {
+    if (!CheckRandomLengths (&mAlgorithms[Index], Data, DataLen)) {
+      ++Failures;
+    }
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mAlgorithms); ++Index) {
+    printf (
+      "%-8s %5llu MB/s bulk, %5llu MB/s 4K chunks, %5llu MB/s byte by byte\n",
+      mAlgorithms[Index].Name,
+      (unsigned long long) MeasureThroughput (&mAlgorithms[Index], Data, DataLen, DataLen),
+      (unsigned long long) MeasureThroughput (&mAlgorithms[Index], Data, DataLen, SIZE_4KB),
+      (unsigned long long) MeasureThroughput (&mAlgorithms[Index], Data, DataLen / 16, 1)
+      );
+  }
+
+  FreePool (Data);
+
+  if (Failures > 0) {
+    printf ("%u tests failed\n", Failures);
+    return -1;
+  }
+
+  printf ("All tests passed\n");
+  return 0;
+}
@@ -32,6 +32,7 @@
 #include <stddef.h>
 #include <assert.h>
 #include <cpuid.h>
+#include <time.h>
 
 #ifndef RSIZE_MAX
 #define RSIZE_MAX (SIZE_MAX >> 1)
@@ -865,6 +866,39 @@ GetPerformanceCounterProperties (
   return 0;
 }
 
+STATIC
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  clock_gettime (CLOCK_MONOTONIC, &Time);
+  return (UINT64) Time.tv_sec * 1000000000ULL + (UINT64) Time.tv_nsec;
+}
+
+STATIC
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  UINT64  Ticks
+  )
+{
+  return Ticks;
+}
+
+STATIC
+UINT64
+EFIAPI
+AsmReadTsc (
+  VOID
+  )
+{
+  return GetPerformanceCounter ();
+}
+
 STATIC
 UINTN
 StrLen (
@@ -1721,6 +1755,7 @@ struct EFI_BOOT_SERVICES_ {
 
 typedef EFI_STATUS (*EFI_GET_VARIABLE)(CHAR16 *VariableName, EFI_GUID *VendorGuid, UINT32 *Attributes, UINTN *DataSize, VOID *Data);
 typedef EFI_STATUS (*EFI_SET_VARIABLE)(CHAR16 *VariableName, EFI_GUID *VendorGuid, UINT32 Attributes, UINTN DataSize, VOID *Data);
+typedef EFI_STATUS (*EFI_GET_NEXT_VARIABLE_NAME)(UINTN *VariableNameSize, CHAR16 *VariableName, EFI_GUID *VendorGuid);
 
 struct EFI_RUNTIME_SERVICES_ {
   EFI_GET_VARIABLE GetVariable;
@@ -0,0 +1,313 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <IndustryStandard/AppleCompressedBinaryImage.h>
+#include <IndustryStandard/AppleFatBinaryImage.h>
+
+#include <Library/OcAppleKernelLib.h>
+#include <Library/OcCompressionLib.h>
+
+/**
+
+clang -g -fsanitize=undefined,address -Wno-incompatible-pointer-types-discards-qualifiers -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h KernelReader.c ../../Library/OcAppleKernelLib/KernelReader.c ../../Library/OcCompressionLib/DecompressStream.c ../../Library/OcCompressionLib/lzss/lzss.c ../../Library/OcCompressionLib/lzvn/lzvn.c ../../Library/OcCompressionLib/zlib/adler32.c -o KernelReader
+
+./KernelReader /System/Library/PrelinkedKernels/prelinkedkernel
+
+Uncompressed kernels, e.g. /System/Library/Kernels/kernel, are compressed
+with LZSS first. Without arguments a synthetic kernel is used.
+
+Use -O2 without sanitizers for meaningful timings.
+
+**/
+
+#define NUM_ITERATIONS 10
+
+STATIC EFI_FILE_PROTOCOL  mNilFileProtocol;
+STATIC UINT8              *mFile;
+STATIC UINT32             mFileSize;
+
+EFI_STATUS
+GetFileData (
+  IN  EFI_FILE_PROTOCOL  *File,
+  IN  UINT32             Position,
+  IN  UINT32             Size,
+  OUT UINT8              *Buffer
+  )
+{
+  ASSERT (File == &mNilFileProtocol);
+
+  if ((UINT64) Position + Size > mFileSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  memcpy (Buffer, &mFile[Position], Size);
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+GetFileSize (
+  IN  EFI_FILE_PROTOCOL  *File,
+  OUT UINT32             *Size
+  )
+{
+  ASSERT (File == &mNilFileProtocol);
+  *Size = mFileSize;
+  return EFI_SUCCESS;
+}
+
+uint8_t *readFile(const char *str, uint32_t *size) {
+  FILE *f = fopen(str, "rb");
+
+  if (!f) return NULL;
+
+  fseek(f, 0, SEEK_END);
+  long fsize = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  uint8_t *string = malloc(fsize + 1);
+  fread(string, fsize, 1, f);
+  fclose(f);
+
+  string[fsize] = 0;
+  *size = fsize;
+
+  return string;
+}
+
+STATIC
+UINT8 *
+SyntheticKernel (
+  OUT UINT32  *Size
+  )
+{
+  UINT8   *Kernel;
+  UINT32  Index;
+  UINT32  Seed;
+
+  //
+  // Repetitive data with some noise compresses like code does.
+  //
+  *Size  = 8 * 1024 * 1024;
+  Kernel = malloc (*Size);
+  if (Kernel == NULL) {
+    return NULL;
+  }
+
+  Seed = 0x12345678;
+  for (Index = 0; Index < *Size; ++Index) {
+    Seed = Seed * 1103515245U + 12345U;
+    Kernel[Index] = (Seed >> 24) < 64 ? (UINT8) (Seed >> 16) : Kernel[Index - MIN (Index, 1 + (Seed >> 29) * 37)];
+  }
+
+  *(UINT32 *) Kernel = MACH_HEADER_64_SIGNATURE;
+  return Kernel;
+}
+
+STATIC
+UINT8 *
+CompressKernel (
+  IN  UINT8   *Kernel,
+  IN  UINT32  KernelSize,
+  OUT UINT32  *Size
+  )
+{
+  MACH_COMP_HEADER  *Header;
+  UINT8             *Image;
+  UINT8             *End;
+  UINT32            MaxSize;
+
+  MaxSize = sizeof (*Header) + KernelSize + KernelSize / 8 + 16;
+  Image   = calloc (1, MaxSize);
+  if (Image == NULL) {
+    return NULL;
+  }
+
+  End = CompressLZSS (Image + sizeof (*Header), MaxSize - sizeof (*Header), Kernel, KernelSize);
+  if (End == NULL) {
+    free (Image);
+    return NULL;
+  }
+
+  Header               = (MACH_COMP_HEADER *) Image;
+  Header->Signature    = MACH_COMPRESSED_BINARY_INVERT_SIGNATURE;
+  Header->Compression  = MACH_COMPRESSED_BINARY_INVERT_LZSS;
+  Header->Hash         = SwapBytes32 (Adler32 (1, Kernel, KernelSize));
+  Header->Decompressed = SwapBytes32 (KernelSize);
+  Header->Compressed   = SwapBytes32 ((UINT32) (End - Image - sizeof (*Header)));
+
+  *Size = (UINT32) (End - Image);
+  return Image;
+}
+
+STATIC
+MACH_COMP_HEADER *
+FindCompressedHeader (
+  VOID
+  )
+{
+  MACH_FAT_HEADER  *FatHeader;
+  UINT32           Index;
+  UINT32           Offset;
+
+  if (mFileSize < sizeof (MACH_COMP_HEADER)) {
+    return NULL;
+  }
+
+  Offset    = 0;
+  FatHeader = (MACH_FAT_HEADER *) mFile;
+  if (FatHeader->Signature == MACH_FAT_BINARY_INVERT_SIGNATURE) {
+    for (Index = 0; Index < SwapBytes32 (FatHeader->NumberOfFatArch); ++Index) {
+      if (SwapBytes32 (FatHeader->FatArch[Index].CpuType) == MachCpuTypeX8664) {
+        Offset = SwapBytes32 (FatHeader->FatArch[Index].Offset);
+        break;
+      }
+    }
+  }
+
+  if ((UINT64) Offset + sizeof (MACH_COMP_HEADER) > mFileSize
+    || ((MACH_COMP_HEADER *) &mFile[Offset])->Signature != MACH_COMPRESSED_BINARY_INVERT_SIGNATURE) {
+    return NULL;
+  }
+
+  return (MACH_COMP_HEADER *) &mFile[Offset];
+}
+
+STATIC
+UINT8 *
+ReadReference (
+  IN  MACH_COMP_HEADER  *Header,
+  OUT UINT32            *KernelSize
+  )
+{
+  UINT8   *Compressed;
+  UINT8   *Kernel;
+  UINT32  CompressedSize;
+
+  //
+  // Former implementation reading the compressed image as a whole.
+  //
+  CompressedSize = SwapBytes32 (Header->Compressed);
+  *KernelSize    = SwapBytes32 (Header->Decompressed);
+
+  Compressed = malloc (CompressedSize);
+  Kernel     = malloc (*KernelSize);
+  if (Compressed == NULL || Kernel == NULL
+    || (UINT64) ((UINT8 *) (Header + 1) - mFile) + CompressedSize > mFileSize) {
+    free (Compressed);
+    free (Kernel);
+    return NULL;
+  }
+
+  memcpy (Compressed, Header + 1, CompressedSize);
+
+  if (Header->Compression == MACH_COMPRESSED_BINARY_INVERT_LZVN) {
+    *KernelSize = (UINT32) DecompressLZVN (Kernel, *KernelSize, Compressed, CompressedSize);
+  } else {
+    *KernelSize = DecompressLZSS (Kernel, *KernelSize, Compressed, CompressedSize);
+  }
+
+  free (Compressed);
+  return Kernel;
+}
+
+int main (int argc, char *argv[]) {
+  UINT8             *Data;
+  UINT32            DataSize;
+  UINT8             *Kernel;
+  UINT32            KernelSize;
+  UINT32            AllocatedSize;
+  UINT8             *Reference;
+  UINT32            ReferenceSize;
+  MACH_COMP_HEADER  *Header;
+  EFI_STATUS        Status;
+  UINT32            Index;
+  UINT64            StartTime;
+  UINT64            ReferenceNs;
+  UINT64            StreamNs;
+
+  if (argc > 1) {
+    Data = readFile (argv[1], &DataSize);
+  } else {
+    Data = SyntheticKernel (&DataSize);
+  }
+
+  if (Data == NULL || DataSize < sizeof (UINT32)) {
+    printf ("Read fail\n");
+    return -1;
+  }
+
+  if (*(UINT32 *) Data == MACH_HEADER_64_SIGNATURE) {
+    mFile = CompressKernel (Data, DataSize, &mFileSize);
+    free (Data);
+  } else {
+    mFile     = Data;
+    mFileSize = DataSize;
+  }
+
+  Header = FindCompressedHeader ();
+  if (Header == NULL) {
+    printf ("No compressed x86_64 kernel\n");
+    return -1;
+  }
+
+  ReferenceNs = 0;
+  StreamNs    = 0;
+
+  for (Index = 0; Index < NUM_ITERATIONS; ++Index) {
+    StartTime   = GetPerformanceCounter ();
+    Reference   = ReadReference (Header, &ReferenceSize);
+    ReferenceNs += GetPerformanceCounter () - StartTime;
+
+    StartTime = GetPerformanceCounter ();
+    Status    = ReadAppleKernel (&mNilFileProtocol, &Kernel, &KernelSize, &AllocatedSize, 0);
+    StreamNs  += GetPerformanceCounter () - StartTime;
+
+    if (Reference == NULL || EFI_ERROR (Status)) {
+      printf ("Kernel read error - %d / %d\n", Reference != NULL, (int) Status);
+      return -1;
+    }
+
+    if (ReferenceSize != KernelSize || memcmp (Reference, Kernel, KernelSize) != 0) {
+      printf ("Kernel mismatch %u vs %u\n", ReferenceSize, KernelSize);
+      return -1;
+    }
+
+    free (Reference);
+    free (Kernel);
+  }
+
+  printf (
+    "Read %u byte kernel from %u byte image: whole %llu ms, streaming %llu ms, saved %u bytes of pool\n",
+    KernelSize,
+    SwapBytes32 (Header->Compressed),
+    (unsigned long long) (ReferenceNs / NUM_ITERATIONS / 1000000ULL),
+    (unsigned long long) (StreamNs / NUM_ITERATIONS / 1000000ULL),
+    SwapBytes32 (Header->Compressed) - MIN (SwapBytes32 (Header->Compressed), BASE_1MB)
+    );
+
+  //
+  // Damage the checksum and ensure it is caught.
+  //
+  Header->Hash ^= 0x01000000U;
+  Status = ReadAppleKernel (&mNilFileProtocol, &Kernel, &KernelSize, &AllocatedSize, 0);
+  if (!EFI_ERROR (Status)) {
+    printf ("Corrupted kernel passed verification\n");
+    return -1;
+  }
+
+  printf ("Success...\n");
+  free (mFile);
+
+  return 0;
+}
@@ -15,6 +15,8 @@
 #include <Library/OcMachoLib.h>
 #include <Library/OcMiscLib.h>
 
+#include "../../Library/OcMachoLib/OcMachoLibInternal.h"
+
 #include <sys/time.h>
 
 /*
@@ -53,6 +55,28 @@ MACH_SECTION_64 Sect;
 MACH_SEGMENT_COMMAND_64 Seg;
 MACH_UUID_COMMAND Uuid;
 
+static void CompareRelocationLookup(OC_MACHO_CONTEXT *Context, UINT64 Address) {
+  MACH_RELOCATION_INFO *Indexed;
+  MACH_RELOCATION_INFO *Linear;
+
+  //
+  // The sorted index must return exactly what the linear search does.
+  //
+  Indexed = MachoLookupRelocation (Context, Address, TRUE);
+  Linear  = InternalLookupRelocationByOffset (Address, Context->DySymtab->NumExternalRelocations, Context->ExternRelocations);
+  if (Indexed != Linear) {
+    printf("Extern relocation mismatch at %llx\n", (unsigned long long) Address);
+    abort();
+  }
+
+  Indexed = MachoLookupRelocation (Context, Address, FALSE);
+  Linear  = InternalLookupRelocationByOffset (Address, Context->DySymtab->NumOfLocalRelocations, Context->LocalRelocations);
+  if (Indexed != Linear) {
+    printf("Local relocation mismatch at %llx\n", (unsigned long long) Address);
+    abort();
+  }
+}
+
 static int FeedMacho(void *file, uint32_t size) {
   OC_MACHO_CONTEXT Context;
   if (!MachoInitializeContext (&Context, file, size)) {
@@ -290,6 +314,22 @@ static int FeedMacho(void *file, uint32_t size) {
     }
   }
 
+  if (InternalRetrieveSymtabs64 (&Context) && Context.DySymtab != NULL) {
+    for (index = 0; index < Context.DySymtab->NumExternalRelocations; index++) {
+      CompareRelocationLookup (&Context, (UINT64) Context.ExternRelocations[index].Address);
+      CompareRelocationLookup (&Context, (UINT64) Context.ExternRelocations[index].Address + 1);
+    }
+    for (index = 0; index < Context.DySymtab->NumOfLocalRelocations; index++) {
+      CompareRelocationLookup (&Context, (UINT64) Context.LocalRelocations[index].Address);
+      CompareRelocationLookup (&Context, (UINT64) Context.LocalRelocations[index].Address + 1);
+    }
+    for (size_t i = 0; i < 0x100000000; i+= 0x1000000) {
+      CompareRelocationLookup (&Context, i);
+    }
+  }
+
+  MachoFreeRelocationIndex (&Context);
+
   return code != 963;
 }
 
@@ -0,0 +1,246 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+/*
+clang -g -O2 -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h MemoryArena.c ../../Library/OcMemoryLib/MemoryArena.c -o MemoryArena
+
+./MemoryArena [rounds]
+
+Stresses several simultaneously used memory arenas with random allocation
+sizes, checks alignment, contents and bookkeeping, and compares arena
+allocation time with individual pool allocations.
+*/
+
+#include <Base.h>
+
+#include <Library/OcMemoryLib.h>
+
+#define NUM_ARENAS       4
+#define NUM_ALLOCATIONS  20000
+#define MAX_SIZE         512
+
+typedef struct {
+  UINT8   *Memory;
+  UINT32  Size;
+  UINT8   Pattern;
+} TEST_ALLOCATION;
+
+STATIC TEST_ALLOCATION  mAllocations[NUM_ARENAS][NUM_ALLOCATIONS];
+STATIC VOID             *mPoolAllocations[NUM_ALLOCATIONS];
+STATIC UINT32           mSizes[NUM_ALLOCATIONS];
+
+STATIC
+BOOLEAN
+CheckPattern (
+  IN CONST UINT8  *Memory,
+  IN UINT32       Size,
+  IN UINT8        Pattern
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < Size; ++Index) {
+    if (Memory[Index] != Pattern) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+StressArenas (
+  IN UINT32  Round
+  )
+{
+  OC_MEMORY_ARENA  Arenas[NUM_ARENAS];
+  TEST_ALLOCATION  *Allocation;
+  UINT32           UsedSize[NUM_ARENAS];
+  UINT32           Index;
+  UINT32           Index2;
+
+  for (Index = 0; Index < NUM_ARENAS; ++Index) {
+    MemoryArenaInit (&Arenas[Index], "Test", (Index + 1) * 1024);
+    UsedSize[Index] = 0;
+  }
+
+  //
+  // Interleave allocations from all arenas, as nested scopes would do.
+  //
+  for (Index2 = 0; Index2 < NUM_ALLOCATIONS; ++Index2) {
+    for (Index = 0; Index < NUM_ARENAS; ++Index) {
+      Allocation          = &mAllocations[Index][Index2];
+      Allocation->Size    = (UINT32) (rand () % (Index2 % 100 == 0 ? 64 * MAX_SIZE : MAX_SIZE));
+      Allocation->Pattern = (UINT8) (Index2 + Index + Round);
+
+      if (Index2 % 3 == 0) {
+        Allocation->Memory = MemoryArenaAllocateZero (&Arenas[Index], Allocation->Size);
+        if (Allocation->Memory == NULL || !CheckPattern (Allocation->Memory, Allocation->Size, 0)) {
+          printf ("Zero allocation %u in arena %u failed\n", Index2, Index);
+          return FALSE;
+        }
+      } else {
+        Allocation->Memory = MemoryArenaAllocate (&Arenas[Index], Allocation->Size);
+        if (Allocation->Memory == NULL) {
+          printf ("Allocation %u in arena %u failed\n", Index2, Index);
+          return FALSE;
+        }
+      }
+
+      if (((UINTN) Allocation->Memory & (sizeof (UINT64) - 1)) != 0) {
+        printf ("Allocation %u in arena %u is misaligned\n", Index2, Index);
+        return FALSE;
+      }
+
+      SetMem (Allocation->Memory, Allocation->Size, Allocation->Pattern);
+      UsedSize[Index] += ALIGN_VALUE (Allocation->Size, sizeof (UINT64));
+    }
+  }
+
+  //
+  // Overlapping allocations would have corrupted each other's patterns.
+  //
+  for (Index = 0; Index < NUM_ARENAS; ++Index) {
+    if (Arenas[Index].Allocations != NUM_ALLOCATIONS
+      || Arenas[Index].UsedSize != UsedSize[Index]
+      || Arenas[Index].PeakSize < UsedSize[Index]) {
+      printf ("Arena %u statistics mismatch\n", Index);
+      return FALSE;
+    }
+
+    for (Index2 = 0; Index2 < NUM_ALLOCATIONS; ++Index2) {
+      Allocation = &mAllocations[Index][Index2];
+      if (!CheckPattern (Allocation->Memory, Allocation->Size, Allocation->Pattern)) {
+        printf ("Allocation %u in arena %u is corrupted\n", Index2, Index);
+        return FALSE;
+      }
+
+      if (Allocation->Size > 0
+        && (!MemoryArenaContains (&Arenas[Index], Allocation->Memory)
+          || MemoryArenaContains (&Arenas[(Index + 1) % NUM_ARENAS], Allocation->Memory))) {
+        printf ("Allocation %u in arena %u has wrong owner\n", Index2, Index);
+        return FALSE;
+      }
+    }
+  }
+
+  for (Index = 0; Index < NUM_ARENAS; ++Index) {
+    if (Arenas[Index].PoolTicks == 0) {
+      printf ("Arena %u pool time is not counted\n", Index);
+      return FALSE;
+    }
+
+    MemoryArenaFree (&Arenas[Index]);
+    if (Arenas[Index].Blocks != NULL
+      || Arenas[Index].Allocations != 0
+      || Arenas[Index].PoolTicks != 0
+      || Arenas[Index].BlockSize != MAX ((Index + 1) * 1024, SIZE_4KB)) {
+      printf ("Arena %u is not reset\n", Index);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+VOID
+CompareWithPool (
+  VOID
+  )
+{
+  OC_MEMORY_ARENA  Arena;
+  UINT64           StartTime;
+  UINT64           PoolTime;
+  UINT64           ArenaTime;
+  UINT32           Index;
+
+  for (Index = 0; Index < NUM_ALLOCATIONS; ++Index) {
+    mSizes[Index] = (UINT32) (rand () % MAX_SIZE) + 1;
+  }
+
+  StartTime = GetPerformanceCounter ();
+  for (Index = 0; Index < NUM_ALLOCATIONS; ++Index) {
+    mPoolAllocations[Index] = AllocatePool (mSizes[Index]);
+    ASSERT (mPoolAllocations[Index] != NULL);
+  }
+  for (Index = 0; Index < NUM_ALLOCATIONS; ++Index) {
+    FreePool (mPoolAllocations[Index]);
+  }
+  PoolTime = GetPerformanceCounter () - StartTime;
+
+  StartTime = GetPerformanceCounter ();
+  MemoryArenaInit (&Arena, "Bench", SIZE_64KB);
+  for (Index = 0; Index < NUM_ALLOCATIONS; ++Index) {
+    mPoolAllocations[Index] = MemoryArenaAllocate (&Arena, mSizes[Index]);
+    ASSERT (mPoolAllocations[Index] != NULL);
+  }
+  MemoryArenaFree (&Arena);
+  ArenaTime = GetPerformanceCounter () - StartTime;
+
+  printf (
+    "%u allocations: pool %llu us, arena %llu us\n",
+    NUM_ALLOCATIONS,
+    (unsigned long long) (GetTimeInNanoSecond (PoolTime) / 1000),
+    (unsigned long long) (GetTimeInNanoSecond (ArenaTime) / 1000)
+    );
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  OC_MEMORY_ARENA  Arena;
+  UINT32           Rounds;
+  UINT32           Index;
+  UINT8            Source[3];
+
+  Rounds = argc > 1 ? (UINT32) atoi (argv[1]) : 4;
+  srand (0);
+
+  //
+  // Size overflows must fail instead of wrapping.
+  //
+  MemoryArenaInit (&Arena, "Overflow", 0);
+  if (MemoryArenaAllocate (&Arena, MAX_UINT32) != NULL
+    || MemoryArenaAllocate (&Arena, MAX_UINT32 - sizeof (UINT64)) != NULL) {
+    printf ("Overflowing allocation succeeded\n");
+    return -1;
+  }
+
+  Source[0] = 1;
+  Source[1] = 2;
+  Source[2] = 3;
+  if (CompareMem (MemoryArenaAllocateCopy (&Arena, sizeof (Source), Source), Source, sizeof (Source)) != 0
+    || MemoryArenaContains (&Arena, Source)) {
+    printf ("Copy allocation failed\n");
+    return -1;
+  }
+
+  MemoryArenaFree (&Arena);
+
+  for (Index = 0; Index < Rounds; ++Index) {
+    if (!StressArenas (Index)) {
+      return -1;
+    }
+  }
+
+  CompareWithPool ();
+
+  printf ("All tests passed\n");
+  return 0;
+}
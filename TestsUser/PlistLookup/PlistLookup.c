@@ -0,0 +1,242 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+/*
+clang -g -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h PlistLookup.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcMemoryLib/MemoryArena.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcMiscLib/Hash.c ../../Library/OcStringLib/OcAsciiLib.c -o PlistLookup
+
+./PlistLookup [rounds]
+
+Looks up every key of small and large plist dictionaries, including
+duplicate and missing keys, checks the results against a dictionary scan,
+checks that appended keys are found after the index is dropped, and
+compares keyed lookup time with scanning.
+*/
+
+#include <Base.h>
+
+#include <Library/OcXmlLib.h>
+
+#define NUM_LARGE_KEYS  1024
+#define NUM_SMALL_KEYS  8
+
+STATIC CHAR8  mKeys[NUM_LARGE_KEYS][32];
+
+STATIC
+XML_NODE *
+ScanDict (
+  IN XML_NODE     *Dict,
+  IN CONST CHAR8  *Key
+  )
+{
+  XML_NODE     *Value;
+  CONST CHAR8  *KeyValue;
+  UINT32       Index;
+
+  for (Index = 0; Index < PlistDictChildren (Dict); ++Index) {
+    KeyValue = PlistKeyValue (PlistDictChild (Dict, Index, &Value));
+    if (KeyValue != NULL && AsciiStrCmp (KeyValue, Key) == 0) {
+      return Value;
+    }
+  }
+
+  return NULL;
+}
+
+STATIC
+CHAR8 *
+BuildPlist (
+  OUT UINT32  *Size
+  )
+{
+  CHAR8   *Plist;
+  UINT32  Offset;
+  UINT32  Index;
+
+  Plist = AllocatePool ((NUM_LARGE_KEYS + NUM_SMALL_KEYS + 1) * 96 + 512);
+  ASSERT (Plist != NULL);
+
+  AsciiSPrint (
+    Plist,
+    512,
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<plist version=\"1.0\">\n<dict>\n<key>Large</key>\n<dict>\n"
+    );
+  Offset = (UINT32) AsciiStrLen (Plist);
+
+  for (Index = 0; Index < NUM_LARGE_KEYS; ++Index) {
+    AsciiSPrint (mKeys[Index], sizeof (mKeys[Index]), "Key%u-%u", Index, (UINT32) rand () % 1000);
+    AsciiSPrint (&Plist[Offset], 96, "<key>%a</key>\n<integer>%u</integer>\n", mKeys[Index], Index);
+    Offset += (UINT32) AsciiStrLen (&Plist[Offset]);
+  }
+
+  //
+  // Duplicate key must resolve to the first value.
+  //
+  AsciiSPrint (&Plist[Offset], 96, "<key>%a</key>\n<integer>%u</integer>\n", mKeys[0], NUM_LARGE_KEYS);
+  Offset += (UINT32) AsciiStrLen (&Plist[Offset]);
+
+  AsciiSPrint (&Plist[Offset], 96, "</dict>\n<key>Small</key>\n<dict>\n");
+  Offset += (UINT32) AsciiStrLen (&Plist[Offset]);
+
+  for (Index = 0; Index < NUM_SMALL_KEYS; ++Index) {
+    AsciiSPrint (&Plist[Offset], 96, "<key>%a</key>\n<true/>\n", mKeys[Index]);
+    Offset += (UINT32) AsciiStrLen (&Plist[Offset]);
+  }
+
+  AsciiSPrint (&Plist[Offset], 96, "</dict>\n</dict>\n</plist>\n");
+  Offset += (UINT32) AsciiStrLen (&Plist[Offset]);
+
+  *Size = Offset;
+  return Plist;
+}
+
+STATIC
+BOOLEAN
+CheckDict (
+  IN XML_NODE  *Dict,
+  IN UINT32    KeyCount
+  )
+{
+  UINT32  Index;
+  CHAR8   Missing[32];
+
+  for (Index = 0; Index < KeyCount; ++Index) {
+    if (PlistDictLookup (Dict, mKeys[Index]) != ScanDict (Dict, mKeys[Index])
+      || PlistDictLookup (Dict, mKeys[Index]) == NULL) {
+      printf ("Key %s lookup mismatch\n", mKeys[Index]);
+      return FALSE;
+    }
+
+    AsciiSPrint (Missing, sizeof (Missing), "%aX", mKeys[Index]);
+    if (PlistDictLookup (Dict, Missing) != NULL) {
+      printf ("Missing key %s found\n", Missing);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+UINT64
+MeasureLookups (
+  IN XML_NODE  *Dict,
+  IN UINT32    Rounds,
+  IN BOOLEAN   Scan
+  )
+{
+  UINT64   StartTime;
+  UINT32   Round;
+  UINT32   Index;
+  BOOLEAN  Result;
+
+  Result    = TRUE;
+  StartTime = GetPerformanceCounter ();
+  for (Round = 0; Round < Rounds; ++Round) {
+    for (Index = 0; Index < NUM_LARGE_KEYS; ++Index) {
+      if (Scan) {
+        Result &= ScanDict (Dict, mKeys[Index]) != NULL;
+      } else {
+        Result &= PlistDictLookup (Dict, mKeys[Index]) != NULL;
+      }
+    }
+  }
+
+  ASSERT (Result);
+  return GetTimeInNanoSecond (GetPerformanceCounter () - StartTime) / 1000;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  XML_DOCUMENT  *Document;
+  XML_NODE      *Root;
+  XML_NODE      *Large;
+  XML_NODE      *Small;
+  XML_NODE      *Value;
+  CHAR8         *Plist;
+  UINT32        PlistSize;
+  UINT32        Rounds;
+  UINT64        IndexTime;
+  UINT64        ScanTime;
+
+  Rounds = argc > 1 ? (UINT32) atoi (argv[1]) : 10;
+  srand (0);
+
+  Plist    = BuildPlist (&PlistSize);
+  Document = XmlDocumentParse (Plist, PlistSize, FALSE);
+  Root     = Document != NULL ? PlistNodeCast (PlistDocumentRoot (Document), PLIST_NODE_TYPE_DICT) : NULL;
+  if (Root == NULL) {
+    printf ("Plist parse failure\n");
+    return -1;
+  }
+
+  Large = PlistNodeCast (PlistDictLookup (Root, "Large"), PLIST_NODE_TYPE_DICT);
+  Small = PlistNodeCast (PlistDictLookup (Root, "Small"), PLIST_NODE_TYPE_DICT);
+  if (Large == NULL || Small == NULL
+    || PlistDictChildren (Large) != NUM_LARGE_KEYS + 1
+    || PlistDictChildren (Small) != NUM_SMALL_KEYS) {
+    printf ("Plist layout mismatch\n");
+    return -1;
+  }
+
+  //
+  // The first lookup of the large dictionary builds its index.
+  //
+  if (!CheckDict (Large, NUM_LARGE_KEYS) || !CheckDict (Small, NUM_SMALL_KEYS)) {
+    return -1;
+  }
+
+  if (AsciiStrCmp (XmlNodeContent (PlistDictLookup (Large, mKeys[0])), "0") != 0) {
+    printf ("Duplicate key resolved to a later value\n");
+    return -1;
+  }
+
+  //
+  // Appending children drops the index, it must be rebuilt with the new key.
+  //
+  if (XmlNodeAppend (Large, "key", NULL, "Appended") == NULL
+    || XmlNodeAppend (Large, "string", NULL, "Value") == NULL) {
+    printf ("Append failure\n");
+    return -1;
+  }
+
+  Value = PlistDictLookup (Large, "Appended");
+  if (Value == NULL
+    || AsciiStrCmp (XmlNodeContent (Value), "Value") != 0
+    || !CheckDict (Large, NUM_LARGE_KEYS)) {
+    printf ("Appended key lookup mismatch\n");
+    return -1;
+  }
+
+  IndexTime = MeasureLookups (Large, Rounds, FALSE);
+  ScanTime  = MeasureLookups (Large, Rounds, TRUE);
+
+  printf (
+    "%u lookups in %u keys: index %llu us, scan %llu us\n",
+    Rounds * NUM_LARGE_KEYS,
+    NUM_LARGE_KEYS,
+    (unsigned long long) IndexTime,
+    (unsigned long long) ScanTime
+    );
+
+  XmlDocumentFree (Document);
+  FreePool (Plist);
+
+  printf ("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,206 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+/*
+clang -g -O2 -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../Library/OcCryptoLib -I../../Tests/CryptoTest -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h RsaVerify.c ../../Library/OcCryptoLib/RsaDigitalSign.c ../../Library/OcCryptoLib/BigNumMontgomery.c ../../Library/OcCryptoLib/BigNumPrimitives.c ../../Library/OcCryptoLib/X64/BigNumWordMul64.c ../../Library/OcCryptoLib/Sha2.c ../../Library/OcCryptoLib/SecureMem.c -o RsaVerify
+
+./RsaVerify [iterations]
+
+Verifies the CryptoTest RSA-2048 sample through all verification entry points,
+checks that corrupted signatures are rejected, and compares verifications per
+second with and without a pre-processed verification context.
+*/
+
+#include <Base.h>
+
+#include <Library/OcCryptoLib.h>
+
+#include "CryptoSamples.h"
+
+STATIC UINT8  mModulus[256];
+
+STATIC
+UINT64
+VerificationsPerSecond (
+  IN UINT32  Iterations,
+  IN UINT64  Time
+  )
+{
+  UINT64  Nanoseconds;
+
+  Nanoseconds = GetTimeInNanoSecond (Time);
+  if (Nanoseconds == 0) {
+    return 0;
+  }
+
+  return (UINT64) Iterations * 1000000000ULL / Nanoseconds;
+}
+
+STATIC
+BOOLEAN
+CheckContext (
+  IN OC_RSA_VERIFY_CONTEXT  *Context,
+  IN CONST CHAR8            *Name
+  )
+{
+  UINT8  Hash[SHA256_DIGEST_SIZE];
+  UINT8  Signature[sizeof (Rsa2048Sha256Sample.Signature)];
+  UINT32 Index;
+
+  Sha256 (Hash, Rsa2048Sha256Sample.Data, SIGNED_DATA_LEN);
+
+  //
+  // Repeated verifications must not depend on the scratch memory contents.
+  //
+  for (Index = 0; Index < 4; ++Index) {
+    if (!RsaVerifySigHashFromContext (Context, Rsa2048Sha256Sample.Signature, sizeof (Signature), Hash, sizeof (Hash), OcSigHashTypeSha256)
+      || !RsaVerifySigDataFromContext (Context, Rsa2048Sha256Sample.Signature, sizeof (Signature), Rsa2048Sha256Sample.Data, SIGNED_DATA_LEN, OcSigHashTypeSha256)) {
+      printf ("%s context verification %u failed\n", Name, Index);
+      return FALSE;
+    }
+  }
+
+  CopyMem (Signature, Rsa2048Sha256Sample.Signature, sizeof (Signature));
+  Signature[sizeof (Signature) / 2] ^= 1;
+  if (RsaVerifySigHashFromContext (Context, Signature, sizeof (Signature), Hash, sizeof (Hash), OcSigHashTypeSha256)) {
+    printf ("%s context accepted corrupted signature\n", Name);
+    return FALSE;
+  }
+
+  if (RsaVerifySigHashFromContext (Context, Rsa2048Sha256Sample.Signature, sizeof (Signature) / 2, Hash, sizeof (Hash), OcSigHashTypeSha256)) {
+    printf ("%s context accepted truncated signature\n", Name);
+    return FALSE;
+  }
+
+  Hash[0] ^= 1;
+  if (RsaVerifySigHashFromContext (Context, Rsa2048Sha256Sample.Signature, sizeof (Signature), Hash, sizeof (Hash), OcSigHashTypeSha256)) {
+    printf ("%s context accepted wrong hash\n", Name);
+    return FALSE;
+  }
+
+  //
+  // Failed verifications must not break further ones.
+  //
+  Hash[0] ^= 1;
+  if (!RsaVerifySigHashFromContext (Context, Rsa2048Sha256Sample.Signature, sizeof (Signature), Hash, sizeof (Hash), OcSigHashTypeSha256)) {
+    printf ("%s context verification after failure failed\n", Name);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+STATIC
+VOID
+Benchmark (
+  IN OC_RSA_VERIFY_CONTEXT  *Context,
+  IN UINT32                 Iterations
+  )
+{
+  CONST OC_RSA_PUBLIC_KEY  *Key;
+  UINT64                   StartTime;
+  UINT64                   DataTime;
+  UINT64                   KeyTime;
+  UINT64                   ContextTime;
+  UINT32                   Index;
+  BOOLEAN                  Result;
+
+  Key    = (CONST OC_RSA_PUBLIC_KEY *) Rsa2048Sha256Sample.PublicKey;
+  Result = TRUE;
+
+  StartTime = GetPerformanceCounter ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    Result &= RsaVerifySigDataFromData (mModulus, sizeof (mModulus), 0x10001, Rsa2048Sha256Sample.Signature, sizeof (Rsa2048Sha256Sample.Signature), Rsa2048Sha256Sample.Data, SIGNED_DATA_LEN, OcSigHashTypeSha256);
+  }
+  DataTime = GetPerformanceCounter () - StartTime;
+
+  StartTime = GetPerformanceCounter ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    Result &= RsaVerifySigDataFromKey (Key, Rsa2048Sha256Sample.Signature, sizeof (Rsa2048Sha256Sample.Signature), Rsa2048Sha256Sample.Data, SIGNED_DATA_LEN, OcSigHashTypeSha256);
+  }
+  KeyTime = GetPerformanceCounter () - StartTime;
+
+  StartTime = GetPerformanceCounter ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    Result &= RsaVerifySigDataFromContext (Context, Rsa2048Sha256Sample.Signature, sizeof (Rsa2048Sha256Sample.Signature), Rsa2048Sha256Sample.Data, SIGNED_DATA_LEN, OcSigHashTypeSha256);
+  }
+  ContextTime = GetPerformanceCounter () - StartTime;
+
+  ASSERT (Result);
+
+  printf (
+    "RSA-2048 verifications per second: %llu from data, %llu from key, %llu from context\n",
+    (unsigned long long) VerificationsPerSecond (Iterations, DataTime),
+    (unsigned long long) VerificationsPerSecond (Iterations, KeyTime),
+    (unsigned long long) VerificationsPerSecond (Iterations, ContextTime)
+    );
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  CONST OC_RSA_PUBLIC_KEY  *Key;
+  OC_RSA_VERIFY_CONTEXT    KeyContext;
+  OC_RSA_VERIFY_CONTEXT    DataContext;
+  OC_RSA_VERIFY_CONTEXT    InvalidContext;
+  UINT32                   Iterations;
+  UINT32                   Index;
+
+  Iterations = argc > 1 ? (UINT32) atoi (argv[1]) : 2000;
+  Key        = (CONST OC_RSA_PUBLIC_KEY *) Rsa2048Sha256Sample.PublicKey;
+
+  //
+  // Key modulus is stored in little endian byte order.
+  //
+  for (Index = 0; Index < sizeof (mModulus); ++Index) {
+    mModulus[Index] = ((CONST UINT8 *) Key->Data)[sizeof (mModulus) - 1 - Index];
+  }
+
+  if (!RsaVerifyContextInitFromKey (&KeyContext, Key)
+    || !RsaVerifyContextInitFromData (&DataContext, mModulus, sizeof (mModulus), 0x10001)) {
+    printf ("Context initialisation failed\n");
+    return -1;
+  }
+
+  if (KeyContext.N0Inv != DataContext.N0Inv
+    || CompareMem (KeyContext.RSqrMod, DataContext.RSqrMod, sizeof (mModulus)) != 0) {
+    printf ("Context Montgomery parameters mismatch\n");
+    return -1;
+  }
+
+  if (!CheckContext (&KeyContext, "Key") || !CheckContext (&DataContext, "Data")) {
+    return -1;
+  }
+
+  if (RsaVerifyContextInitFromData (&InvalidContext, mModulus, sizeof (mModulus) - 1, 0x10001)
+    || InvalidContext.Memory != NULL) {
+    printf ("Unaligned modulus context initialised\n");
+    return -1;
+  }
+
+  Benchmark (&KeyContext, Iterations);
+
+  RsaVerifyContextFree (&KeyContext);
+  RsaVerifyContextFree (&DataContext);
+  if (KeyContext.Memory != NULL || DataContext.Scratch != NULL) {
+    printf ("Context is not reset\n");
+    return -1;
+  }
+
+  printf ("All tests passed\n");
+  return 0;
+}
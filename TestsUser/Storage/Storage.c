@@ -0,0 +1,464 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+/*
+clang -g -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h Storage.c ../../Library/OcStorageLib/OcStorageLib.c ../../Library/OcFileLib/OpenFile.c ../../Library/OcFileLib/FileProtocol.c ../../Library/OcXmlLib/OcXmlLib.c ../../Library/OcMemoryLib/MemoryArena.c ../../Library/OcTemplateLib/OcTemplateLib.c ../../Library/OcSerializeLib/OcSerializeLib.c ../../Library/OcMiscLib/Base64Decode.c ../../Library/OcMiscLib/Hash.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcCryptoLib/Sha2.c ../../Library/OcCryptoLib/SecureMem.c ../../Library/OcCryptoLib/RsaDigitalSign.c ../../Library/OcCryptoLib/BigNumMontgomery.c ../../Library/OcCryptoLib/BigNumPrimitives.c ../../Library/OcCryptoLib/X64/BigNumWordMul64.c -o Storage
+
+./Storage [rounds]
+
+Builds a vaulted storage on a mock file system, checks that vaulted files
+are read back intact and that missing or altered files are rejected, and
+compares vault lookup time with and without the vault path index.
+*/
+
+#include <Base.h>
+
+#include <Library/OcStorageLib.h>
+
+#define NUM_FILES   256
+
+//
+// Matches OC_STORAGE_READ_CHUNK_SIZE to make files span several chunks.
+//
+#define CHUNK_SIZE  BASE_256KB
+
+typedef struct {
+  CHAR16  Name[64];
+  UINT8   *Data;
+  UINT32  Size;
+} MOCK_FILE;
+
+typedef struct {
+  EFI_FILE_PROTOCOL  Protocol;
+  MOCK_FILE          *File;
+  UINT64             Position;
+} MOCK_FILE_HANDLE;
+
+STATIC MOCK_FILE  mFiles[NUM_FILES + 2];
+STATIC UINT32     mFileCount;
+STATIC UINTN      mOpenHandles;
+
+STATIC EFI_FILE_PROTOCOL  mMockFileProtocol;
+
+STATIC
+MOCK_FILE_HANDLE *
+MockCreateHandle (
+  IN MOCK_FILE  *File
+  )
+{
+  MOCK_FILE_HANDLE  *Handle;
+
+  Handle = AllocateZeroPool (sizeof (*Handle));
+  ASSERT (Handle != NULL);
+  CopyMem (&Handle->Protocol, &mMockFileProtocol, sizeof (Handle->Protocol));
+  Handle->File = File;
+  ++mOpenHandles;
+  return Handle;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockOpen (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL  **NewHandle,
+  IN  CHAR16             *FileName,
+  IN  UINT64             OpenMode,
+  IN  UINT64             Attributes
+  )
+{
+  UINT32  Index;
+
+  //
+  // Storage root is a directory.
+  //
+  if (StrCmp (FileName, L"EFI\\OC") == 0) {
+    *NewHandle = &MockCreateHandle (NULL)->Protocol;
+    return EFI_SUCCESS;
+  }
+
+  for (Index = 0; Index < mFileCount; ++Index) {
+    if (StrCmp (FileName, mFiles[Index].Name) == 0) {
+      *NewHandle = &MockCreateHandle (&mFiles[Index])->Protocol;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockClose (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  --mOpenHandles;
+  FreePool (This);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockRead (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  MOCK_FILE_HANDLE  *Handle;
+
+  Handle = (MOCK_FILE_HANDLE *) This;
+  if (Handle->File == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Handle->Position >= Handle->File->Size) {
+    *BufferSize = 0;
+    return EFI_SUCCESS;
+  }
+
+  *BufferSize = MIN (*BufferSize, (UINTN) (Handle->File->Size - Handle->Position));
+  CopyMem (Buffer, &Handle->File->Data[Handle->Position], *BufferSize);
+  Handle->Position += *BufferSize;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockSetPosition (
+  IN EFI_FILE_PROTOCOL  *This,
+  IN UINT64             Position
+  )
+{
+  MOCK_FILE_HANDLE  *Handle;
+
+  Handle = (MOCK_FILE_HANDLE *) This;
+  if (Handle->File == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Handle->Position = Position == MAX_UINT64 ? Handle->File->Size : Position;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockGetPosition (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT UINT64             *Position
+  )
+{
+  *Position = ((MOCK_FILE_HANDLE *) This)->Position;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockOpenVolume (
+  IN  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL                **Root
+  )
+{
+  *Root = &MockCreateHandle (NULL)->Protocol;
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_FILE_PROTOCOL  mMockFileProtocol = {
+  .Open        = MockOpen,
+  .Close       = MockClose,
+  .Read        = MockRead,
+  .GetPosition = MockGetPosition,
+  .SetPosition = MockSetPosition
+};
+
+STATIC EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  mMockFileSystem = {
+  .OpenVolume = MockOpenVolume
+};
+
+STATIC
+MOCK_FILE *
+AddFile (
+  IN CONST CHAR8  *Format,
+  IN UINT32       Number,
+  IN UINT32       Size
+  )
+{
+  MOCK_FILE  *File;
+  CHAR8      AsciiName[64];
+  UINT32     Index;
+
+  ASSERT (mFileCount < ARRAY_SIZE (mFiles));
+
+  File = &mFiles[mFileCount++];
+  snprintf (AsciiName, sizeof (AsciiName), Format, Number);
+  for (Index = 0; AsciiName[Index] != '\0'; ++Index) {
+    File->Name[Index] = AsciiName[Index];
+  }
+
+  File->Name[Index] = L'\0';
+  File->Size        = Size;
+  File->Data        = AllocatePool (MAX (Size, 1));
+  ASSERT (File->Data != NULL);
+
+  for (Index = 0; Index < Size; ++Index) {
+    File->Data[Index] = (UINT8) rand ();
+  }
+
+  return File;
+}
+
+STATIC
+UINT32
+Base64Encode (
+  IN  CONST UINT8  *Data,
+  IN  UINT32       DataSize,
+  OUT CHAR8        *Encoded
+  )
+{
+  STATIC CONST CHAR8  Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  UINT32              Index;
+  UINT32              Length;
+  UINT32              Value;
+
+  Length = 0;
+  for (Index = 0; Index < DataSize; Index += 3) {
+    Value = (UINT32) Data[Index] << 16U;
+    if (Index + 1 < DataSize) {
+      Value |= (UINT32) Data[Index + 1] << 8U;
+    }
+    if (Index + 2 < DataSize) {
+      Value |= Data[Index + 2];
+    }
+
+    Encoded[Length++] = Alphabet[(Value >> 18U) & 0x3FU];
+    Encoded[Length++] = Alphabet[(Value >> 12U) & 0x3FU];
+    Encoded[Length++] = Index + 1 < DataSize ? Alphabet[(Value >> 6U) & 0x3FU] : '=';
+    Encoded[Length++] = Index + 2 < DataSize ? Alphabet[Value & 0x3FU] : '=';
+  }
+
+  return Length;
+}
+
+/**
+  Create vault.plist with digests of all files added so far.
+**/
+STATIC
+VOID
+AddVault (
+  VOID
+  )
+{
+  MOCK_FILE  *Vault;
+  CHAR8      *Plist;
+  UINT32     Size;
+  UINT32     Index;
+  UINT32     Index2;
+  UINT8      Digest[SHA256_DIGEST_SIZE];
+
+  Plist = AllocatePool (NUM_FILES * 256 + 512);
+  ASSERT (Plist != NULL);
+
+  AsciiSPrint (
+    Plist,
+    512,
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<plist version=\"1.0\">\n<dict>\n<key>Files</key>\n<dict>\n"
+    );
+  Size = (UINT32) AsciiStrLen (Plist);
+
+  for (Index = 0; Index < mFileCount; ++Index) {
+    Plist[Size++] = '<';
+    Plist[Size++] = 'k';
+    Plist[Size++] = 'e';
+    Plist[Size++] = 'y';
+    Plist[Size++] = '>';
+    for (Index2 = 0; mFiles[Index].Name[Index2] != L'\0'; ++Index2) {
+      Plist[Size++] = (CHAR8) mFiles[Index].Name[Index2];
+    }
+
+    Sha256 (Digest, mFiles[Index].Data, mFiles[Index].Size);
+    AsciiSPrint (&Plist[Size], 32, "</key>\n<data>");
+    Size += (UINT32) AsciiStrLen (&Plist[Size]);
+    Size += Base64Encode (Digest, sizeof (Digest), &Plist[Size]);
+    AsciiSPrint (&Plist[Size], 32, "</data>\n");
+    Size += (UINT32) AsciiStrLen (&Plist[Size]);
+  }
+
+  AsciiSPrint (
+    &Plist[Size],
+    128,
+    "</dict>\n<key>Version</key>\n<integer>%u</integer>\n</dict>\n</plist>\n",
+    OC_STORAGE_VAULT_VERSION
+    );
+  Size += (UINT32) AsciiStrLen (&Plist[Size]);
+
+  ASSERT (mFileCount < ARRAY_SIZE (mFiles));
+  Vault       = &mFiles[mFileCount++];
+  Vault->Data = (UINT8 *) Plist;
+  Vault->Size = Size;
+  StrCpyS (Vault->Name, ARRAY_SIZE (Vault->Name), OC_STORAGE_VAULT_PATH);
+}
+
+STATIC
+BOOLEAN
+CheckFiles (
+  IN OC_STORAGE_CONTEXT  *Context
+  )
+{
+  UINT8   *Data;
+  UINT32  Size;
+  UINT32  Index;
+
+  for (Index = 0; Index < NUM_FILES; ++Index) {
+    Data = OcStorageReadFileUnicode (Context, mFiles[Index].Name, &Size);
+    if (Data == NULL
+      || Size != mFiles[Index].Size
+      || CompareMem (Data, mFiles[Index].Data, Size) != 0
+      || Data[Size] != 0
+      || Data[Size + 1] != 0) {
+      printf ("File %u read mismatch\n", Index);
+      return FALSE;
+    }
+
+    FreePool (Data);
+
+    if (!OcStorageExistsFileUnicode (Context, mFiles[Index].Name)) {
+      printf ("File %u does not exist\n", Index);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+UINT64
+MeasureLookups (
+  IN OC_STORAGE_CONTEXT  *Context,
+  IN UINT32              Rounds
+  )
+{
+  UINT64   StartTime;
+  UINT32   Round;
+  UINT32   Index;
+  BOOLEAN  Result;
+
+  Result    = TRUE;
+  StartTime = GetPerformanceCounter ();
+  for (Round = 0; Round < Rounds; ++Round) {
+    for (Index = 0; Index < NUM_FILES; ++Index) {
+      Result &= OcStorageExistsFileUnicode (Context, mFiles[Index].Name);
+    }
+  }
+
+  ASSERT (Result);
+  return GetTimeInNanoSecond (GetPerformanceCounter () - StartTime) / 1000;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  OC_STORAGE_CONTEXT            Context;
+  OC_STORAGE_VAULT_INDEX_ENTRY  *VaultIndex;
+  MOCK_FILE                     *Unvaulted;
+  EFI_STATUS                    Status;
+  UINT32                        Rounds;
+  UINT32                        Index;
+  UINT64                        IndexTime;
+  UINT64                        ScanTime;
+
+  Rounds = argc > 1 ? (UINT32) atoi (argv[1]) : 100;
+  srand (0);
+
+  //
+  // Mix small and chunk-sized files, including empty ones and ones ending
+  // exactly at a chunk boundary.
+  //
+  for (Index = 0; Index < NUM_FILES; ++Index) {
+    AddFile (
+      Index % 2 == 0 ? "Kexts\\Kext%03u.kext\\Contents\\MacOS\\Kext" : "ACPI\\SSDT-%03u.aml",
+      Index,
+      Index % 16 == 0 ? (Index / 16) * CHUNK_SIZE : (UINT32) rand () % (Index % 4 == 0 ? 3 * CHUNK_SIZE : 4096)
+      );
+  }
+
+  AddVault ();
+  Unvaulted = AddFile ("Drivers\\Unvaulted%u.efi", 0, 128);
+
+  Status = OcStorageInitFromFs (&Context, &mMockFileSystem, L"EFI\\OC", NULL);
+  if (EFI_ERROR (Status) || !Context.HasVault || Context.VaultIndex == NULL) {
+    printf ("Storage init failure - %d\n", (INT32) Status);
+    return -1;
+  }
+
+  if (!CheckFiles (&Context)) {
+    return -1;
+  }
+
+  if (OcStorageReadFileUnicode (&Context, Unvaulted->Name, NULL) != NULL
+    || OcStorageExistsFileUnicode (&Context, L"ACPI\\SSDT-001.am")) {
+    printf ("Missing vault entry allowed file access\n");
+    return -1;
+  }
+
+  mFiles[1].Data[mFiles[1].Size / 2] ^= 1;
+  if (OcStorageReadFileUnicode (&Context, mFiles[1].Name, NULL) != NULL) {
+    printf ("Altered file passed vault verification\n");
+    return -1;
+  }
+  mFiles[1].Data[mFiles[1].Size / 2] ^= 1;
+
+  //
+  // Compare with scanning the vault, which is also the fallback
+  // when the index cannot be allocated.
+  //
+  IndexTime          = MeasureLookups (&Context, Rounds);
+  VaultIndex         = Context.VaultIndex;
+  Context.VaultIndex = NULL;
+  if (!CheckFiles (&Context)) {
+    return -1;
+  }
+  ScanTime           = MeasureLookups (&Context, Rounds);
+  Context.VaultIndex = VaultIndex;
+
+  printf (
+    "%u lookups in %u vault files: index %llu us, scan %llu us\n",
+    Rounds * NUM_FILES,
+    NUM_FILES,
+    (unsigned long long) IndexTime,
+    (unsigned long long) ScanTime
+    );
+
+  OcStorageFree (&Context);
+  if (mOpenHandles != 0 || Context.VaultIndex != NULL) {
+    printf ("Storage resources leaked\n");
+    return -1;
+  }
+
+  for (Index = 0; Index < mFileCount; ++Index) {
+    FreePool (mFiles[Index].Data);
+  }
+
+  printf ("All tests passed\n");
+  return 0;
+}
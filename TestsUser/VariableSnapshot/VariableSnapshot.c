@@ -0,0 +1,332 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+/*
+clang -g -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -I../../Platform/OpenRuntime -include ../Include/Base.h VariableSnapshot.c ../../Platform/OpenRuntime/VariableSnapshot.c -o VariableSnapshot
+
+./VariableSnapshot
+
+Runs OpenRuntime variable snapshot against a mock variable store, checks that
+enumeration results match the store and counts firmware calls needed to find
+EfiBoot variables with and without the snapshot.
+*/
+
+#include <Base.h>
+
+#include <Library/OcStringLib.h>
+
+#include "OpenRuntimePrivate.h"
+
+#define MAX_VARIABLES  512
+
+typedef struct {
+  EFI_GUID  Guid;
+  CHAR16    Name[32];
+} MOCK_VARIABLE;
+
+STATIC EFI_GUID       mNormalGuid = {0x7C436110, 0xAB2A, 0x4BBB, {0xA8, 0x80, 0xFE, 0x41, 0x99, 0x5C, 0x9F, 0x82}};
+STATIC EFI_GUID       mGlobalGuid = {0x8BE4DF61, 0x93CA, 0x11D2, {0xAA, 0x0D, 0x00, 0xE0, 0x98, 0x03, 0x2B, 0x8C}};
+STATIC EFI_GUID       mVendorGuid = {0x4D1FDA02, 0x38C7, 0x4A6A, {0x9C, 0xC6, 0x4B, 0xCC, 0xA8, 0xB3, 0x01, 0x02}};
+
+STATIC MOCK_VARIABLE  mVariables[MAX_VARIABLES];
+STATIC UINTN          mVariableCount;
+STATIC UINTN          mMockCalls;
+STATIC BOOLEAN        mMockLoops;
+
+STATIC
+VOID
+AddVariable (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST CHAR16    *Name
+  )
+{
+  ASSERT (mVariableCount < MAX_VARIABLES);
+  CopyGuid (&mVariables[mVariableCount].Guid, Guid);
+  StrCpyS (mVariables[mVariableCount].Name, ARRAY_SIZE (mVariables[mVariableCount].Name), Name);
+  ++mVariableCount;
+}
+
+STATIC
+VOID
+AddNumberedVariable (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST CHAR8     *Format,
+  IN UINT32          Number
+  )
+{
+  CHAR8   AsciiName[32];
+  CHAR16  Name[32];
+  UINTN   Index;
+
+  snprintf (AsciiName, sizeof (AsciiName), Format, Number);
+  for (Index = 0; AsciiName[Index] != '\0'; ++Index) {
+    Name[Index] = AsciiName[Index];
+  }
+
+  Name[Index] = L'\0';
+  AddVariable (Guid, Name);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  )
+{
+  UINTN  Index;
+  UINTN  Size;
+
+  ++mMockCalls;
+
+  Index = 0;
+  if (VariableName[0] != L'\0') {
+    while (Index < mVariableCount
+      && (!CompareGuid (&mVariables[Index].Guid, VendorGuid)
+        || StrCmp (mVariables[Index].Name, VariableName) != 0)) {
+      ++Index;
+    }
+
+    if (Index == mVariableCount) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    ++Index;
+  }
+
+  if (Index == mVariableCount) {
+    if (!mMockLoops) {
+      return EFI_NOT_FOUND;
+    }
+
+    Index = 0;
+  }
+
+  Size = StrSize (mVariables[Index].Name);
+  if (*VariableNameSize < Size) {
+    *VariableNameSize = Size;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *VariableNameSize = Size;
+  StrCpyS (VariableName, Size / sizeof (CHAR16), mVariables[Index].Name);
+  CopyGuid (VendorGuid, &mVariables[Index].Guid);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+SnapshotGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = VariableSnapshotGetNextVariableName (VariableNameSize, VariableName, VendorGuid);
+  if (Status != EFI_NOT_READY) {
+    return Status;
+  }
+
+  return MockGetNextVariableName (VariableNameSize, VariableName, VendorGuid);
+}
+
+STATIC
+BOOLEAN
+CheckEnumeration (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      Name[256];
+  EFI_GUID    Guid;
+  UINTN       Size;
+  UINTN       Index;
+
+  Name[0] = L'\0';
+  ZeroMem (&Guid, sizeof (Guid));
+
+  for (Index = 0; Index <= mVariableCount; ++Index) {
+    Size   = sizeof (Name);
+    Status = VariableSnapshotGetNextVariableName (&Size, Name, &Guid);
+    if (Index == mVariableCount) {
+      return Status == EFI_NOT_FOUND;
+    }
+
+    if (EFI_ERROR (Status)
+      || Size != StrSize (mVariables[Index].Name)
+      || !CompareGuid (&Guid, &mVariables[Index].Guid)
+      || StrCmp (Name, mVariables[Index].Name) != 0) {
+      printf ("Mismatch at %u - %d\n", (UINT32) Index, (INT32) Status);
+      return FALSE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Find the variable following Name with vendor GUID, like redirected
+  EfiBoot variable iteration does.
+**/
+STATIC
+BOOLEAN
+FindNextVendorBootVariable (
+  IN     EFI_STATUS  (*GetNext)(UINTN *, CHAR16 *, EFI_GUID *),
+  IN OUT CHAR16      *Name,
+  IN OUT EFI_GUID    *Guid
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+
+  while (TRUE) {
+    Size   = 256 * sizeof (CHAR16);
+    Status = GetNext (&Size, Name, Guid);
+    if (EFI_ERROR (Status)) {
+      return FALSE;
+    }
+
+    if (CompareGuid (Guid, &mVendorGuid) && CompareMem (Name, L"Boot", L_STR_LEN (L"Boot") * sizeof (CHAR16)) == 0) {
+      return TRUE;
+    }
+  }
+}
+
+STATIC
+UINTN
+CountBootIterationCalls (
+  IN EFI_STATUS  (*GetNext)(UINTN *, CHAR16 *, EFI_GUID *)
+  )
+{
+  CHAR16    Name[256];
+  EFI_GUID  Guid;
+  UINTN     Count;
+
+  mMockCalls = 0;
+  Count      = 0;
+  Name[0]    = L'\0';
+  ZeroMem (&Guid, sizeof (Guid));
+
+  while (FindNextVendorBootVariable (GetNext, Name, &Guid)) {
+    ++Count;
+  }
+
+  ASSERT (Count == 16);
+  return mMockCalls;
+}
+
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      Name[256];
+  EFI_GUID    Guid;
+  UINTN       Size;
+  UINTN       Index;
+  UINTN       DirectCalls;
+  UINTN       SnapshotCalls;
+
+  for (Index = 0; Index < 400; ++Index) {
+    AddNumberedVariable (&mNormalGuid, "Variable%u", (UINT32) Index);
+    if (Index % 25 == 0) {
+      AddNumberedVariable (&mGlobalGuid, "Boot%04X", (UINT32) Index);
+      AddNumberedVariable (&mVendorGuid, "Boot%04X", (UINT32) Index);
+    }
+  }
+
+  //
+  // Snapshot is unusable until built.
+  //
+  Size    = sizeof (Name);
+  Name[0] = L'\0';
+  if (VariableSnapshotIsValid ()
+    || VariableSnapshotGetNextVariableName (&Size, Name, &Guid) != EFI_NOT_READY) {
+    printf ("Snapshot is valid before build\n");
+    return -1;
+  }
+
+  mMockCalls = 0;
+  if (!VariableSnapshotBuild (MockGetNextVariableName) || !CheckEnumeration ()) {
+    printf ("Snapshot enumeration failed\n");
+    return -1;
+  }
+
+  printf ("Built snapshot of %u variables with %u calls\n", (UINT32) mVariableCount, (UINT32) mMockCalls);
+
+  //
+  // Small buffers and unknown variables.
+  //
+  Size    = 2;
+  Name[0] = L'\0';
+  Status  = VariableSnapshotGetNextVariableName (&Size, Name, &Guid);
+  if (Status != EFI_BUFFER_TOO_SMALL || Size != StrSize (mVariables[0].Name)) {
+    printf ("Small buffer is not reported - %d\n", (INT32) Status);
+    return -1;
+  }
+
+  Size = sizeof (Name);
+  StrCpyS (Name, ARRAY_SIZE (Name), L"Missing");
+  if (VariableSnapshotGetNextVariableName (&Size, Name, &mNormalGuid) != EFI_NOT_READY) {
+    printf ("Unknown variable is not passed to firmware\n");
+    return -1;
+  }
+
+  DirectCalls   = CountBootIterationCalls (MockGetNextVariableName);
+  SnapshotCalls = CountBootIterationCalls (SnapshotGetNextVariableName);
+  printf ("Boot variable iteration takes %u calls direct, %u with snapshot\n", (UINT32) DirectCalls, (UINT32) SnapshotCalls);
+  if (SnapshotCalls != 0) {
+    return -1;
+  }
+
+  //
+  // Variable updates invalidate the snapshot.
+  //
+  VariableSnapshotInvalidate ();
+  AddVariable (&mNormalGuid, L"NewVariable");
+  Size    = sizeof (Name);
+  Name[0] = L'\0';
+  if (VariableSnapshotIsValid ()
+    || VariableSnapshotGetNextVariableName (&Size, Name, &Guid) != EFI_NOT_READY) {
+    printf ("Snapshot is valid after update\n");
+    return -1;
+  }
+
+  if (!VariableSnapshotBuild (MockGetNextVariableName) || !CheckEnumeration ()) {
+    printf ("Snapshot enumeration failed after update\n");
+    return -1;
+  }
+
+  //
+  // Looping firmware must not hang us.
+  //
+  VariableSnapshotInvalidate ();
+  mMockLoops = TRUE;
+  if (VariableSnapshotBuild (MockGetNextVariableName) || VariableSnapshotIsValid ()) {
+    printf ("Looping firmware snapshot succeeded\n");
+    return -1;
+  }
+
+  mMockLoops = FALSE;
+  VariableSnapshotDiscard ();
+
+  printf ("All tests passed\n");
+  return 0;
+}